@@ -248,6 +248,9 @@ SUBCLASSABLE_ONLY(Xapian, StemImplementation)
 #endif
 STANDARD_IGNORES(Xapian, Stem)
 %ignore Xapian::Stem::Stem();
+/* Ignore the forms which set a string passed by reference. */
+%ignore Xapian::Stem::stem_into;
+%ignore Xapian::StemImplementation::stem_into;
 %include <xapian/stem.h>
 
 STANDARD_IGNORES(Xapian, TermGenerator)
@@ -262,6 +265,9 @@ STANDARD_IGNORES(Xapian, TermGenerator)
 %ignore Xapian::TermGenerator::TermGenerator(const TermGenerator &);
 %include <xapian/termgenerator.h>
 
+STANDARD_IGNORES(Xapian, MatchProfile)
+%include <xapian/matchprofile.h>
+
 STANDARD_IGNORES(Xapian, MSet)
 #ifdef SWIGJAVA
 // For compatibility with the original JNI wrappers.
@@ -421,12 +427,17 @@ INPUT_ITERATOR_METHODS(Xapian, LatLongCoordsIterator, LatLongCoord, get_coord)
 %ignore Xapian::LatLongCoord::operator<;
 %include <xapian/geospatial.h>
 
+STANDARD_IGNORES(Xapian, DatabaseStats)
+%include <xapian/databasestats.h>
+
 STANDARD_IGNORES(Xapian, Database)
 STANDARD_IGNORES(Xapian, WritableDatabase)
 %ignore Xapian::WritableDatabase::WritableDatabase(Database::Internal *);
 %ignore Xapian::Database::get_document_lazily_;
 %ignore Xapian::Database::check(const std::string &, int, std::ostream *);
 %ignore Xapian::Database::check(int fd, int, std::ostream *);
+/* We don't wrap std::vector<Xapian::Document>. */
+%ignore Xapian::WritableDatabase::add_documents;
 %include <xapian/database.h>
 %extend Xapian::Database {
     static size_t check(const std::string &path, int opts = 0) {
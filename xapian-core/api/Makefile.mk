@@ -1,10 +1,14 @@
 noinst_HEADERS +=\
+	api/buildertermlist.h\
+	api/databasestatsinternal.h\
 	api/documentterm.h\
+	api/documenttermbuilder.h\
 	api/documentvaluelist.h\
 	api/editdistance.h\
 	api/emptypostlist.h\
 	api/leafpostlist.h\
 	api/maptermlist.h\
+	api/matchprofileinternal.h\
 	api/omenquireinternal.h\
 	api/postlist.h\
 	api/queryinternal.h\
@@ -20,7 +24,9 @@ EXTRA_DIST +=\
 lib_src +=\
 	api/compactor.cc\
 	api/constinfo.cc\
+	api/databasestats.cc\
 	api/decvalwtsource.cc\
+	api/documenttermbuilder.cc\
 	api/documentvaluelist.cc\
 	api/editdistance.cc\
 	api/emptypostlist.cc\
@@ -29,6 +35,7 @@ lib_src +=\
 	api/expanddecider.cc\
 	api/keymaker.cc\
 	api/leafpostlist.cc\
+	api/matchprofile.cc\
 	api/matchspy.cc\
 	api/omdatabase.cc\
 	api/omdocument.cc\
@@ -0,0 +1,110 @@
+/** @file buildertermlist.h
+ * @brief Iterate the terms in a DocumentTermBuilder
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_BUILDERTERMLIST_H
+#define XAPIAN_INCLUDED_BUILDERTERMLIST_H
+
+#include "termlist.h"
+
+#include "api/documenttermbuilder.h"
+#include "backends/inmemory/inmemory_positionlist.h"
+
+#include "omassert.h"
+
+#include <vector>
+
+/// Iterate the terms in a DocumentTermBuilder (which must be sorted).
+class BuilderTermList : public TermList {
+    /// The terms to iterate.
+    const DocumentTermBuilder & builder;
+
+    /// Index of the current term in sorted order.
+    size_t i;
+
+    bool started;
+
+  public:
+    explicit BuilderTermList(const DocumentTermBuilder & builder_)
+	: builder(builder_), i(0), started(false) { }
+
+    Xapian::termcount get_approx_size() const {
+	return builder.size();
+    }
+
+    std::string get_termname() const {
+	Assert(started);
+	Assert(!at_end());
+	return builder.get_termname(i);
+    }
+
+    Xapian::termcount get_wdf() const {
+	Assert(started);
+	Assert(!at_end());
+	return builder.get_wdf(i);
+    }
+
+    Xapian::doccount get_termfreq() const {
+	throw Xapian::InvalidOperationError("Can't get term frequency from a document termlist which is not associated with a database.");
+    }
+
+    bool get_termpos_array(const Xapian::termpos *& begin,
+			   const Xapian::termpos *& end) const {
+	builder.get_positions(i, begin, end);
+	return true;
+    }
+
+    Xapian::PositionIterator positionlist_begin() const {
+	const Xapian::termpos * begin;
+	const Xapian::termpos * end;
+	builder.get_positions(i, begin, end);
+	std::vector<Xapian::termpos> positions(begin, end);
+	return Xapian::PositionIterator(new InMemoryPositionList(positions));
+    }
+
+    Xapian::termcount positionlist_count() const {
+	const Xapian::termpos * begin;
+	const Xapian::termpos * end;
+	builder.get_positions(i, begin, end);
+	return end - begin;
+    }
+
+    TermList * next() {
+	if (!started) {
+	    started = true;
+	} else {
+	    Assert(!at_end());
+	    ++i;
+	}
+	return NULL;
+    }
+
+    TermList * skip_to(const std::string & term) {
+	size_t j = builder.lower_bound(term);
+	if (j > i) i = j;
+	started = true;
+	return NULL;
+    }
+
+    bool at_end() const {
+	Assert(started);
+	return i == builder.size();
+    }
+};
+
+#endif // XAPIAN_INCLUDED_BUILDERTERMLIST_H
@@ -52,6 +52,7 @@
 
 #ifdef XAPIAN_HAS_GLASS_BACKEND
 #include "backends/glass/glass_database.h"
+#include "backends/glass/glass_segmented.h"
 #include "backends/glass/glass_version.h"
 #endif
 #ifdef XAPIAN_HAS_CHERT_BACKEND
@@ -202,6 +203,45 @@ Database::compact_(const string * output_ptr, int fd, unsigned flags,
 	flags |= DBCOMPACT_SINGLE_FILE;
     }
 
+#ifdef XAPIAN_HAS_GLASS_BACKEND
+    // A segmented glass database is compacted by compacting its segments.
+    for (const auto& it : internal) {
+	string srcdir;
+	if (it->get_backend_info(&srcdir) != BACKEND_GLASS_SEGMENTED)
+	    continue;
+	if (!compact_to_stub && srcdir == destdir)
+	    throw Xapian::InvalidArgumentError("destination may not be the same as any source database, unless it is a stub database");
+	Xapian::Database segments;
+	// Temporary databases holding the live documents of segmented
+	// databases with deleted or replaced documents.
+	vector<string> tmpdirs;
+	try {
+	    for (const auto& j : internal) {
+		if (j->get_backend_info(NULL) != BACKEND_GLASS_SEGMENTED) {
+		    segments.internal.push_back(j);
+		    continue;
+		}
+		auto db = static_cast<const GlassSegmentedDatabase *>(j.get());
+		string tmpdir = db->get_segment_databases(segments.internal);
+		if (!tmpdir.empty()) tmpdirs.push_back(tmpdir);
+	    }
+	    segments.compact_(output_ptr, fd, flags, block_size, compactor);
+	} catch (...) {
+	    segments.internal.clear();
+	    for (const auto& tmpdir : tmpdirs) {
+		removedir(tmpdir);
+	    }
+	    throw;
+	}
+	// Release the temporary databases before removing them.
+	segments.internal.clear();
+	for (const auto& tmpdir : tmpdirs) {
+	    removedir(tmpdir);
+	}
+	return;
+    }
+#endif
+
     int backend = BACKEND_UNKNOWN;
     for (const auto& it : internal) {
 	string srcdir;
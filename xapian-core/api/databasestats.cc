@@ -0,0 +1,130 @@
+/** @file databasestats.cc
+ * @brief Class holding counts of the I/O done by a database
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "xapian/databasestats.h"
+
+#include "api/databasestatsinternal.h"
+#include "str.h"
+
+using namespace std;
+
+TableCounts
+Xapian::DatabaseStats::Internal::get_counts(const string & table) const
+{
+    if (table.empty()) {
+	TableCounts total;
+	for (auto && i : tables) total += i.second;
+	return total;
+    }
+    auto i = tables.find(table);
+    if (i == tables.end()) return TableCounts();
+    return i->second;
+}
+
+namespace Xapian {
+
+DatabaseStats::DatabaseStats(const DatabaseStats & o) : internal(o.internal) { }
+
+DatabaseStats &
+DatabaseStats::operator=(const DatabaseStats & o)
+{
+    internal = o.internal;
+    return *this;
+}
+
+DatabaseStats::DatabaseStats() : internal(new DatabaseStats::Internal) { }
+
+DatabaseStats::DatabaseStats(Internal * internal_) : internal(internal_) { }
+
+DatabaseStats::~DatabaseStats() { }
+
+unsigned long long
+DatabaseStats::get_blocks_read(const string & table) const
+{
+    return internal->get_counts(table).blocks_read;
+}
+
+unsigned long long
+DatabaseStats::get_bytes_read(const string & table) const
+{
+    return internal->get_counts(table).bytes_read;
+}
+
+unsigned long long
+DatabaseStats::get_pread_calls(const string & table) const
+{
+    return internal->get_counts(table).pread_calls;
+}
+
+unsigned long long
+DatabaseStats::get_readahead_hints(const string & table) const
+{
+    return internal->get_counts(table).readahead_hints;
+}
+
+unsigned long long
+DatabaseStats::get_cursor_rebuilds(const string & table) const
+{
+    return internal->get_counts(table).cursor_rebuilds;
+}
+
+unsigned long long
+DatabaseStats::get_tags_inflated(const string & table) const
+{
+    return internal->get_counts(table).tags_inflated;
+}
+
+unsigned long long
+DatabaseStats::get_cache_hits(const string & table) const
+{
+    return internal->get_counts(table).cache_hits;
+}
+
+string
+DatabaseStats::get_description() const
+{
+    string desc = "Xapian::DatabaseStats(";
+    bool first = true;
+    for (auto && i : internal->tables) {
+	const TableCounts & counts = i.second;
+	if (!first) desc += ", ";
+	first = false;
+	desc += i.first;
+	desc += ": blocks_read=";
+	desc += str(counts.blocks_read);
+	desc += " bytes_read=";
+	desc += str(counts.bytes_read);
+	desc += " pread_calls=";
+	desc += str(counts.pread_calls);
+	desc += " readahead_hints=";
+	desc += str(counts.readahead_hints);
+	desc += " cursor_rebuilds=";
+	desc += str(counts.cursor_rebuilds);
+	desc += " tags_inflated=";
+	desc += str(counts.tags_inflated);
+	desc += " cache_hits=";
+	desc += str(counts.cache_hits);
+    }
+    desc += ')';
+    return desc;
+}
+
+}
@@ -0,0 +1,50 @@
+/** @file databasestatsinternal.h
+ * @brief Internals of Xapian::DatabaseStats
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_DATABASESTATSINTERNAL_H
+#define XAPIAN_INCLUDED_DATABASESTATSINTERNAL_H
+
+#include "xapian/databasestats.h"
+
+#include "backends/tablecounts.h"
+
+#include <map>
+#include <string>
+
+class Xapian::DatabaseStats::Internal : public Xapian::Internal::intrusive_base {
+    /// Don't allow assignment.
+    void operator=(const Internal &);
+
+    /// Don't allow copying.
+    Internal(const Internal &);
+
+  public:
+    /// Counts for the tables, keyed by table name.
+    std::map<std::string, TableCounts> tables;
+
+    Internal() { }
+
+    /** Return the counts for @a table.
+     *
+     *  If @a table is empty, return the total for all the tables.
+     */
+    TableCounts get_counts(const std::string & table) const;
+};
+
+#endif // XAPIAN_INCLUDED_DATABASESTATSINTERNAL_H
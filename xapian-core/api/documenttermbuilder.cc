@@ -0,0 +1,177 @@
+/** @file documenttermbuilder.cc
+ * @brief Accumulate the terms of a new document quickly
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "documenttermbuilder.h"
+
+#include "omassert.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+size_t
+DocumentTermBuilder::hash(const char * p, size_t len)
+{
+    // FNV-1a.
+    size_t h = 2166136261u;
+    while (len--) {
+	h ^= static_cast<unsigned char>(*p++);
+	h *= 16777619u;
+    }
+    return h;
+}
+
+void
+DocumentTermBuilder::grow_hash_table()
+{
+    size_t new_size = hash_table.empty() ? 64 : hash_table.size() * 2;
+    hash_table.assign(new_size, 0);
+    size_t mask = new_size - 1;
+    for (size_t i = 0; i != terms.size(); ++i) {
+	const Term & t = terms[i];
+	size_t slot = hash(names.data() + t.name_offset, t.name_len) & mask;
+	while (hash_table[slot]) slot = (slot + 1) & mask;
+	hash_table[slot] = i + 1;
+    }
+}
+
+DocumentTermBuilder::Term &
+DocumentTermBuilder::find_or_add(const string & tname)
+{
+    // Keep the table at most half full.
+    if (terms.size() * 2 >= hash_table.size()) grow_hash_table();
+
+    size_t mask = hash_table.size() - 1;
+    size_t slot = hash(tname.data(), tname.size()) & mask;
+    while (true) {
+	unsigned entry = hash_table[slot];
+	if (entry == 0) break;
+	Term & t = terms[entry - 1];
+	if (t.name_len == tname.size() &&
+	    memcmp(names.data() + t.name_offset, tname.data(), t.name_len) == 0) {
+	    return t;
+	}
+	slot = (slot + 1) & mask;
+    }
+
+    sorted = false;
+    hash_table[slot] = terms.size() + 1;
+    terms.push_back(Term(names.size(), tname.size()));
+    names += tname;
+    return terms.back();
+}
+
+bool
+DocumentTermBuilder::term_less(unsigned a, unsigned b) const
+{
+    const Term & ta = terms[a];
+    const Term & tb = terms[b];
+    int c = memcmp(names.data() + ta.name_offset,
+		   names.data() + tb.name_offset,
+		   min(ta.name_len, tb.name_len));
+    if (c) return c < 0;
+    return ta.name_len < tb.name_len;
+}
+
+void
+DocumentTermBuilder::clear()
+{
+    names.resize(0);
+    terms.clear();
+    hash_table.clear();
+    postings.clear();
+    order.clear();
+    positions.clear();
+    sorted = true;
+}
+
+void
+DocumentTermBuilder::sort()
+{
+    if (sorted && positions.size() == postings.size()) return;
+
+    order.resize(terms.size());
+    for (size_t i = 0; i != order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+	      [this](unsigned a, unsigned b) { return term_less(a, b); });
+
+    // Gather the positions of each term together with a counting sort, which
+    // keeps each term's positions in the order they were added.
+    for (Term & t : terms) t.pos_begin = t.pos_end = 0;
+    for (const auto & posting : postings) ++terms[posting.first].pos_end;
+    size_t offset = 0;
+    for (Term & t : terms) {
+	t.pos_begin = offset;
+	offset += t.pos_end;
+	t.pos_end = t.pos_begin;
+    }
+    positions.resize(postings.size());
+    for (const auto & posting : postings) {
+	positions[terms[posting.first].pos_end++] = posting.second;
+    }
+
+    // Positions are usually added in ascending order, but check and fix up
+    // any terms for which they weren't.
+    for (Term & t : terms) {
+	auto b = positions.begin() + t.pos_begin;
+	auto e = positions.begin() + t.pos_end;
+	if (adjacent_find(b, e, [](Xapian::termpos x, Xapian::termpos y) {
+		return x >= y;
+	    }) != e) {
+	    std::sort(b, e);
+	    // Leave any duplicates at the end of the term's range, which
+	    // nothing will look at.
+	    t.pos_end = unique(b, e) - positions.begin();
+	}
+    }
+
+    sorted = true;
+}
+
+void
+DocumentTermBuilder::move_to(map<string, OmDocumentTerm> & out)
+{
+    sort();
+    out.clear();
+    for (size_t i = 0; i != order.size(); ++i) {
+	const Term & t = terms[order[i]];
+	OmDocumentTerm term(t.wdf);
+	term.positions.assign(positions.begin() + t.pos_begin,
+			      positions.begin() + t.pos_end);
+	// The terms are in order, so each insert can go at the end.
+	out.insert(out.end(),
+		   make_pair(string(names, t.name_offset, t.name_len), term));
+    }
+    clear();
+}
+
+size_t
+DocumentTermBuilder::lower_bound(const string & tname) const
+{
+    Assert(sorted);
+    auto i = std::lower_bound(order.begin(), order.end(), tname,
+	[this](unsigned a, const string & b) {
+	    const Term & t = terms[a];
+	    return names.compare(t.name_offset, t.name_len, b) < 0;
+	});
+    return i - order.begin();
+}
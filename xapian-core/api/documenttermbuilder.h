@@ -0,0 +1,165 @@
+/** @file documenttermbuilder.h
+ * @brief Accumulate the terms of a new document quickly
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_DOCUMENTTERMBUILDER_H
+#define XAPIAN_INCLUDED_DOCUMENTTERMBUILDER_H
+
+#include "api/documentterm.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <xapian/types.h>
+
+/** Accumulate the terms of a new document quickly.
+ *
+ *  Indexing a document usually means adding a posting for each word in it,
+ *  and adding each to a map<string, OmDocumentTerm> means a tree search
+ *  per posting plus a node and a position vector allocated per term.
+ *
+ *  Instead we keep the term names one after another in a single string,
+ *  find them using an open-addressed hash table, and append the postings to
+ *  a single vector.  When the terms are needed in order, sort() sorts the
+ *  distinct terms once and gathers each term's positions together.
+ */
+class DocumentTermBuilder {
+    /// A distinct term.
+    struct Term {
+	/// Offset of the term name in names.
+	size_t name_offset;
+
+	/// Length of the term name.
+	size_t name_len;
+
+	/// The wdf of the term.
+	Xapian::termcount wdf;
+
+	/// Offset of the term's first position in positions (after sort()).
+	size_t pos_begin;
+
+	/// Offset after the term's last position in positions (after sort()).
+	size_t pos_end;
+
+	Term(size_t name_offset_, size_t name_len_)
+	    : name_offset(name_offset_), name_len(name_len_), wdf(0),
+	      pos_begin(0), pos_end(0) { }
+    };
+
+    /// The names of the terms, one after another.
+    std::string names;
+
+    /// The distinct terms, in the order first added.
+    std::vector<Term> terms;
+
+    /** Open-addressed hash table of the terms.
+     *
+     *  Each entry is an index into terms plus one, or 0 for an empty slot.
+     *  The size is always a power of two.
+     */
+    std::vector<unsigned> hash_table;
+
+    /// The postings added, as (index into terms, position), in order added.
+    std::vector<std::pair<unsigned, Xapian::termpos>> postings;
+
+    /// After sort(), indices into terms in ascending order of term name.
+    std::vector<unsigned> order;
+
+    /** After sort(), the positions of each term.
+     *
+     *  Each term's positions are in ascending order without duplicates.
+     */
+    std::vector<Xapian::termpos> positions;
+
+    /// Is order (and positions) up to date?
+    bool sorted;
+
+    /// Return the hash of a term name.
+    static size_t hash(const char * p, size_t len);
+
+    /// Find the entry for a term name, adding it if it isn't present.
+    Term & find_or_add(const std::string & tname);
+
+    /// Double the size of the hash table.
+    void grow_hash_table();
+
+    /// Does terms[a] sort before terms[b]?
+    bool term_less(unsigned a, unsigned b) const;
+
+  public:
+    DocumentTermBuilder() : sorted(true) { }
+
+    /// Add a posting (with position @a tpos) of term @a tname.
+    void add_posting(const std::string & tname, Xapian::termpos tpos,
+		     Xapian::termcount wdfinc) {
+	Term & t = find_or_add(tname);
+	t.wdf += wdfinc;
+	postings.push_back(std::make_pair(unsigned(&t - &terms[0]), tpos));
+    }
+
+    /// Add term @a tname without a position.
+    void add_term(const std::string & tname, Xapian::termcount wdfinc) {
+	Term & t = find_or_add(tname);
+	t.wdf += wdfinc;
+    }
+
+    /// Return true if there are no terms.
+    bool empty() const { return terms.empty(); }
+
+    /// Return the number of distinct terms.
+    size_t size() const { return terms.size(); }
+
+    /// Remove all the terms.
+    void clear();
+
+    /// Sort the terms and gather the positions for each.
+    void sort();
+
+    /** Move the terms to a map, leaving this object empty.
+     *
+     *  Any entries in @a out are replaced.
+     */
+    void move_to(std::map<std::string, OmDocumentTerm> & out);
+
+    /// Return the name of the @a i-th term in sorted order.
+    std::string get_termname(size_t i) const {
+	const Term & t = terms[order[i]];
+	return std::string(names, t.name_offset, t.name_len);
+    }
+
+    /// Return the wdf of the @a i-th term in sorted order.
+    Xapian::termcount get_wdf(size_t i) const {
+	return terms[order[i]].wdf;
+    }
+
+    /// Return the positions of the @a i-th term in sorted order.
+    void get_positions(size_t i,
+		       const Xapian::termpos *& begin,
+		       const Xapian::termpos *& end) const {
+	const Term & t = terms[order[i]];
+	begin = positions.data() + t.pos_begin;
+	end = positions.data() + t.pos_end;
+    }
+
+    /// Return the index of the first term in sorted order >= @a tname.
+    size_t lower_bound(const std::string & tname) const;
+};
+
+#endif // XAPIAN_INCLUDED_DOCUMENTTERMBUILDER_H
@@ -1,13 +1,14 @@
 /** @file editdistance.cc
  * @brief Edit distance calculation algorithm.
  *
- *  Based on that described in:
+ *  Based on the bit-parallel algorithm described in:
  *
- *  "An extension of Ukkonen's enhanced dynamic programming ASM algorithm"
- *  by Hal Berghel, University of Arkansas
- *  and David Roach, Acxiom Corporation
+ *  "A Bit-Vector Algorithm for Computing Levenshtein and Damerau Edit
+ *  Distances" by Heikki Hyyrö, Nordic Journal of Computing 10 (2003)
  *
- *  http://berghel.net/publications/asm/asm.php
+ *  which extends the algorithm in "A fast bit-vector algorithm for
+ *  approximate string matching based on dynamic programming" by Gene Myers,
+ *  Journal of the ACM 46 (1999) to handle transpositions.
  */
 /* Copyright (C) 2003 Richard Boulton
  * Copyright (C) 2007,2008,2009 Olly Betts
@@ -31,179 +32,233 @@
 
 #include "editdistance.h"
 
-#include "omassert.h"
-
 #include <algorithm>
-#include <cstdlib>
 
 using namespace std;
 
-template<class CHR>
-struct edist_seq {
-    edist_seq(const CHR * ptr_, int len_) : ptr(ptr_), len(len_) { }
-    const CHR * ptr;
-    int len;
-};
-
-template<class CHR>
-class edist_state {
-    /// Don't allow assignment.
-    void operator=(const edist_state &);
-
-    /// Don't allow copying.
-    edist_state(const edist_state &);
-
-    edist_seq<CHR> seq1;
-    edist_seq<CHR> seq2;
-
-    /* Array of f(k,p) values, where f(k,p) = the largest index i such that
-     * d(i,j) = p and d(i,j) is on diagonal k.
-     * ie: f(k,p) = largest i s.t. d(i,k+i) = p
-     * Where: d(i,j) = edit distance between substrings of length i and j.
-     */
-    int * fkp;
-    int fkp_cols;
-
-    /* Maximum possible edit distance (this is referred to as ZERO_K in
-     * the algorithm description by Berghel and Roach). */
-    int maxdist;
-
-    int calc_index(int k, int p) const {
-	return (k + maxdist) * fkp_cols + p + 1;
-    }
-
-  public:
-
-    edist_state(const CHR * ptr1, int len1, const CHR * ptr2, int len2);
-
-    ~edist_state();
-
-    int get_f_kp(int k, int p) const {
-	return fkp[calc_index(k, p)];
-    }
-
-    void set_f_kp(int k, int p, int val) {
-	fkp[calc_index(k, p)] = val;
-    }
-
-    bool is_transposed(int pos1, int pos2) const {
-	if (pos1 <= 0 || pos2 <= 0 || pos1 >= seq1.len || pos2 >= seq2.len) return false;
-	return (seq1.ptr[pos1 - 1] == seq2.ptr[pos2] &&
-		seq1.ptr[pos1] == seq2.ptr[pos2 - 1]);
+// Each column of the dynamic programming matrix is represented by the
+// differences between vertically adjacent cells, encoded as two bit vectors
+// VP and VN with one bit per target character (a bit set in VP means +1, in
+// VN means -1).  Each candidate character updates the column with a
+// constant number of bitwise operations per block, and we track the value of
+// the bottom cell, which is the edit distance for the prefix of the
+// candidate seen so far.
+
+EditDistanceCalculator::EditDistanceCalculator(const unsigned * ptr, int len)
+    : target_len(len),
+      nblocks(len ? (len + BLOCK_BITS - 1) / BLOCK_BITS : 1),
+      hash_bits(2)
+{
+    // Size the hash table to be at most half full.
+    while ((1 << hash_bits) < len * 2) ++hash_bits;
+    keys.resize(1u << hash_bits);
+    masks.resize((keys.size() + 1) * nblocks);
+    for (int i = 0; i != len; ++i) {
+	unsigned slot = find_slot(ptr[i]);
+	keys[slot] = ptr[i];
+	block_t bit = block_t(1) << (i % BLOCK_BITS);
+	masks[slot * nblocks + i / BLOCK_BITS] |= bit;
     }
+    if (nblocks > 1) state.resize(nblocks * 4);
+}
 
-    void edist_calc_f_kp(int k, int p);
-};
-
-template<class CHR>
-void edist_state<CHR>::edist_calc_f_kp(int k, int p)
+unsigned
+EditDistanceCalculator::find_slot(unsigned ch) const
 {
-    int maxlen = get_f_kp(k, p - 1) + 1; /* dist if do substitute */
-    int maxlen2 = get_f_kp(k - 1, p - 1); /* dist if do insert */
-    int maxlen3 = get_f_kp(k + 1, p - 1) + 1; /* dist if delete */
-
-    if (is_transposed(maxlen, maxlen + k)) {
-	// Transposition.
-	++maxlen;
+    // Fibonacci hashing, with linear probing.
+    unsigned mask = (1u << hash_bits) - 1;
+    unsigned slot = (uint32_t(ch) * 0x9e3779b1u) >> (32 - hash_bits);
+    while (true) {
+	const block_t * m = &masks[slot * nblocks];
+	bool used = false;
+	for (int b = 0; b != nblocks; ++b) {
+	    if (m[b]) {
+		used = true;
+		break;
+	    }
+	}
+	if (!used || keys[slot] == ch) return slot;
+	slot = (slot + 1) & mask;
     }
+}
 
-    if (maxlen >= maxlen2) {
-	if (maxlen >= maxlen3) {
-	    // Transposition or Substitution.
-	} else {
-	    // Deletion.
-	    maxlen = maxlen3;
-	}
-    } else {
-	if (maxlen2 >= maxlen3) {
-	    // Insertion.
-	    maxlen = maxlen2;
-	} else {
-	    // Deletion.
-	    maxlen = maxlen3;
+inline const EditDistanceCalculator::block_t *
+EditDistanceCalculator::get_mask(unsigned ch) const
+{
+    unsigned mask = (1u << hash_bits) - 1;
+    unsigned slot = (uint32_t(ch) * 0x9e3779b1u) >> (32 - hash_bits);
+    if (nblocks == 1) {
+	while (true) {
+	    block_t m = masks[slot];
+	    if (m == 0) break;
+	    if (keys[slot] == ch) return &masks[slot];
+	    slot = (slot + 1) & mask;
 	}
+	return &masks[keys.size()];
     }
+    slot = find_slot(ch);
+    if (keys[slot] != ch) return &masks[keys.size() * nblocks];
+    return &masks[slot * nblocks];
+}
 
-    /* Check for exact matches, and increase the length until we don't have
-     * one. */
-    while (maxlen < seq1.len &&
-	   maxlen + k < seq2.len &&
-	   seq1.ptr[maxlen] == seq2.ptr[maxlen + k]) {
-	++maxlen;
+int
+EditDistanceCalculator::calc_single(const unsigned * ptr, int len,
+				    int max_distance) const
+{
+    const block_t top = block_t(1) << (target_len - 1);
+    block_t vp = ~block_t(0);
+    block_t vn = 0;
+    block_t d0 = 0;
+    block_t pm_prev = 0;
+    int score = target_len;
+    for (int j = 0; j != len; ++j) {
+	block_t pm = *get_mask(ptr[j]);
+	// Positions where a transposition gives a diagonal zero difference.
+	block_t tr = ((~d0 & pm) << 1) & pm_prev;
+	d0 = (((pm & vp) + vp) ^ vp) | pm | vn | tr;
+	block_t hp = vn | ~(d0 | vp);
+	block_t hn = d0 & vp;
+	if (hp & top) {
+	    ++score;
+	} else if (hn & top) {
+	    --score;
+	}
+	// Each remaining character can reduce the score by at most one.
+	int lower_bound = score - (len - 1 - j);
+	if (lower_bound > max_distance) return lower_bound;
+	block_t x = (hp << 1) | 1;
+	vn = x & d0;
+	vp = (hn << 1) | ~(x | d0);
+	pm_prev = pm;
     }
-    set_f_kp(k, p, maxlen);
+    return score;
 }
 
-#define INF 1000000
-template<class CHR>
-edist_state<CHR>::edist_state(const CHR * ptr1, int len1,
-			      const CHR * ptr2, int len2)
-    : seq1(ptr1, len1), seq2(ptr2, len2), maxdist(len2)
+int
+EditDistanceCalculator::calc_blocked(const unsigned * ptr, int len,
+				     int max_distance) const
 {
-    Assert(len2 >= len1);
-    /* Each row represents a value of k, from -maxdist to maxdist. */
-    int fkp_rows = maxdist * 2 + 1;
-    /* Each column represents a value of p, from -1 to maxdist. */
-    fkp_cols = maxdist + 2;
-    /* fkp is stored as a rectangular array, row by row. */
-    fkp = new int[fkp_rows * fkp_cols];
-
-    for (int k = -maxdist; k <= maxdist; k++) {
-	for (int p = -1; p <= maxdist; p++) {
-	    if (p == abs(k) - 1) {
-		if (k < 0) {
-		    set_f_kp(k, p, abs(k) - 1);
-		} else {
-		    set_f_kp(k, p, -1);
+    // This is the same as calc_single(), but treating the blocks as a single
+    // wide integer, so we need to propagate the carries from additions and
+    // left shifts from each block to the next.
+    block_t * vp = &state[0];
+    block_t * vn = vp + nblocks;
+    block_t * d0 = vn + nblocks;
+    block_t * pm_prev = d0 + nblocks;
+    for (int b = 0; b != nblocks; ++b) {
+	vp[b] = ~block_t(0);
+	vn[b] = d0[b] = pm_prev[b] = 0;
+    }
+
+    const int last = nblocks - 1;
+    const block_t top = block_t(1) << ((target_len - 1) % BLOCK_BITS);
+    int score = target_len;
+    for (int j = 0; j != len; ++j) {
+	const block_t * pm = get_mask(ptr[j]);
+	block_t add_carry = 0;
+	block_t tr_carry = 0;
+	block_t hp_carry = 1;
+	block_t hn_carry = 0;
+	for (int b = 0; b != nblocks; ++b) {
+	    block_t t = ~d0[b] & pm[b];
+	    block_t tr = ((t << 1) | tr_carry) & pm_prev[b];
+	    tr_carry = t >> (BLOCK_BITS - 1);
+
+	    block_t a = pm[b] & vp[b];
+	    block_t sum = a + vp[b];
+	    block_t carry = (sum < a);
+	    sum += add_carry;
+	    carry |= (sum < add_carry);
+	    add_carry = carry;
+
+	    block_t d = (sum ^ vp[b]) | pm[b] | vn[b] | tr;
+	    block_t hp = vn[b] | ~(d | vp[b]);
+	    block_t hn = d & vp[b];
+	    if (b == last) {
+		if (hp & top) {
+		    ++score;
+		} else if (hn & top) {
+		    --score;
 		}
-	    } else if (p < abs(k)) {
-		set_f_kp(k, p, -INF);
 	    }
+	    block_t x = (hp << 1) | hp_carry;
+	    hp_carry = hp >> (BLOCK_BITS - 1);
+	    vn[b] = x & d;
+	    vp[b] = ((hn << 1) | hn_carry) | ~(x | d);
+	    hn_carry = hn >> (BLOCK_BITS - 1);
+	    d0[b] = d;
+	    pm_prev[b] = pm[b];
 	}
+	int lower_bound = score - (len - 1 - j);
+	if (lower_bound > max_distance) return lower_bound;
     }
+    return score;
 }
 
-template<class CHR>
-edist_state<CHR>::~edist_state() {
-    delete [] fkp;
+int
+EditDistanceCalculator::operator()(const unsigned * ptr, int len,
+				   int max_distance) const
+{
+    // The difference in lengths is a lower bound on the edit distance.
+    int lendiff = len - target_len;
+    if (lendiff < 0) lendiff = -lendiff;
+    if (lendiff > max_distance || target_len == 0 || len == 0)
+	return lendiff;
+
+    if (nblocks == 1) return calc_single(ptr, len, max_distance);
+    return calc_blocked(ptr, len, max_distance);
 }
 
-template<class CHR>
-static int
-seqcmp_editdist(const CHR * ptr1, int len1, const CHR * ptr2, int len2,
-		int max_distance)
+EditDistanceAutomaton::EditDistanceAutomaton(const unsigned * ptr, int len,
+					     int max_distance_)
+    : target(ptr, ptr + len), max_distance(max_distance_)
 {
-    int lendiff = len2 - len1;
-    /* Make sure second sequence is longer (or same length). */
-    if (lendiff < 0) {
-	lendiff = -lendiff;
-	swap(ptr1, ptr2);
-	swap(len1, len2);
+    // Once more than len + max_distance + 1 characters have been fed in,
+    // no extension can be close enough to the target, so that's the most
+    // columns we need.
+    size_t max_columns = len + max_distance + 2;
+    chars.reserve(max_columns);
+    columns.resize(max_columns * (len + 1));
+    column_min.resize(max_columns);
+    for (int i = 0; i <= len; ++i) {
+	columns[i] = i;
     }
+    column_min[0] = 0;
+}
 
-    /* Special case for if one or both sequences are empty. */
-    if (len1 == 0) return len2;
-
-    edist_state<CHR> state(ptr1, len1, ptr2, len2);
-
-    int p = lendiff; /* This is the minimum possible edit distance. */
-    while (p <= max_distance) {
-	for (int temp_p = 0; temp_p != p; ++temp_p) {
-	    int inc = p - temp_p;
-	    if (abs(lendiff - inc) <= temp_p) {
-		state.edist_calc_f_kp(lendiff - inc, temp_p);
-	    }
-	    if (abs(lendiff + inc) <= temp_p) {
-		state.edist_calc_f_kp(lendiff + inc, temp_p);
-	    }
+bool
+EditDistanceAutomaton::push(unsigned ch)
+{
+    const size_t m = target.size();
+    const size_t j = chars.size() + 1;
+    if (j * (m + 1) >= columns.size()) return false;
+
+    int * col = &columns[j * (m + 1)];
+    const int * prev = col - (m + 1);
+    const int * prev2 = (j > 1) ? prev - (m + 1) : NULL;
+    col[0] = int(j);
+    int min_val = col[0];
+    for (size_t i = 1; i <= m; ++i) {
+	int v = prev[i - 1] + (target[i - 1] != ch);
+	v = min(v, min(prev[i], col[i - 1]) + 1);
+	if (prev2 && i > 1 &&
+	    target[i - 1] == chars[j - 2] && target[i - 2] == ch) {
+	    // Transposition.
+	    v = min(v, prev2[i - 2] + 1);
 	}
-	state.edist_calc_f_kp(lendiff, p);
-
-	if (state.get_f_kp(lendiff, p) == len1) break;
-	++p;
+	col[i] = v;
+	min_val = min(min_val, v);
     }
 
-    return p;
+    // Every alignment passes through column j, or jumps over it with a
+    // transposition from column j - 1, so if both of these are entirely
+    // greater than the maximum distance, so is every extension.
+    if (min_val > max_distance && column_min[j - 1] > max_distance)
+	return false;
+
+    column_min[j] = min_val;
+    chars.push_back(ch);
+    return true;
 }
 
 int
@@ -211,5 +266,12 @@ edit_distance_unsigned(const unsigned * ptr1, int len1,
 		       const unsigned * ptr2, int len2,
 		       int max_distance)
 {
-    return seqcmp_editdist<unsigned>(ptr1, len1, ptr2, len2, max_distance);
+    // The distance is symmetric, so use the shorter sequence as the target
+    // to minimise the number of blocks needed.
+    if (len1 > len2) {
+	swap(ptr1, ptr2);
+	swap(len1, len2);
+    }
+    EditDistanceCalculator edcalc(ptr1, len1);
+    return edcalc(ptr2, len2, max_distance);
 }
@@ -22,7 +22,11 @@
 #ifndef XAPIAN_INCLUDED_EDITDISTANCE_H
 #define XAPIAN_INCLUDED_EDITDISTANCE_H
 
-/** Calculate the edit distance between two sequences.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Calculate edit distances to a target sequence.
  *
  *  Edit distance is defined as the minimum number of edit operations
  *  required to move from one sequence to another.  The edit operations
@@ -33,15 +37,163 @@
  *   - Transposition of two neighbouring characters at an arbitrary position
  *     in the string.
  *
+ *  The work which depends only on the target is done once by the
+ *  constructor, so this is intended to be used to compare a target with many
+ *  candidates.  Comparing with a candidate doesn't allocate any memory.
+ *
+ *  An object of this class must not be used by more than one thread at
+ *  once.
+ */
+class EditDistanceCalculator {
+    /// Type used for blocks of the bit vectors.
+    typedef uint64_t block_t;
+
+    /// Number of bits in each block.
+    static const int BLOCK_BITS = 64;
+
+    /// Length of the target.
+    int target_len;
+
+    /// Number of blocks needed to hold one bit per target character.
+    int nblocks;
+
+    /// log2 of the number of slots in the hash table.
+    int hash_bits;
+
+    /** Hash table keys - the distinct characters in the target.
+     *
+     *  A slot is unused if all its bit vector blocks are zero, since any
+     *  character which occurs in the target has at least one bit set.
+     */
+    std::vector<unsigned> keys;
+
+    /** Bit vectors for each slot in the hash table.
+     *
+     *  Bit i of the vector for character c is set if target[i] == c.  Each
+     *  vector takes nblocks entries, and there's an extra all zero vector at
+     *  the end which is returned for characters not in the target.
+     */
+    std::vector<block_t> masks;
+
+    /// State for the blocked version of the algorithm.
+    mutable std::vector<block_t> state;
+
+    /// Find the slot in the hash table for character @a ch.
+    unsigned find_slot(unsigned ch) const;
+
+    /// Return the bit vector for character @a ch.
+    const block_t * get_mask(unsigned ch) const;
+
+    /// Calculate the edit distance when the target fits in a single block.
+    int calc_single(const unsigned * ptr, int len, int max_distance) const;
+
+    /// Calculate the edit distance when the target needs several blocks.
+    int calc_blocked(const unsigned * ptr, int len, int max_distance) const;
+
+  public:
+    /** Constructor.
+     *
+     *  @param ptr	A pointer to the start of the target sequence.
+     *  @param len	The length of the target sequence.
+     */
+    EditDistanceCalculator(const unsigned * ptr, int len);
+
+    /** Calculate the edit distance from a sequence to the target.
+     *
+     *  @param ptr A pointer to the start of the sequence.
+     *  @param len The length of the sequence.
+     *  @param max_distance The greatest edit distance that's interesting to us.
+     *			If the true edit distance is > max_distance, any
+     *			value > max_distance may be returned instead (which
+     *			allows the edit distance algorithm to avoid work for
+     *			poor matches).
+     *
+     *  @return The edit distance from the sequence to the target.
+     */
+    int operator()(const unsigned * ptr, int len, int max_distance) const;
+};
+
+/** Incrementally match sequences against a target within an edit distance.
+ *
+ *  Characters of a candidate are fed in one at a time, and the state after
+ *  each is kept so that the candidate can be truncated and extended again.
+ *  This allows walking a sorted list of terms, reusing the work for the
+ *  prefix each term shares with the previous one, and spotting when no
+ *  sequence starting with the current prefix can be within the edit distance,
+ *  so all such terms can be skipped.
+ *
+ *  This is a simulation of a Levenshtein automaton for the target, with each
+ *  state represented by a column of the dynamic programming matrix.
+ */
+class EditDistanceAutomaton {
+    /// The target sequence.
+    std::vector<unsigned> target;
+
+    /// The maximum edit distance of interest.
+    int max_distance;
+
+    /// The characters fed in so far.
+    std::vector<unsigned> chars;
+
+    /** Columns of the dynamic programming matrix.
+     *
+     *  Column j holds the edit distances between each prefix of the target
+     *  and the first j characters fed in.
+     */
+    std::vector<int> columns;
+
+    /// The smallest value in each column.
+    std::vector<int> column_min;
+
+  public:
+    /** Constructor.
+     *
+     *  @param ptr		A pointer to the start of the target sequence.
+     *  @param len		The length of the target sequence.
+     *  @param max_distance_	The maximum edit distance of interest.
+     */
+    EditDistanceAutomaton(const unsigned * ptr, int len, int max_distance_);
+
+    /// The number of characters fed in.
+    size_t size() const { return chars.size(); }
+
+    /// Discard all but the first @a n characters fed in.
+    void truncate(size_t n) {
+	if (n < chars.size()) chars.resize(n);
+    }
+
+    /** Feed in another character.
+     *
+     *  @return	true if the character was added; false if no sequence
+     *		starting with the characters fed in followed by @a ch can be
+     *		within the maximum edit distance of the target (in which case
+     *		the state is unchanged).
+     */
+    bool push(unsigned ch);
+
+    /** The edit distance between the characters fed in and the target.
+     *
+     *  If this is more than the maximum edit distance given to the
+     *  constructor, the characters aren't a match (but some longer sequence
+     *  starting with them may be).
+     */
+    int get_distance() const {
+	return columns[chars.size() * (target.size() + 1) + target.size()];
+    }
+};
+
+/** Calculate the edit distance between two sequences.
+ *
+ *  This is a convenience wrapper around EditDistanceCalculator - if you're
+ *  comparing one sequence with many others, use that directly.
+ *
  *  @param ptr1 A pointer to the start of the first sequence.
  *  @param len1 The length of the first sequence.
  *  @param ptr2 A pointer to the start of the second sequence.
- *  @param len2 The length of the first sequence.
+ *  @param len2 The length of the second sequence.
  *  @param max_distance The greatest edit distance that's interesting to us.
  *			If the true edit distance is > max_distance, any
- *			value > max_distance may be returned instead (which
- *			allows the edit distance algorithm to avoid work for
- *			poor matces).
+ *			value > max_distance may be returned instead.
  *
  *  @return The edit distance from one item to the other.
  */
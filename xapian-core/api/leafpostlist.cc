@@ -32,6 +32,7 @@ using namespace std;
 LeafPostList::~LeafPostList()
 {
     delete weight;
+    if (profile) profile->add_leaf_counts(term, counts);
 }
 
 Xapian::doccount
@@ -72,6 +73,7 @@ double
 LeafPostList::get_weight() const
 {
     if (!weight) return 0;
+    ++counts.weight_calls;
     Xapian::termcount doclen = 0, unique_terms = 0;
     // Fetching the document length and number of unique terms is work we can
     // avoid if the weighting scheme doesn't use them.
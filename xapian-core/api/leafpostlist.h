@@ -24,6 +24,8 @@
 
 #include "postlist.h"
 
+#include "api/matchprofileinternal.h"
+
 #include <string>
 
 namespace Xapian {
@@ -50,14 +52,29 @@ class LeafPostList : public PostList {
     /// The term name for this postlist (empty for an alldocs postlist).
     std::string term;
 
+    /// Counts of the work done, reported to profile when we're destroyed.
+    mutable PostListCounts counts;
+
+    /// The profile of the match we're part of, or NULL if not profiling.
+    Xapian::MatchProfile::Internal * profile;
+
     /// Only constructable as a base class for derived classes.
     explicit LeafPostList(const std::string & term_)
 	: weight(0), need_doclength(false), need_unique_terms(false),
-	  term(term_) { }
+	  term(term_), profile(NULL) { }
 
   public:
     ~LeafPostList();
 
+    /** Report counts of our work to @a profile_ when we're destroyed.
+     *
+     *  @a profile_ must remain valid until this object is destroyed.
+     *  Subclasses which wrap other leaf postlists should pass it on to them.
+     */
+    virtual void set_profile(Xapian::MatchProfile::Internal * profile_) {
+	profile = profile_;
+    }
+
     /** Set the weighting scheme to use during matching.
      *
      *  If this isn't called, get_weight() and get_maxweight() will both
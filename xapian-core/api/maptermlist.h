@@ -70,8 +70,12 @@ class MapTermList : public TermList {
 	    throw Xapian::InvalidOperationError("Can't get term frequency from a document termlist which is not associated with a database.");
 	}
 
-	const std::vector<Xapian::termpos> * get_vector_termpos() const {
-	    return &(it->second.positions);
+	bool get_termpos_array(const Xapian::termpos *& begin,
+			       const Xapian::termpos *& end) const {
+	    const std::vector<Xapian::termpos> & positions = it->second.positions;
+	    begin = positions.data();
+	    end = begin + positions.size();
+	    return true;
 	}
 
 	Xapian::PositionIterator positionlist_begin() const {
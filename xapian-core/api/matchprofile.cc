@@ -0,0 +1,236 @@
+/** @file matchprofile.cc
+ * @brief Class describing the work done to run a query
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "xapian/matchprofile.h"
+
+#include "api/matchprofileinternal.h"
+#include "str.h"
+#include "vectortermlist.h"
+#include "unicode/description_append.h"
+
+#include <vector>
+
+using namespace std;
+
+namespace Xapian {
+
+MatchProfile::MatchProfile(const MatchProfile & o) : internal(o.internal) { }
+
+MatchProfile &
+MatchProfile::operator=(const MatchProfile & o)
+{
+    internal = o.internal;
+    return *this;
+}
+
+MatchProfile::MatchProfile() : internal(new MatchProfile::Internal) { }
+
+MatchProfile::MatchProfile(Internal * internal_) : internal(internal_) { }
+
+MatchProfile::~MatchProfile() { }
+
+double
+MatchProfile::get_total_time() const
+{
+    return internal->total_time;
+}
+
+double
+MatchProfile::get_build_time() const
+{
+    return internal->build_time;
+}
+
+double
+MatchProfile::get_match_time() const
+{
+    return internal->match_time;
+}
+
+double
+MatchProfile::get_weight_time() const
+{
+    return internal->weight_time;
+}
+
+double
+MatchProfile::get_collapse_time() const
+{
+    return internal->collapse_time;
+}
+
+double
+MatchProfile::get_sort_time() const
+{
+    return internal->sort_time;
+}
+
+Xapian::doccount
+MatchProfile::get_docs_considered() const
+{
+    return internal->docs_considered;
+}
+
+unsigned long long
+MatchProfile::get_next_calls() const
+{
+    unsigned long long result = 0;
+    for (auto && i : internal->leaves) result += i.second.next_calls;
+    return result;
+}
+
+unsigned long long
+MatchProfile::get_skip_to_calls() const
+{
+    unsigned long long result = 0;
+    for (auto && i : internal->leaves) result += i.second.skip_to_calls;
+    return result;
+}
+
+unsigned long long
+MatchProfile::get_postings_decoded() const
+{
+    unsigned long long result = 0;
+    for (auto && i : internal->leaves) result += i.second.postings_decoded;
+    return result;
+}
+
+unsigned long long
+MatchProfile::get_weight_calls() const
+{
+    unsigned long long result = 0;
+    for (auto && i : internal->leaves) result += i.second.weight_calls;
+    return result;
+}
+
+TermIterator
+MatchProfile::get_terms_begin() const
+{
+    vector<string> terms;
+    terms.reserve(internal->leaves.size());
+    for (auto && i : internal->leaves) terms.push_back(i.first);
+    return TermIterator(new VectorTermList(terms.begin(), terms.end()));
+}
+
+unsigned long long
+MatchProfile::get_next_calls(const string & term) const
+{
+    auto i = internal->leaves.find(term);
+    if (i == internal->leaves.end()) return 0;
+    return i->second.next_calls;
+}
+
+unsigned long long
+MatchProfile::get_skip_to_calls(const string & term) const
+{
+    auto i = internal->leaves.find(term);
+    if (i == internal->leaves.end()) return 0;
+    return i->second.skip_to_calls;
+}
+
+unsigned long long
+MatchProfile::get_postings_decoded(const string & term) const
+{
+    auto i = internal->leaves.find(term);
+    if (i == internal->leaves.end()) return 0;
+    return i->second.postings_decoded;
+}
+
+unsigned long long
+MatchProfile::get_weight_calls(const string & term) const
+{
+    auto i = internal->leaves.find(term);
+    if (i == internal->leaves.end()) return 0;
+    return i->second.weight_calls;
+}
+
+unsigned long long
+MatchProfile::get_blocks_read(const string & table) const
+{
+    auto i = internal->tables.find(table);
+    if (i == internal->tables.end()) return 0;
+    return i->second.blocks_read;
+}
+
+unsigned long long
+MatchProfile::get_cache_hits(const string & table) const
+{
+    auto i = internal->tables.find(table);
+    if (i == internal->tables.end()) return 0;
+    return i->second.cache_hits;
+}
+
+string
+MatchProfile::get_postlist_tree() const
+{
+    return internal->postlist_tree;
+}
+
+string
+MatchProfile::get_description() const
+{
+    string desc = "Xapian::MatchProfile(total=";
+    desc += str(internal->total_time);
+    desc += ", build=";
+    desc += str(internal->build_time);
+    desc += ", match=";
+    desc += str(internal->match_time);
+    desc += ", weight=";
+    desc += str(internal->weight_time);
+    desc += ", collapse=";
+    desc += str(internal->collapse_time);
+    desc += ", sort=";
+    desc += str(internal->sort_time);
+    desc += ", docs_considered=";
+    desc += str(internal->docs_considered);
+    if (!internal->postlist_tree.empty()) {
+	desc += ", tree=(";
+	desc += internal->postlist_tree;
+	desc += ')';
+    }
+    for (auto && i : internal->leaves) {
+	const PostListCounts & counts = i.second;
+	desc += ", term ";
+	description_append(desc, i.first);
+	desc += ": next=";
+	desc += str(counts.next_calls);
+	desc += " skip_to=";
+	desc += str(counts.skip_to_calls);
+	desc += " decoded=";
+	desc += str(counts.postings_decoded);
+	desc += " weighted=";
+	desc += str(counts.weight_calls);
+    }
+    for (auto && i : internal->tables) {
+	const TableCounts & counts = i.second;
+	if (counts.blocks_read == 0 && counts.cache_hits == 0) continue;
+	desc += ", table ";
+	desc += i.first;
+	desc += ": blocks_read=";
+	desc += str(counts.blocks_read);
+	desc += " cache_hits=";
+	desc += str(counts.cache_hits);
+    }
+    desc += ')';
+    return desc;
+}
+
+}
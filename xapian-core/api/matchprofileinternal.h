@@ -0,0 +1,102 @@
+/** @file matchprofileinternal.h
+ * @brief Internals of Xapian::MatchProfile
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_MATCHPROFILEINTERNAL_H
+#define XAPIAN_INCLUDED_MATCHPROFILEINTERNAL_H
+
+#include "xapian/matchprofile.h"
+
+#include "backends/tablecounts.h"
+
+#include <map>
+#include <string>
+
+/// Counts of the work done by a leaf postlist.
+struct PostListCounts {
+    /// Number of calls to next().
+    unsigned long long next_calls;
+
+    /// Number of calls to skip_to().
+    unsigned long long skip_to_calls;
+
+    /// Number of postings decoded.
+    unsigned long long postings_decoded;
+
+    /// Number of calls to get_weight().
+    unsigned long long weight_calls;
+
+    PostListCounts()
+	: next_calls(0), skip_to_calls(0), postings_decoded(0),
+	  weight_calls(0) { }
+
+    PostListCounts & operator+=(const PostListCounts & o) {
+	next_calls += o.next_calls;
+	skip_to_calls += o.skip_to_calls;
+	postings_decoded += o.postings_decoded;
+	weight_calls += o.weight_calls;
+	return *this;
+    }
+};
+
+class Xapian::MatchProfile::Internal : public Xapian::Internal::intrusive_base {
+    /// Don't allow assignment.
+    void operator=(const Internal &);
+
+    /// Don't allow copying.
+    Internal(const Internal &);
+
+  public:
+    double total_time;
+
+    double build_time;
+
+    double match_time;
+
+    double weight_time;
+
+    double collapse_time;
+
+    double sort_time;
+
+    Xapian::doccount docs_considered;
+
+    /** Counts for the leaf postlists, keyed by term.
+     *
+     *  The counts from every leaf postlist for a term are added together,
+     *  whichever subdatabase or part of the query it was for.
+     */
+    std::map<std::string, PostListCounts> leaves;
+
+    /// Counts for the tables, keyed by table name.
+    std::map<std::string, TableCounts> tables;
+
+    std::string postlist_tree;
+
+    Internal()
+	: total_time(0), build_time(0), match_time(0), weight_time(0),
+	  collapse_time(0), sort_time(0), docs_considered(0) { }
+
+    /// Add the counts from a leaf postlist for @a term.
+    void add_leaf_counts(const std::string & term,
+			 const PostListCounts & counts) {
+	leaves[term] += counts;
+    }
+};
+
+#endif // XAPIAN_INCLUDED_MATCHPROFILEINTERNAL_H
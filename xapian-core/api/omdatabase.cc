@@ -39,6 +39,7 @@
 #include "backends/multi/multi_termlist.h"
 #include "backends/multivaluelist.h"
 #include "backends/database.h"
+#include "api/databasestatsinternal.h"
 #include "editdistance.h"
 #include "expand/ortermlist.h"
 #include "noreturn.h"
@@ -581,6 +582,8 @@ Database::get_spelling_suggestion(const string &word,
 
     vector<unsigned> utf32_term;
 
+    EditDistanceCalculator edcalc(&utf32_word[0], int(utf32_word.size()));
+
     Xapian::termcount best = 1;
     string result;
     int edist_best = max_edit_distance;
@@ -625,11 +628,8 @@ Database::get_spelling_suggestion(const string &word,
 		continue;
 	    }
 
-	    int edist = edit_distance_unsigned(&utf32_term[0],
-					       int(utf32_term.size()),
-					       &utf32_word[0],
-					       int(utf32_word.size()),
-					       edist_best);
+	    int edist = edcalc(&utf32_term[0], int(utf32_term.size()),
+			       edist_best);
 	    LOGLINE(SPELLING, "Edit distance " << edist);
 
 	    if (edist <= edist_best) {
@@ -750,6 +750,17 @@ Database::get_uuid() const
     RETURN(uuid);
 }
 
+DatabaseStats
+Database::get_stats() const
+{
+    LOGCALL(API, DatabaseStats, "Database::get_stats", NO_ARGS);
+    DatabaseStats stats;
+    for (auto && subdb : internal) {
+	subdb->add_table_counts(stats.internal->tables);
+    }
+    RETURN(stats);
+}
+
 ///////////////////////////////////////////////////////////////////////////
 
 WritableDatabase::WritableDatabase() : Database()
@@ -792,6 +803,21 @@ WritableDatabase::commit()
 	internal[i]->commit();
 }
 
+bool
+WritableDatabase::compact_incrementally(unsigned flags, double max_io_rate)
+{
+    LOGCALL(API, bool, "WritableDatabase::compact_incrementally", flags | max_io_rate);
+    size_t n_dbs = internal.size();
+    if (rare(n_dbs == 0))
+	no_subdatabases();
+    bool more = false;
+    for (size_t i = 0; i != n_dbs; ++i) {
+	if (internal[i]->compact_incrementally(flags, max_io_rate))
+	    more = true;
+    }
+    RETURN(more);
+}
+
 void
 WritableDatabase::begin_transaction(bool flushed)
 {
@@ -849,6 +875,24 @@ WritableDatabase::add_document(const Document & document)
     RETURN(did);
 }
 
+Xapian::docid
+WritableDatabase::add_documents(const std::vector<Document> & docs)
+{
+    LOGCALL(API, Xapian::docid, "WritableDatabase::add_documents", docs.size());
+    size_t n_dbs = internal.size();
+    if (rare(n_dbs == 0))
+	no_subdatabases();
+    if (n_dbs == 1)
+	RETURN(internal[0]->add_documents(docs));
+
+    Xapian::docid first_did = 0;
+    for (const Document & document : docs) {
+	Xapian::docid did = add_document(document);
+	if (first_did == 0) first_did = did;
+    }
+    RETURN(first_did);
+}
+
 void
 WritableDatabase::delete_document(Xapian::docid did)
 {
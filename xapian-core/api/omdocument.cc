@@ -26,6 +26,7 @@
 #include <xapian/document.h>
 
 #include "backends/document.h"
+#include "buildertermlist.h"
 #include "documentvaluelist.h"
 #include "maptermlist.h"
 #include "net/serialise.h"
@@ -301,6 +302,10 @@ Xapian::Document::Internal::open_term_list() const
 {
     LOGCALL(DB, TermList *, "Document::Internal::open_term_list", NO_ARGS);
     if (terms_here) {
+	if (!term_builder.empty()) {
+	    term_builder.sort();
+	    RETURN(new BuilderTermList(term_builder));
+	}
 	RETURN(new MapTermList(terms.begin(), terms.end()));
     }
     if (!database.get()) RETURN(NULL);
@@ -347,6 +352,11 @@ Xapian::Document::Internal::add_posting(const string & tname, Xapian::termpos tp
     need_terms();
     positions_modified = true;
 
+    if (terms.empty()) {
+	term_builder.add_posting(tname, tpos, wdfinc);
+	return;
+    }
+
     map<string, OmDocumentTerm>::iterator i;
     i = terms.find(tname);
     if (i == terms.end()) {
@@ -364,6 +374,11 @@ Xapian::Document::Internal::add_term(const string & tname, Xapian::termcount wdf
 {
     need_terms();
 
+    if (terms.empty()) {
+	term_builder.add_term(tname, wdfinc);
+	return;
+    }
+
     map<string, OmDocumentTerm>::iterator i;
     i = terms.find(tname);
     if (i == terms.end()) {
@@ -379,7 +394,7 @@ Xapian::Document::Internal::remove_posting(const string & tname,
 					   Xapian::termpos tpos,
 					   Xapian::termcount wdfdec)	
 {
-    need_terms();
+    need_term_map();
 
     map<string, OmDocumentTerm>::iterator i;
     i = terms.find(tname);
@@ -396,7 +411,7 @@ Xapian::Document::Internal::remove_posting(const string & tname,
 void
 Xapian::Document::Internal::remove_term(const string & tname)
 {
-    need_terms();
+    need_term_map();
     map<string, OmDocumentTerm>::iterator i;
     i = terms.find(tname);
     if (i == terms.end()) {
@@ -412,6 +427,7 @@ void
 Xapian::Document::Internal::clear_terms()
 {
     terms.clear();
+    term_builder.clear();
     terms_here = true;
     // Assume there was a term with positions for now.
     // FIXME: may be worth checking...
@@ -427,7 +443,7 @@ Xapian::Document::Internal::termlist_count() const
 	need_terms();
     }
     Assert(terms_here);
-    return terms.size();
+    return terms.size() + term_builder.size();
 }
 
 void
@@ -449,6 +465,13 @@ Xapian::Document::Internal::need_terms() const
     terms_here = true;
 }
 
+void
+Xapian::Document::Internal::need_term_map() const
+{
+    need_terms();
+    if (!term_builder.empty()) term_builder.move_to(terms);
+}
+
 Xapian::valueno
 Xapian::Document::Internal::values_count() const
 {
@@ -480,7 +503,7 @@ Xapian::Document::Internal::get_description() const
     if (terms_here) {
 	if (data_here || values_here) desc += ", ";
 	desc += "terms[";
-	desc += str(terms.size());
+	desc += str(terms.size() + term_builder.size());
 	desc += ']';
     }
 
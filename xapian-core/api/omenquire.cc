@@ -41,6 +41,7 @@
 #include "matcher/multimatch.h"
 #include "omassert.h"
 #include "api/omenquireinternal.h"
+#include "realtime.h"
 #include "str.h"
 #include "weight/weightinternal.h"
 
@@ -285,6 +286,14 @@ MSet::get_max_attained() const
     return internal->max_attained;
 }
 
+MatchProfile
+MSet::get_profile() const
+{
+    Assert(internal.get() != 0);
+    if (!internal->profile.get()) return MatchProfile();
+    return MatchProfile(internal->profile.get());
+}
+
 string
 MSet::snippet(const string & text,
 	      size_t length,
@@ -299,6 +308,22 @@ MSet::snippet(const string & text,
 			     hi_start, hi_end, omit);
 }
 
+string
+MSet::snippet(const string & text,
+	      Xapian::docid did,
+	      Xapian::valueno offsets_slot,
+	      size_t length,
+	      const Xapian::Stem & stemmer,
+	      unsigned flags,
+	      const string & hi_start,
+	      const string & hi_end,
+	      const string & omit) const
+{
+    Assert(internal.get() != 0);
+    return internal->snippet(text, did, offsets_slot, length, stemmer, flags,
+			     hi_start, hi_end, omit);
+}
+
 Xapian::doccount
 MSet::size() const
 {
@@ -483,7 +508,7 @@ Enquire::Internal::Internal(const Database &db_)
   : db(db_), query(), collapse_key(Xapian::BAD_VALUENO), collapse_max(0),
     order(Enquire::ASCENDING), percent_cutoff(0), weight_cutoff(0),
     sort_key(Xapian::BAD_VALUENO), sort_by(REL), sort_value_forward(true),
-    sorter(), time_limit(0.0), weight(0),
+    sorter(), time_limit(0.0), profiling(false), weight(0),
     eweightname("trad"), expand_k(1.0)
 {
     if (db.internal.empty()) {
@@ -534,6 +559,17 @@ Enquire::Internal::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 	check_at_least = max(check_at_least, maxitems);
     }
 
+    Xapian::Internal::intrusive_ptr<MatchProfile::Internal> profile;
+    double start_time = 0.0;
+    map<string, TableCounts> counts_before;
+    if (profiling) {
+	profile = new MatchProfile::Internal;
+	start_time = RealTime::now();
+	for (auto && subdb : db.internal) {
+	    subdb->add_table_counts(counts_before);
+	}
+    }
+
     AutoPtr<Xapian::Weight::Internal> stats(new Xapian::Weight::Internal);
     ::MultiMatch match(db, query, qlen, rset,
 		       collapse_max, collapse_key,
@@ -541,7 +577,8 @@ Enquire::Internal::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 		       order, sort_key, sort_by, sort_value_forward,
 		       time_limit, *(stats.get()), weight, spies,
 		       (sorter.get() != NULL),
-		       (mdecider != NULL));
+		       (mdecider != NULL),
+		       profile.get());
     // Run query and put results into supplied Xapian::MSet object.
     MSet retval;
     match.get_mset(first, maxitems, check_at_least, retval,
@@ -562,6 +599,17 @@ Enquire::Internal::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 	retval.internal->stats = stats.release();
     }
 
+    if (profile.get()) {
+	for (auto && subdb : db.internal) {
+	    subdb->add_table_counts(profile->tables);
+	}
+	for (auto && i : counts_before) {
+	    profile->tables[i.first] -= i.second;
+	}
+	profile->total_time = RealTime::now() - start_time;
+	retval.internal->profile = profile;
+    }
+
     RETURN(retval);
 }
 
@@ -897,6 +945,12 @@ Enquire::set_time_limit(double time_limit)
     internal->time_limit = time_limit;
 }
 
+void
+Enquire::set_profiling(bool profiling)
+{
+    internal->profiling = profiling;
+}
+
 MSet
 Enquire::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 		  Xapian::doccount check_at_least, const RSet *rset,
@@ -37,6 +37,7 @@
 #include <map>
 #include <set>
 
+#include "api/matchprofileinternal.h"
 #include "weight/weightinternal.h"
 
 using namespace std;
@@ -153,6 +154,9 @@ class Enquire::Internal : public Xapian::Internal::intrusive_base {
 
 	double time_limit;
 
+	/// Should get_mset() gather a MatchProfile?
+	bool profiling;
+
 	/** The weight to use for this query.
 	 *
 	 *  This is mutable so that the default BM25Weight object can be
@@ -228,6 +232,9 @@ class MSet::Internal : public Xapian::Internal::intrusive_base {
 	/** Provides the term frequency and weight for each term in the query. */
 	Xapian::Weight::Internal * stats;
 
+	/// The profile of the match, or NULL if not profiled.
+	Xapian::Internal::intrusive_ptr<MatchProfile::Internal> profile;
+
 	/// A list of items comprising the (selected part of the) MSet.
 	vector<Xapian::Internal::MSetItem> items;
 
@@ -304,6 +311,16 @@ class MSet::Internal : public Xapian::Internal::intrusive_base {
 			    const std::string & hi_end,
 			    const std::string & omit) const;
 
+	std::string snippet(const std::string & text,
+			    Xapian::docid did,
+			    Xapian::valueno offsets_slot,
+			    size_t length,
+			    const Xapian::Stem & stemmer,
+			    unsigned flags,
+			    const std::string & hi_start,
+			    const std::string & hi_end,
+			    const std::string & omit) const;
+
 	/// Return a string describing this object.
 	string get_description() const;
 
@@ -110,16 +110,45 @@ Query::Query(op op_,
 	     op combiner)
 {
     LOGCALL_CTOR(API, "Query", op_ | pattern | max_expansion | max_type | combiner);
-    if (rare(op_ != OP_WILDCARD))
-	throw Xapian::InvalidArgumentError("op must be OP_WILDCARD");
     if (rare(combiner != OP_SYNONYM && combiner != OP_MAX && combiner != OP_OR))
 	throw Xapian::InvalidArgumentError("combiner must be OP_SYNONYM or OP_MAX or OP_OR");
+    if (op_ == OP_EDIT_DISTANCE) {
+	internal = new Xapian::Internal::QueryEditDistance(pattern,
+							   max_expansion,
+							   max_type,
+							   combiner,
+							   2, 0);
+	return;
+    }
+    if (rare(op_ != OP_WILDCARD))
+	throw Xapian::InvalidArgumentError("op must be OP_WILDCARD or OP_EDIT_DISTANCE");
     internal = new Xapian::Internal::QueryWildcard(pattern,
 						   max_expansion,
 						   max_type,
 						   combiner);
 }
 
+Query::Query(op op_,
+	     const std::string & target,
+	     Xapian::termcount max_expansion,
+	     int max_type,
+	     op combiner,
+	     unsigned edit_distance,
+	     size_t min_prefix_len)
+{
+    LOGCALL_CTOR(API, "Query", op_ | target | max_expansion | max_type | combiner | edit_distance | min_prefix_len);
+    if (rare(op_ != OP_EDIT_DISTANCE))
+	throw Xapian::InvalidArgumentError("op must be OP_EDIT_DISTANCE");
+    if (rare(combiner != OP_SYNONYM && combiner != OP_MAX && combiner != OP_OR))
+	throw Xapian::InvalidArgumentError("combiner must be OP_SYNONYM or OP_MAX or OP_OR");
+    internal = new Xapian::Internal::QueryEditDistance(target,
+						       max_expansion,
+						       max_type,
+						       combiner,
+						       edit_distance,
+						       min_prefix_len);
+}
+
 const TermIterator
 Query::get_terms_begin() const
 {
@@ -28,9 +28,11 @@
 #include "xapian/query.h"
 
 #include "matcher/const_database_wrapper.h"
+#include "editdistance.h"
 #include "leafpostlist.h"
 #include "matcher/andmaybepostlist.h"
 #include "matcher/andnotpostlist.h"
+#include "matcher/boolorpostlist.h"
 #include "emptypostlist.h"
 #include "matcher/exactphrasepostlist.h"
 #include "matcher/externalpostlist.h"
@@ -53,6 +55,8 @@
 #include "str.h"
 #include "unicode/description_append.h"
 
+#include <xapian/unicode.h>
+
 #include <algorithm>
 #include <functional>
 #include <list>
@@ -69,6 +73,9 @@ using Xapian::Internal::AndContext;
 using Xapian::Internal::OrContext;
 using Xapian::Internal::XorContext;
 
+/// Use block mode for an unweighted OR with at least this many subqueries.
+static const size_t BOOLOR_BLOCK_MIN_SUBQS = 8;
+
 namespace Xapian {
 
 namespace Internal {
@@ -163,6 +170,9 @@ class OrContext : public Context {
 
     PostList * postlist(QueryOptimiser* qopt);
     PostList * postlist_max(QueryOptimiser* qopt);
+
+    /// Build an OR postlist for when the weights aren't needed.
+    PostList * postlist_bool(QueryOptimiser* qopt);
 };
 
 void
@@ -275,6 +285,33 @@ OrContext::postlist_max(QueryOptimiser* qopt)
     return pl;
 }
 
+PostList *
+OrContext::postlist_bool(QueryOptimiser* qopt)
+{
+    Assert(!pls.empty());
+
+    if (pls.size() == 1) {
+	PostList * pl = pls[0];
+	pls.clear();
+	return pl;
+    }
+
+    // For a wide OR, gathering the postings a block of docids at a time
+    // means we only touch each sub-postlist once per block rather than
+    // once per posting, but for a narrow one the heap is cheap enough.
+    const Xapian::Database::Internal * db = NULL;
+    if (pls.size() >= BOOLOR_BLOCK_MIN_SUBQS)
+	db = &qopt->db;
+
+    PostList * pl;
+    pl = new BoolOrPostList(pls.begin(), pls.end(), qopt->matcher,
+			    qopt->db_size, db);
+
+    // Empty pls so our destructor doesn't delete them all!
+    pls.clear();
+    return pl;
+}
+
 class XorContext : public Context {
   public:
     explicit XorContext(size_t reserve) : Context(reserve) { }
@@ -563,6 +600,31 @@ Query::Internal::unserialise(const char ** p, const char * end,
 							       max_type,
 							       combiner);
 		}
+		case 0x10: { // Edit distance
+		    if (*p == end)
+			throw SerialisationError("not enough data");
+		    Xapian::termcount max_expansion;
+		    decode_length(p, end, max_expansion);
+		    if (end - *p < 2)
+			throw SerialisationError("not enough data");
+		    int max_type = static_cast<unsigned char>(*(*p)++);
+		    op combiner = static_cast<op>(*(*p)++);
+		    unsigned edit_distance;
+		    decode_length(p, end, edit_distance);
+		    size_t min_prefix_len;
+		    decode_length(p, end, min_prefix_len);
+		    size_t len;
+		    decode_length_and_check(p, end, len);
+		    string target(*p, len);
+		    *p += len;
+		    using Xapian::Internal::QueryEditDistance;
+		    return new QueryEditDistance(target,
+						 max_expansion,
+						 max_type,
+						 combiner,
+						 edit_distance,
+						 min_prefix_len);
+		}
 		case 0x0c: { // PostingSource
 		    size_t len;
 		    decode_length_and_check(p, end, len);
@@ -937,6 +999,107 @@ QueryValueGE::get_description() const
     return desc;
 }
 
+/** Combine the postlists for the terms a query expanded to.
+ *
+ *  This is shared by OP_WILDCARD and OP_EDIT_DISTANCE.
+ */
+static PostingIterator::Internal *
+combine_expansion(OrContext & ctx, QueryOptimiser * qopt, double factor,
+		  Query::op op, Xapian::termcount max_expansion, int max_type)
+{
+    if (max_type == Xapian::Query::WILDCARD_LIMIT_MOST_FREQUENT) {
+	// FIXME: open_lazy_post_list() results in the term getting registered
+	// for stats, so we still incur an avoidable cost from the full
+	// expansion size of the wildcard, which is most likely to be visible
+	// with the remote backend.  Perhaps we should split creating the lazy
+	// postlist from registering the term for stats.
+	if (ctx.size() > max_expansion)
+	    ctx.select_most_frequent(qopt, max_expansion);
+    }
+
+    if (factor != 0.0) {
+	if (op != Query::OP_SYNONYM) {
+	    qopt->set_total_subqs(qopt->get_total_subqs() + ctx.size());
+	} else {
+	    qopt->inc_total_subqs();
+	}
+    }
+
+    if (ctx.empty())
+	return new EmptyPostList;
+
+    if (op == Query::OP_MAX)
+	return ctx.postlist_max(qopt);
+
+    if (op == Query::OP_OR) {
+	if (factor == 0.0)
+	    return ctx.postlist_bool(qopt);
+	return ctx.postlist(qopt);
+    }
+
+    PostList * pl = ctx.postlist_bool(qopt);
+    if (factor == 0.0)
+	return pl;
+
+    // We build an OP_OR tree for OP_SYNONYM and then wrap it in a
+    // SynonymPostList, which supplies the weights.
+    return qopt->make_synonym_postlist(pl, factor);
+}
+
+/** Advance past the (UTF-8) character starting at position @a i in @a s.
+ *
+ *  Bytes which aren't valid UTF-8 are each treated as a character.
+ */
+static inline size_t
+next_char(const string & s, size_t i)
+{
+    if (static_cast<unsigned char>(s[i++]) >= 0xc0) {
+	while (i < s.size() && (static_cast<unsigned char>(s[i]) & 0xc0) == 0x80)
+	    ++i;
+    }
+    return i;
+}
+
+bool
+QueryWildcard::test_pattern(const string & term) const
+{
+    const int flags = max_type & Xapian::Query::WILDCARD_PATTERN_GLOB;
+    size_t p = 0, t = 0;
+    // Where to resume matching from if we need to make the most recent
+    // "*" match more characters.
+    size_t star_p = string::npos, star_t = 0;
+    while (t < term.size()) {
+	if (p < pattern.size()) {
+	    char ch = pattern[p];
+	    if (ch == '*' && (flags & Xapian::Query::WILDCARD_PATTERN_MULTI)) {
+		star_p = ++p;
+		star_t = t;
+		continue;
+	    }
+	    if (ch == '?' && (flags & Xapian::Query::WILDCARD_PATTERN_SINGLE)) {
+		++p;
+		t = next_char(term, t);
+		continue;
+	    }
+	    if (ch == term[t]) {
+		++p;
+		++t;
+		continue;
+	    }
+	}
+	if (star_p == string::npos) return false;
+	p = star_p;
+	star_t = next_char(term, star_t);
+	t = star_t;
+    }
+    // Any trailing "*" can match the empty string.
+    while (p < pattern.size() && pattern[p] == '*' &&
+	   (flags & Xapian::Query::WILDCARD_PATTERN_MULTI)) {
+	++p;
+    }
+    return p == pattern.size();
+}
+
 PostingIterator::Internal *
 QueryWildcard::postlist(QueryOptimiser * qopt, double factor) const
 {
@@ -950,8 +1113,41 @@ QueryWildcard::postlist(QueryOptimiser * qopt, double factor) const
     } else if (op != Query::OP_SYNONYM) {
 	or_factor = factor;
     }
+    const int limit_type = max_type & Xapian::Query::WILDCARD_LIMIT_MASK_;
+    const int flags = max_type & Xapian::Query::WILDCARD_PATTERN_GLOB;
+
+    AutoPtr<TermList> t;
+    if (!flags) {
+	t.reset(qopt->db.open_allterms(pattern));
+    } else {
+	// Split the pattern into the literal strings between the wildcard
+	// characters.
+	string wildcard_chars;
+	if (flags & Xapian::Query::WILDCARD_PATTERN_MULTI)
+	    wildcard_chars += '*';
+	if (flags & Xapian::Query::WILDCARD_PATTERN_SINGLE)
+	    wildcard_chars += '?';
+	size_t prefix_len = pattern.find_first_of(wildcard_chars);
+	if (prefix_len == string::npos) prefix_len = pattern.size();
+	string longest;
+	size_t i = prefix_len;
+	while (i < pattern.size()) {
+	    size_t start = i + 1;
+	    i = pattern.find_first_of(wildcard_chars, start);
+	    if (i == string::npos) i = pattern.size();
+	    if (i - start > longest.size())
+		longest.assign(pattern, start, i - start);
+	}
+	// Only terms containing all the literal strings can match, so if one
+	// is longer than the fixed prefix, ask the backend for the terms
+	// containing it - it may be able to avoid checking every term.
+	if (longest.size() > prefix_len)
+	    t.reset(qopt->db.open_substring_termlist(longest));
+	if (!t.get())
+	    t.reset(qopt->db.open_allterms(pattern.substr(0, prefix_len)));
+    }
+
     OrContext ctx(0);
-    AutoPtr<TermList> t(qopt->db.open_allterms(pattern));
     Xapian::termcount expansions_left = max_expansion;
     // If there's no expansion limit, set expansions_left to the maximum
     // value Xapian::termcount can hold.
@@ -961,54 +1157,27 @@ QueryWildcard::postlist(QueryOptimiser * qopt, double factor) const
 	t->next();
 	if (t->at_end())
 	    break;
-	if (max_type < Xapian::Query::WILDCARD_LIMIT_MOST_FREQUENT) {
+	const string & term = t->get_termname();
+	if (flags && !test_pattern(term))
+	    continue;
+	if (limit_type < Xapian::Query::WILDCARD_LIMIT_MOST_FREQUENT) {
 	    if (expansions_left-- == 0) {
-		if (max_type == Xapian::Query::WILDCARD_LIMIT_FIRST)
+		if (limit_type == Xapian::Query::WILDCARD_LIMIT_FIRST)
 		    break;
 		string msg("Wildcard ");
 		msg += pattern;
-		msg += "* expands to more than ";
+		if (!flags) msg += '*';
+		msg += " expands to more than ";
 		msg += str(max_expansion);
 		msg += " terms";
 		throw Xapian::WildcardError(msg);
 	    }
 	}
-	const string & term = t->get_termname();
 	ctx.add_postlist(qopt->open_lazy_post_list(term, 1, or_factor));
     }
 
-    if (max_type == Xapian::Query::WILDCARD_LIMIT_MOST_FREQUENT) {
-	// FIXME: open_lazy_post_list() results in the term getting registered
-	// for stats, so we still incur an avoidable cost from the full
-	// expansion size of the wildcard, which is most likely to be visible
-	// with the remote backend.  Perhaps we should split creating the lazy
-	// postlist from registering the term for stats.
-	if (ctx.size() > max_expansion)
-	    ctx.select_most_frequent(qopt, max_expansion);
-    }
-
-    if (factor != 0.0) {
-	if (op != Query::OP_SYNONYM) {
-	    qopt->set_total_subqs(qopt->get_total_subqs() + ctx.size());
-	} else {
-	    qopt->inc_total_subqs();
-	}
-    }
-
-    if (ctx.empty())
-	RETURN(new EmptyPostList);
-
-    if (op == Query::OP_MAX)
-	RETURN(ctx.postlist_max(qopt));
-
-    PostList * pl = ctx.postlist(qopt);
-    if (op == Query::OP_OR)
-	RETURN(pl);
-
-    // We build an OP_OR tree for OP_SYNONYM and then wrap it in a
-    // SynonymPostList, which supplies the weights.
-    PostingIterator::Internal * r = qopt->make_synonym_postlist(pl, factor);
-    RETURN(r);
+    RETURN(combine_expansion(ctx, qopt, factor, op, max_expansion,
+			     limit_type));
 }
 
 termcount
@@ -1060,6 +1229,183 @@ QueryWildcard::get_description() const
     return desc;
 }
 
+QueryEditDistance::QueryEditDistance(const string &target_,
+				     Xapian::termcount max_expansion_,
+				     int max_type_,
+				     Query::op combiner_,
+				     unsigned edit_distance_,
+				     size_t min_prefix_len_)
+    : target(target_),
+      max_expansion(max_expansion_),
+      max_type(max_type_),
+      combiner(combiner_),
+      edit_distance(edit_distance_),
+      min_prefix_len(min_prefix_len_)
+{
+    if (rare(edit_distance > MAX_EDIT_DISTANCE)) {
+	string msg("edit_distance must be at most ");
+	msg += str(MAX_EDIT_DISTANCE);
+	throw Xapian::InvalidArgumentError(msg);
+    }
+}
+
+PostingIterator::Internal *
+QueryEditDistance::postlist(QueryOptimiser * qopt, double factor) const
+{
+    LOGCALL(QUERY, PostingIterator::Internal *, "QueryEditDistance::postlist", qopt | factor);
+    Query::op op = combiner;
+    double or_factor = 0.0;
+    if (factor == 0.0) {
+	// If we have a factor of 0, we don't care about the weights, so
+	// we're just like a normal OR query.
+	op = Query::OP_OR;
+    } else if (op != Query::OP_SYNONYM) {
+	or_factor = factor;
+    }
+    const int limit_type = max_type & Xapian::Query::WILDCARD_LIMIT_MASK_;
+
+    // Terms must start with the first min_prefix_len characters of target.
+    Utf8Iterator u(target);
+    for (size_t i = 0; i != min_prefix_len && u != Utf8Iterator(); ++i) {
+	++u;
+    }
+    string prefix(target, 0, target.size() - u.left());
+
+    vector<unsigned> utf32_target((Utf8Iterator(target)), Utf8Iterator());
+    EditDistanceAutomaton automaton(utf32_target.data(),
+				    int(utf32_target.size()),
+				    int(edit_distance));
+    // Byte offset in the term of the end of each character fed to the
+    // automaton.
+    vector<size_t> char_ends(1, 0);
+
+    OrContext ctx(0);
+    AutoPtr<TermList> t(qopt->db.open_allterms(prefix));
+    Xapian::termcount expansions_left = max_expansion;
+    // If there's no expansion limit, set expansions_left to the maximum
+    // value Xapian::termcount can hold.
+    if (expansions_left == 0)
+	--expansions_left;
+    string prev_term;
+    t->next();
+    while (!t->at_end()) {
+	const string & term = t->get_termname();
+
+	// The terms are in sorted order, so reuse the automaton state for the
+	// characters this term shares with the previous one.
+	size_t common = 0;
+	size_t len = min(term.size(), prev_term.size());
+	while (common != len && term[common] == prev_term[common]) ++common;
+	size_t n = automaton.size();
+	while (char_ends[n] > common) --n;
+	automaton.truncate(n);
+	char_ends.resize(n + 1);
+
+	size_t dead_end = 0;
+	Utf8Iterator c(term.data() + char_ends[n], term.size() - char_ends[n]);
+	while (c != Utf8Iterator()) {
+	    unsigned ch = *c;
+	    ++c;
+	    size_t char_end = term.size() - c.left();
+	    if (!automaton.push(ch)) {
+		dead_end = char_end;
+		break;
+	    }
+	    char_ends.push_back(char_end);
+	}
+	prev_term = term;
+
+	if (dead_end) {
+	    // No term starting with term[0, dead_end) can match, so skip to
+	    // the first term after all of those.
+	    string next_term(term, 0, dead_end);
+	    while (!next_term.empty() && next_term.back() == '\xff')
+		next_term.resize(next_term.size() - 1);
+	    if (next_term.empty())
+		break;
+	    next_term.back() = char(static_cast<unsigned char>(next_term.back()) + 1);
+	    t->skip_to(next_term);
+	    continue;
+	}
+
+	if (automaton.get_distance() <= int(edit_distance)) {
+	    if (limit_type < Xapian::Query::WILDCARD_LIMIT_MOST_FREQUENT) {
+		if (expansions_left-- == 0) {
+		    if (limit_type == Xapian::Query::WILDCARD_LIMIT_FIRST)
+			break;
+		    string msg("Edit distance ");
+		    msg += str(edit_distance);
+		    msg += " expansion of ";
+		    msg += target;
+		    msg += " expands to more than ";
+		    msg += str(max_expansion);
+		    msg += " terms";
+		    throw Xapian::WildcardError(msg);
+		}
+	    }
+	    ctx.add_postlist(qopt->open_lazy_post_list(term, 1, or_factor));
+	}
+	t->next();
+    }
+
+    RETURN(combine_expansion(ctx, qopt, factor, op, max_expansion,
+			     limit_type));
+}
+
+termcount
+QueryEditDistance::get_length() const XAPIAN_NOEXCEPT
+{
+    // As for QueryWildcard, the expansion is one "virtual" term.
+    return 1;
+}
+
+void
+QueryEditDistance::serialise(string & result) const
+{
+    result += static_cast<char>(0x10);
+    result += encode_length(max_expansion);
+    result += static_cast<unsigned char>(max_type);
+    result += static_cast<unsigned char>(combiner);
+    result += encode_length(edit_distance);
+    result += encode_length(min_prefix_len);
+    result += encode_length(target.size());
+    result += target;
+}
+
+Query::op
+QueryEditDistance::get_type() const XAPIAN_NOEXCEPT
+{
+    return Query::OP_EDIT_DISTANCE;
+}
+
+string
+QueryEditDistance::get_description() const
+{
+    string desc = "EDIT_DISTANCE ";
+    switch (combiner) {
+	case Query::OP_SYNONYM:
+	    desc += "SYNONYM ";
+	    break;
+	case Query::OP_MAX:
+	    desc += "MAX ";
+	    break;
+	case Query::OP_OR:
+	    desc += "OR ";
+	    break;
+	default:
+	    desc += "BAD ";
+	    break;
+    }
+    description_append(desc, target);
+    desc += '~';
+    desc += str(edit_distance);
+    if (min_prefix_len) {
+	desc += " fixed:";
+	desc += str(min_prefix_len);
+    }
+    return desc;
+}
+
 Xapian::termcount
 QueryBranch::get_length() const XAPIAN_NOEXCEPT
 {
@@ -1198,7 +1544,7 @@ QueryBranch::do_synonym(QueryOptimiser * qopt, double factor) const
     LOGCALL(MATCH, PostList *, "QueryBranch::do_synonym", qopt | factor);
     OrContext ctx(subqueries.size());
     do_or_like(ctx, qopt, 0.0);
-    PostList * pl = ctx.postlist(qopt);
+    PostList * pl = ctx.postlist_bool(qopt);
     if (factor == 0.0) {
 	// If we have a factor of 0, we don't care about the weights, so
 	// we're just like a normal OR query.
@@ -1224,7 +1570,7 @@ QueryBranch::do_max(QueryOptimiser * qopt, double factor) const
     if (factor == 0.0) {
 	// If we have a factor of 0, we don't care about the weights, so
 	// we're just like a normal OR query.
-	RETURN(ctx.postlist(qopt));
+	RETURN(ctx.postlist_bool(qopt));
     }
 
     // We currently assume wqf is 1 for calculating the OP_MAX's weight
@@ -1498,6 +1844,8 @@ QueryOr::postlist(QueryOptimiser * qopt, double factor) const
     LOGCALL(QUERY, PostingIterator::Internal *, "QueryOr::postlist", qopt | factor);
     OrContext ctx(subqueries.size());
     do_or_like(ctx, qopt, factor);
+    if (factor == 0.0)
+	RETURN(ctx.postlist_bool(qopt));
     RETURN(ctx.postlist(qopt));
 }
 
@@ -1515,7 +1863,7 @@ QueryAndNot::postlist(QueryOptimiser * qopt, double factor) const
     AutoPtr<PostList> l(subqueries[0].internal->postlist(qopt, factor));
     OrContext ctx(subqueries.size() - 1);
     do_or_like(ctx, qopt, 0.0, 0, 1);
-    AutoPtr<PostList> r(ctx.postlist(qopt));
+    AutoPtr<PostList> r(ctx.postlist_bool(qopt));
     RETURN(new AndNotPostList(l.release(), r.release(),
 			      qopt->matcher, qopt->db_size));
 }
@@ -1620,6 +1968,8 @@ QueryEliteSet::postlist(QueryOptimiser * qopt, double factor) const
     LOGCALL(QUERY, PostingIterator::Internal *, "QueryEliteSet::postlist", qopt | factor);
     OrContext ctx(subqueries.size());
     do_or_like(ctx, qopt, factor, set_size);
+    if (factor == 0.0)
+	RETURN(ctx.postlist_bool(qopt));
     RETURN(ctx.postlist(qopt));
 }
 
@@ -1750,6 +2100,12 @@ QueryWildcard::get_op() const
     return Xapian::Query::OP_WILDCARD;
 }
 
+Xapian::Query::op
+QueryEditDistance::get_op() const
+{
+    return Xapian::Query::OP_EDIT_DISTANCE;
+}
+
 string
 QueryAnd::get_description() const
 {
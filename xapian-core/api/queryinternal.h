@@ -401,6 +401,12 @@ class QueryWildcard : public Query::Internal {
 
     Xapian::Query::op get_op() const;
 
+    /** Test if a term matches the pattern.
+     *
+     *  Only used if one of the WILDCARD_PATTERN_* flags is set.
+     */
+    bool test_pattern(const std::string & term) const;
+
   public:
     QueryWildcard(const std::string &pattern_,
 		  Xapian::termcount max_expansion_,
@@ -425,6 +431,51 @@ class QueryWildcard : public Query::Internal {
     std::string get_description() const;
 };
 
+class QueryEditDistance : public Query::Internal {
+    /** The largest edit distance we allow.
+     *
+     *  The automaton needs space proportional to the edit distance, and a
+     *  term can't be longer than this, so a larger distance can't be useful.
+     */
+    static const unsigned MAX_EDIT_DISTANCE = 255;
+
+    std::string target;
+
+    Xapian::termcount max_expansion;
+
+    int max_type;
+
+    Query::op combiner;
+
+    unsigned edit_distance;
+
+    size_t min_prefix_len;
+
+    Xapian::Query::op get_op() const;
+
+  public:
+    QueryEditDistance(const std::string &target_,
+		      Xapian::termcount max_expansion_,
+		      int max_type_,
+		      Query::op combiner_,
+		      unsigned edit_distance_,
+		      size_t min_prefix_len_);
+
+    Xapian::Query::op get_type() const XAPIAN_NOEXCEPT XAPIAN_PURE_FUNCTION;
+
+    const std::string & get_target() const { return target; }
+
+    unsigned get_edit_distance() const { return edit_distance; }
+
+    PostingIterator::Internal * postlist(QueryOptimiser * qopt, double factor) const;
+
+    termcount get_length() const XAPIAN_NOEXCEPT XAPIAN_PURE_FUNCTION;
+
+    void serialise(std::string & result) const;
+
+    std::string get_description() const;
+};
+
 class QueryInvalid : public Query::Internal {
   public:
     QueryInvalid() { }
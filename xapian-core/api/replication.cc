@@ -32,15 +32,21 @@
 #include "backends/database.h"
 #include "backends/databasereplicator.h"
 #include "debuglog.h"
+#include "fd.h"
 #include "filetests.h"
 #include "fileutils.h"
 #include "io_utils.h"
 #include "omassert.h"
+#include "posixy_wrapper.h"
 #include "realtime.h"
 #include "net/remoteconnection.h"
 #include "noreturn.h"
+#include "replicate_utils.h"
 #include "replicationprotocol.h"
+#include "safedirent.h"
 #include "safeerrno.h"
+#include "safefcntl.h"
+#include "safesysselect.h"
 #include "safesysstat.h"
 #include "safeunistd.h"
 #include "net/length.h"
@@ -48,8 +54,11 @@
 #include "unicode/description_append.h"
 
 #include "autoptr.h"
+#include <algorithm>
 #include <fstream>
+#include <set>
 #include <string>
+#include <vector>
 
 using namespace std;
 using namespace Xapian;
@@ -66,14 +75,73 @@ throw_connection_closed_unexpectedly()
 {
     throw Xapian::NetworkError("Connection closed unexpectedly");
 }
+
+/** Split a replica's revision string into the UUID and backend revision.
+ *
+ *  @param db		The master database.
+ *  @param start_revision	The replica's revision string.
+ *  @param[out] revision	The backend part of @a start_revision.
+ *
+ *  @return true if a copy of the whole database is needed because the
+ *	    replica is empty or of a different database.
+ */
+static bool
+parse_start_revision(const Database::Internal & db,
+		     const string & start_revision,
+		     string & revision)
+{
+    if (start_revision.empty()) return true;
+    const char * ptr = start_revision.data();
+    const char * end = ptr + start_revision.size();
+    size_t uuid_length;
+    decode_length_and_check(&ptr, end, uuid_length);
+    string request_uuid(ptr, uuid_length);
+    ptr += uuid_length;
+    revision.assign(ptr, end - ptr);
+    return request_uuid != db.get_uuid();
+}
 #endif
 
 void
 DatabaseMaster::write_changesets_to_fd(int fd,
 				       const string & start_revision,
-				       ReplicationInfo * info) const
+				       ReplicationInfo * info,
+				       const string & copy_info) const
+{
+    LOGCALL_VOID(REPLICA, "DatabaseMaster::write_changesets_to_fd", fd | start_revision | info | copy_info);
+    if (copy_info.empty()) {
+	write_to_fd(fd, start_revision, info, string());
+	return;
+    }
+    // Send all of the copy (if one is needed).
+    string buf = encode_length(0u);
+    buf += encode_length(0u);
+    buf += copy_info;
+    write_to_fd(fd, start_revision, info, buf);
+}
+
+void
+DatabaseMaster::write_copy_part_to_fd(int fd,
+				      const string & start_revision,
+				      const string & copy_info,
+				      unsigned part, unsigned nparts) const
+{
+    LOGCALL_VOID(REPLICA, "DatabaseMaster::write_copy_part_to_fd", fd | start_revision | copy_info | part | nparts);
+    if (part >= nparts) {
+	throw Xapian::InvalidArgumentError("part must be less than nparts");
+    }
+    string buf = encode_length(nparts);
+    buf += encode_length(part);
+    buf += copy_info;
+    write_to_fd(fd, start_revision, NULL, buf);
+}
+
+void
+DatabaseMaster::write_to_fd(int fd,
+			    const string & start_revision,
+			    ReplicationInfo * info,
+			    const string & copy_info) const
 {
-    LOGCALL_VOID(REPLICA, "DatabaseMaster::write_changesets_to_fd", fd | start_revision | info);
 #ifdef XAPIAN_HAS_REMOTE_BACKEND
     if (info != NULL)
 	info->clear();
@@ -92,29 +160,43 @@ DatabaseMaster::write_changesets_to_fd(int fd,
     }
 
     // Extract the UUID from start_revision and compare it to the database.
-    bool need_whole_db = false;
     string revision;
-    if (start_revision.empty()) {
-	need_whole_db = true;
-    } else {
-	const char * ptr = start_revision.data();
-	const char * end = ptr + start_revision.size();
-	size_t uuid_length;
-	decode_length_and_check(&ptr, end, uuid_length);
-	string request_uuid(ptr, uuid_length);
-	ptr += uuid_length;
-	string db_uuid = db.internal[0]->get_uuid();
-	if (request_uuid != db_uuid) {
-	    need_whole_db = true;
-	}
-	revision.assign(ptr, end - ptr);
-    }
+    bool need_whole_db = parse_start_revision(*db.internal[0], start_revision,
+					      revision);
 
-    db.internal[0]->write_changesets_to_fd(fd, revision, need_whole_db, info);
+    db.internal[0]->write_changesets_to_fd(fd, revision, need_whole_db, info,
+					   copy_info);
 #else
     (void)fd;
     (void)start_revision;
     (void)info;
+    (void)copy_info;
+    throw Xapian::FeatureUnavailableError("Replication requires remote backend to be enabled");
+#endif
+}
+
+bool
+DatabaseMaster::copy_needed(const string & start_revision) const
+{
+    LOGCALL(REPLICA, bool, "DatabaseMaster::copy_needed", start_revision);
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+    Database db;
+    try {
+	db = Database(path);
+    } catch (const Xapian::DatabaseError &) {
+	// write_changesets_to_fd() will report the problem.
+	RETURN(false);
+    }
+    if (db.internal.size() != 1) {
+	throw Xapian::InvalidOperationError("DatabaseMaster needs to be pointed at exactly one subdatabase");
+    }
+
+    string revision;
+    if (parse_start_revision(*db.internal[0], start_revision, revision))
+	RETURN(true);
+    RETURN(!db.internal[0]->changesets_available(revision));
+#else
+    (void)start_revision;
     throw Xapian::FeatureUnavailableError("Replication requires remote backend to be enabled");
 #endif
 }
@@ -181,6 +263,13 @@ class DatabaseReplica::Internal : public Xapian::Internal::intrusive_base {
     /// The remote connection we're using.
     RemoteConnection * conn;
 
+    /** Should a new offline copy start from the files of the live database?
+     *
+     *  Set by get_copy_info() if it returned checksums for the live database
+     *  (because there wasn't an offline copy to use).
+     */
+    mutable bool seed_from_live;
+
     /** Update the stub database which points to a single database.
      *
      *  The stub database file is created at a separate path, and then
@@ -192,6 +281,20 @@ class DatabaseReplica::Internal : public Xapian::Internal::intrusive_base {
     /** Delete the offline database. */
     void remove_offline_db();
 
+    /** Make sure there's an offline copy to write a DB copy into.
+     *
+     *  Any existing offline copy is kept so that it can be updated in place.
+     */
+    void prepare_offline_copy();
+
+    /** Receive a file in a DB copy which is being sent as ranges.
+     *
+     *  @param filepath	The path of the file in the offline copy.
+     *  @param end_time	If this time is reached, an exception will be thrown
+     *			(0.0 for no timeout).
+     */
+    void receive_file_ranges(const string & filepath, double end_time);
+
     /** Apply a set of DB copy messages from the connection.
      */
     void apply_db_copy(double end_time);
@@ -227,6 +330,12 @@ class DatabaseReplica::Internal : public Xapian::Internal::intrusive_base {
     /// Get a string describing the current revision of the replica.
     string get_revision_info() const;
 
+    /// Get checksums of what the replica has which a DB copy could reuse.
+    string get_copy_info() const;
+
+    /// Read parts of a DB copy from several file descriptors.
+    void prefetch_copy(const vector<int> & fds);
+
     /// Set the file descriptor to read changesets from.
     void set_read_fd(int fd);
 
@@ -259,6 +368,20 @@ DatabaseReplica::get_revision_info() const
     RETURN(internal->get_revision_info());
 }
 
+string
+DatabaseReplica::get_copy_info() const
+{
+    LOGCALL(REPLICA, string, "DatabaseReplica::get_copy_info", NO_ARGS);
+    RETURN(internal->get_copy_info());
+}
+
+void
+DatabaseReplica::prefetch_copy(const vector<int> & fds)
+{
+    LOGCALL_VOID(REPLICA, "DatabaseReplica::prefetch_copy", fds.size());
+    internal->prefetch_copy(fds);
+}
+
 void
 DatabaseReplica::set_read_fd(int fd)
 {
@@ -309,7 +432,7 @@ DatabaseReplica::Internal::update_stub_database() const
 DatabaseReplica::Internal::Internal(const string & path_)
 	: path(path_), live_id(0), live_db(), have_offline_db(false),
 	  need_copy_next(false), offline_revision(), offline_needed_revision(),
-	  last_live_changeset_time(), conn(NULL)
+	  last_live_changeset_time(), conn(NULL), seed_from_live(false)
 {
     LOGCALL_CTOR(REPLICA, "DatabaseReplica::Internal", path_);
 #if !defined XAPIAN_HAS_REMOTE_BACKEND || (!defined XAPIAN_HAS_CHERT_BACKEND && !defined XAPIAN_HAS_GLASS_BACKEND)
@@ -390,24 +513,177 @@ DatabaseReplica::Internal::remove_offline_db()
 #endif
 }
 
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+/// Copy a file.
+static void
+copy_file(const string & from, const string & to)
+{
+    FD fd_from(posixy_open(from.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd_from < 0) return;
+    FD fd_to(posixy_open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+			 0666));
+    if (fd_to < 0) {
+	throw Xapian::DatabaseError("Couldn't open file for writing: " + to,
+				    errno);
+    }
+    string buf(REPL_COPY_RANGE_SIZE, '\0');
+    while (size_t len = io_read(fd_from, &buf[0], buf.size(), 0)) {
+	io_write(fd_to, buf.data(), len);
+    }
+}
+
+/** List the files in a directory.
+ *
+ *  @param dir	The directory to list.
+ *  @param[out] leaves	The leafnames of the files.
+ */
+static void
+list_files(const string & dir, vector<string> & leaves)
+{
+    DIR * d = opendir(dir.c_str());
+    if (d == NULL) return;
+    while (struct dirent * entry = readdir(d)) {
+	if (entry->d_name[0] == '.') continue;
+	string leaf(entry->d_name);
+	if (file_exists(dir + "/" + leaf)) leaves.push_back(leaf);
+    }
+    closedir(d);
+}
+
+/** Write a range of a file which was received in a DB copy.
+ *
+ *  @param fd	The file to write to.
+ *  @param msg	The REPL_REPLY_DB_FILERANGE message.
+ */
+static void
+write_file_range(int fd, const string & msg)
+{
+    const char * p = msg.data();
+    const char * end = p + msg.size();
+    unsigned long long offset;
+    decode_length(&p, end, offset);
+    if (size_t(end - p) > REPL_COPY_RANGE_SIZE) {
+	throw NetworkError("File range in database copy is too long");
+    }
+    io_write_block(fd, p, end - p, 0, off_t(offset));
+}
+#endif
+
 void
-DatabaseReplica::Internal::apply_db_copy(double end_time)
+DatabaseReplica::Internal::prepare_offline_copy()
 {
 #ifdef XAPIAN_HAS_REMOTE_BACKEND
-    have_offline_db = true;
-    last_live_changeset_time = 0;
     string offline_path = get_replica_path(live_id ^ 1);
-    // If there's already an offline database, discard it.  This happens if one
-    // copy of the database was sent, but further updates were needed before it
-    // could be made live, and the remote end was then unable to send those
-    // updates (probably due to not having changesets available, or the remote
-    // database being replaced by a new database).
-    removedir(offline_path);
+    // If there's already an offline database, update it in place.  This
+    // happens if an earlier copy was interrupted, or if one copy of the
+    // database was sent but further updates were needed before it could be
+    // made live, and the remote end was then unable to send those updates
+    // (probably due to not having changesets available, or the remote
+    // database being replaced by a new database).  If we supplied checksums
+    // of its contents to the master, only ranges which differ get sent.
+    if (dir_exists(offline_path)) return;
+
     if (mkdir(offline_path.c_str(), 0777)) {
 	throw Xapian::DatabaseError("Cannot make directory '" +
 				    offline_path + "'", errno);
     }
 
+    if (!seed_from_live) return;
+    seed_from_live = false;
+
+    // The master was sent checksums of the live database, so start from a
+    // copy of its files.
+    string live_path = get_replica_path(live_id);
+    vector<string> leaves;
+    list_files(live_path, leaves);
+    for (const string & leaf : leaves) {
+	copy_file(live_path + "/" + leaf, offline_path + "/" + leaf);
+    }
+#else
+    throw Xapian::FeatureUnavailableError("Replication requires remote backend to be enabled");
+#endif
+}
+
+string
+DatabaseReplica::Internal::get_copy_info() const
+{
+    LOGCALL(REPLICA, string, "DatabaseReplica::Internal::get_copy_info", NO_ARGS);
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+    // A partial copy left by an interrupted update is the best place to start
+    // from.  Otherwise use the live database, which will share most of its
+    // data with the master if it's only out of date because the changesets
+    // it needed are no longer available.
+    string dir = get_replica_path(live_id ^ 1);
+    seed_from_live = !dir_exists(dir);
+    if (seed_from_live)
+	dir = get_replica_path(live_id);
+
+    vector<string> leaves;
+    list_files(dir, leaves);
+    string result;
+    string sums;
+    for (const string & leaf : leaves) {
+	FD fd(posixy_open((dir + "/" + leaf).c_str(), O_RDONLY | O_CLOEXEC));
+	if (fd < 0) continue;
+	sums.resize(0);
+	checksum_file_ranges(fd, sums);
+	result += encode_length(leaf.size());
+	result += leaf;
+	result += encode_length(sums.size());
+	result += sums;
+    }
+    RETURN(result);
+#else
+    throw Xapian::FeatureUnavailableError("Replication requires remote backend to be enabled");
+#endif
+}
+
+void
+DatabaseReplica::Internal::receive_file_ranges(const string & filepath,
+					       double end_time)
+{
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+    string buf;
+    int type = conn->get_message(buf, end_time);
+    check_message_type(type, REPL_REPLY_DB_FILEDIFF);
+    const char * p = buf.data();
+    unsigned long long size;
+    decode_length(&p, p + buf.size(), size);
+
+    FD fd(posixy_open(filepath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666));
+    if (fd < 0) {
+	throw Xapian::DatabaseError("Couldn't open file for writing: " +
+				    filepath, errno);
+    }
+    // Ranges we already have aren't sent.
+    while (conn->sniff_next_message_type(end_time) == REPL_REPLY_DB_FILERANGE) {
+	if (conn->get_message(buf, end_time) < 0)
+	    throw_connection_closed_unexpectedly();
+	write_file_range(fd, buf);
+    }
+    if (ftruncate(fd, off_t(size)) < 0) {
+	throw Xapian::DatabaseError("Couldn't set size of file: " + filepath,
+				    errno);
+    }
+#else
+    (void)filepath;
+    (void)end_time;
+    throw Xapian::FeatureUnavailableError("Replication requires remote backend to be enabled");
+#endif
+}
+
+void
+DatabaseReplica::Internal::apply_db_copy(double end_time)
+{
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+    have_offline_db = true;
+    last_live_changeset_time = 0;
+    // Don't let an earlier copy's required revision make this copy live
+    // before it's complete.
+    offline_needed_revision.resize(0);
+    string offline_path = get_replica_path(live_id ^ 1);
+    prepare_offline_copy();
+
     {
 	string buf;
 	int type = conn->get_message(buf, end_time);
@@ -421,6 +697,9 @@ DatabaseReplica::Internal::apply_db_copy(double end_time)
     }
 
     // Now, read the files for the database from the connection and create it.
+    // Note the files sent so we can remove any others left in the offline
+    // copy afterwards.
+    set<string> files_sent;
     while (true) {
 	string filename;
 	int type = conn->sniff_next_message_type(end_time);
@@ -437,12 +716,17 @@ DatabaseReplica::Internal::apply_db_copy(double end_time)
 	if (filename.find("..") != string::npos) {
 	    throw NetworkError("Filename in database contains '..'");
 	}
+	files_sent.insert(filename);
 
 	type = conn->sniff_next_message_type(end_time);
 	if (type < 0 || type == REPL_REPLY_FAIL)
 	    return;
 
 	string filepath = offline_path + "/" + filename;
+	if (type == REPL_REPLY_DB_FILEDIFF) {
+	    receive_file_ranges(filepath, end_time);
+	    continue;
+	}
 	type = conn->receive_file(filepath, end_time);
 	if (type < 0)
 	    throw_connection_closed_unexpectedly();
@@ -450,6 +734,13 @@ DatabaseReplica::Internal::apply_db_copy(double end_time)
     }
     int type = conn->get_message(offline_needed_revision, end_time);
     check_message_type(type, REPL_REPLY_DB_FOOTER);
+
+    vector<string> leaves;
+    list_files(offline_path, leaves);
+    for (const string & leaf : leaves) {
+	if (files_sent.find(leaf) == files_sent.end())
+	    io_unlink(offline_path + "/" + leaf);
+    }
     need_copy_next = false;
 #else
     (void)end_time;
@@ -517,6 +808,139 @@ DatabaseReplica::Internal::possibly_make_offline_live()
 #endif
 }
 
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+/// A connection supplying one part of a DB copy.
+struct CopyPart {
+    /// The file descriptor the part is being read from.
+    int read_fd;
+
+    /// The connection.
+    RemoteConnection conn;
+
+    /// The name of the file being sent.
+    string filename;
+
+    /// The file being written, or -1.
+    FD fd;
+
+    explicit CopyPart(int fd_) : read_fd(fd_), conn(fd_, -1) { }
+};
+#endif
+
+void
+DatabaseReplica::Internal::prefetch_copy(const vector<int> & fds)
+{
+    LOGCALL_VOID(REPLICA, "DatabaseReplica::Internal::prefetch_copy", fds.size());
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+    vector<AutoPtr<CopyPart>> parts;
+    for (int fd : fds) {
+	parts.push_back(AutoPtr<CopyPart>(new CopyPart(fd)));
+    }
+    string offline_path = get_replica_path(live_id ^ 1);
+    bool prepared = false;
+    string buf;
+    while (!parts.empty()) {
+#ifndef __WIN32__
+	// Wait until at least one of the connections has something to read.
+	// We don't know if a connection has a message already buffered, but
+	// the remote end will either send more or close the connection, so
+	// this can only delay reading such a message, not block forever.
+	fd_set fdset;
+	FD_ZERO(&fdset);
+	int fd_max = 0;
+	for (size_t i = 0; i != parts.size(); ++i) {
+	    FD_SET(parts[i]->read_fd, &fdset);
+	    fd_max = max(fd_max, parts[i]->read_fd);
+	}
+	int res;
+	do {
+	    res = select(fd_max + 1, &fdset, 0, 0, NULL);
+	} while (res < 0 && errno == EINTR);
+	if (res < 0) {
+	    throw Xapian::NetworkError("select failed during prefetch", errno);
+	}
+#endif
+	size_t i = 0;
+	while (i != parts.size()) {
+	    CopyPart & part = *parts[i];
+#ifndef __WIN32__
+	    if (!FD_ISSET(part.read_fd, &fdset)) {
+		++i;
+		continue;
+	    }
+#else
+	    if (!part.conn.ready_to_read()) {
+		++i;
+		continue;
+	    }
+#endif
+	    bool done = false;
+	    try {
+		int type = part.conn.get_message(buf, 0.0);
+		switch (type) {
+		    case REPL_REPLY_DB_FILENAME:
+			if (buf.find("..") != string::npos) {
+			    throw NetworkError("Filename in database contains '..'");
+			}
+			part.filename = buf;
+			part.fd = -1;
+			break;
+		    case REPL_REPLY_DB_FILEDIFF: {
+			if (part.filename.empty()) {
+			    throw NetworkError("File size without a filename");
+			}
+			if (!prepared) {
+			    prepare_offline_copy();
+			    // An offline copy we're already bringing up to
+			    // date isn't complete once we've written to it,
+			    // so changesets mustn't be applied to it until a
+			    // copy fills it in - but keep it, as that copy
+			    // can reuse what's there.
+			    if (have_offline_db)
+				need_copy_next = true;
+			    prepared = true;
+			}
+			string filepath = offline_path + "/" + part.filename;
+			part.fd = posixy_open(filepath.c_str(),
+					      O_WRONLY | O_CREAT | O_CLOEXEC,
+					      0666);
+			if (part.fd < 0) {
+			    throw Xapian::DatabaseError("Couldn't open file for writing: " + filepath, errno);
+			}
+			break;
+		    }
+		    case REPL_REPLY_DB_FILERANGE:
+			if (part.fd < 0) {
+			    throw NetworkError("File range without a file");
+			}
+			write_file_range(part.fd, buf);
+			break;
+		    case REPL_REPLY_END_OF_CHANGES:
+		    case REPL_REPLY_FAIL:
+		    case -1:
+			done = true;
+			break;
+		    default:
+			throw NetworkError("Unexpected replication protocol message ("
+					   + str(type) + ") in prefetch");
+		}
+	    } catch (const Xapian::NetworkError &) {
+		// The update which follows will fetch anything we're missing.
+		done = true;
+	    }
+	    if (done) {
+		parts.erase(parts.begin() + i);
+		continue;
+	    }
+	    ++i;
+	}
+    }
+#else
+    (void)fds;
+    throw Xapian::FeatureUnavailableError("Replication requires remote backend to be enabled");
+#endif
+}
+
 void
 DatabaseReplica::Internal::set_read_fd(int fd)
 {
@@ -543,6 +967,11 @@ DatabaseReplica::Internal::apply_next_changeset(ReplicationInfo * info,
 		string buf;
 		type = conn->get_message(buf, 0.0);
 		check_message_type(type, REPL_REPLY_END_OF_CHANGES);
+		if (!have_offline_db && dir_exists(get_replica_path(live_id ^ 1))) {
+		    // A partial copy left by an interrupted update which is
+		    // no longer needed.
+		    remove_offline_db();
+		}
 		RETURN(false);
 	    }
 	    case REPL_REPLY_DB_HEADER:
@@ -558,7 +987,9 @@ DatabaseReplica::Internal::apply_next_changeset(ReplicationInfo * info,
 			replica_uuid = replicator->get_uuid();
 		    }
 		    if (replica_uuid != offline_uuid) {
-			remove_offline_db();
+			// Keep the files, as the next copy can still reuse
+			// any ranges which match.
+			have_offline_db = false;
 			// We've been sent an database with the wrong uuid,
 			// which only happens if the database at the server
 			// got changed during the copy, so the only safe
@@ -568,7 +999,9 @@ DatabaseReplica::Internal::apply_next_changeset(ReplicationInfo * info,
 			need_copy_next = true;
 		    }
 		} catch (...) {
-		    remove_offline_db();
+		    // Keep what we've copied so far so that a later copy can
+		    // resume from it.
+		    have_offline_db = false;
 		    throw;
 		}
 		if (possibly_make_offline_live()) {
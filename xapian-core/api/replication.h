@@ -26,6 +26,7 @@
 #include "xapian/visibility.h"
 
 #include <string>
+#include <vector>
 
 namespace Xapian {
 
@@ -62,6 +63,15 @@ class XAPIAN_VISIBILITY_DEFAULT DatabaseMaster {
     /// The path to the master database.
     std::string path;
 
+    /** Write changesets or a copy of the database to a file.
+     *
+     *  @param copy_info	Information about the copy, as passed to
+     *			Database::Internal::write_changesets_to_fd().
+     */
+    void write_to_fd(int fd, const std::string & start_revision,
+		     ReplicationInfo * info,
+		     const std::string & copy_info) const;
+
   public:
     /** Create a new DatabaseMaster for the database at the specified path.
      *
@@ -97,10 +107,57 @@ class XAPIAN_VISIBILITY_DEFAULT DatabaseMaster {
      *  @param info     If non-NULL, the supplied structure will be updated
      *                  to reflect the changes written to the file
      *                  descriptor.
+     *
+     *  @param copy_info What the replica already has which could be used
+     *                  to avoid sending all of a copy of the whole database,
+     *                  as returned by DatabaseReplica::get_copy_info().  If
+     *                  a copy is needed, only ranges of the files which
+     *                  differ from this are sent.
      */
     void write_changesets_to_fd(int fd,
 				const std::string & start_revision,
-				ReplicationInfo * info) const;
+				ReplicationInfo * info,
+				const std::string & copy_info = std::string()) const;
+
+    /** Write one part of a copy of the whole database to a file.
+     *
+     *  Large copies can be sped up by fetching the parts over several
+     *  connections at once and passing them to DatabaseReplica::prefetch_copy()
+     *  before updating the replica as usual - only ranges which changed in
+     *  the meantime then need to be sent again.
+     *
+     *  If a whole database copy isn't needed to update a replica at
+     *  @a start_revision, nothing is written except the end marker.
+     *
+     *  @param fd       An open file descriptor to write the copy to.
+     *
+     *  @param start_revision The revision of the replica, as for
+     *                  write_changesets_to_fd().
+     *
+     *  @param copy_info What the replica already has, as for
+     *                  write_changesets_to_fd().
+     *
+     *  @param part     Which part to write (from 0 to @a nparts - 1).  The
+     *                  files are split into ranges which are dealt out to
+     *                  the parts in turn.
+     *
+     *  @param nparts   The number of parts the copy is split into.
+     */
+    void write_copy_part_to_fd(int fd,
+			       const std::string & start_revision,
+			       const std::string & copy_info,
+			       unsigned part, unsigned nparts) const;
+
+    /** Check if updating a replica needs a copy of the whole database.
+     *
+     *  This is cheap to check, so a replica can use it to avoid computing
+     *  DatabaseReplica::get_copy_info() (which reads all its files) unless
+     *  a copy will actually be sent.
+     *
+     *  @param start_revision The revision of the replica, as for
+     *                  write_changesets_to_fd().
+     */
+    bool copy_needed(const std::string & start_revision) const;
 
     /// Return a string describing this object.
     std::string get_description() const;
@@ -151,6 +208,37 @@ class XAPIAN_VISIBILITY_DEFAULT DatabaseReplica {
      */
     std::string get_revision_info() const;
 
+    /** Get a string describing what the replica has which could be reused
+     *  by a copy of the whole database.
+     *
+     *  This is checksums of ranges of the files from any partial copy left
+     *  by an interrupted update (or if there isn't one, from the live
+     *  database).  If this is passed to the master, a copy can resume where
+     *  it left off and skip data the replica already has.
+     *
+     *  This reads all the files concerned, so may take a while for a large
+     *  database.
+     */
+    std::string get_copy_info() const;
+
+    /** Read parts of a copy of the whole database from several file
+     *  descriptors at once.
+     *
+     *  Each file descriptor should be supplying a different part, as written
+     *  by DatabaseMaster::write_copy_part_to_fd().  The data is written into
+     *  an offline copy, which won't be used until a normal update completes
+     *  it (call get_copy_info() again and pass the result to the master for
+     *  the normal update so the data fetched here is reused).
+     *
+     *  A part which fails due to a network problem is abandoned, as the
+     *  normal update will fetch anything which is missing.
+     *
+     *  The caller is responsible for closing the file descriptors.
+     *
+     *  @param fds	The file descriptors to read from.
+     */
+    void prefetch_copy(const std::vector<int> & fds);
+
     /** Set the file descriptor to read changesets from.
      *
      *  This will be remembered in the DatabaseReplica, but the caller is still
@@ -45,11 +45,12 @@ TermIterator::Internal::get_collection_freq() const
     return 0;
 }
 
-// Default implementation for when the positions aren't in vector<termpos>.
-const std::vector<Xapian::termpos> *
-TermIterator::Internal::get_vector_termpos() const
+// Default implementation for when the positions aren't in an array.
+bool
+TermIterator::Internal::get_termpos_array(const Xapian::termpos *&,
+					  const Xapian::termpos *&) const
 {
-    return NULL;
+    return false;
 }
 
 }
@@ -101,15 +101,20 @@ class Xapian::TermIterator::Internal : public Xapian::Internal::intrusive_base {
     /// Return the length of the position list for the current position.
     virtual Xapian::termcount positionlist_count() const = 0;
 
-    /** Get pointer to vector<termpos> if that's the internal representation.
+    /** Get the positions as an array if that's the internal representation.
      *
      *  This avoids unnecessary copying of positions in the common cases - the
      *  case it doesn't help with is adding a document back with unmodified
      *  positions *AND* a different docid, which is an unusual thing to do.
      *
-     *  @return Pointer to vector<termpos> or NULL.
+     *  @param[out] begin	Set to point to the first position.
+     *  @param[out] end	Set to point after the last position.
+     *
+     *  @return true if @a begin and @a end were set; false if the positions
+     *	    need to be read using positionlist_begin().
      */
-    virtual const std::vector<Xapian::termpos> * get_vector_termpos() const;
+    virtual bool get_termpos_array(const Xapian::termpos *& begin,
+				   const Xapian::termpos *& end) const;
 
     /// Return a PositionIterator for the current position.
     virtual Xapian::PositionIterator positionlist_begin() const = 0;
@@ -11,6 +11,7 @@ noinst_HEADERS +=\
 	backends/positionlist.h\
 	backends/prefix_compressed_strings.h\
 	backends/slowvaluelist.h\
+	backends/tablecounts.h\
 	backends/valuelist.h\
 	backends/valuestats.h
 
@@ -27,18 +27,20 @@ enum {
     BACKEND_INMEMORY = 1,
     BACKEND_CHERT = 2,
     BACKEND_GLASS = 3,
+    BACKEND_GLASS_SEGMENTED = 4,
     BACKEND_MAX_
 };
 
 inline const char * backend_name(int code) {
     if (code < 0 || code > BACKEND_MAX_) code = BACKEND_MAX_;
     const char * p =
-	"remote\0\0\0"
-	"inmemory\0"
-	"chert\0\0\0\0"
-	"glass\0\0\0\0"
+	"remote\0\0\0\0"
+	"inmemory\0\0"
+	"chert\0\0\0\0\0"
+	"glass\0\0\0\0\0"
+	"segmented\0"
 	"?";
-    return p + code * 9;
+    return p + code * 10;
 }
 
 #endif
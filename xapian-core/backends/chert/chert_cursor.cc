@@ -72,6 +72,7 @@ ChertCursor::ChertCursor(const ChertTable *B_)
 void
 ChertCursor::rebuild()
 {
+    ++B->counts.cursor_rebuilds;
     int new_level = B->level;
     if (new_level <= level) {
 	for (int i = 0; i < new_level; i++) {
@@ -51,6 +51,7 @@
 #include "chert_values.h"
 #include "debuglog.h"
 #include "fd.h"
+#include "filetests.h"
 #include "io_utils.h"
 #include "pack.h"
 #include "posixy_wrapper.h"
@@ -488,6 +489,18 @@ ChertDatabase::readahead_for_query(const Xapian::Query &query)
     }
 }
 
+void
+ChertDatabase::add_table_counts(map<string, TableCounts> & counts) const
+{
+    const ChertTable * tables[] = {
+	&postlist_table, &position_table, &termlist_table,
+	&synonym_table, &spelling_table, &record_table
+    };
+    for (const ChertTable * table : tables) {
+	counts[table->get_tablename()] += table->get_counts();
+    }
+}
+
 bool
 ChertDatabase::reopen()
 {
@@ -528,17 +541,20 @@ ChertDatabase::get_database_write_lock(int flags, bool creating)
 }
 
 void
-ChertDatabase::send_whole_database(RemoteConnection & conn, double end_time)
-{
-    LOGCALL_VOID(DB, "ChertDatabase::send_whole_database", conn | end_time);
-
-    // Send the current revision number in the header.
-    string buf;
-    string uuid = get_uuid();
-    buf += encode_length(uuid.size());
-    buf += uuid;
-    pack_uint(buf, get_revision_number());
-    conn.send_message(REPL_REPLY_DB_HEADER, buf, end_time);
+ChertDatabase::send_whole_database(RemoteConnection & conn,
+				   const string & copy_info, double end_time)
+{
+    LOGCALL_VOID(DB, "ChertDatabase::send_whole_database", conn | copy_info | end_time);
+
+    if (!copy_info_is_part(copy_info)) {
+	// Send the current revision number in the header.
+	string buf;
+	string uuid = get_uuid();
+	buf += encode_length(uuid.size());
+	buf += uuid;
+	pack_uint(buf, get_revision_number());
+	conn.send_message(REPL_REPLY_DB_HEADER, buf, end_time);
+    }
 
     // Send all the tables.  The tables which we want to be cached best after
     // the copy finished are sent last.
@@ -557,8 +573,7 @@ ChertDatabase::send_whole_database(RemoteConnection & conn, double end_time)
 	filepath.replace(db_dir.size() + 1, string::npos, leaf);
 	FD fd(posixy_open(filepath.c_str(), O_RDONLY | O_CLOEXEC));
 	if (fd >= 0) {
-	    conn.send_message(REPL_REPLY_DB_FILENAME, leaf, end_time);
-	    conn.send_file(REPL_REPLY_DB_FILEDATA, fd, end_time);
+	    send_db_file(conn, leaf, fd, copy_info, end_time);
 	}
     }
 }
@@ -567,9 +582,10 @@ void
 ChertDatabase::write_changesets_to_fd(int fd,
 				      const string & revision,
 				      bool need_whole_db,
-				      ReplicationInfo * info)
+				      ReplicationInfo * info,
+				      const string & copy_info)
 {
-    LOGCALL_VOID(DB, "ChertDatabase::write_changesets_to_fd", fd | revision | need_whole_db | info);
+    LOGCALL_VOID(DB, "ChertDatabase::write_changesets_to_fd", fd | revision | need_whole_db | info | copy_info);
 
     int whole_db_copies_left = MAX_DB_COPIES_PER_CONVERSATION;
     chert_revision_number_t start_rev_num = 0;
@@ -584,6 +600,23 @@ ChertDatabase::write_changesets_to_fd(int fd,
     }
 
     RemoteConnection conn(-1, fd, string());
+    // Replicas always support compressed messages, so compress any large ones
+    // we send - table files and changesets usually compress well.
+    conn.set_compress_min(DEFAULT_COMPRESS_MIN);
+
+    if (copy_info_is_part(copy_info)) {
+	// We've been asked for one part of a copy of the whole database, to be
+	// sent in parallel with the other parts - if a copy is needed, the
+	// replica will follow up with a normal conversation to fill in any
+	// ranges which changed in the meantime.
+	if (!need_whole_db)
+	    need_whole_db = !changesets_available(revision);
+	if (need_whole_db) {
+	    send_whole_database(conn, copy_info, 0.0);
+	}
+	conn.send_message(REPL_REPLY_END_OF_CHANGES, string(), 0.0);
+	return;
+    }
 
     // While the starting revision number is less than the latest revision
     // number, look for a changeset, and write it.
@@ -608,7 +641,7 @@ ChertDatabase::write_changesets_to_fd(int fd,
 	    start_rev_num = get_revision_number();
 	    start_uuid = get_uuid();
 
-	    send_whole_database(conn, 0.0);
+	    send_whole_database(conn, copy_info, 0.0);
 	    if (info != NULL)
 		++(info->fullcopy_count);
 
@@ -688,6 +721,20 @@ ChertDatabase::write_changesets_to_fd(int fd,
     conn.send_message(REPL_REPLY_END_OF_CHANGES, string(), 0.0);
 }
 
+bool
+ChertDatabase::changesets_available(const string & start_revision) const
+{
+    LOGCALL(DB, bool, "ChertDatabase::changesets_available", start_revision);
+    chert_revision_number_t start_rev_num;
+    const char * p = start_revision.data();
+    const char * end = p + start_revision.size();
+    if (!unpack_uint(&p, end, &start_rev_num))
+	RETURN(false);
+    if (start_rev_num >= get_revision_number())
+	RETURN(true);
+    RETURN(file_exists(db_dir + "/changes" + str(start_rev_num)));
+}
+
 void
 ChertDatabase::modifications_failed(chert_revision_number_t old_revision,
 				    chert_revision_number_t new_revision,
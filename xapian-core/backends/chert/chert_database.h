@@ -214,8 +214,12 @@ class ChertDatabase : public Xapian::Database::Internal {
 	void cancel();
 
 	/** Send a set of messages which transfer the whole database.
+	 *
+	 *  @param copy_info	Information about the copy, as passed to
+	 *			write_changesets_to_fd().
 	 */
-	void send_whole_database(RemoteConnection & conn, double end_time);
+	void send_whole_database(RemoteConnection & conn,
+				 const string & copy_info, double end_time);
 
 	/** Get the revision stored in a changeset.
 	 */
@@ -299,12 +303,15 @@ class ChertDatabase : public Xapian::Database::Internal {
 	void write_changesets_to_fd(int fd,
 				    const string & start_revision,
 				    bool need_whole_db,
-				    Xapian::ReplicationInfo * info);
+				    Xapian::ReplicationInfo * info,
+				    const string & copy_info);
+	bool changesets_available(const string & start_revision) const;
 	string get_revision_info() const;
 	string get_uuid() const;
 
 	void request_document(Xapian::docid /*did*/) const;
 	void readahead_for_query(const Xapian::Query &query);
+	void add_table_counts(map<string, TableCounts> & counts) const;
 	//@}
 
 	XAPIAN_NORETURN(void throw_termlist_table_close_exception() const);
@@ -55,7 +55,7 @@ ChertPositionListTable::set_positionlist(Xapian::docid did,
 	BitWriter wr(s);
 	wr.encode(poscopy[0], poscopy.back());
 	wr.encode(poscopy.size() - 2, poscopy.back() - poscopy[0]);
-	wr.encode_interpolative(poscopy, 0, poscopy.size() - 1);
+	wr.encode_interpolative(poscopy.data(), 0, poscopy.size() - 1);
 	swap(s, wr.freeze());
     }
 
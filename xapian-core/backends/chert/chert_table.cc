@@ -179,7 +179,9 @@ ChertTable::read_block(uint4 n, byte * p) const
      */
     Assert(n / CHAR_BIT < base.get_bit_map_size());
 
-    io_read_block(handle, reinterpret_cast<char *>(p), block_size, n);
+    unsigned calls = io_read_block(handle, reinterpret_cast<char *>(p),
+				   block_size, n);
+    counts.count_block_read(block_size, calls);
 
     int dir_end = DIR_END(p);
     if (rare(dir_end < DIR_START || unsigned(dir_end) > block_size)) {
@@ -272,7 +274,10 @@ void
 ChertTable::block_to_cursor(Cursor * C_, int j, uint4 n) const
 {
     LOGCALL_VOID(DB, "ChertTable::block_to_cursor", (void*)C_ | j | n);
-    if (n == C_[j].n) return;
+    if (n == C_[j].n) {
+	++counts.cache_hits;
+	return;
+    }
     byte * p = C_[j].p;
     Assert(p);
 
@@ -289,6 +294,7 @@ ChertTable::block_to_cursor(Cursor * C_, int j, uint4 n) const
     if (n == C[j].n) {
 	if (p != C[j].p)
 	    memcpy(p, C[j].p, block_size);
+	++counts.cache_hits;
     } else {
 	read_block(n, p);
     }
@@ -1173,6 +1179,7 @@ ChertTable::readahead_key(const string &key) const
 	last_readahead = n;
 	if (!io_readahead_block(handle, block_size, n))
 	    RETURN(false);
+	++counts.readahead_hints;
     }
     RETURN(true);
 }
@@ -1240,6 +1247,8 @@ ChertTable::read_tag(Cursor * C_, string *tag, bool keep_compressed) const
     // it to the next key (ChertCursor::get_tag() relies on this).
     if (!compressed || keep_compressed) RETURN(compressed);
 
+    ++counts.tags_inflated;
+
     // FIXME: Perhaps we should decompress each chunk as we read it so we
     // don't need both the full compressed and uncompressed tags in memory
     // at once.
@@ -29,6 +29,7 @@
 #include "chert_types.h"
 #include "chert_btreebase.h"
 #include "chert_cursor.h"
+#include "backends/tablecounts.h"
 
 #include "noreturn.h"
 #include "omassert.h"
@@ -652,6 +653,12 @@ class ChertTable {
 	 */
 	bool is_modified() const { return Btree_modified; }
 
+	/// Return the counts of the work this table has done.
+	const TableCounts & get_counts() const { return counts; }
+
+	/// Return the name of the table.
+	const char * get_tablename() const { return tablename; }
+
 	/** Set the maximum item size given the block capacity.
 	 *
 	 *  At least this many items of maximum size must fit into a block.
@@ -863,6 +870,9 @@ class ChertTable {
 	/// Last block readahead_key() preread.
 	mutable uint4 last_readahead;
 
+	/// Counts of the work this table has done.
+	mutable TableCounts counts;
+
 	/* Debugging methods */
 //	void report_block_full(int m, int n, const byte * p);
 };
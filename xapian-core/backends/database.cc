@@ -33,6 +33,7 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 using namespace std;
 using Xapian::Internal::intrusive_ptr;
@@ -55,6 +56,11 @@ Database::Internal::readahead_for_query(const Xapian::Query &)
 {
 }
 
+void
+Database::Internal::add_table_counts(map<string, TableCounts> &) const
+{
+}
+
 Xapian::doccount
 Database::Internal::get_value_freq(Xapian::valueno) const
 {
@@ -99,6 +105,12 @@ Database::Internal::get_wdf_upper_bound(const string & term) const
     return cf;
 }
 
+Xapian::termcount
+Database::Internal::get_term_doclength_lower_bound(const string &) const
+{
+    return get_doclength_lower_bound();
+}
+
 // Discard any exceptions - we're called from the destructors of derived
 // classes so we can't safely throw.
 void
@@ -183,6 +195,17 @@ Database::Internal::add_document(const Xapian::Document &)
     return 0;
 }
 
+Xapian::docid
+Database::Internal::add_documents(const vector<Xapian::Document> & docs)
+{
+    Xapian::docid first_did = 0;
+    for (const Xapian::Document & document : docs) {
+	Xapian::docid did = add_document(document);
+	if (first_did == 0) first_did = did;
+    }
+    return first_did;
+}
+
 void
 Database::Internal::delete_document(Xapian::docid)
 {
@@ -258,6 +281,14 @@ Database::Internal::get_spelling_frequency(const string &) const
     return 0;
 }
 
+TermList *
+Database::Internal::open_substring_termlist(const string &) const
+{
+    // Only implemented for some database backends - for others the caller
+    // needs to check every term.
+    return NULL;
+}
+
 void
 Database::Internal::add_spelling(const string &, Xapian::termcount) const
 {
@@ -350,7 +381,14 @@ Database::Internal::collect_document(Xapian::docid did) const
 }
 
 void
-Database::Internal::write_changesets_to_fd(int, const string &, bool, ReplicationInfo *)
+Database::Internal::write_changesets_to_fd(int, const string &, bool,
+					   ReplicationInfo *, const string &)
+{
+    throw Xapian::UnimplementedError("This backend doesn't provide changesets");
+}
+
+bool
+Database::Internal::changesets_available(const string &) const
 {
     throw Xapian::UnimplementedError("This backend doesn't provide changesets");
 }
@@ -373,6 +411,12 @@ Database::Internal::invalidate_doc_object(Xapian::Document::Internal *) const
     // Do nothing, by default.
 }
 
+bool
+Database::Internal::compact_incrementally(unsigned, double)
+{
+    throw Xapian::UnimplementedError("This backend doesn't support compacting in place");
+}
+
 void
 Database::Internal::get_used_docid_range(Xapian::docid &,
 					 Xapian::docid &) const
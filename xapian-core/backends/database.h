@@ -25,7 +25,9 @@
 #ifndef OM_HGUARD_DATABASE_H
 #define OM_HGUARD_DATABASE_H
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "internaltypes.h"
 
@@ -41,6 +43,7 @@ using namespace std;
 
 class LeafPostList;
 class RemoteDatabase;
+struct TableCounts;
 
 typedef Xapian::TermIterator::Internal TermList;
 typedef Xapian::PositionIterator::Internal PositionList;
@@ -108,6 +111,14 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
 
 	virtual void readahead_for_query(const Xapian::Query & query);
 
+	/** Add the counts of the work done by this database's tables.
+	 *
+	 *  Each table's counts are added to the entry in @a counts for its
+	 *  name.  The default implementation is for backends which don't keep
+	 *  counts, and does nothing.
+	 */
+	virtual void add_table_counts(map<string, TableCounts> & counts) const;
+
 	//////////////////////////////////////////////////////////////////
 	// Database statistics:
 	// ====================
@@ -200,6 +211,13 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
 	/// Get an upper bound on the wdf of term @a term.
 	virtual Xapian::termcount get_wdf_upper_bound(const std::string & term) const;
 
+	/** Get a lower bound on the length of documents indexed by @a term.
+	 *
+	 *  The default implementation returns get_doclength_lower_bound(),
+	 *  which is valid but not term-specific.
+	 */
+	virtual Xapian::termcount get_term_doclength_lower_bound(const std::string & term) const;
+
 	/** Check whether a given term is in the database.
 	 *
 	 *  @param tname  The term whose presence is being checked.
@@ -314,6 +332,16 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
 	/** Return the number of times @a word was added as a spelling. */
 	virtual Xapian::doccount get_spelling_frequency(const string & word) const;
 
+	/** Open a termlist returning the terms which contain @a substring.
+	 *
+	 *  This is used to expand wildcard patterns which don't start with a
+	 *  fixed prefix, and is only implemented by backends which can do it
+	 *  more efficiently than checking every term.
+	 *
+	 *  If this isn't supported (or isn't for @a substring), returns NULL.
+	 */
+	virtual TermList * open_substring_termlist(const string & substring) const;
+
 	/** Add a word to the spelling dictionary.
 	 *
 	 *  If the word is already present, its frequency is increased.
@@ -437,6 +465,15 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
 	 */
 	virtual Xapian::docid add_document(const Xapian::Document & document);
 
+	/** Add a batch of new documents to the database.
+	 *
+	 *  See WritableDatabase::add_documents() for more information.
+	 *
+	 *  The default implementation calls add_document() for each.
+	 */
+	virtual Xapian::docid
+	add_documents(const std::vector<Xapian::Document> & docs);
+
 	/** Delete a document in the database.
 	 *
 	 *  See WritableDatabase::delete_document() for more information.
@@ -482,18 +519,42 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
 	 *
 	 *  This call may reopen the database, leaving it pointing to a more
 	 *  recent version of the database.
+	 *
+	 *  @param copy_info	Information about any copy of the whole database
+	 *			which is needed: encode_length() of the number of
+	 *			parts the copy is split into (0 for a normal
+	 *			conversation) and of the part to send, followed
+	 *			by DatabaseReplica::get_copy_info() from the
+	 *			replica.  Empty if the replica didn't supply
+	 *			this.  If only one part is to be sent, no
+	 *			changesets are sent, and the copy isn't followed
+	 *			by a footer.
 	 */
 	virtual void write_changesets_to_fd(int fd,
 					    const std::string & start_revision,
 					    bool need_whole_db,
-					    Xapian::ReplicationInfo * info);
+					    Xapian::ReplicationInfo * info,
+					    const std::string & copy_info);
+
+	/** Check if changesets to update a replica are available.
+	 *
+	 *  If not, write_changesets_to_fd() will need to send a copy of the
+	 *  whole database.  This is much cheaper than computing checksums of
+	 *  the replica's files for a copy, so replicas check this first.
+	 *
+	 *  @param start_revision	The revision of the replica, as for
+	 *				write_changesets_to_fd().
+	 */
+	virtual bool changesets_available(const std::string & start_revision) const;
 
 	/// Get a string describing the current revision of the database.
 	virtual string get_revision_info() const;
 
 	/** Get a UUID for the database.
 	 *
-	 *  The UUID will persist for the lifetime of the database.
+	 *  The UUID will persist for the lifetime of the database, except
+	 *  that compacting it in place with compact_incrementally() gives it
+	 *  a new UUID.
 	 *
 	 *  Replicas (eg, made with the replication protocol, or by copying all
 	 *  the database files) will have the same UUID.  However, copies (made
@@ -512,6 +573,14 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
 	 */
 	virtual void invalidate_doc_object(Xapian::Document::Internal * obj) const;
 
+	/** Compact the next table of the database in place.
+	 *
+	 *  See WritableDatabase::compact_incrementally() for details.
+	 *
+	 *  @return true if there are more tables to compact.
+	 */
+	virtual bool compact_incrementally(unsigned flags, double max_io_rate);
+
 	/** Get backend information about this database.
 	 *
 	 *  @param path  If non-NULL, and set the pointed to string to the file
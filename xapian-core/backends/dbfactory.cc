@@ -40,6 +40,7 @@
 
 #ifdef XAPIAN_HAS_GLASS_BACKEND
 # include "glass/glass_database.h"
+# include "glass/glass_segmented.h"
 #endif
 #ifdef XAPIAN_HAS_CHERT_BACKEND
 # include "chert/chert_database.h"
@@ -93,7 +94,7 @@ check_if_single_file_db(const struct stat & sb, const string & path,
 namespace Xapian {
 
 static void
-open_stub(Database &db, const string &file)
+open_stub(Database &db, const string &file, int flags)
 {
     // A stub database is a text file with one or more lines of this format:
     // <dbtype> <serialised db object>
@@ -122,7 +123,7 @@ open_stub(Database &db, const string &file)
 
 	if (type == "auto") {
 	    resolve_relative_path(line, file);
-	    db.add_database(Database(line));
+	    db.add_database(Database(line, flags & DB_PIN_REVISION));
 	    continue;
 	}
 
@@ -137,7 +138,9 @@ open_stub(Database &db, const string &file)
 #ifdef XAPIAN_HAS_GLASS_BACKEND
 	if (type == "glass") {
 	    resolve_relative_path(line, file);
-	    db.add_database(Database(new GlassDatabase(line)));
+	    bool pin_revision = (flags & DB_PIN_REVISION);
+	    db.add_database(Database(new GlassDatabase(line, DB_READONLY_, 0,
+							pin_revision)));
 	    continue;
 	}
 #endif
@@ -316,13 +319,19 @@ Database::Database(const string &path, int flags)
 #endif
 	case DB_BACKEND_GLASS:
 #ifdef XAPIAN_HAS_GLASS_BACKEND
-	    internal.push_back(new GlassDatabase(path));
+	    if (GlassSegmentedDatabase::database_exists(path)) {
+		internal.push_back(new GlassSegmentedDatabase(path, false,
+							      (flags & DB_PIN_REVISION)));
+		return;
+	    }
+	    internal.push_back(new GlassDatabase(path, DB_READONLY_, 0,
+						 (flags & DB_PIN_REVISION)));
 	    return;
 #else
 	    throw FeatureUnavailableError("Glass backend disabled");
 #endif
 	case DB_BACKEND_STUB:
-	    open_stub(*this, path);
+	    open_stub(*this, path, flags);
 	    return;
 	case DB_BACKEND_INMEMORY:
 #ifdef XAPIAN_HAS_INMEMORY_BACKEND
@@ -351,7 +360,7 @@ Database::Database(const string &path, int flags)
 #endif
 	}
 
-	open_stub(*this, path);
+	open_stub(*this, path, flags);
 	return;
     }
 
@@ -368,7 +377,13 @@ Database::Database(const string &path, int flags)
 
 #ifdef XAPIAN_HAS_GLASS_BACKEND
     if (file_exists(path + "/iamglass")) {
-	internal.push_back(new GlassDatabase(path));
+	internal.push_back(new GlassDatabase(path, DB_READONLY_, 0,
+					     (flags & DB_PIN_REVISION)));
+	return;
+    }
+    if (GlassSegmentedDatabase::database_exists(path)) {
+	internal.push_back(new GlassSegmentedDatabase(path, false,
+						      (flags & DB_PIN_REVISION)));
 	return;
     }
 #endif
@@ -377,7 +392,7 @@ Database::Database(const string &path, int flags)
     string stub_file = path;
     stub_file += "/XAPIANDB";
     if (usual(file_exists(stub_file))) {
-	open_stub(*this, stub_file);
+	open_stub(*this, stub_file, flags);
 	return;
     }
 
@@ -459,8 +474,9 @@ WritableDatabase::WritableDatabase(const std::string &path, int flags, int block
 #else
 		throw FeatureUnavailableError("Chert backend disabled");
 #endif
-	    } else if (file_exists(path + "/iamglass")) {
-		// Existing glass DB.
+	    } else if (file_exists(path + "/iamglass") ||
+		       file_exists(path + "/iamsegmented")) {
+		// Existing glass DB (possibly segmented).
 #ifdef XAPIAN_HAS_GLASS_BACKEND
 		type = DB_BACKEND_GLASS;
 #else
@@ -490,6 +506,12 @@ WritableDatabase::WritableDatabase(const std::string &path, int flags, int block
 	    // by preference.
 #ifdef XAPIAN_HAS_GLASS_BACKEND
 	case DB_BACKEND_GLASS:
+	    if (GlassSegmentedDatabase::database_exists(path) ||
+		((flags & DB_SEGMENTED) && !file_exists(path + "/iamglass"))) {
+		internal.push_back(new GlassSegmentedDatabase(path, true, flags,
+							      block_size));
+		return;
+	    }
 	    internal.push_back(new GlassWritableDatabase(path, flags, block_size));
 	    return;
 #endif
@@ -29,6 +29,7 @@
 #include "api/termlist.h"
 #include "backends/database.h"
 #include "api/documentterm.h"
+#include "api/documenttermbuilder.h"
 #include <map>
 #include <string>
 
@@ -71,6 +72,18 @@ class Xapian::Document::Internal : public Xapian::Internal::intrusive_base {
 	/// The terms (and their frequencies and positions) in this document.
 	mutable document_terms terms;
 
+	/** Terms added to this document while terms was empty.
+	 *
+	 *  Building up a new document's terms here is much quicker than
+	 *  adding each to terms, so we only move them to terms when something
+	 *  needs them there.  At most one of terms and term_builder is
+	 *  non-empty.
+	 */
+	mutable DocumentTermBuilder term_builder;
+
+	/// Make sure all the terms are in terms (rather than term_builder).
+	void need_term_map() const;
+
     protected:
 	/** The document ID of the document in that database.
 	 *
@@ -3,6 +3,7 @@ EXTRA_DIST +=\
 
 if BUILD_BACKEND_GLASS
 noinst_HEADERS +=\
+	backends/glass/glass_alldocsmodifiedpostlist.h\
 	backends/glass/glass_alldocspostlist.h\
 	backends/glass/glass_alltermslist.h\
 	backends/glass/glass_changes.h\
@@ -18,9 +19,15 @@ noinst_HEADERS +=\
 	backends/glass/glass_inverter.h\
 	backends/glass/glass_lazytable.h\
 	backends/glass/glass_metadata.h\
+	backends/glass/glass_modifiedpostlist.h\
+	backends/glass/glass_pins.h\
 	backends/glass/glass_positionlist.h\
 	backends/glass/glass_postlist.h\
 	backends/glass/glass_replicate_internal.h\
+	backends/glass/glass_segmentdeletions.h\
+	backends/glass/glass_segmented.h\
+	backends/glass/glass_segmentpostlist.h\
+	backends/glass/glass_segmentvaluelist.h\
 	backends/glass/glass_spelling.h\
 	backends/glass/glass_spellingwordslist.h\
 	backends/glass/glass_synonym.h\
@@ -32,6 +39,7 @@ noinst_HEADERS +=\
 	backends/glass/glass_version.h
 
 lib_src +=\
+	backends/glass/glass_alldocsmodifiedpostlist.cc\
 	backends/glass/glass_alldocspostlist.cc\
 	backends/glass/glass_alltermslist.cc\
 	backends/glass/glass_changes.cc\
@@ -45,8 +53,13 @@ lib_src +=\
 	backends/glass/glass_freelist.cc\
 	backends/glass/glass_inverter.cc\
 	backends/glass/glass_metadata.cc\
+	backends/glass/glass_modifiedpostlist.cc\
+	backends/glass/glass_pins.cc\
 	backends/glass/glass_positionlist.cc\
 	backends/glass/glass_postlist.cc\
+	backends/glass/glass_segmented.cc\
+	backends/glass/glass_segmentpostlist.cc\
+	backends/glass/glass_segmentvaluelist.cc\
 	backends/glass/glass_spelling.cc\
 	backends/glass/glass_spellingwordslist.cc\
 	backends/glass/glass_synonym.cc\
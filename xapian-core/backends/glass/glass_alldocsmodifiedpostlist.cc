@@ -0,0 +1,145 @@
+/** @file glass_alldocsmodifiedpostlist.cc
+ * @brief A GlassAllDocsPostList plus pending modifications.
+ */
+/* Copyright (C) 2008 Lemur Consulting Ltd
+ * Copyright (C) 2006,2007,2008,2009,2010 Olly Betts
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+#include "glass_alldocsmodifiedpostlist.h"
+
+#include <algorithm>
+
+#include "glass_database.h"
+#include "glass_inverter.h"
+#include "debuglog.h"
+#include "str.h"
+
+using namespace std;
+using Xapian::Internal::intrusive_ptr;
+
+GlassAllDocsModifiedPostList::GlassAllDocsModifiedPostList(intrusive_ptr<const GlassDatabase> db_,
+							   Xapian::doccount doccount_,
+							   const map<Xapian::docid, Xapian::termcount> & doclens_)
+	: GlassAllDocsPostList(db_, doccount_),
+	  doclens(doclens_),
+	  doclens_it(doclens.begin())
+{
+    LOGCALL_CTOR(DB, "GlassAllDocsModifiedPostList", db_.get() | doccount_ | doclens_);
+}
+
+void
+GlassAllDocsModifiedPostList::skip_deletes(double w_min)
+{
+    LOGCALL_VOID(DB, "GlassAllDocsModifiedPostList::skip_deletes", w_min);
+    while (!GlassAllDocsPostList::at_end()) {
+	if (doclens_it == doclens.end()) return;
+	if (doclens_it->first != GlassAllDocsPostList::get_docid()) return;
+	if (doclens_it->second != DELETED_POSTING) return;
+	++doclens_it;
+	GlassAllDocsPostList::next(w_min);
+    }
+    while (doclens_it != doclens.end() && doclens_it->second == DELETED_POSTING) {
+	++doclens_it;
+    }
+}
+
+Xapian::docid
+GlassAllDocsModifiedPostList::get_docid() const
+{
+    LOGCALL(DB, Xapian::docid, "GlassAllDocsModifiedPostList::get_docid", NO_ARGS);
+    if (doclens_it == doclens.end()) RETURN(GlassAllDocsPostList::get_docid());
+    if (GlassAllDocsPostList::at_end()) RETURN(doclens_it->first);
+    RETURN(min(doclens_it->first, GlassAllDocsPostList::get_docid()));
+}
+
+Xapian::termcount
+GlassAllDocsModifiedPostList::get_doclength() const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassAllDocsModifiedPostList::get_doclength", NO_ARGS);
+    // Override with value from doclens_it (which cannot be DELETED_POSTING,
+    // because that would have been skipped past).
+    if (doclens_it != doclens.end() &&
+	(GlassAllDocsPostList::at_end() ||
+	 doclens_it->first <= GlassAllDocsPostList::get_docid()))
+	RETURN(doclens_it->second);
+
+    RETURN(GlassAllDocsPostList::get_doclength());
+}
+
+Xapian::termcount
+GlassAllDocsModifiedPostList::get_unique_terms() const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassAllDocsModifiedPostList::get_unique_terms", NO_ARGS);
+    Assert(this_db.get());
+    RETURN(this_db->get_unique_terms(get_docid()));
+}
+
+PostList *
+GlassAllDocsModifiedPostList::next(double w_min)
+{
+    LOGCALL(DB, PostList *, "GlassAllDocsModifiedPostList::next", w_min);
+    if (have_started) {
+	if (GlassAllDocsPostList::at_end()) {
+	    ++doclens_it;
+	    skip_deletes(w_min);
+	    RETURN(NULL);
+	}
+	Xapian::docid unmod_did = GlassAllDocsPostList::get_docid();
+	if (doclens_it != doclens.end() && doclens_it->first <= unmod_did) {
+	    if (doclens_it->first < unmod_did &&
+		doclens_it->second != DELETED_POSTING) {
+		++doclens_it;
+		skip_deletes(w_min);
+		RETURN(NULL);
+	    }
+	    ++doclens_it;
+	}
+    }
+    GlassAllDocsPostList::next(w_min);
+    skip_deletes(w_min);
+    RETURN(NULL);
+}
+
+PostList *
+GlassAllDocsModifiedPostList::skip_to(Xapian::docid desired_did,
+				      double w_min)
+{
+    LOGCALL(DB, PostList *, "GlassAllDocsModifiedPostList::skip_to", desired_did | w_min);
+    if (!GlassAllDocsPostList::at_end())
+	GlassAllDocsPostList::skip_to(desired_did, w_min);
+    if (doclens_it != doclens.end() && doclens_it->first < desired_did)
+	doclens_it = doclens.lower_bound(desired_did);
+    skip_deletes(w_min);
+    RETURN(NULL);
+}
+
+bool
+GlassAllDocsModifiedPostList::at_end() const
+{
+    LOGCALL(DB, bool, "GlassAllDocsModifiedPostList::at_end", NO_ARGS);
+    RETURN(doclens_it == doclens.end() && GlassAllDocsPostList::at_end());
+}
+
+string
+GlassAllDocsModifiedPostList::get_description() const
+{
+    string desc = "GlassAllDocsModifiedPostList(did=";
+    desc += str(get_docid());
+    desc += ')';
+    return desc;
+}
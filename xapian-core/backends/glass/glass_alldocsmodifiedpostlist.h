@@ -0,0 +1,69 @@
+/** @file glass_alldocsmodifiedpostlist.h
+ * @brief A GlassAllDocsPostList plus pending modifications.
+ */
+/* Copyright (C) 2008 Lemur Consulting Ltd
+ * Copyright (C) 2006,2007,2008,2009,2010 Olly Betts
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_ALLDOCSMODIFIEDPOSTLIST_H
+#define XAPIAN_INCLUDED_GLASS_ALLDOCSMODIFIEDPOSTLIST_H
+
+#include <map>
+#include <string>
+
+#include "glass_alldocspostlist.h"
+
+class GlassAllDocsModifiedPostList : public GlassAllDocsPostList {
+    /** Modifications to apply to the GlassAllDocsPostList.
+     *
+     *  Deleted documents have length DELETED_POSTING.
+     */
+    std::map<Xapian::docid, Xapian::termcount> doclens;
+
+    /// Current position in the doclens list.
+    std::map<Xapian::docid, Xapian::termcount>::const_iterator doclens_it;
+
+    /// Don't allow assignment.
+    void operator=(const GlassAllDocsModifiedPostList &);
+
+    /// Don't allow copying.
+    GlassAllDocsModifiedPostList(const GlassAllDocsModifiedPostList &);
+
+    /// Skip over deleted documents after a next() or skip_to().
+    void skip_deletes(double w_min);
+
+  public:
+    GlassAllDocsModifiedPostList(Xapian::Internal::intrusive_ptr<const GlassDatabase> db_,
+				 Xapian::doccount doccount_,
+				 const std::map<Xapian::docid, Xapian::termcount> & doclens_);
+
+    Xapian::docid get_docid() const;
+
+    Xapian::termcount get_doclength() const;
+
+    Xapian::termcount get_unique_terms() const;
+
+    PostList * next(double w_min);
+
+    PostList * skip_to(Xapian::docid desired_did, double w_min);
+
+    bool at_end() const;
+
+    std::string get_description() const;
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_ALLDOCSMODIFIEDPOSTLIST_H
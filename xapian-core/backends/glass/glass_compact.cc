@@ -35,6 +35,7 @@
 #include "safeerrno.h"
 
 #include "backends/flint_lock.h"
+#include "debuglog.h"
 #include "glass_database.h"
 #include "glass_defs.h"
 #include "glass_table.h"
@@ -42,7 +43,10 @@
 #include "glass_version.h"
 #include "filetests.h"
 #include "internaltypes.h"
+#include "io_utils.h"
 #include "pack.h"
+#include "realtime.h"
+#include "stringutils.h"
 #include "backends/valuestats.h"
 
 #include "../byte_length_strings.h"
@@ -60,6 +64,12 @@ is_user_metadata_key(const string & key)
     return key.size() > 1 && key[0] == '\0' && key[1] == '\xc0';
 }
 
+static inline bool
+is_impact_key(const string & key)
+{
+    return key.size() > 1 && key[0] == '\0' && key[1] == '\xc8';
+}
+
 static inline bool
 is_valuestats_key(const string & key)
 {
@@ -94,7 +104,11 @@ class PostlistCursor : private GlassCursor {
     }
 
     bool next() {
-	if (!GlassCursor::next()) return false;
+	do {
+	    if (!GlassCursor::next()) return false;
+	    // Any impact bounds in the input are stale once merged, so we skip
+	    // them and recalculate if they're wanted in the output.
+	} while (is_impact_key(current_key));
 	// We put all chunks into the non-initial chunk form here, then fix up
 	// the first chunk for each term in the merged database as we merge.
 	read_tag();
@@ -186,11 +200,42 @@ encode_valuestats(Xapian::doccount freq,
     return value;
 }
 
+/** Call @a action(did, wdf) for each entry in chunk @a tag.
+ *
+ *  @a tag must be in the non-initial chunk form which PostlistCursor returns,
+ *  and @a did is the first docid in the chunk.
+ */
+template<typename ACTION>
+static void
+for_each_posting(Xapian::docid did, const string & tag, ACTION action)
+{
+    const char * p = tag.data();
+    const char * end = p + tag.size();
+    bool is_last_chunk;
+    Xapian::docid increase_to_last;
+    if (!unpack_bool(&p, end, &is_last_chunk) ||
+	!unpack_uint(&p, end, &increase_to_last)) {
+	throw Xapian::DatabaseCorruptError("Bad postlist chunk header");
+    }
+    while (true) {
+	Xapian::termcount wdf;
+	if (!unpack_uint(&p, end, &wdf))
+	    throw Xapian::DatabaseCorruptError("Bad postlist chunk wdf");
+	action(did, wdf);
+	if (p == end) break;
+	Xapian::docid inc;
+	if (!unpack_uint(&p, end, &inc))
+	    throw Xapian::DatabaseCorruptError("Bad postlist chunk docid");
+	did += inc + 1;
+    }
+}
+
 static void
 merge_postlists(Xapian::Compactor * compactor,
 		GlassTable * out, vector<Xapian::docid>::const_iterator offset,
 		vector<GlassTable*>::const_iterator b,
-		vector<GlassTable*>::const_iterator e)
+		vector<GlassTable*>::const_iterator e,
+		bool impact_bounds)
 {
     priority_queue<PostlistCursor *, vector<PostlistCursor *>, PostlistCursorGt> pq;
     for ( ; b != e; ++b, ++offset) {
@@ -335,6 +380,16 @@ merge_postlists(Xapian::Compactor * compactor,
 	}
     }
 
+    // If we're storing impact bounds, we need the document lengths, which
+    // come before any of the term postlists.  The bounds have keys which
+    // sort before the postlists too, so we buffer them and add them at the
+    // end.  The lengths are stored as (docid, length) pairs sorted by docid,
+    // as docids may be sparse (e.g. with DBCOMPACT_NO_RENUMBER).  This means
+    // memory use grows with the number of documents and terms - see the
+    // documentation of DBCOMPACT_IMPACT_BOUNDS.
+    vector<pair<Xapian::docid, Xapian::termcount> > doclens;
+    vector<pair<string, string> > impacts;
+
     Xapian::termcount tf = 0, cf = 0; // Initialise to avoid warnings.
     vector<pair<Xapian::docid, string> > tags;
     while (true) {
@@ -363,6 +418,40 @@ merge_postlists(Xapian::Compactor * compactor,
 			throw Xapian::DatabaseCorruptError("Bad postlist chunk key");
 		}
 
+		if (impact_bounds) {
+		    if (term.empty()) {
+			for (auto && t : tags) {
+			    for_each_posting(t.first, t.second,
+				[&](Xapian::docid did, Xapian::termcount len) {
+				    doclens.push_back(make_pair(did, len));
+				});
+			}
+			sort(doclens.begin(), doclens.end());
+		    } else {
+			Xapian::termcount wdf_ub = 0;
+			Xapian::termcount doclen_lb = Xapian::termcount(-1);
+			// The postings are in ascending docid order, so each
+			// search only needs to look beyond the previous match.
+			auto it = doclens.begin();
+			for (auto && t : tags) {
+			    for_each_posting(t.first, t.second,
+				[&](Xapian::docid did, Xapian::termcount wdf) {
+				    wdf_ub = max(wdf_ub, wdf);
+				    Xapian::termcount len = 0;
+				    it = lower_bound(it, doclens.end(),
+						     make_pair(did, Xapian::termcount(0)));
+				    if (it != doclens.end() && it->first == did)
+					len = it->second;
+				    doclen_lb = min(doclen_lb, len);
+				});
+			}
+			string impact;
+			pack_uint(impact, wdf_ub);
+			pack_uint_last(impact, doclen_lb);
+			impacts.push_back(make_pair(term, impact));
+		    }
+		}
+
 		vector<pair<Xapian::docid, string> >::const_iterator i;
 		i = tags.begin();
 		while (++i != tags.end()) {
@@ -385,6 +474,17 @@ merge_postlists(Xapian::Compactor * compactor,
 	    delete cur;
 	}
     }
+
+    if (impact_bounds) {
+	// The bounds are only valid for the revision we write them at, and
+	// the compacted output is always committed as revision 1.
+	string tag;
+	pack_uint_last(tag, 1u);
+	out->add(GlassPostListTable::make_impact_key(string()), tag);
+	for (auto && i : impacts) {
+	    out->add(GlassPostListTable::make_impact_key(i.first), i.second);
+	}
+    }
 }
 
 struct MergeCursor : public GlassCursor {
@@ -408,10 +508,40 @@ merge_spellings(GlassTable * out,
 		vector<GlassTable*>::const_iterator b,
 		vector<GlassTable*>::const_iterator e)
 {
+    // A deletion index is only useful if it covers every word, so we only
+    // keep it if every input has one with the same parameters.
+    bool deletion_index = true;
+    string deletion_params;
+    bool first = true;
+
+    // Similarly for the term n-gram index, except that an input with an
+    // empty spelling table could still have terms, so every input needs to
+    // have one.
+    bool term_ngram_index = true;
+    string term_ngram_params;
+
     priority_queue<MergeCursor *, vector<MergeCursor *>, CursorGt> pq;
-    for ( ; b != e; ++b) {
-	GlassTable *in = *b;
+    for (auto i = b; i != e; ++i) {
+	GlassTable *in = *i;
+	string ngram_params;
+	if (!in->get_exact_entry("N", ngram_params)) {
+	    term_ngram_index = false;
+	} else if (i == b) {
+	    term_ngram_params = ngram_params;
+	} else if (ngram_params != term_ngram_params) {
+	    term_ngram_index = false;
+	}
+
 	if (!in->empty()) {
+	    string params;
+	    if (!in->get_exact_entry("D", params)) {
+		deletion_index = false;
+	    } else if (first) {
+		deletion_params = params;
+	    } else if (params != deletion_params) {
+		deletion_index = false;
+	    }
+	    first = false;
 	    pq.push(new MergeCursor(in));
 	}
     }
@@ -421,6 +551,32 @@ merge_spellings(GlassTable * out,
 	pq.pop();
 
 	string key = cur->current_key;
+	bool keep_index = true;
+	const string * params = NULL;
+	if (key[0] == 'D') {
+	    keep_index = deletion_index;
+	    params = &deletion_params;
+	} else if (key[0] == 'N') {
+	    keep_index = term_ngram_index;
+	    params = &term_ngram_params;
+	}
+	if (params && (!keep_index || key.size() == 1)) {
+	    // Either drop the index, or copy its parameters (which we've
+	    // checked are the same for all inputs) once.
+	    if (keep_index) out->add(key, *params);
+	    while (true) {
+		if (cur->next()) {
+		    pq.push(cur);
+		} else {
+		    delete cur;
+		}
+		if (pq.empty() || pq.top()->current_key != key) break;
+		cur = pq.top();
+		pq.pop();
+	    }
+	    continue;
+	}
+
 	if (pq.empty() || pq.top()->current_key > key) {
 	    // No need to merge the tags, just copy the (possibly compressed)
 	    // tag value.
@@ -597,7 +753,8 @@ static void
 multimerge_postlists(Xapian::Compactor * compactor,
 		     GlassTable * out, const char * tmpdir,
 		     vector<GlassTable *> tmp,
-		     vector<Xapian::docid> off)
+		     vector<Xapian::docid> off,
+		     bool impact_bounds)
 {
     unsigned int c = 0;
     while (tmp.size() > 3) {
@@ -626,7 +783,7 @@ multimerge_postlists(Xapian::Compactor * compactor,
 	    tmptab->create_and_open(flags, root_info);
 
 	    merge_postlists(compactor, tmptab, off.begin() + i,
-			    tmp.begin() + i, tmp.begin() + j);
+			    tmp.begin() + i, tmp.begin() + j, false);
 	    if (c > 0) {
 		for (unsigned int k = i; k < j; ++k) {
 		    unlink(tmp[k]->get_path().c_str());
@@ -643,7 +800,8 @@ multimerge_postlists(Xapian::Compactor * compactor,
 	swap(off, newoff);
 	++c;
     }
-    merge_postlists(compactor, out, off.begin(), tmp.begin(), tmp.end());
+    merge_postlists(compactor, out, off.begin(), tmp.begin(), tmp.end(),
+		    impact_bounds);
     if (c > 0) {
 	for (size_t k = 0; k < tmp.size(); ++k) {
 	    unlink(tmp[k]->get_path().c_str());
@@ -807,6 +965,7 @@ GlassDatabase::compact(Xapian::Compactor * compactor,
 
     bool single_file = (flags & Xapian::DBCOMPACT_SINGLE_FILE);
     bool multipass = (flags & Xapian::DBCOMPACT_MULTIPASS);
+    bool impact_bounds = (flags & Xapian::DBCOMPACT_IMPACT_BOUNDS);
     if (single_file) {
 	// FIXME: Support this combination - we need to put temporary files
 	// somewhere.
@@ -999,10 +1158,11 @@ GlassDatabase::compact(Xapian::Compactor * compactor,
 	    case Glass::POSTLIST: {
 		if (multipass && inputs.size() > 3) {
 		    multimerge_postlists(compactor, out, destdir,
-					 inputs, offset);
+					 inputs, offset, impact_bounds);
 		} else {
 		    merge_postlists(compactor, out, offset.begin(),
-				    inputs.begin(), inputs.end());
+				    inputs.begin(), inputs.end(),
+				    impact_bounds);
 		}
 		break;
 	    }
@@ -1115,3 +1275,238 @@ GlassDatabase::compact(Xapian::Compactor * compactor,
 
     if (!single_file) lock.release();
 }
+
+/// The tables compact_incrementally() works through, in order.
+static const struct {
+    // The "base name" of the table.
+    const char * name;
+    // The type.
+    Glass::table_type type;
+} incremental_tables[] = {
+    { "postlist",	Glass::POSTLIST },
+    { "docdata",	Glass::DOCDATA },
+    { "termlist",	Glass::TERMLIST },
+    { "position",	Glass::POSITION },
+    { "spelling",	Glass::SPELLING },
+    { "synonym",	Glass::SYNONYM }
+};
+
+static const unsigned N_INCREMENTAL_TABLES =
+    sizeof(incremental_tables) / sizeof(incremental_tables[0]);
+
+/// Path of the compacted copy of table @a name which is to be swapped in.
+static string
+swap_table_path(const string & db_dir, const char * name)
+{
+    string path = db_dir;
+    path += '/';
+    path += name;
+    path += ".tmp." GLASS_TABLE_EXTENSION;
+    return path;
+}
+
+void
+GlassDatabase::recover_table_swap()
+{
+    LOGCALL_VOID(DB, "GlassDatabase::recover_table_swap", NO_ARGS);
+    string swap_file = db_dir;
+    swap_file += "/" GLASS_TABLE_SWAP_FILE;
+    if (!file_exists(swap_file)) return;
+
+    // If the compacted table is still waiting to be renamed into place, the
+    // old table and version file are still live, so undo the swap.
+    // Otherwise the table has been replaced, so finish the swap.
+    bool swapped = true;
+    for (unsigned i = 0; i != N_INCREMENTAL_TABLES; ++i) {
+	string tmp = swap_table_path(db_dir, incremental_tables[i].name);
+	if (file_exists(tmp)) {
+	    (void)io_unlink(tmp);
+	    swapped = false;
+	}
+    }
+    if (!swapped) {
+	(void)io_unlink(swap_file);
+	return;
+    }
+    if (!io_tmp_rename(swap_file, db_dir + "/iamglass")) {
+	throw Xapian::DatabaseError("Couldn't finish swapping in compacted "
+				    "table", errno);
+    }
+}
+
+bool
+GlassWritableDatabase::compact_incrementally(unsigned flags,
+					     double max_io_rate)
+{
+    LOGCALL(DB, bool, "GlassWritableDatabase::compact_incrementally", flags | max_io_rate);
+    if (transaction_active())
+	throw Xapian::InvalidOperationError("Can't compact during a transaction");
+    if (!postlist_table.is_open())
+	GlassTable::throw_database_closed();
+
+    // The compacted table is copied from the latest revision on disk.
+    commit();
+
+    GlassTable * tables[Glass::MAX_];
+    tables[Glass::POSTLIST] = &postlist_table;
+    tables[Glass::DOCDATA] = &docdata_table;
+    tables[Glass::TERMLIST] = &termlist_table;
+    tables[Glass::POSITION] = &position_table;
+    tables[Glass::SPELLING] = &spelling_table;
+    tables[Glass::SYNONYM] = &synonym_table;
+
+    // Lazy tables which haven't been created yet have nothing to compact.
+    while (compact_next != N_INCREMENTAL_TABLES &&
+	   !tables[incremental_tables[compact_next].type]->is_open()) {
+	++compact_next;
+    }
+    if (compact_next == N_INCREMENTAL_TABLES) {
+	compact_next = 0;
+	RETURN(false);
+    }
+    const char * name = incremental_tables[compact_next].name;
+    Glass::table_type type = incremental_tables[compact_next].type;
+    GlassTable * table = tables[type];
+    ++compact_next;
+
+    // Remove any compacted tables left behind by an earlier failure, so
+    // recover_table_swap() only ever sees the one for this swap.
+    for (unsigned i = 0; i != N_INCREMENTAL_TABLES; ++i) {
+	(void)io_unlink(swap_table_path(db_dir, incremental_tables[i].name));
+    }
+
+    int db_flags = postlist_table.get_flags();
+    glass_revision_number_t new_revision = get_next_revision_number();
+    string tmp_path = swap_table_path(db_dir, name);
+    string swap_file = db_dir;
+    swap_file += "/" GLASS_TABLE_SWAP_FILE;
+
+    Xapian::Compactor::compaction_level compaction =
+	static_cast<Xapian::Compactor::compaction_level>(flags & (Xapian::Compactor::STANDARD|Xapian::Compactor::FULL|Xapian::Compactor::FULLER));
+
+    const RootInfo & old_root = version_file.get_root(type);
+    RootInfo new_root;
+    new_root.init(old_root.get_blocksize(), old_root.get_compress_min());
+
+    bool swap_started = false;
+    try {
+	{
+	    string prefix = tmp_path;
+	    prefix.resize(prefix.size() - CONST_STRLEN(GLASS_TABLE_EXTENSION));
+	    GlassTable out(name, prefix, false);
+	    out.create_and_open(Xapian::DB_DANGEROUS, new_root);
+	    // Open it again as the previous revision so the blocks we write
+	    // are marked with new_revision.  Then a reader which opens the
+	    // new table with the old version file will notice the mismatch.
+	    out.open(Xapian::DB_DANGEROUS, new_root, new_revision - 1);
+	    out.set_full_compaction(compaction != Xapian::Compactor::STANDARD);
+	    if (compaction == Xapian::Compactor::FULLER) out.set_max_item_size(1);
+
+	    if (!table->empty()) {
+		GlassCursor cur(table);
+		cur.find_entry(string());
+		double start = RealTime::now();
+		double bytes = 0;
+		while (cur.next()) {
+		    bool compressed = cur.read_tag(true);
+		    out.add(cur.current_key, cur.current_tag, compressed);
+		    if (max_io_rate > 0.0) {
+			bytes += cur.current_key.size() + cur.current_tag.size();
+			// Don't get ahead of the I/O budget.
+			RealTime::sleep(start + bytes / max_io_rate);
+		    }
+		}
+	    }
+
+	    out.flush_db();
+	    out.commit(new_revision, &new_root);
+	    if (!out.sync()) {
+		throw Xapian::DatabaseError("Couldn't sync compacted table",
+					    errno);
+	    }
+	}
+
+	// The other tables are unchanged, but commit them at the new
+	// revision.
+	for (unsigned i = 0; i != N_INCREMENTAL_TABLES; ++i) {
+	    Glass::table_type t = incremental_tables[i].type;
+	    if (t == type) continue;
+	    tables[t]->flush_db();
+	    tables[t]->commit(new_revision, version_file.root_to_set(t));
+	}
+	*version_file.root_to_set(type) = new_root;
+
+	// A changeset can't describe the compacted table, so give the
+	// database a new UUID, which makes replicas take a fresh copy.
+	version_file.new_uuid();
+
+	const string & tmpfile = version_file.write(new_revision, db_flags);
+	for (unsigned i = 0; i != N_INCREMENTAL_TABLES; ++i) {
+	    Glass::table_type t = incremental_tables[i].type;
+	    if (t != type && !tables[t]->sync()) {
+		(void)io_unlink(tmpfile);
+		throw Xapian::DatabaseError("Commit failed", errno);
+	    }
+	}
+
+	// Once the new version file is in place as GLASS_TABLE_SWAP_FILE,
+	// recover_table_swap() can finish or undo the swap after a crash.
+	swap_started = true;
+	if (!version_file.sync(tmpfile, new_revision, db_flags, swap_file)) {
+	    throw Xapian::DatabaseError("Commit failed", errno);
+	}
+	if (!io_tmp_rename(tmp_path, table->get_path())) {
+	    throw Xapian::DatabaseError("Couldn't swap in compacted table",
+					errno);
+	}
+	if (!tmpfile.empty()) {
+	    if (!io_tmp_rename(swap_file, db_dir + "/iamglass")) {
+		throw Xapian::DatabaseError("Couldn't swap in compacted "
+					    "table", errno);
+	    }
+	}
+    } catch (const Xapian::Error & e) {
+	if (!swap_started) {
+	    (void)io_unlink(tmp_path);
+	    modifications_failed(new_revision, e.get_description());
+	    throw;
+	}
+	// We can't reliably get back to a consistent state in memory, so
+	// tidy up on disk as best we can and close the database.
+	try {
+	    recover_table_swap();
+	} catch (...) {
+	}
+	GlassDatabase::close();
+	throw;
+    }
+
+    changes.commit(new_revision, db_flags);
+
+    // Switch to the compacted table.
+    if (type == Glass::POSTLIST) {
+	postlist_table.open(db_flags, new_root, new_revision);
+    } else {
+	table->open(db_flags, new_root, new_revision);
+    }
+    value_manager.reset();
+
+    GlassChanges * p = changes.start(new_revision, new_revision + 1, db_flags);
+    version_file.set_changes(p);
+    postlist_table.set_changes(p);
+    position_table.set_changes(p);
+    termlist_table.set_changes(p);
+    synonym_table.set_changes(p);
+    spelling_table.set_changes(p);
+    docdata_table.set_changes(p);
+
+    while (compact_next != N_INCREMENTAL_TABLES &&
+	   !tables[incremental_tables[compact_next].type]->is_open()) {
+	++compact_next;
+    }
+    if (compact_next == N_INCREMENTAL_TABLES) {
+	compact_next = 0;
+	RETURN(false);
+    }
+    RETURN(true);
+}
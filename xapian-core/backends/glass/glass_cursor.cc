@@ -71,6 +71,7 @@ GlassCursor::GlassCursor(const GlassTable *B_, const Glass::Cursor * C_)
 void
 GlassCursor::rebuild()
 {
+    ++B->counts.cursor_rebuilds;
     int new_level = B->level;
     if (new_level <= level) {
 	for (int j = new_level; j <= level; ++j) {
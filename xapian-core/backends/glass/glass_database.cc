@@ -34,6 +34,7 @@
 #include "xapian/valueiterator.h"
 
 #include "backends/contiguousalldocspostlist.h"
+#include "glass_alldocsmodifiedpostlist.h"
 #include "glass_alldocspostlist.h"
 #include "glass_alltermslist.h"
 #include "glass_defs.h"
@@ -41,6 +42,7 @@
 #include "glass_document.h"
 #include "../flint_lock.h"
 #include "glass_metadata.h"
+#include "glass_modifiedpostlist.h"
 #include "glass_positionlist.h"
 #include "glass_postlist.h"
 #include "glass_replicate_internal.h"
@@ -50,13 +52,17 @@
 #include "glass_values.h"
 #include "debuglog.h"
 #include "fd.h"
+#include "filetests.h"
 #include "io_utils.h"
 #include "pack.h"
+#include "../prefix_compressed_strings.h"
 #include "net/remoteconnection.h"
 #include "api/replication.h"
+#include "replicate_utils.h"
 #include "replicationprotocol.h"
 #include "net/length.h"
 #include "posixy_wrapper.h"
+#include "realtime.h"
 #include "str.h"
 #include "stringutils.h"
 #include "backends/valuestats.h"
@@ -68,7 +74,11 @@
 #include <algorithm>
 #include "autoptr.h"
 #include <cstdlib>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 using namespace std;
 using namespace Xapian;
@@ -94,7 +104,7 @@ using Xapian::Internal::intrusive_ptr;
  * and stores handles to the tables.
  */
 GlassDatabase::GlassDatabase(const string &glass_dir, int flags,
-			     unsigned int block_size)
+			     unsigned int block_size, bool pin_revision)
 	: db_dir(glass_dir),
 	  readonly(flags == Xapian::DB_READONLY_),
 	  version_file(db_dir),
@@ -105,14 +115,19 @@ GlassDatabase::GlassDatabase(const string &glass_dir, int flags,
 	  termlist_table(db_dir, readonly, (flags & Xapian::DB_NO_TERMLIST)),
 	  value_manager(&postlist_table, &termlist_table),
 	  synonym_table(db_dir, readonly),
-	  spelling_table(db_dir, readonly),
+	  spelling_table(db_dir, readonly,
+			 !readonly && (flags & Xapian::DB_SPELLING_DELETION_INDEX)),
 	  docdata_table(db_dir, readonly),
 	  lock(db_dir),
 	  changes(db_dir)
 {
-    LOGCALL_CTOR(DB, "GlassDatabase", glass_dir | flags | block_size);
+    LOGCALL_CTOR(DB, "GlassDatabase", glass_dir | flags | block_size | pin_revision);
 
     if (readonly) {
+	if (pin_revision) {
+	    revision_pins = GlassRevisionPins::get(db_dir);
+	    revision_pin.init(revision_pins);
+	}
 	open_tables(flags);
 	return;
     }
@@ -140,6 +155,7 @@ GlassDatabase::GlassDatabase(const string &glass_dir, int flags,
 					      db_dir + "'", errno);
 	}
 	get_database_write_lock(flags, true);
+	init_revision_pins();
 
 	create_and_open_tables(flags, block_size);
 	return;
@@ -152,12 +168,15 @@ GlassDatabase::GlassDatabase(const string &glass_dir, int flags,
     }
 
     get_database_write_lock(flags, false);
+    init_revision_pins();
     // if we're overwriting, pretend the db doesn't exist
     if (action == Xapian::DB_CREATE_OR_OVERWRITE) {
 	create_and_open_tables(flags, block_size);
 	return;
     }
 
+    recover_table_swap();
+
     // Open the latest version of each table.
     open_tables(flags);
 }
@@ -185,6 +204,19 @@ GlassDatabase::~GlassDatabase()
     LOGCALL_DTOR(DB, "GlassDatabase");
 }
 
+void
+GlassDatabase::init_revision_pins()
+{
+    revision_pins = GlassRevisionPins::get(db_dir);
+    const GlassRevisionPins * pins = revision_pins.get();
+    postlist_table.set_revision_pins(pins);
+    position_table.set_revision_pins(pins);
+    termlist_table.set_revision_pins(pins);
+    synonym_table.set_revision_pins(pins);
+    spelling_table.set_revision_pins(pins);
+    docdata_table.set_revision_pins(pins);
+}
+
 bool
 GlassDatabase::database_exists() {
     LOGCALL(DB, bool, "GlassDatabase::database_exists", NO_ARGS);
@@ -212,6 +244,26 @@ GlassDatabase::create_and_open_tables(int flags, unsigned int block_size)
     Assert(database_exists());
 }
 
+/// How many times to retry opening tables which a writer is swapping.
+static const int MAX_TABLE_SWAP_RETRIES = 10;
+
+/** Wait for a writer to finish swapping in a table.
+ *
+ *  @return true if the revision is no longer @a rev.
+ */
+static bool
+wait_for_table_swap(const string & db_dir, glass_revision_number_t rev)
+{
+    string swap_file = db_dir;
+    swap_file += "/" GLASS_TABLE_SWAP_FILE;
+    for (int i = 0; i != 100 && file_exists(swap_file); ++i) {
+	RealTime::sleep(RealTime::now() + 0.001);
+    }
+    GlassVersion version_file(db_dir);
+    version_file.read();
+    return version_file.get_revision() != rev;
+}
+
 bool
 GlassDatabase::open_tables(int flags)
 {
@@ -229,20 +281,43 @@ GlassDatabase::open_tables(int flags)
 	    GlassTable::throw_database_closed();
     }
 
-    version_file.read();
-    glass_revision_number_t rev = version_file.get_revision();
-    if (cur_rev && cur_rev == rev) {
-	// We're reopening a database and the revision hasn't changed so we
-	// don't need to do anything.
-	RETURN(false);
+    // If we're pinning the revision we read, pin revision 0 (which stops
+    // the writer reusing any blocks) until we know which revision that is.
+    GlassRevisionPin provisional_pin;
+    if (readonly) {
+	provisional_pin.init(revision_pins);
+	provisional_pin.set(0);
     }
 
-    docdata_table.open(flags, version_file.get_root(Glass::DOCDATA), rev);
-    spelling_table.open(flags, version_file.get_root(Glass::SPELLING), rev);
-    synonym_table.open(flags, version_file.get_root(Glass::SYNONYM), rev);
-    termlist_table.open(flags, version_file.get_root(Glass::TERMLIST), rev);
-    position_table.open(flags, version_file.get_root(Glass::POSITION), rev);
-    postlist_table.open(flags, version_file.get_root(Glass::POSTLIST), rev);
+    glass_revision_number_t rev;
+    int retries = MAX_TABLE_SWAP_RETRIES;
+    while (true) {
+	version_file.read();
+	rev = version_file.get_revision();
+	if (cur_rev && cur_rev == rev) {
+	    // We're reopening a database and the revision hasn't changed so we
+	    // don't need to do anything.
+	    RETURN(false);
+	}
+	if (readonly) revision_pin.set(rev);
+
+	try {
+	    docdata_table.open(flags, version_file.get_root(Glass::DOCDATA), rev);
+	    spelling_table.open(flags, version_file.get_root(Glass::SPELLING), rev);
+	    synonym_table.open(flags, version_file.get_root(Glass::SYNONYM), rev);
+	    termlist_table.open(flags, version_file.get_root(Glass::TERMLIST), rev);
+	    position_table.open(flags, version_file.get_root(Glass::POSITION), rev);
+	    postlist_table.open(flags, version_file.get_root(Glass::POSTLIST), rev);
+	    break;
+	} catch (const Xapian::DatabaseError &) {
+	    // A writer compacting a table in place replaces the table file
+	    // just before the version file, so we may have read the old
+	    // version file and then opened the new table.
+	    if (!readonly || single_file() || --retries == 0 ||
+		!wait_for_table_swap(db_dir, rev))
+		throw;
+	}
+    }
 
     Xapian::termcount swfub = version_file.get_spelling_wordfreq_upper_bound();
     spelling_table.set_wordfreq_upper_bound(swfub);
@@ -385,6 +460,18 @@ GlassDatabase::readahead_for_query(const Xapian::Query &query)
     }
 }
 
+void
+GlassDatabase::add_table_counts(map<string, TableCounts> & counts) const
+{
+    const GlassTable * tables[] = {
+	&postlist_table, &position_table, &termlist_table,
+	&synonym_table, &spelling_table, &docdata_table
+    };
+    for (const GlassTable * table : tables) {
+	counts[table->get_tablename()] += table->get_counts();
+    }
+}
+
 bool
 GlassDatabase::reopen()
 {
@@ -404,6 +491,7 @@ GlassDatabase::close()
     spelling_table.close(true);
     docdata_table.close(true);
     lock.release();
+    revision_pin.release();
 }
 
 void
@@ -428,17 +516,20 @@ GlassDatabase::get_database_write_lock(int flags, bool creating)
 }
 
 void
-GlassDatabase::send_whole_database(RemoteConnection & conn, double end_time)
-{
-    LOGCALL_VOID(DB, "GlassDatabase::send_whole_database", conn | end_time);
-
-    // Send the current revision number in the header.
-    string buf;
-    string uuid = get_uuid();
-    buf += encode_length(uuid.size());
-    buf += uuid;
-    pack_uint(buf, get_revision_number());
-    conn.send_message(REPL_REPLY_DB_HEADER, buf, end_time);
+GlassDatabase::send_whole_database(RemoteConnection & conn,
+				   const string & copy_info, double end_time)
+{
+    LOGCALL_VOID(DB, "GlassDatabase::send_whole_database", conn | copy_info | end_time);
+
+    if (!copy_info_is_part(copy_info)) {
+	// Send the current revision number in the header.
+	string buf;
+	string uuid = get_uuid();
+	buf += encode_length(uuid.size());
+	buf += uuid;
+	pack_uint(buf, get_revision_number());
+	conn.send_message(REPL_REPLY_DB_HEADER, buf, end_time);
+    }
 
     // Send all the tables.  The tables which we want to be cached best after
     // the copy finishes are sent last.
@@ -458,8 +549,7 @@ GlassDatabase::send_whole_database(RemoteConnection & conn, double end_time)
 	filepath.replace(db_dir.size() + 1, string::npos, p, len);
 	FD fd(posixy_open(filepath.c_str(), O_RDONLY | O_CLOEXEC));
 	if (fd >= 0) {
-	    conn.send_message(REPL_REPLY_DB_FILENAME, string(p, len), end_time);
-	    conn.send_file(REPL_REPLY_DB_FILEDATA, fd, end_time);
+	    send_db_file(conn, string(p, len), fd, copy_info, end_time);
 	}
 	p += len + 1;
     } while (*p);
@@ -469,9 +559,10 @@ void
 GlassDatabase::write_changesets_to_fd(int fd,
 				      const string & revision,
 				      bool need_whole_db,
-				      ReplicationInfo * info)
+				      ReplicationInfo * info,
+				      const string & copy_info)
 {
-    LOGCALL_VOID(DB, "GlassDatabase::write_changesets_to_fd", fd | revision | need_whole_db | info);
+    LOGCALL_VOID(DB, "GlassDatabase::write_changesets_to_fd", fd | revision | need_whole_db | info | copy_info);
 
     int whole_db_copies_left = MAX_DB_COPIES_PER_CONVERSATION;
     glass_revision_number_t start_rev_num = 0;
@@ -486,6 +577,23 @@ GlassDatabase::write_changesets_to_fd(int fd,
     }
 
     RemoteConnection conn(-1, fd, string());
+    // Replicas always support compressed messages, so compress any large ones
+    // we send - table files and changesets usually compress well.
+    conn.set_compress_min(DEFAULT_COMPRESS_MIN);
+
+    if (copy_info_is_part(copy_info)) {
+	// We've been asked for one part of a copy of the whole database, to be
+	// sent in parallel with the other parts - if a copy is needed, the
+	// replica will follow up with a normal conversation to fill in any
+	// ranges which changed in the meantime.
+	if (!need_whole_db)
+	    need_whole_db = !changesets_available(revision);
+	if (need_whole_db) {
+	    send_whole_database(conn, copy_info, 0.0);
+	}
+	conn.send_message(REPL_REPLY_END_OF_CHANGES, string(), 0.0);
+	return;
+    }
 
     // While the starting revision number is less than the latest revision
     // number, look for a changeset, and write it.
@@ -510,7 +618,7 @@ GlassDatabase::write_changesets_to_fd(int fd,
 	    start_rev_num = get_revision_number();
 	    start_uuid = get_uuid();
 
-	    send_whole_database(conn, 0.0);
+	    send_whole_database(conn, copy_info, 0.0);
 	    if (info != NULL)
 		++(info->fullcopy_count);
 
@@ -590,6 +698,20 @@ GlassDatabase::write_changesets_to_fd(int fd,
     conn.send_message(REPL_REPLY_END_OF_CHANGES, string(), 0.0);
 }
 
+bool
+GlassDatabase::changesets_available(const string & start_revision) const
+{
+    LOGCALL(DB, bool, "GlassDatabase::changesets_available", start_revision);
+    glass_revision_number_t start_rev_num;
+    const char * p = start_revision.data();
+    const char * end = p + start_revision.size();
+    if (!unpack_uint(&p, end, &start_rev_num))
+	RETURN(false);
+    if (start_rev_num >= get_revision_number())
+	RETURN(true);
+    RETURN(file_exists(db_dir + "/changes" + str(start_rev_num)));
+}
+
 void
 GlassDatabase::modifications_failed(glass_revision_number_t new_revision,
 				    const std::string & msg)
@@ -792,7 +914,25 @@ GlassDatabase::get_wdf_upper_bound(const string & term) const
 {
     Xapian::termcount cf;
     get_freqs(term, NULL, &cf);
-    return min(cf, version_file.get_wdf_upper_bound());
+    Xapian::termcount ub = min(cf, version_file.get_wdf_upper_bound());
+    Xapian::termcount wdf_ub, doclen_lb;
+    if (!has_uncommitted_changes() &&
+	postlist_table.get_impact_bounds(term, wdf_ub, doclen_lb)) {
+	ub = min(ub, wdf_ub);
+    }
+    return ub;
+}
+
+Xapian::termcount
+GlassDatabase::get_term_doclength_lower_bound(const string & term) const
+{
+    Xapian::termcount lb = version_file.get_doclength_lower_bound();
+    Xapian::termcount wdf_ub, doclen_lb;
+    if (!has_uncommitted_changes() &&
+	postlist_table.get_impact_bounds(term, wdf_ub, doclen_lb)) {
+	lb = max(lb, doclen_lb);
+    }
+    return lb;
 }
 
 bool
@@ -903,6 +1043,12 @@ GlassDatabase::get_spelling_frequency(const string & word) const
     return spelling_table.get_word_frequency(word);
 }
 
+TermList *
+GlassDatabase::open_substring_termlist(const string & substring) const
+{
+    return spelling_table.open_substring_termlist(substring);
+}
+
 TermList *
 GlassDatabase::open_synonym_termlist(const string & term) const
 {
@@ -992,7 +1138,8 @@ GlassWritableDatabase::GlassWritableDatabase(const string &dir, int flags,
 	  change_count(0),
 	  flush_threshold(0),
 	  modify_shortcut_document(NULL),
-	  modify_shortcut_docid(0)
+	  modify_shortcut_docid(0),
+	  compact_next(0)
 {
     LOGCALL_CTOR(DB, "GlassWritableDatabase", dir | flags | block_size);
 
@@ -1001,6 +1148,13 @@ GlassWritableDatabase::GlassWritableDatabase(const string &dir, int flags,
 	flush_threshold = atoi(p);
     if (flush_threshold == 0)
 	flush_threshold = 10000;
+
+    // The term n-gram index has to contain every term, so we can only start
+    // one when there aren't any terms yet.
+    if ((flags & Xapian::DB_TERM_NGRAM_INDEX) && get_doccount() == 0)
+	spelling_table.enable_term_ngram_index();
+    if (spelling_table.has_term_ngram_index())
+	postlist_table.set_term_ngram_table(&spelling_table);
 }
 
 GlassWritableDatabase::~GlassWritableDatabase()
@@ -1116,6 +1270,114 @@ GlassWritableDatabase::add_document_(Xapian::docid did,
     RETURN(did);
 }
 
+Xapian::docid
+GlassWritableDatabase::add_documents(const vector<Xapian::Document> & docs)
+{
+    LOGCALL(DB, Xapian::docid, "GlassWritableDatabase::add_documents", docs.size());
+    if (docs.empty())
+	RETURN(0);
+    // Make sure the docid counter doesn't overflow.
+    if (GLASS_MAX_DOCID - version_file.get_last_docid() < docs.size())
+	throw Xapian::DatabaseError("Run out of docids - you'll have to use copydatabase to eliminate any gaps before you can add more documents");
+
+    Xapian::docid first_did = version_file.get_last_docid() + 1;
+
+    // Rather than passing each posting to the inverter, which means searching
+    // its maps once per posting, gather the batch's postings by term and pass
+    // each distinct term's postings over in one go.
+    unordered_map<string, unsigned> term_index;
+    vector<const string *> term_names;
+    vector<pair<unsigned, pair<Xapian::docid, Xapian::termcount>>> postings;
+    vector<pair<unsigned, pair<Xapian::docid, string>>> positions;
+    try {
+	for (const Xapian::Document & document : docs) {
+	    Xapian::docid did = version_file.get_next_docid();
+	    docdata_table.replace_document_data(did, document.get_data());
+	    value_manager.add_document(did, document, value_stats);
+
+	    Xapian::termcount new_doclen = 0;
+	    Xapian::TermIterator term = document.termlist_begin();
+	    for ( ; term != document.termlist_end(); ++term) {
+		termcount wdf = term.get_wdf();
+		new_doclen += wdf;
+		version_file.check_wdf(wdf);
+
+		string tname = *term;
+		if (tname.size() > MAX_SAFE_TERM_LENGTH)
+		    throw Xapian::InvalidArgumentError("Term too long (> " STRINGIZE(MAX_SAFE_TERM_LENGTH) "): " + tname);
+
+		auto r = term_index.insert(make_pair(tname, term_names.size()));
+		if (r.second) term_names.push_back(&r.first->first);
+		unsigned t = r.first->second;
+		postings.push_back(make_pair(t, make_pair(did, wdf)));
+
+		string s;
+		if (Inverter::pack_positions(position_table, term, s)) {
+		    positions.push_back(make_pair(t, make_pair(did, string())));
+		    swap(positions.back().second.second, s);
+		}
+	    }
+
+	    if (termlist_table.is_open())
+		termlist_table.set_termlist(did, document, new_doclen);
+
+	    inverter.set_doclength(did, new_doclen, true);
+	    version_file.add_document(new_doclen);
+	}
+
+	// Group the postings by term with a counting sort, which keeps each
+	// term's postings in ascending docid order.
+	size_t n_terms = term_names.size();
+	vector<size_t> starts(n_terms + 1);
+	for (const auto & posting : postings) ++starts[posting.first + 1];
+	for (size_t t = 0; t != n_terms; ++t) starts[t + 1] += starts[t];
+	{
+	    vector<pair<Xapian::docid, Xapian::termcount>> by_term(postings.size());
+	    vector<size_t> next(starts.begin(), starts.end() - 1);
+	    for (const auto & posting : postings)
+		by_term[next[posting.first]++] = posting.second;
+	    postings.clear();
+	    for (size_t t = 0; t != n_terms; ++t) {
+		inverter.add_postings(*term_names[t],
+				      by_term.data() + starts[t],
+				      by_term.data() + starts[t + 1]);
+	    }
+	}
+
+	if (!positions.empty()) {
+	    fill(starts.begin(), starts.end(), 0);
+	    for (const auto & pos : positions) ++starts[pos.first + 1];
+	    for (size_t t = 0; t != n_terms; ++t) starts[t + 1] += starts[t];
+	    vector<pair<Xapian::docid, string>> by_term(positions.size());
+	    vector<size_t> next(starts.begin(), starts.end() - 1);
+	    for (auto & pos : positions) {
+		auto & dest = by_term[next[pos.first]++];
+		dest.first = pos.second.first;
+		swap(dest.second, pos.second.second);
+	    }
+	    positions.clear();
+	    for (size_t t = 0; t != n_terms; ++t) {
+		if (starts[t] == starts[t + 1]) continue;
+		inverter.set_positionlists(*term_names[t],
+					   by_term.data() + starts[t],
+					   by_term.data() + starts[t + 1]);
+	    }
+	}
+    } catch (...) {
+	// As for add_document_(), discard all the uncommitted changes.
+	cancel();
+	throw;
+    }
+
+    change_count += docs.size();
+    if (change_count >= flush_threshold) {
+	flush_postlist_changes();
+	if (!transaction_active()) apply();
+    }
+
+    RETURN(first_did);
+}
+
 void
 GlassWritableDatabase::delete_document(Xapian::docid did)
 {
@@ -1437,14 +1699,22 @@ GlassWritableDatabase::open_post_list(const string& tname) const
 	if (version_file.get_last_docid() == doccount) {
 	    RETURN(new ContiguousAllDocsPostList(ptrtothis, doccount));
 	}
-	inverter.flush_doclengths(postlist_table);
-	RETURN(new GlassAllDocsPostList(ptrtothis, doccount));
+	if (inverter.doclen_changes.empty()) {
+	    RETURN(new GlassAllDocsPostList(ptrtothis, doccount));
+	}
+	RETURN(new GlassAllDocsModifiedPostList(ptrtothis, doccount,
+						inverter.doclen_changes));
     }
 
-    // Flush any buffered changes for this term's postlist so we can just
-    // iterate from the flushed state.
-    inverter.flush_post_list(postlist_table, tname);
+    // Buffered positional changes are just replacements of whole entries, so
+    // flush those, but merge in any buffered changes to this term's postlist
+    // as we iterate so we don't have to rewrite its chunks until commit.
     inverter.flush_pos_lists(position_table);
+    const map<Xapian::docid, Xapian::termcount> * mods;
+    mods = inverter.get_post_list_changes(tname);
+    if (mods) {
+	RETURN(new GlassModifiedPostList(ptrtothis, tname, *mods));
+    }
     RETURN(new GlassPostList(ptrtothis, tname, true));
 }
 
@@ -1537,6 +1807,38 @@ GlassWritableDatabase::open_spelling_wordlist() const
     return GlassDatabase::open_spelling_wordlist();
 }
 
+TermList *
+GlassWritableDatabase::open_substring_termlist(const string & substring) const
+{
+    // Terms are only added to and removed from the index as their postlist
+    // changes are flushed, so adjust the list for any buffered changes rather
+    // than flushing them.
+    vector<string> changed;
+    inverter.find_changed_terms(substring, changed);
+    TermList * tl = GlassDatabase::open_substring_termlist(substring);
+    if (!tl || changed.empty()) return tl;
+
+    set<string> terms;
+    AutoPtr<TermList> flushed(tl);
+    for (flushed->next(); !flushed->at_end(); flushed->next()) {
+	terms.insert(flushed->get_termname());
+    }
+    for (const string & term : changed) {
+	if (term_exists(term)) {
+	    terms.insert(term);
+	} else {
+	    terms.erase(term);
+	}
+    }
+
+    string encoded;
+    PrefixCompressedStringWriter out(encoded);
+    for (const string & term : terms) {
+	out.append(term);
+    }
+    return new GlassSpellingTermList(encoded);
+}
+
 TermList *
 GlassWritableDatabase::open_synonym_keylist(const string & prefix) const
 {
@@ -30,6 +30,7 @@
 #include "glass_changes.h"
 #include "glass_docdata.h"
 #include "glass_inverter.h"
+#include "glass_pins.h"
 #include "glass_positionlist.h"
 #include "glass_postlist.h"
 #include "glass_spelling.h"
@@ -47,6 +48,7 @@
 #include "xapian/constants.h"
 
 #include <map>
+#include <vector>
 
 class GlassTermList;
 class GlassAllDocsPostList;
@@ -113,6 +115,18 @@ class GlassDatabase : public Xapian::Database::Internal {
 	/// Replication changesets.
 	GlassChanges changes;
 
+	/** Revisions pinned by readers in this process.
+	 *
+	 *  Only set if we're writable, or are pinning the revision we read.
+	 */
+	std::shared_ptr<GlassRevisionPins> revision_pins;
+
+	/// Our pin on the revision we're reading, if we're pinning it.
+	GlassRevisionPin revision_pin;
+
+	/// Stop the tables reusing blocks which pinned revisions may be using.
+	void init_revision_pins();
+
 	/** Return true if a database exists at the path specified for this
 	 *  database.
 	 */
@@ -133,6 +147,12 @@ class GlassDatabase : public Xapian::Database::Internal {
 	 */
 	bool open_tables(int flags);
 
+	/** Finish or undo an in-place table swap interrupted by a crash.
+	 *
+	 *  See GlassWritableDatabase::compact_incrementally().
+	 */
+	void recover_table_swap();
+
 	/** Get a write lock on the database, or throw an
 	 *  Xapian::DatabaseLockError if failure.
 	 *
@@ -195,8 +215,12 @@ class GlassDatabase : public Xapian::Database::Internal {
 	void cancel();
 
 	/** Send a set of messages which transfer the whole database.
+	 *
+	 *  @param copy_info	Information about the copy, as passed to
+	 *			write_changesets_to_fd().
 	 */
-	void send_whole_database(RemoteConnection & conn, double end_time);
+	void send_whole_database(RemoteConnection & conn,
+				 const string & copy_info, double end_time);
 
 	/** Get the revision stored in a changeset.
 	 */
@@ -223,9 +247,13 @@ class GlassDatabase : public Xapian::Database::Internal {
 	 *                    tables.  This is only important, and has the
 	 *                    correct value, when the database is being
 	 *                    created.
+	 *
+	 *  @param pin_revision If opening read-only, stop a writer in this
+	 *			process from reusing blocks of the revision we
+	 *			read (see Xapian::DB_PIN_REVISION).
 	 */
 	explicit GlassDatabase(const string &db_dir_, int flags = Xapian::DB_READONLY_,
-		      unsigned int block_size = 0u);
+		      unsigned int block_size = 0u, bool pin_revision = false);
 
 	explicit GlassDatabase(int fd);
 
@@ -260,6 +288,7 @@ class GlassDatabase : public Xapian::Database::Internal {
 	Xapian::termcount get_doclength_lower_bound() const;
 	Xapian::termcount get_doclength_upper_bound() const;
 	Xapian::termcount get_wdf_upper_bound(const string & term) const;
+	Xapian::termcount get_term_doclength_lower_bound(const string & term) const;
 	bool term_exists(const string & tname) const;
 	bool has_positions() const;
 
@@ -275,6 +304,8 @@ class GlassDatabase : public Xapian::Database::Internal {
 	TermList * open_spelling_wordlist() const;
 	Xapian::doccount get_spelling_frequency(const string & word) const;
 
+	TermList * open_substring_termlist(const string & substring) const;
+
 	TermList * open_synonym_termlist(const string & term) const;
 	TermList * open_synonym_keylist(const string & prefix) const;
 
@@ -283,12 +314,15 @@ class GlassDatabase : public Xapian::Database::Internal {
 	void write_changesets_to_fd(int fd,
 				    const string & start_revision,
 				    bool need_whole_db,
-				    Xapian::ReplicationInfo * info);
+				    Xapian::ReplicationInfo * info,
+				    const string & copy_info);
+	bool changesets_available(const string & start_revision) const;
 	string get_revision_info() const;
 	string get_uuid() const;
 
 	void request_document(Xapian::docid /*did*/) const;
 	void readahead_for_query(const Xapian::Query &query);
+	void add_table_counts(map<string, TableCounts> & counts) const;
 	//@}
 
 	XAPIAN_NORETURN(void throw_termlist_table_close_exception() const);
@@ -344,6 +378,9 @@ class GlassWritableDatabase : public GlassDatabase {
 	 */
 	mutable Xapian::docid modify_shortcut_docid;
 
+	/// Index of the next table for compact_incrementally() to compact.
+	unsigned compact_next;
+
 	/// Flush any unflushed postlist changes, but don't commit them.
 	void flush_postlist_changes() const;
 
@@ -364,6 +401,7 @@ class GlassWritableDatabase : public GlassDatabase {
 
 	Xapian::docid add_document(const Xapian::Document & document);
 	Xapian::docid add_document_(Xapian::docid did, const Xapian::Document & document);
+	Xapian::docid add_documents(const std::vector<Xapian::Document> & docs);
 	// Stop the default implementation of delete_document(term) and
 	// replace_document(term) from being hidden.  This isn't really
 	// a problem as we only try to call them through the base class
@@ -419,6 +457,8 @@ class GlassWritableDatabase : public GlassDatabase {
 	void remove_spelling(const string & word, Xapian::termcount freqdec) const;
 	TermList * open_spelling_wordlist() const;
 
+	TermList * open_substring_termlist(const string & substring) const;
+
 	TermList * open_synonym_keylist(const string & prefix) const;
 	void add_synonym(const string & word, const string & synonym) const;
 	void remove_synonym(const string & word, const string & synonym) const;
@@ -426,6 +466,8 @@ class GlassWritableDatabase : public GlassDatabase {
 
 	void set_metadata(const string & key, const string & value);
 	void invalidate_doc_object(Xapian::Document::Internal * obj) const;
+
+	bool compact_incrementally(unsigned flags, double max_io_rate);
 	//@}
 
 	/** Return true if there are uncommitted changes. */
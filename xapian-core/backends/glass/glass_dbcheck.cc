@@ -124,6 +124,27 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 		continue;
 	    }
 
+	    if (key.size() >= 2 && key[0] == '\0' && key[1] == '\xc8') {
+		// Impact bounds (or the revision they're valid for).  We don't
+		// check the bounds against the postlists as they may be stale.
+		cursor->read_tag();
+		const char * p = cursor->current_tag.data();
+		const char * end = p + cursor->current_tag.size();
+		Xapian::termcount v;
+		bool ok;
+		if (key.size() == 2) {
+		    ok = unpack_uint_last(&p, end, &v);
+		} else {
+		    ok = unpack_uint(&p, end, &v) && unpack_uint_last(&p, end, &v);
+		}
+		if (!ok) {
+		    if (out)
+			*out << "Bad impact bounds entry" << endl;
+		    ++errors;
+		}
+		continue;
+	    }
+
 	    if (key.size() >= 2 && key[0] == '\0' && key[1] == '\xe0') {
 		// doclen chunk
 		const char * pos, * end;
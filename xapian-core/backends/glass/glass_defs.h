@@ -26,6 +26,12 @@
 /// Glass table extension.
 #define GLASS_TABLE_EXTENSION "glass"
 
+/** The version file for an in-place table swap which is in progress.
+ *
+ *  See GlassWritableDatabase::compact_incrementally().
+ */
+#define GLASS_TABLE_SWAP_FILE "iamglass.swap"
+
 /// Default B-tree block size.
 #define GLASS_DEFAULT_BLOCKSIZE 8192
 
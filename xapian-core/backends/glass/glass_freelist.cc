@@ -23,6 +23,7 @@
 
 #include "glass_freelist.h"
 
+#include "glass_pins.h"
 #include "glass_table.h"
 #include "xapian/error.h"
 
@@ -89,6 +90,21 @@ GlassFreeList::get_block(const GlassTable *B, uint4 block_size,
 	read_block(B, fl.n, p);
     }
 
+    if (revision_pins) {
+	// Don't reuse a block which a pinned revision may still be using.
+	// A freelist block's revision is that of the last commit which added
+	// entries to it, so that's one bound on when the next entry was freed,
+	// and the end of the entries from each commit gives us another.
+	while (!commit_ends.empty() && commit_ends.front().second == fl) {
+	    commit_ends.pop_front();
+	}
+	uint4 oldest = revision_pins->get_oldest();
+	if (REVISION(p) > oldest &&
+	    (commit_ends.empty() || commit_ends.front().first > oldest)) {
+	    return first_unused_block++;
+	}
+    }
+
     // Either the freelist end is in this block, or this freelist block has a
     // next pointer.
     Assert(fl.n == fl_end.n || aligned_read4(p + FREELIST_END - 4) != UNUSED);
@@ -197,6 +213,7 @@ GlassFreeList::mark_block_unused(const GlassTable * B, uint4 block_size, uint4 b
 	flw.c = C_BASE;
 	if (fl.c == 0) {
 	    fl = fl_end = flw;
+	    commit_ends.clear();
 	}
 	flw_appending = (n == first_unused_block - 1);
 	aligned_write4(pw + FREELIST_END - 4, UNUSED);
@@ -247,6 +264,10 @@ GlassFreeList::commit(const GlassTable * B, uint4 block_size)
 	}
 	flw_appending = true;
 	fl_end = flw;
+	if (revision_pins &&
+	    (commit_ends.empty() || commit_ends.back().second != fl_end)) {
+	    commit_ends.push_back(make_pair(revision, fl_end));
+	}
     }
 }
 
@@ -25,6 +25,10 @@
 #include "glass_defs.h"
 #include "pack.h"
 
+#include <deque>
+#include <utility>
+
+class GlassRevisionPins;
 class GlassTable;
 
 class GlassFLCursor {
@@ -88,18 +92,32 @@ class GlassFreeList {
     /// Current freelist block we're writing.
     byte * pw;
 
+    /// Revisions pinned by readers, or NULL.
+    const GlassRevisionPins * revision_pins;
+
+    /** Where the entries added by each recent commit end.
+     *
+     *  Each element is a revision and the value fl_end had once it was
+     *  committed, so the blocks listed before that position were freed by
+     *  that revision or earlier.  Elements are dropped once fl reaches them.
+     *  Only maintained if revision_pins is set.
+     */
+    std::deque<std::pair<uint4, GlassFLCursor>> commit_ends;
+
   public:
     GlassFreeList() {
 	revision = 0;
 	first_unused_block = 0;
 	flw_appending = false;
 	p = pw = NULL;
+	revision_pins = NULL;
     }
 
     void reset() {
 	revision = 0;
 	first_unused_block = 0;
 	flw_appending = false;
+	commit_ends.clear();
     }
 
     ~GlassFreeList() { delete [] p; delete [] pw; }
@@ -113,6 +131,15 @@ class GlassFreeList {
 
     void mark_block_unused(const GlassTable * B, uint4 block_size, uint4 n);
 
+    /** Set the revisions pinned by readers.
+     *
+     *  Blocks which a pinned revision may still be using won't be returned by
+     *  get_block().  The object isn't owned by the freelist.
+     */
+    void set_revision_pins(const GlassRevisionPins * pins) {
+	revision_pins = pins;
+    }
+
     uint4 get_revision() const { return revision; }
     void set_revision(uint4 revision_) { revision = revision_; }
 
@@ -138,6 +165,9 @@ class GlassFreeList {
 	if (r) {
 	    fl_end = flw;
 	    flw_appending = false;
+	    commit_ends.clear();
+	    if (revision_pins)
+		commit_ends.push_back(std::make_pair(revision, fl_end));
 	}
 	return r;
     }
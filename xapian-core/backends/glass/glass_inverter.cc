@@ -36,11 +36,9 @@ void
 Inverter::store_positions(const GlassPositionListTable & position_table,
 			  Xapian::docid did,
 			  const string & tname,
-			  const vector<Xapian::termpos> & posvec,
+			  string & s,
 			  bool modifying)
 {
-    string s;
-    position_table.pack(s, posvec);
     if (modifying) {
 	map<string, map<Xapian::docid, string> >::iterator i;
 	i = pos_changes.find(tname);
@@ -64,6 +62,26 @@ Inverter::store_positions(const GlassPositionListTable & position_table,
     set_positionlist(did, tname, s);
 }
 
+bool
+Inverter::pack_positions(const GlassPositionListTable & position_table,
+			 const Xapian::TermIterator & term,
+			 string & s)
+{
+    const Xapian::termpos * begin;
+    const Xapian::termpos * end;
+    if (term.internal->get_termpos_array(begin, end)) {
+	if (begin == end) return false;
+	position_table.pack(s, begin, end);
+	return true;
+    }
+
+    Xapian::PositionIterator pos = term.positionlist_begin();
+    if (pos == term.positionlist_end()) return false;
+    vector<Xapian::termpos> posvec(pos, Xapian::PositionIterator());
+    position_table.pack(s, posvec.data(), posvec.data() + posvec.size());
+    return true;
+}
+
 void
 Inverter::set_positionlist(const GlassPositionListTable & position_table,
 			   Xapian::docid did,
@@ -71,26 +89,31 @@ Inverter::set_positionlist(const GlassPositionListTable & position_table,
 			   const Xapian::TermIterator & term,
 			   bool modifying)
 {
-    const std::vector<Xapian::termpos> * ptr;
-    ptr = term.internal->get_vector_termpos();
-    if (ptr) {
-	if (!ptr->empty()) {
-	    store_positions(position_table, did, tname, *ptr, modifying);
-	    return;
-	}
-    } else {
-	Xapian::PositionIterator pos = term.positionlist_begin();
-	if (pos != term.positionlist_end()) {
-	    vector<Xapian::termpos> posvec(pos, Xapian::PositionIterator());
-	    store_positions(position_table, did, tname, posvec, modifying);
-	    return;
-	}
+    string s;
+    if (pack_positions(position_table, term, s)) {
+	store_positions(position_table, did, tname, s, modifying);
+	return;
     }
     // If we get here, the new position list was empty.
     if (modifying)
 	delete_positionlist(did, tname);
 }
 
+void
+Inverter::set_positionlists(const string & term,
+			    pair<Xapian::docid, string> * begin,
+			    pair<Xapian::docid, string> * end)
+{
+    map<Xapian::docid, string> & m =
+	pos_changes.insert(make_pair(term, map<Xapian::docid, string>()))
+	    .first->second;
+    for ( ; begin != end; ++begin) {
+	// New documents get docids higher than any already buffered.
+	swap(m.emplace_hint(m.end(), begin->first, string())->second,
+	     begin->second);
+    }
+}
+
 void
 Inverter::set_positionlist(Xapian::docid did,
 			   const string & term,
@@ -73,6 +73,9 @@ class Inverter {
 	    pl_changes.insert(std::make_pair(did, DELETED_POSTING));
 	}
 
+	/// Constructor for postings to be added with add_new_postings().
+	PostingChanges() : tf_delta(0), cf_delta(0) { }
+
 	/// Constructor for an updated posting.
 	PostingChanges(Xapian::docid did, Xapian::termcount old_wdf,
 		       Xapian::termcount new_wdf)
@@ -89,6 +92,22 @@ class Inverter {
 	    pl_changes[did] = wdf;
 	}
 
+	/** Add postings for new documents.
+	 *
+	 *  @param begin,end	(docid, wdf) pairs in ascending docid order.
+	 *			New documents get docids higher than any
+	 *			already buffered, so each can go at the end.
+	 */
+	void add_new_postings(const std::pair<Xapian::docid, Xapian::termcount> * begin,
+			      const std::pair<Xapian::docid, Xapian::termcount> * end) {
+	    for ( ; begin != end; ++begin) {
+		++tf_delta;
+		cf_delta += begin->second;
+		pl_changes.emplace_hint(pl_changes.end(), *begin)->second =
+		    begin->second;
+	    }
+	}
+
 	/// Remove a posting.
 	void remove_posting(Xapian::docid did, Xapian::termcount wdf) {
 	    --tf_delta;
@@ -109,6 +128,11 @@ class Inverter {
 
 	/// Get the collection frequency delta.
 	Xapian::termcount_diff get_cfdelta() const { return cf_delta; }
+
+	/// Get the changes to this term's postlist.
+	const std::map<Xapian::docid, Xapian::termcount> & get_changes() const {
+	    return pl_changes;
+	}
     };
 
     /// Buffered changes to postlists.
@@ -120,7 +144,7 @@ class Inverter {
     void store_positions(const GlassPositionListTable & position_table,
 			 Xapian::docid did,
 			 const std::string & tname,
-			 const std::vector<Xapian::termpos> & posvec,
+			 std::string & s,
 			 bool modifying);
 
     void set_positionlist(Xapian::docid did,
@@ -144,6 +168,22 @@ class Inverter {
 	}
     }
 
+    /** Add the postings of @a term for a batch of new documents.
+     *
+     *  @param begin,end	(docid, wdf) pairs in ascending docid order.
+     */
+    void add_postings(const std::string & term,
+		      const std::pair<Xapian::docid, Xapian::termcount> * begin,
+		      const std::pair<Xapian::docid, Xapian::termcount> * end) {
+	std::map<std::string, PostingChanges>::iterator i;
+	i = postlist_changes.lower_bound(term);
+	if (i == postlist_changes.end() || i->first != term) {
+	    i = postlist_changes.insert(i,
+					std::make_pair(term, PostingChanges()));
+	}
+	i->second.add_new_postings(begin, end);
+    }
+
     void remove_posting(Xapian::docid did, const std::string & term,
 			Xapian::doccount wdf) {
 	std::map<std::string, PostingChanges>::iterator i;
@@ -175,6 +215,24 @@ class Inverter {
 			  const Xapian::TermIterator & term,
 			  bool modifying = false);
 
+    /** Set the positional data of @a term for a batch of new documents.
+     *
+     *  @param begin,end	(docid, encoded positions) pairs in ascending
+     *			docid order.  The strings are swapped out of
+     *			the pairs rather than copied.
+     */
+    void set_positionlists(const std::string & term,
+			   std::pair<Xapian::docid, std::string> * begin,
+			   std::pair<Xapian::docid, std::string> * end);
+
+    /** Encode the positions of @a term into @a s.
+     *
+     *  @return false if @a term has no positions.
+     */
+    static bool pack_positions(const GlassPositionListTable & position_table,
+			       const Xapian::TermIterator & term,
+			       std::string & s);
+
     void delete_positionlist(Xapian::docid did,
 			     const std::string & term);
 
@@ -231,6 +289,36 @@ class Inverter {
     /// Flush position changes.
     void flush_pos_lists(GlassPositionListTable & table);
 
+    /** Get the buffered changes to the postlist for @a term.
+     *
+     *  Deleted postings have wdf DELETED_POSTING.
+     *
+     *  @return NULL if there are no buffered changes for @a term.
+     */
+    const std::map<Xapian::docid, Xapian::termcount> *
+    get_post_list_changes(const std::string & term) const {
+	std::map<std::string, PostingChanges>::const_iterator i;
+	i = postlist_changes.find(term);
+	if (i == postlist_changes.end()) {
+	    return NULL;
+	}
+	return &i->second.get_changes();
+    }
+
+    /** Find the terms with buffered postlist changes containing a string.
+     *
+     *  @param substring	The string to look for.
+     *  @param terms	Matching terms are appended to this, in order.
+     */
+    void find_changed_terms(const std::string & substring,
+			    std::vector<std::string> & terms) const {
+	std::map<std::string, PostingChanges>::const_iterator i;
+	for (i = postlist_changes.begin(); i != postlist_changes.end(); ++i) {
+	    if (i->first.find(substring) != std::string::npos)
+		terms.push_back(i->first);
+	}
+    }
+
     bool get_deltas(const std::string & term,
 		    Xapian::termcount_diff & tf_delta,
 		    Xapian::termcount_diff & cf_delta) const {
@@ -0,0 +1,162 @@
+/** @file glass_modifiedpostlist.cc
+ * @brief A GlassPostList plus pending modifications
+ */
+/* Copyright (C) 2006,2007,2008,2009,2010,2011 Olly Betts
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+#include "glass_modifiedpostlist.h"
+
+#include <algorithm>
+
+#include "glass_database.h"
+#include "glass_inverter.h"
+#include "debuglog.h"
+
+using namespace std;
+
+void
+GlassModifiedPostList::skip_deletes(double w_min)
+{
+    while (!GlassPostList::at_end()) {
+	while (it != mods.end() && it->second == DELETED_POSTING &&
+	       it->first < GlassPostList::get_docid())
+	    ++it;
+	if (it == mods.end()) return;
+	if (it->first != GlassPostList::get_docid()) return;
+	if (it->second != DELETED_POSTING) return;
+	++it;
+	GlassPostList::next(w_min);
+    }
+    while (it != mods.end() && it->second == DELETED_POSTING) ++it;
+}
+
+Xapian::doccount
+GlassModifiedPostList::get_termfreq() const
+{
+    Xapian::doccount tf;
+    this_db->get_freqs(term, &tf, NULL);
+    return tf;
+}
+
+Xapian::docid
+GlassModifiedPostList::get_docid() const
+{
+    if (it == mods.end()) return GlassPostList::get_docid();
+    if (GlassPostList::at_end()) return it->first;
+    Assert(it->second != DELETED_POSTING);
+    return min(it->first, GlassPostList::get_docid());
+}
+
+Xapian::termcount
+GlassModifiedPostList::get_doclength() const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassModifiedPostList::get_doclength", NO_ARGS);
+    if (current_is_modified())
+	RETURN(this_db->get_doclength(it->first));
+    RETURN(GlassPostList::get_doclength());
+}
+
+Xapian::termcount
+GlassModifiedPostList::get_unique_terms() const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassModifiedPostList::get_unique_terms", NO_ARGS);
+    if (current_is_modified())
+	RETURN(this_db->get_unique_terms(it->first));
+    RETURN(GlassPostList::get_unique_terms());
+}
+
+Xapian::termcount
+GlassModifiedPostList::get_wdf() const
+{
+    if (current_is_modified()) return it->second;
+    return GlassPostList::get_wdf();
+}
+
+PositionList *
+GlassModifiedPostList::read_position_list()
+{
+    if (current_is_modified()) {
+	poslist.reset(this_db->open_position_list(it->first, term));
+	return poslist.get();
+    }
+    return GlassPostList::read_position_list();
+}
+
+PositionList *
+GlassModifiedPostList::open_position_list() const
+{
+    if (current_is_modified()) {
+	return this_db->open_position_list(it->first, term);
+    }
+    return GlassPostList::open_position_list();
+}
+
+PostList *
+GlassModifiedPostList::next(double w_min)
+{
+    if (have_started) {
+	if (GlassPostList::at_end()) {
+	    ++it;
+	    skip_deletes(w_min);
+	    return NULL;
+	}
+	Xapian::docid unmod_did = GlassPostList::get_docid();
+	if (it != mods.end() && it->first <= unmod_did) {
+	    if (it->first < unmod_did && it->second != DELETED_POSTING) {
+		++it;
+		skip_deletes(w_min);
+		return NULL;
+	    }
+	    ++it;
+	}
+    }
+    GlassPostList::next(w_min);
+    skip_deletes(w_min);
+    return NULL;
+}
+
+PostList *
+GlassModifiedPostList::skip_to(Xapian::docid desired_did, double w_min)
+{
+    if (!GlassPostList::at_end()) {
+	GlassPostList::skip_to(desired_did, w_min);
+    } else {
+	// The committed postlist is empty, so GlassPostList::skip_to() isn't
+	// called, but next() still needs to know we've started.
+	have_started = true;
+    }
+    if (it != mods.end() && it->first < desired_did)
+	it = mods.lower_bound(desired_did);
+    skip_deletes(w_min);
+    return NULL;
+}
+
+bool
+GlassModifiedPostList::at_end() const
+{
+    return it == mods.end() && GlassPostList::at_end();
+}
+
+string
+GlassModifiedPostList::get_description() const
+{
+    string desc = "GlassModifiedPostList(";
+    desc += GlassPostList::get_description();
+    desc += ')';
+    return desc;
+}
@@ -0,0 +1,95 @@
+/** @file glass_modifiedpostlist.h
+ * @brief A GlassPostList plus pending modifications
+ */
+/* Copyright (C) 2006,2007,2008,2009,2010,2011 Olly Betts
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_MODIFIEDPOSTLIST_H
+#define XAPIAN_INCLUDED_GLASS_MODIFIEDPOSTLIST_H
+
+#include <map>
+#include <string>
+
+#include "autoptr.h"
+#include "glass_postlist.h"
+
+/** A GlassPostList plus the changes buffered in the Inverter.
+ *
+ *  This allows a WritableDatabase to be searched without having to flush
+ *  the buffered changes for each term to the postlist table first.
+ */
+class GlassModifiedPostList : public GlassPostList {
+    /// Don't allow assignment.
+    void operator=(const GlassModifiedPostList &);
+
+    /// Don't allow copying.
+    GlassModifiedPostList(const GlassModifiedPostList &);
+
+    /** Modifications to apply to the GlassPostList.
+     *
+     *  We take a copy so that further changes don't affect us.  Deleted
+     *  postings have wdf DELETED_POSTING.
+     */
+    std::map<Xapian::docid, Xapian::termcount> mods;
+
+    /// Current position in mods.
+    std::map<Xapian::docid, Xapian::termcount>::const_iterator it;
+
+    /// PositionList returned from read_position_list().
+    AutoPtr<PositionList> poslist;
+
+    /// Skip over deleted documents after a next() or skip_to().
+    void skip_deletes(double w_min);
+
+    /// Is the current entry from mods?
+    bool current_is_modified() const {
+	return it != mods.end() &&
+	       (GlassPostList::at_end() || it->first <= GlassPostList::get_docid());
+    }
+
+  public:
+    GlassModifiedPostList(Xapian::Internal::intrusive_ptr<const GlassDatabase> this_db_,
+			  const std::string & term_,
+			  const std::map<Xapian::docid, Xapian::termcount> & mods_)
+	: GlassPostList(this_db_, term_, true),
+	  mods(mods_), it(mods.begin())
+    { }
+
+    Xapian::doccount get_termfreq() const;
+
+    Xapian::docid get_docid() const;
+
+    Xapian::termcount get_doclength() const;
+
+    Xapian::termcount get_unique_terms() const;
+
+    Xapian::termcount get_wdf() const;
+
+    PositionList * read_position_list();
+
+    PositionList * open_position_list() const;
+
+    PostList * next(double w_min);
+
+    PostList * skip_to(Xapian::docid desired_did, double w_min);
+
+    bool at_end() const;
+
+    std::string get_description() const;
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_MODIFIEDPOSTLIST_H
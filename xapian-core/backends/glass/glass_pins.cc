@@ -0,0 +1,98 @@
+/** @file glass_pins.cc
+ * @brief Revisions of a glass database pinned by readers in this process
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "glass_pins.h"
+
+#include "omassert.h"
+#include "safesysstat.h"
+#include "str.h"
+
+using namespace std;
+
+const glass_revision_number_t GlassRevisionPins::NONE;
+
+/// Protects registry.
+static mutex registry_mutex;
+
+/// The GlassRevisionPins objects which currently exist, by key.
+static map<string, weak_ptr<GlassRevisionPins>> registry;
+
+/// Return a key identifying the database directory @a db_dir.
+static string
+make_key(const string & db_dir)
+{
+#ifndef __WIN32__
+    // Use the device and inode so different paths to the same directory
+    // share pins.
+    struct stat statbuf;
+    if (stat(db_dir.c_str(), &statbuf) == 0) {
+	string key = str(static_cast<unsigned long long>(statbuf.st_dev));
+	key += ':';
+	key += str(static_cast<unsigned long long>(statbuf.st_ino));
+	return key;
+    }
+#endif
+    return db_dir;
+}
+
+GlassRevisionPins::~GlassRevisionPins()
+{
+    lock_guard<mutex> guard(registry_mutex);
+    map<string, weak_ptr<GlassRevisionPins>>::iterator i;
+    i = registry.find(key);
+    // get() may already have replaced our expired entry with a new object.
+    if (i != registry.end() && i->second.expired())
+	registry.erase(i);
+}
+
+shared_ptr<GlassRevisionPins>
+GlassRevisionPins::get(const string & db_dir)
+{
+    string key = make_key(db_dir);
+    lock_guard<mutex> guard(registry_mutex);
+    weak_ptr<GlassRevisionPins> & entry = registry[key];
+    shared_ptr<GlassRevisionPins> pins = entry.lock();
+    if (!pins) {
+	pins = make_shared<GlassRevisionPins>(key);
+	entry = pins;
+    }
+    return pins;
+}
+
+void
+GlassRevisionPins::pin(glass_revision_number_t rev)
+{
+    lock_guard<mutex> guard(pins_mutex);
+    ++pins[rev];
+    if (rev < oldest) oldest = rev;
+}
+
+void
+GlassRevisionPins::unpin(glass_revision_number_t rev)
+{
+    lock_guard<mutex> guard(pins_mutex);
+    map<glass_revision_number_t, unsigned>::iterator i = pins.find(rev);
+    Assert(i != pins.end());
+    if (--i->second == 0) {
+	pins.erase(i);
+	oldest = pins.empty() ? NONE : pins.begin()->first;
+    }
+}
@@ -0,0 +1,141 @@
+/** @file glass_pins.h
+ * @brief Revisions of a glass database pinned by readers in this process
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_PINS_H
+#define XAPIAN_INCLUDED_GLASS_PINS_H
+
+#include "glass_defs.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/** The revisions of a glass database which readers in this process have
+ *  pinned.
+ *
+ *  A WritableDatabase won't reuse blocks which were freed by a commit after
+ *  the oldest pinned revision, so readers of a pinned revision never see
+ *  its blocks overwritten.
+ *
+ *  There's one object for each database which is open in this process
+ *  with pins or for writing, shared between the database objects (which may
+ *  be used from different threads).
+ */
+class GlassRevisionPins {
+    /// Don't allow assignment.
+    void operator=(const GlassRevisionPins &);
+
+    /// Don't allow copying.
+    GlassRevisionPins(const GlassRevisionPins &);
+
+    /// The key this object is registered under.
+    std::string key;
+
+    /// Protects pins.
+    std::mutex pins_mutex;
+
+    /// Reference count for each pinned revision.
+    std::map<glass_revision_number_t, unsigned> pins;
+
+    /// The oldest pinned revision, or NONE.
+    std::atomic<glass_revision_number_t> oldest;
+
+  public:
+    /// Value returned by get_oldest() when no revisions are pinned.
+    static const glass_revision_number_t NONE =
+	static_cast<glass_revision_number_t>(-1);
+
+    /// Construct (use get() rather than calling this directly).
+    explicit GlassRevisionPins(const std::string & key_)
+	: key(key_), oldest(NONE) { }
+
+    ~GlassRevisionPins();
+
+    /** Get the object for the database in directory @a db_dir.
+     *
+     *  The same object is returned for every path which refers to the same
+     *  directory (on platforms where we can tell).
+     */
+    static std::shared_ptr<GlassRevisionPins> get(const std::string & db_dir);
+
+    /// Pin revision @a rev.
+    void pin(glass_revision_number_t rev);
+
+    /// Release a pin on revision @a rev.
+    void unpin(glass_revision_number_t rev);
+
+    /** Get the oldest pinned revision.
+     *
+     *  Returns NONE if no revisions are pinned.
+     */
+    glass_revision_number_t get_oldest() const { return oldest; }
+};
+
+/** A pin on a single revision, released automatically. */
+class GlassRevisionPin {
+    /// Don't allow assignment.
+    void operator=(const GlassRevisionPin &);
+
+    /// Don't allow copying.
+    GlassRevisionPin(const GlassRevisionPin &);
+
+    std::shared_ptr<GlassRevisionPins> pins;
+
+    glass_revision_number_t rev;
+
+    bool pinned;
+
+  public:
+    GlassRevisionPin() : rev(0), pinned(false) { }
+
+    GlassRevisionPin(const std::shared_ptr<GlassRevisionPins> & pins_,
+		     glass_revision_number_t rev_)
+	: pins(pins_), rev(0), pinned(false) {
+	set(rev_);
+    }
+
+    ~GlassRevisionPin() { release(); }
+
+    /// Set the GlassRevisionPins object to pin revisions in.
+    void init(const std::shared_ptr<GlassRevisionPins> & pins_) {
+	release();
+	pins = pins_;
+    }
+
+    /// Move the pin to revision @a rev_ (does nothing if init() wasn't called).
+    void set(glass_revision_number_t rev_) {
+	if (!pins) return;
+	pins->pin(rev_);
+	release();
+	rev = rev_;
+	pinned = true;
+    }
+
+    /// Release the pin, if there is one.
+    void release() {
+	if (pinned) {
+	    pinned = false;
+	    pins->unpin(rev);
+	}
+    }
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_PINS_H
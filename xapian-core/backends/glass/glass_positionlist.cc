@@ -35,18 +35,21 @@ using namespace std;
 
 void
 GlassPositionListTable::pack(string & s,
-			     const vector<Xapian::termpos> & vec) const
+			     const Xapian::termpos * begin,
+			     const Xapian::termpos * end) const
 {
-    LOGCALL_VOID(DB, "GlassPositionListTable::pack", s | vec);
-    Assert(!vec.empty());
+    LOGCALL_VOID(DB, "GlassPositionListTable::pack", s | (const void*)begin | (const void*)end);
+    Assert(begin != end);
 
-    pack_uint(s, vec.back());
+    size_t n = end - begin;
+    Xapian::termpos last = begin[n - 1];
+    pack_uint(s, last);
 
-    if (vec.size() > 1) {
+    if (n > 1) {
 	BitWriter wr(s);
-	wr.encode(vec[0], vec.back());
-	wr.encode(vec.size() - 2, vec.back() - vec[0]);
-	wr.encode_interpolative(vec, 0, vec.size() - 1);
+	wr.encode(begin[0], last);
+	wr.encode(n - 2, last - begin[0]);
+	wr.encode_interpolative(begin, 0, n - 1);
 	swap(s, wr.freeze());
     }
 }
@@ -59,9 +59,14 @@ class GlassPositionListTable : public GlassLazyTable {
 
     /** Pack a position list into a string.
      *
-     *  @param s The string to append the position list data to.
+     *  @param s	The string to append the position list data to.
+     *  @param begin	The first position (the positions must be in
+     *			ascending order, and there must be at least one).
+     *  @param end	After the last position.
      */
-    void pack(string & s, const std::vector<Xapian::termpos> & vec) const;
+    void pack(string & s,
+	      const Xapian::termpos * begin,
+	      const Xapian::termpos * end) const;
 
     /** Set the position list for term tname in document did.
      */
@@ -53,6 +53,40 @@ GlassPostListTable::get_freqs(const string & term,
     }
 }
 
+bool
+GlassPostListTable::get_impact_bounds(const string & term,
+				      Xapian::termcount & wdf_ub,
+				      Xapian::termcount & doclen_lb) const
+{
+    // make_impact_key(string()) holds the revision, not bounds.
+    if (term.empty()) return false;
+
+    glass_revision_number_t rev = get_open_revision_number();
+    if (rev != impact_checked_rev) {
+	impact_checked_rev = rev;
+	impact_valid = false;
+	string tag;
+	if (get_exact_entry(make_impact_key(string()), tag)) {
+	    const char * p = tag.data();
+	    glass_revision_number_t impact_rev;
+	    if (!unpack_uint_last(&p, p + tag.size(), &impact_rev))
+		throw Xapian::DatabaseCorruptError("Bad impact bounds revision");
+	    impact_valid = (impact_rev == rev);
+	}
+    }
+    if (!impact_valid) return false;
+
+    string tag;
+    if (!get_exact_entry(make_impact_key(term), tag)) return false;
+    const char * p = tag.data();
+    const char * end = p + tag.size();
+    if (!unpack_uint(&p, end, &wdf_ub) ||
+	!unpack_uint_last(&p, end, &doclen_lb)) {
+	throw Xapian::DatabaseCorruptError("Bad impact bounds entry");
+    }
+    return true;
+}
+
 Xapian::termcount
 GlassPostListTable::get_doclength(Xapian::docid did,
 				  intrusive_ptr<const GlassDatabase> db) const {
@@ -717,6 +751,7 @@ GlassPostList::init()
     last_did_in_chunk = read_start_of_chunk(&pos, end, first_did_in_chunk,
 					    &is_last_chunk);
     read_wdf(&pos, end, &wdf);
+    ++counts.postings_decoded;
     LOGLINE(DB, "Initial docid " << did);
 }
 
@@ -762,6 +797,7 @@ GlassPostList::next_in_chunk()
 
     read_did_increase(&pos, end, &did);
     read_wdf(&pos, end, &wdf);
+    ++counts.postings_decoded;
 
     // Either not at last doc in chunk, or pos == end, but not both.
     Assert(did <= last_did_in_chunk);
@@ -815,6 +851,7 @@ GlassPostList::next_chunk()
     last_did_in_chunk = read_start_of_chunk(&pos, end, first_did_in_chunk,
 					    &is_last_chunk);
     read_wdf(&pos, end, &wdf);
+    ++counts.postings_decoded;
 }
 
 PositionList *
@@ -839,6 +876,7 @@ GlassPostList::next(double w_min)
 {
     LOGCALL(DB, PostList *, "GlassPostList::next", w_min);
     (void)w_min; // no warning
+    ++counts.next_calls;
 
     if (!have_started) {
 	have_started = true;
@@ -908,6 +946,7 @@ GlassPostList::move_to_chunk_containing(Xapian::docid desired_did)
     last_did_in_chunk = read_start_of_chunk(&pos, end, first_did_in_chunk,
 					    &is_last_chunk);
     read_wdf(&pos, end, &wdf);
+    ++counts.postings_decoded;
 
     // Possible, since desired_did might be after end of this chunk and before
     // the next.
@@ -924,6 +963,7 @@ GlassPostList::move_forward_in_chunk_to_at_least(Xapian::docid desired_did)
     if (desired_did <= last_did_in_chunk) {
 	while (pos != end) {
 	    read_did_increase(&pos, end, &did);
+	    ++counts.postings_decoded;
 	    if (did >= desired_did) {
 		read_wdf(&pos, end, &wdf);
 		RETURN(true);
@@ -945,6 +985,7 @@ GlassPostList::skip_to(Xapian::docid desired_did, double w_min)
 {
     LOGCALL(DB, PostList *, "GlassPostList::skip_to", desired_did | w_min);
     (void)w_min; // no warning
+    ++counts.skip_to_calls;
     // We've started now - if we hadn't already, we're already positioned
     // at start so there's no need to actually do anything.
     have_started = true;
@@ -1202,6 +1243,8 @@ GlassPostListTable::merge_changes(const string &term,
 	if (termfreq == 0) {
 	    // All postings deleted!  So we can shortcut by zapping the
 	    // posting list.
+	    if (term_ngram_table && pos != end)
+		term_ngram_table->toggle_term(term);
 	    if (islast) {
 		// Only one entry for this posting list.
 		del(current_key);
@@ -1225,6 +1268,7 @@ GlassPostListTable::merge_changes(const string &term,
 	newhdr += make_start_of_chunk(islast, firstdid, lastdid);
 	if (pos == end) {
 	    add(current_key, newhdr);
+	    if (term_ngram_table) term_ngram_table->toggle_term(term);
 	} else {
 	    Assert((size_t)(pos - tag.data()) <= tag.size());
 	    tag.replace(0, pos - tag.data(), newhdr);
@@ -41,6 +41,7 @@ using namespace std;
 
 class GlassCursor;
 class GlassDatabase;
+class GlassSpellingTable;
 
 namespace Glass {
     class PostlistChunkReader;
@@ -56,6 +57,19 @@ class GlassPostListTable : public GlassTable {
 	/// PostList for looking up document lengths.
 	mutable AutoPtr<GlassPostList> doclen_pl;
 
+	/** Revision we last checked for valid impact bounds at.
+	 *
+	 *  Impact bounds are only valid for the revision the compactor wrote
+	 *  them at, so we cache the result of checking per revision.
+	 */
+	mutable glass_revision_number_t impact_checked_rev;
+
+	/// Are the impact bounds valid for impact_checked_rev?
+	mutable bool impact_valid;
+
+	/// Table to record terms added and removed in, or NULL.
+	GlassSpellingTable * term_ngram_table;
+
     public:
 	/** Create a new table object.
 	 *
@@ -71,20 +85,33 @@ class GlassPostListTable : public GlassTable {
 	 */
 	GlassPostListTable(const string & path_, bool readonly_)
 	    : GlassTable("postlist", path_ + "/postlist.", readonly_),
-	      doclen_pl()
+	      doclen_pl(), impact_checked_rev(0), impact_valid(false),
+	      term_ngram_table(NULL)
 	{ }
 
 	GlassPostListTable(int fd, off_t offset_, bool readonly_)
 	    : GlassTable("postlist", fd, offset_, readonly_),
-	      doclen_pl()
+	      doclen_pl(), impact_checked_rev(0), impact_valid(false),
+	      term_ngram_table(NULL)
 	{ }
 
 	void open(int flags_, const RootInfo & root_info,
 		  glass_revision_number_t rev) {
 	    doclen_pl.reset(0);
+	    impact_checked_rev = 0;
+	    impact_valid = false;
 	    GlassTable::open(flags_, root_info, rev);
 	}
 
+	/** Maintain a term n-gram index in @a table.
+	 *
+	 *  After this is called, merge_changes() toggles each term in @a table
+	 *  when it is added or removed.
+	 */
+	void set_term_ngram_table(GlassSpellingTable * table) {
+	    term_ngram_table = table;
+	}
+
 	/// Merge changes for a term.
 	void merge_changes(const string &term, const Inverter::PostingChanges & changes);
 
@@ -106,6 +133,32 @@ class GlassPostListTable : public GlassTable {
 	    return pack_glass_postlist_key(term);
 	}
 
+	/** Compose the key for the impact bounds of a term.
+	 *
+	 *  Nothing follows the term, so we can just append it.  The key with
+	 *  an empty term holds the revision the bounds are valid for.
+	 */
+	static string make_impact_key(const string & term) {
+	    string key("\x00\xc8", 2);
+	    key += term;
+	    return key;
+	}
+
+	/** Get the impact bounds stored for a term by the compactor.
+	 *
+	 *  @param term		The term to get the bounds for.
+	 *  @param wdf_ub	Set to the maximum wdf of @a term.
+	 *  @param doclen_lb	Set to the minimum length of a document indexed
+	 *			by @a term.
+	 *
+	 *  @return true if bounds were found and are valid for the revision
+	 *	    this table is open at.  Always false for the empty term,
+	 *	    since its key holds the revision instead.
+	 */
+	bool get_impact_bounds(const string & term,
+			       Xapian::termcount & wdf_ub,
+			       Xapian::termcount & doclen_lb) const;
+
 	bool term_exists(const string & term) const {
 	    return key_exists(make_key(term));
 	}
@@ -137,6 +190,7 @@ class GlassPostListTable : public GlassTable {
 /** A postlist in a glass database.
  */
 class GlassPostList : public LeafPostList {
+    protected:
 	/** The database we are searching.  This pointer is held so that the
 	 *  database doesn't get deleted before us, and also to give us access
 	 *  to the position_table.
@@ -149,6 +203,8 @@ class GlassPostList : public LeafPostList {
 	/// Whether we've started reading the list yet.
 	bool have_started;
 
+    private:
+
 	/// True if this is the last chunk.
 	bool is_last_chunk;
 
@@ -0,0 +1,70 @@
+/** @file glass_segmentdeletions.h
+ * @brief Documents a segment deletes or replaces in older segments
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_SEGMENTDELETIONS_H
+#define XAPIAN_INCLUDED_GLASS_SEGMENTDELETIONS_H
+
+#include "xapian/intrusive_ptr.h"
+#include "xapian/types.h"
+
+#include <set>
+#include <vector>
+
+/** The documents a segment deletes or replaces in older segments.
+ *
+ *  Committed segments are never modified, so deleting or replacing a
+ *  document which is in an older segment is recorded in the segment being
+ *  written: the copies of the docids in @a deleted in all older segments are
+ *  dead.  For the docids in @a replaced the segment itself holds the new
+ *  copy.
+ */
+class GlassSegmentDeletions : public Xapian::Internal::intrusive_base {
+  public:
+    /// Docids whose copies in older segments are dead.
+    std::set<Xapian::docid> deleted;
+
+    /// The docids in @a deleted which this segment holds a new copy of.
+    std::set<Xapian::docid> replaced;
+};
+
+/// Checks if a document in a segment has been superseded by a newer one.
+class GlassSegmentFilter {
+    /// The non-empty deletions of the newer segments.
+    std::vector<Xapian::Internal::intrusive_ptr<const GlassSegmentDeletions>> newer;
+
+  public:
+    /// Add the deletions of a newer segment.
+    void add(const GlassSegmentDeletions * deletions) {
+	if (!deletions->deleted.empty())
+	    newer.push_back(deletions);
+    }
+
+    /// Does this filter never remove anything?
+    bool empty() const { return newer.empty(); }
+
+    /// Has the copy of @a did in this segment been deleted or replaced?
+    bool is_dead(Xapian::docid did) const {
+	for (const auto& deletions : newer) {
+	    if (deletions->deleted.count(did)) return true;
+	}
+	return false;
+    }
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_SEGMENTDELETIONS_H
@@ -0,0 +1,1673 @@
+/** @file glass_segmented.cc
+ * @brief A database made up of immutable glass segments
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "glass_segmented.h"
+
+#include "xapian/compactor.h"
+#include "xapian/constants.h"
+#include "xapian/database.h"
+#include "xapian/document.h"
+#include "xapian/error.h"
+
+#include "api/leafpostlist.h"
+#include "backends/document.h"
+#include "backends/multi/multi_alltermslist.h"
+#include "glass_database.h"
+#include "glass_positionlist.h"
+#include "glass_segmentpostlist.h"
+#include "glass_segmentvaluelist.h"
+#include "glass_termlist.h"
+
+#include "autoptr.h"
+#include "debuglog.h"
+#include "fd.h"
+#include "fileutils.h"
+#include "filetests.h"
+#include "io_utils.h"
+#include "omassert.h"
+#include "pack.h"
+#include "posixy_wrapper.h"
+#include "safedirent.h"
+#include "safeerrno.h"
+#include "safefcntl.h"
+#include "safesysstat.h"
+#include "safeunistd.h"
+#include "safeuuid.h"
+#include "str.h"
+#include "stringutils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+using Xapian::Internal::intrusive_ptr;
+
+
+/** Number of segments of a similar size which trigger a merge.
+ *
+ *  Segments are of a similar size if their document counts have the same
+ *  number of decimal digits, so merging 10 of them gives a segment of the
+ *  next size up.
+ */
+static const size_t MERGE_FACTOR = 10;
+
+/** How many times to retry opening the segments for reading.
+ *
+ *  A writer may merge segments and remove the old ones between us reading
+ *  "iamsegmented" and opening the segments it lists, in which case we read
+ *  it again.
+ */
+static const int MAX_OPEN_RETRIES = 10;
+
+/// Metadata key a segment stores the docids it deletes from older ones in.
+static const char DELETED_KEY[] = "deleted";
+
+/// Metadata key a segment stores the docids it replaces in older ones in.
+static const char REPLACED_KEY[] = "replaced";
+
+/// Return the size class of a segment with @a doccount documents.
+static unsigned
+segment_level(Xapian::doccount doccount)
+{
+    unsigned level = 0;
+    while (doccount) {
+	++level;
+	doccount /= 10;
+    }
+    return level;
+}
+
+/// Is @a name @a prefix followed by digits?
+static bool
+is_numbered_name(const string & name, const char * prefix)
+{
+    size_t len = strlen(prefix);
+    if (!startswith(name, prefix) || name.size() == len)
+	return false;
+    for (size_t i = len; i != name.size(); ++i) {
+	if (!C_isdigit(name[i])) return false;
+    }
+    return true;
+}
+
+/// Is @a name one of our subdirectories ("seg" or "aux" followed by digits)?
+static bool
+is_segment_name(const string & name)
+{
+    return is_numbered_name(name, "seg") || is_numbered_name(name, "aux");
+}
+
+/// Encode a set of docids as a list of differences.
+static string
+encode_docids(const set<Xapian::docid> & dids)
+{
+    string s;
+    Xapian::docid prev = 0;
+    for (Xapian::docid did : dids) {
+	pack_uint(s, did - prev);
+	prev = did;
+    }
+    return s;
+}
+
+/// Decode a set of docids encoded by encode_docids().
+static bool
+decode_docids(const string & s, set<Xapian::docid> & dids)
+{
+    const char * p = s.data();
+    const char * end = p + s.size();
+    Xapian::docid did = 0;
+    while (p != end) {
+	Xapian::docid inc;
+	if (!unpack_uint(&p, end, &inc)) return false;
+	did += inc;
+	dids.insert(dids.end(), did);
+    }
+    return true;
+}
+
+/// Flags to open a segment of a writable database with.
+static int
+segment_flags(int flags)
+{
+    // The term n-gram index needs to see every term, so a segmented database
+    // can't support it.
+    return flags & ~(Xapian::DB_ACTION_MASK_ | Xapian::DB_SEGMENTED |
+		     Xapian::DB_TERM_NGRAM_INDEX);
+}
+
+/** Copy the glass database in directory @a from to directory @a to.
+ *
+ *  Nothing may be writing to @a from.
+ */
+static void
+copy_glass_database(const string & from, const string & to, int flags)
+{
+    if (dir_exists(to)) removedir(to);
+    if (mkdir(to.c_str(), 0755) == -1) {
+	throw Xapian::DatabaseCreateError("Cannot create directory '" + to +
+					  "'", errno);
+    }
+
+    vector<string> names;
+    DIR * dir = opendir(from.c_str());
+    if (dir == NULL) {
+	throw Xapian::DatabaseOpeningError("Cannot read directory '" + from +
+					   "'", errno);
+    }
+    while (true) {
+	struct dirent * entry = readdir(dir);
+	if (entry == NULL) break;
+	string name(entry->d_name);
+	if (name == "iamglass" || endswith(name, ".glass"))
+	    names.push_back(name);
+    }
+    closedir(dir);
+
+    vector<string>::const_iterator i;
+    for (i = names.begin(); i != names.end(); ++i) {
+	string src = from + "/" + *i;
+	string dest = to + "/" + *i;
+	FD in(posixy_open(src.c_str(), O_RDONLY|O_BINARY));
+	if (in < 0) {
+	    throw Xapian::DatabaseOpeningError("Couldn't open " + src, errno);
+	}
+	FD out(posixy_open(dest.c_str(), O_CREAT|O_TRUNC|O_WRONLY|O_BINARY,
+			   0666));
+	if (out < 0) {
+	    throw Xapian::DatabaseCreateError("Couldn't create " + dest, errno);
+	}
+	char buf[65536];
+	size_t n;
+	while ((n = io_read(in, buf, sizeof(buf))) != 0) {
+	    io_write(out, buf, n);
+	}
+	// The copy gets committed as part of a later commit, which only syncs
+	// the tables it modifies.
+	if ((flags & Xapian::DB_NO_SYNC) == 0 &&
+	    ((flags & Xapian::DB_FULL_SYNC) ?
+	      !io_full_sync(out) :
+	      !io_sync(out))) {
+	    throw Xapian::DatabaseError("Couldn't sync " + dest, errno);
+	}
+	if (out.close() != 0) {
+	    throw Xapian::DatabaseError("Couldn't close " + dest, errno);
+	}
+    }
+}
+
+GlassSegmentedDatabase::GlassSegmentedDatabase(const string & db_dir_,
+					       bool writable_,
+					       int flags_, int block_size_)
+    : db_dir(db_dir_),
+      flags(flags_),
+      block_size(block_size_),
+      writable(writable_),
+      lock(db_dir_),
+      closed(false),
+      lastdocid(0),
+      committed_lastdocid(0),
+      next_segment(1),
+      last_segment_uncommitted(false),
+      aux_writable(false),
+      dead_doccount(0),
+      dead_length(0),
+      modify_shortcut_document(NULL),
+      modify_shortcut_docid(0),
+      change_count(0),
+      flush_threshold(0)
+{
+    LOGCALL_CTOR(DB, "GlassSegmentedDatabase", db_dir_ | writable_ | flags_ | block_size_);
+
+    if (!writable) {
+	open_segments();
+	return;
+    }
+
+    // Use the same automatic commit threshold as GlassWritableDatabase.
+    const char *p = getenv("XAPIAN_FLUSH_THRESHOLD");
+    if (p)
+	flush_threshold = atoi(p);
+    if (flush_threshold == 0)
+	flush_threshold = 10000;
+
+    int action = flags & Xapian::DB_ACTION_MASK_;
+    if (action == Xapian::DB_OPEN && !database_exists(db_dir)) {
+	string msg("No segmented glass database found at path '");
+	msg += db_dir;
+	msg += '\'';
+	throw Xapian::DatabaseOpeningError(msg);
+    }
+
+    // Create the directory for the database, if it doesn't exist already.
+    if (mkdir(db_dir.c_str(), 0755) == -1 && errno != EEXIST) {
+	throw Xapian::DatabaseCreateError("Cannot create directory '" +
+					  db_dir + "'", errno);
+    }
+    if (!dir_exists(db_dir)) {
+	throw Xapian::DatabaseCreateError("Cannot create directory '" +
+					  db_dir + "'", ENOTDIR);
+    }
+
+    string explanation;
+    bool retry = flags & Xapian::DB_RETRY_LOCK;
+    FlintLock::reason why = lock.lock(true, retry, explanation);
+    if (why != FlintLock::SUCCESS)
+	lock.throw_databaselockerror(why, db_dir, explanation);
+
+    if (!database_exists(db_dir)) {
+	create();
+	return;
+    }
+
+    if (action == Xapian::DB_CREATE) {
+	throw Xapian::DatabaseCreateError("Can't create new database at '" +
+					  db_dir + "': a database already exists and I was told "
+					  "not to overwrite it");
+    }
+
+    if (action == Xapian::DB_CREATE_OR_OVERWRITE) {
+	remove_unused_segments();
+	create();
+	return;
+    }
+
+    open_segments();
+    // Clean up after a writer which didn't get to commit or finish a merge.
+    remove_unused_segments();
+}
+
+GlassSegmentedDatabase::~GlassSegmentedDatabase()
+{
+    LOGCALL_DTOR(DB, "GlassSegmentedDatabase");
+    if (writable) dtor_called();
+}
+
+bool
+GlassSegmentedDatabase::database_exists(const string & path)
+{
+    return file_exists(path + "/iamsegmented");
+}
+
+string
+GlassSegmentedDatabase::get_segment_databases(vector<intrusive_ptr<Xapian::Database::Internal>> & out) const
+{
+    LOGCALL(DB, string, "GlassSegmentedDatabase::get_segment_databases", out.size());
+    // The deleted docids are stored as metadata, which we don't want to
+    // end up in the compacted database.
+    bool clean = true;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	if (!i->deletions->deleted.empty()) clean = false;
+    }
+    if (clean) {
+	for (i = segments.begin(); i != segments.end(); ++i) {
+	    out.push_back(i->db);
+	}
+	out.push_back(aux_db);
+	RETURN(string());
+    }
+
+    // The compactor can't skip dead documents, so copy the live ones.
+    uuid_t uu;
+    uuid_generate(uu);
+    char buf[37];
+    uuid_unparse_lower(uu, buf);
+    string tmpdir = db_dir + "/compact-" + buf;
+    try {
+	intrusive_ptr<Xapian::Database::Internal> tmp;
+	tmp = new GlassWritableDatabase(tmpdir,
+					Xapian::DB_CREATE_OR_OVERWRITE |
+					Xapian::DB_NO_SYNC,
+					block_size);
+	GlassSegmentDeletions deletions;
+	copy_live_documents(0, segments.size(), tmp.get(), deletions);
+	tmp->commit();
+	tmp->close();
+	out.push_back(new GlassDatabase(tmpdir));
+    } catch (...) {
+	try {
+	    removedir(tmpdir);
+	} catch (const Xapian::DatabaseError &) {
+	}
+	throw;
+    }
+    out.push_back(aux_db);
+    RETURN(tmpdir);
+}
+
+string
+GlassSegmentedDatabase::read_segments_file() const
+{
+    LOGCALL(DB, string, "GlassSegmentedDatabase::read_segments_file", NO_ARGS);
+    string filename = db_dir;
+    filename += "/iamsegmented";
+    FD fd(posixy_open(filename.c_str(), O_RDONLY|O_BINARY));
+    if (fd < 0) {
+	string msg = filename;
+	msg += ": Failed to open segment list for reading";
+	throw Xapian::DatabaseOpeningError(msg, errno);
+    }
+
+    string contents;
+    char buf[4096];
+    size_t n;
+    while ((n = io_read(fd, buf, sizeof(buf))) != 0) {
+	contents.append(buf, n);
+	if (n < sizeof(buf)) break;
+    }
+    RETURN(contents);
+}
+
+void
+GlassSegmentedDatabase::parse_segments_file(const string & contents,
+					    vector<Segment> & new_segments,
+					    vector<pair<Xapian::doccount, Xapian::doccount>> & sizes,
+					    string & new_aux_name_)
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::parse_segments_file", contents | new_segments.size() | sizes.size() | new_aux_name_);
+    istringstream in(contents);
+    string magic;
+    unsigned version;
+    if (!(in >> magic >> version) || magic != "segmented") {
+	throw Xapian::DatabaseCorruptError(db_dir + "/iamsegmented: "
+					   "Segment list magic incorrect");
+    }
+    if (version != 2) {
+	string msg = db_dir;
+	msg += "/iamsegmented: Segment list format version ";
+	msg += str(version);
+	msg += " but I only understand 2";
+	throw Xapian::DatabaseVersionError(msg);
+    }
+
+    string new_uuid;
+    Xapian::docid new_lastdocid;
+    unsigned new_next_segment;
+    if (!(in >> new_uuid >> new_lastdocid >> new_next_segment >>
+	  new_aux_name_) ||
+	new_uuid.size() != 36 || !is_numbered_name(new_aux_name_, "aux")) {
+	throw Xapian::DatabaseCorruptError(db_dir + "/iamsegmented: "
+					   "Bad segment list header");
+    }
+
+    // Segments which only delete documents don't cover any docids, so can
+    // have the same first docid as the next segment.
+    string name;
+    Xapian::docid first_did;
+    Xapian::doccount deleted_size, replaced_size;
+    while (in >> name >> first_did >> deleted_size >> replaced_size) {
+	if (!is_numbered_name(name, "seg") || first_did == 0 ||
+	    (!new_segments.empty() &&
+	     first_did < new_segments.back().first_did) ||
+	    replaced_size > deleted_size) {
+	    throw Xapian::DatabaseCorruptError(db_dir + "/iamsegmented: "
+					       "Bad segment entry");
+	}
+	new_segments.push_back(Segment(name, first_did));
+	sizes.push_back(make_pair(deleted_size, replaced_size));
+    }
+    if (!in.eof()) {
+	throw Xapian::DatabaseCorruptError(db_dir + "/iamsegmented: "
+					   "Bad segment list");
+    }
+
+    uuid = new_uuid;
+    lastdocid = committed_lastdocid = new_lastdocid;
+    next_segment = new_next_segment;
+}
+
+void
+GlassSegmentedDatabase::read_deletions(Segment & seg,
+				       Xapian::doccount deleted_size,
+				       Xapian::doccount replaced_size) const
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::read_deletions", seg.name | deleted_size | replaced_size);
+    if (deleted_size == 0) return;
+    GlassSegmentDeletions & deletions = *seg.deletions;
+    if (!decode_docids(seg.db->get_metadata(DELETED_KEY), deletions.deleted) ||
+	!decode_docids(seg.db->get_metadata(REPLACED_KEY), deletions.replaced) ||
+	deletions.deleted.size() != deleted_size ||
+	deletions.replaced.size() != replaced_size) {
+	throw Xapian::DatabaseCorruptError(segment_path(seg.name) + ": "
+					   "Deleted documents don't match the "
+					   "segment list");
+    }
+}
+
+void
+GlassSegmentedDatabase::write_segments_file()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::write_segments_file", NO_ARGS);
+    string s = "segmented 2\n";
+    s += uuid;
+    s += '\n';
+    s += str(lastdocid);
+    s += ' ';
+    s += str(next_segment);
+    s += ' ';
+    s += aux_name;
+    s += '\n';
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	s += i->name;
+	s += ' ';
+	s += str(i->first_did);
+	s += ' ';
+	s += str(i->deletions->deleted.size());
+	s += ' ';
+	s += str(i->deletions->replaced.size());
+	s += '\n';
+    }
+    if (s == segments_file_contents) return;
+
+    string filename = db_dir;
+    filename += "/iamsegmented";
+    string tmpfile = filename;
+    tmpfile += ".tmp";
+    FD fd(posixy_open(tmpfile.c_str(), O_CREAT|O_TRUNC|O_WRONLY|O_BINARY, 0666));
+    if (fd < 0) {
+	throw Xapian::DatabaseError("Couldn't write new segment list: " +
+				    tmpfile, errno);
+    }
+    try {
+	io_write(fd, s.data(), s.size());
+	if ((flags & Xapian::DB_NO_SYNC) == 0 &&
+	    ((flags & Xapian::DB_FULL_SYNC) ?
+	      !io_full_sync(fd) :
+	      !io_sync(fd))) {
+	    throw Xapian::DatabaseError("Couldn't sync new segment list: " +
+					tmpfile, errno);
+	}
+	if (fd.close() != 0) {
+	    throw Xapian::DatabaseError("Couldn't close new segment list: " +
+					tmpfile, errno);
+	}
+    } catch (...) {
+	(void)unlink(tmpfile.c_str());
+	throw;
+    }
+    if (!io_tmp_rename(tmpfile, filename)) {
+	throw Xapian::DatabaseError("Couldn't update segment list: " +
+				    filename, errno);
+    }
+    segments_file_contents = s;
+}
+
+bool
+GlassSegmentedDatabase::open_segments()
+{
+    LOGCALL(DB, bool, "GlassSegmentedDatabase::open_segments", NO_ARGS);
+    int tries = 0;
+    while (true) {
+	string contents = read_segments_file();
+	// Committed segments are never modified, so if the list is the same
+	// nothing has changed.
+	if (contents == segments_file_contents) RETURN(false);
+
+	vector<Segment> new_segments;
+	vector<pair<Xapian::doccount, Xapian::doccount>> sizes;
+	string new_aux_name_;
+	parse_segments_file(contents, new_segments, sizes, new_aux_name_);
+	intrusive_ptr<Xapian::Database::Internal> new_aux_db = aux_db;
+	try {
+	    // Segment names are never reused, so we can keep any segments we
+	    // already have open which are still listed.
+	    map<string, const Segment *> old_segments;
+	    vector<Segment>::const_iterator j;
+	    for (j = segments.begin(); j != segments.end(); ++j) {
+		old_segments[j->name] = &*j;
+	    }
+	    for (size_t i = 0; i != new_segments.size(); ++i) {
+		Segment & seg = new_segments[i];
+		auto old = old_segments.find(seg.name);
+		if (old != old_segments.end()) {
+		    seg.db = old->second->db;
+		    seg.deletions = old->second->deletions;
+		    continue;
+		}
+		seg.db = new GlassDatabase(segment_path(seg.name),
+					   Xapian::DB_READONLY_, 0,
+					   (flags & Xapian::DB_PIN_REVISION));
+		read_deletions(seg, sizes[i].first, sizes[i].second);
+	    }
+	    if (new_aux_name_ != aux_name) {
+		new_aux_db = new GlassDatabase(segment_path(new_aux_name_),
+					       Xapian::DB_READONLY_, 0,
+					       (flags & Xapian::DB_PIN_REVISION));
+	    }
+	} catch (const Xapian::DatabaseOpeningError &) {
+	    if (++tries == MAX_OPEN_RETRIES) throw;
+	    continue;
+	}
+	swap(segments, new_segments);
+	aux_name = new_aux_name_;
+	aux_db = new_aux_db;
+	segments_file_contents = contents;
+	find_dead_copies();
+	RETURN(true);
+    }
+}
+
+void
+GlassSegmentedDatabase::create()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::create", NO_ARGS);
+    segments.clear();
+    lastdocid = committed_lastdocid = 0;
+    next_segment = 1;
+    uuid_t uu;
+    uuid_generate(uu);
+    char buf[37];
+    uuid_unparse_lower(uu, buf);
+    uuid.assign(buf, 36);
+    segments_file_contents.resize(0);
+
+    // There are no segments until documents are added, but there's always a
+    // spelling, synonym and metadata database.
+    aux_name = "aux" + str(next_segment++);
+    aux_db = new GlassWritableDatabase(segment_path(aux_name),
+				       segment_flags(flags) |
+				       Xapian::DB_CREATE_OR_OVERWRITE,
+				       block_size);
+    aux_db->commit();
+    write_segments_file();
+}
+
+Xapian::Database::Internal *
+GlassSegmentedDatabase::new_segment()
+{
+    LOGCALL(DB, Xapian::Database::Internal *, "GlassSegmentedDatabase::new_segment", NO_ARGS);
+    Assert(writable);
+    if (last_segment_uncommitted) RETURN(segments.back().db.get());
+
+    check_not_closed();
+    Segment seg("seg" + str(next_segment++), lastdocid + 1);
+    // Overwrite anything left behind by a writer which didn't commit.
+    seg.db = new GlassWritableDatabase(segment_path(seg.name),
+				       segment_flags(flags) |
+				       Xapian::DB_CREATE_OR_OVERWRITE,
+				       block_size);
+    seg.writable = true;
+    // Segments stay in a transaction so they never commit until we do.
+    seg.db->begin_transaction(false);
+    segments.push_back(seg);
+    last_segment_uncommitted = true;
+    RETURN(segments.back().db.get());
+}
+
+void
+GlassSegmentedDatabase::discard_new_segment()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::discard_new_segment", NO_ARGS);
+    Assert(last_segment_uncommitted);
+    Segment & seg = segments.back();
+    seg.db->cancel_transaction();
+    seg.db->close();
+    string path = segment_path(seg.name);
+    segments.pop_back();
+    last_segment_uncommitted = false;
+    try {
+	removedir(path);
+    } catch (const Xapian::DatabaseError &) {
+	// The next writer to open the database will remove it.
+    }
+}
+
+Xapian::Database::Internal *
+GlassSegmentedDatabase::writable_aux()
+{
+    Assert(writable);
+    check_not_closed();
+    if (!aux_writable) {
+	LOGLINE(DB, "Copying " << aux_name << " to modify it");
+	new_aux_name = "aux" + str(next_segment++);
+	string path = segment_path(new_aux_name);
+	copy_glass_database(segment_path(aux_name), path, flags);
+	aux_db = new GlassWritableDatabase(path,
+					   segment_flags(flags) |
+					   Xapian::DB_OPEN,
+					   block_size);
+	aux_db->begin_transaction(false);
+	aux_writable = true;
+    }
+    return aux_db.get();
+}
+
+void
+GlassSegmentedDatabase::remove_unused_segments()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::remove_unused_segments", NO_ARGS);
+    vector<string> unused;
+    DIR * dir = opendir(db_dir.c_str());
+    if (dir == NULL) return;
+    while (true) {
+	struct dirent * entry = readdir(dir);
+	if (entry == NULL) break;
+	string name(entry->d_name);
+	if (!is_segment_name(name)) continue;
+	bool used = (name == aux_name ||
+		     (aux_writable && name == new_aux_name));
+	vector<Segment>::const_iterator i;
+	for (i = segments.begin(); !used && i != segments.end(); ++i) {
+	    if (i->name == name) used = true;
+	}
+	if (!used) unused.push_back(name);
+    }
+    closedir(dir);
+
+    vector<string>::const_iterator i;
+    for (i = unused.begin(); i != unused.end(); ++i) {
+	try {
+	    removedir(segment_path(*i));
+	} catch (const Xapian::DatabaseError &) {
+	    // Try again next time.
+	}
+    }
+}
+
+size_t
+GlassSegmentedDatabase::find_segment(Xapian::docid did) const
+{
+    Assert(!segments.empty());
+    size_t lo = 0, hi = segments.size();
+    // Find the last segment with first_did <= did.
+    while (hi - lo > 1) {
+	size_t mid = lo + (hi - lo) / 2;
+	if (segments[mid].first_did <= did) {
+	    lo = mid;
+	} else {
+	    hi = mid;
+	}
+    }
+    return lo;
+}
+
+size_t
+GlassSegmentedDatabase::find_copy(Xapian::docid did, size_t end) const
+{
+    size_t covering = find_segment(did);
+    AssertRel(covering,<,end);
+    // A newer segment can hold the live copy if it replaced the document.
+    for (size_t i = end - 1; i > covering; --i) {
+	const GlassSegmentDeletions & deletions = *segments[i].deletions;
+	if (deletions.deleted.empty()) continue;
+	if (deletions.replaced.count(did)) return i;
+	if (deletions.deleted.count(did)) return segments.size();
+    }
+    return covering;
+}
+
+size_t
+GlassSegmentedDatabase::live_segment(Xapian::docid did) const
+{
+    if (did <= lastdocid) {
+	size_t i = find_live(did);
+	if (i != segments.size()) return i;
+    }
+    throw Xapian::DocNotFoundError("Document " + str(did) + " not found");
+}
+
+GlassSegmentFilter
+GlassSegmentedDatabase::get_filter(size_t i) const
+{
+    GlassSegmentFilter filter;
+    for (size_t j = i + 1; j < segments.size(); ++j) {
+	filter.add(segments[j].deletions.get());
+    }
+    return filter;
+}
+
+bool
+GlassSegmentedDatabase::have_replacements(size_t begin, size_t end) const
+{
+    for (size_t i = begin; i != end; ++i) {
+	if (!segments[i].deletions->replaced.empty()) return true;
+    }
+    return false;
+}
+
+void
+GlassSegmentedDatabase::add_dead_copy(size_t i, Xapian::docid did)
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::add_dead_copy", i | did);
+    Xapian::Database::Internal * db = segments[i].db.get();
+    Xapian::termcount doclen;
+    try {
+	doclen = db->get_doclength(did);
+    } catch (const Xapian::DocNotFoundError &) {
+	return;
+    }
+    ++segments[i].dead_count;
+    ++dead_doccount;
+    dead_length += doclen;
+
+    AutoPtr<TermList> tl(db->open_term_list(did));
+    for (tl->next(); !tl->at_end(); tl->next()) {
+	pair<Xapian::doccount, Xapian::termcount> & freqs =
+	    dead_freqs[tl->get_termname()];
+	++freqs.first;
+	freqs.second += tl->get_wdf();
+    }
+
+    Xapian::Document doc(db->open_document(did, true));
+    Xapian::ValueIterator v;
+    for (v = doc.values_begin(); v != doc.values_end(); ++v) {
+	++dead_value_freqs[v.get_valueno()];
+	++segments[i].dead_value_freqs[v.get_valueno()];
+    }
+}
+
+void
+GlassSegmentedDatabase::find_dead_copies()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::find_dead_copies", NO_ARGS);
+    dead_doccount = 0;
+    dead_length = 0;
+    dead_freqs.clear();
+    dead_value_freqs.clear();
+    vector<Segment>::iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	i->dead_count = 0;
+	i->dead_value_freqs.clear();
+    }
+    for (size_t j = 0; j != segments.size(); ++j) {
+	for (Xapian::docid did : segments[j].deletions->deleted) {
+	    size_t k = find_copy(did, j);
+	    if (k != segments.size()) add_dead_copy(k, did);
+	}
+    }
+}
+
+void
+GlassSegmentedDatabase::copy_live_documents(size_t begin, size_t end,
+					    Xapian::Database::Internal * out,
+					    GlassSegmentDeletions & deletions) const
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::copy_live_documents", begin | end | out | deletions.deleted.size());
+    Xapian::docid first_did = segments[begin].first_did;
+    // Pairs of (docid, segment index), so we can add them in docid order.
+    vector<pair<Xapian::docid, size_t>> docs;
+    for (size_t i = begin; i != end; ++i) {
+	const Segment & seg = segments[i];
+	GlassSegmentFilter filter = get_filter(i);
+	AutoPtr<LeafPostList> pl(seg.db->open_post_list(string()));
+	for (pl->next(0.0); !pl->at_end(); pl->next(0.0)) {
+	    Xapian::docid did = pl->get_docid();
+	    if (!filter.is_dead(did)) docs.push_back(make_pair(did, i));
+	}
+	// Deletions of documents in segments before begin still apply.
+	const set<Xapian::docid> & deleted = seg.deletions->deleted;
+	deletions.deleted.insert(deleted.begin(),
+				 deleted.lower_bound(first_did));
+    }
+    sort(docs.begin(), docs.end());
+
+    vector<pair<Xapian::docid, size_t>>::const_iterator i;
+    for (i = docs.begin(); i != docs.end(); ++i) {
+	Xapian::docid did = i->first;
+	Xapian::Document doc(segments[i->second].db->open_document(did, false));
+	out->replace_document(did, doc);
+	if (did < first_did) deletions.replaced.insert(did);
+    }
+}
+
+void
+GlassSegmentedDatabase::check_not_closed() const
+{
+    if (closed)
+	throw Xapian::DatabaseError("Database has been closed");
+}
+
+void
+GlassSegmentedDatabase::merge_segments(size_t begin, size_t end)
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::merge_segments", begin | end);
+    AssertRel(begin,<,end);
+    Segment merged("seg" + str(next_segment++), segments[begin].first_did);
+    string path = segment_path(merged.name);
+    // The compactor can merge segments which cover disjoint docid ranges
+    // and don't have any dead documents.
+    bool clean = true;
+    for (size_t i = begin; i != end; ++i) {
+	const Segment & seg = segments[i];
+	if (seg.dead_count || !seg.deletions->deleted.empty()) {
+	    clean = false;
+	    break;
+	}
+    }
+    try {
+	if (clean) {
+	    Xapian::Database src;
+	    for (size_t i = begin; i != end; ++i) {
+		src.add_database(Xapian::Database(segment_path(segments[i].name),
+						  Xapian::DB_BACKEND_GLASS));
+	    }
+	    src.compact(path,
+			Xapian::DBCOMPACT_NO_RENUMBER | Xapian::Compactor::FULL,
+			block_size);
+	} else {
+	    intrusive_ptr<Xapian::Database::Internal> out;
+	    out = new GlassWritableDatabase(path,
+					    segment_flags(flags) |
+					    Xapian::DB_CREATE_OR_OVERWRITE,
+					    block_size);
+	    const GlassSegmentDeletions & deletions = *merged.deletions;
+	    copy_live_documents(begin, end, out.get(), *merged.deletions);
+	    if (!deletions.deleted.empty()) {
+		out->set_metadata(DELETED_KEY, encode_docids(deletions.deleted));
+		out->set_metadata(REPLACED_KEY,
+				  encode_docids(deletions.replaced));
+	    }
+	    out->commit();
+	    out->close();
+	}
+	merged.db = new GlassDatabase(path);
+    } catch (...) {
+	try {
+	    removedir(path);
+	} catch (const Xapian::DatabaseError &) {
+	    // The next writer to open the database will remove it.
+	}
+	throw;
+    }
+
+    segments.erase(segments.begin() + begin + 1, segments.begin() + end);
+    segments[begin] = merged;
+    write_segments_file();
+    find_dead_copies();
+    // A reader in another process may have just read the old list of
+    // segments and be about to open the ones we merged, so leave them for
+    // remove_unused_segments() to remove when a writer next opens the
+    // database.
+}
+
+void
+GlassSegmentedDatabase::merge_if_needed()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::merge_if_needed", NO_ARGS);
+    // Merge the newest MERGE_FACTOR segments while they're all of the same
+    // size class.  A merge can produce a segment which completes a run at the
+    // next size class up, so keep going until there's nothing to do.
+    while (segments.size() >= MERGE_FACTOR) {
+	size_t begin = segments.size() - MERGE_FACTOR;
+	unsigned level = segment_level(segments[begin].db->get_doccount());
+	size_t i;
+	for (i = begin + 1; i != segments.size(); ++i) {
+	    if (segment_level(segments[i].db->get_doccount()) != level)
+		break;
+	}
+	if (i != segments.size()) break;
+	merge_segments(begin, segments.size());
+    }
+
+    // Rewrite any segment in which at least half the documents are dead, so
+    // that dead documents don't build up in large segments which rarely get
+    // merged.
+    for (size_t i = 0; i != segments.size(); ++i) {
+	const Segment & seg = segments[i];
+	if (seg.dead_count && seg.dead_count * 2 >= seg.db->get_doccount())
+	    merge_segments(i, i + 1);
+    }
+}
+
+void
+GlassSegmentedDatabase::readahead_for_query(const Xapian::Query & query)
+{
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	i->db->readahead_for_query(query);
+    }
+}
+
+void
+GlassSegmentedDatabase::add_table_counts(map<string, TableCounts> & counts) const
+{
+    // Counts for segments which have been merged away are lost.
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	i->db->add_table_counts(counts);
+    }
+    if (aux_db.get()) aux_db->add_table_counts(counts);
+}
+
+Xapian::doccount
+GlassSegmentedDatabase::get_doccount() const
+{
+    LOGCALL(DB, Xapian::doccount, "GlassSegmentedDatabase::get_doccount", NO_ARGS);
+    check_not_closed();
+    Xapian::doccount doccount = 0;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	doccount += i->db->get_doccount();
+    }
+    RETURN(doccount - dead_doccount);
+}
+
+Xapian::docid
+GlassSegmentedDatabase::get_lastdocid() const
+{
+    LOGCALL(DB, Xapian::docid, "GlassSegmentedDatabase::get_lastdocid", NO_ARGS);
+    RETURN(lastdocid);
+}
+
+totlen_t
+GlassSegmentedDatabase::get_total_length() const
+{
+    LOGCALL(DB, totlen_t, "GlassSegmentedDatabase::get_total_length", NO_ARGS);
+    check_not_closed();
+    totlen_t total_length = 0;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	total_length += i->db->get_total_length();
+    }
+    RETURN(total_length - dead_length);
+}
+
+Xapian::doclength
+GlassSegmentedDatabase::get_avlength() const
+{
+    LOGCALL(DB, Xapian::doclength, "GlassSegmentedDatabase::get_avlength", NO_ARGS);
+    Xapian::doccount doccount = get_doccount();
+    if (doccount == 0) {
+	// Avoid dividing by zero when there are no documents.
+	RETURN(0);
+    }
+    RETURN(double(get_total_length()) / doccount);
+}
+
+Xapian::termcount
+GlassSegmentedDatabase::get_doclength(Xapian::docid did) const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassSegmentedDatabase::get_doclength", did);
+    Assert(did != 0);
+    RETURN(segments[live_segment(did)].db->get_doclength(did));
+}
+
+Xapian::termcount
+GlassSegmentedDatabase::get_unique_terms(Xapian::docid did) const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassSegmentedDatabase::get_unique_terms", did);
+    Assert(did != 0);
+    RETURN(segments[live_segment(did)].db->get_unique_terms(did));
+}
+
+void
+GlassSegmentedDatabase::get_freqs(const string & term,
+				  Xapian::doccount * termfreq_ptr,
+				  Xapian::termcount * collfreq_ptr) const
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::get_freqs", term | termfreq_ptr | collfreq_ptr);
+    check_not_closed();
+    Xapian::doccount termfreq = 0;
+    Xapian::termcount collfreq = 0;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	Xapian::doccount sub_termfreq;
+	Xapian::termcount sub_collfreq;
+	i->db->get_freqs(term,
+			 termfreq_ptr ? &sub_termfreq : NULL,
+			 collfreq_ptr ? &sub_collfreq : NULL);
+	if (termfreq_ptr) termfreq += sub_termfreq;
+	if (collfreq_ptr) collfreq += sub_collfreq;
+    }
+    auto dead = dead_freqs.find(term);
+    if (dead != dead_freqs.end()) {
+	termfreq -= dead->second.first;
+	collfreq -= dead->second.second;
+    }
+    if (termfreq_ptr) *termfreq_ptr = termfreq;
+    if (collfreq_ptr) *collfreq_ptr = collfreq;
+}
+
+Xapian::doccount
+GlassSegmentedDatabase::get_value_freq(Xapian::valueno slot) const
+{
+    LOGCALL(DB, Xapian::doccount, "GlassSegmentedDatabase::get_value_freq", slot);
+    check_not_closed();
+    Xapian::doccount value_freq = 0;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	value_freq += i->db->get_value_freq(slot);
+    }
+    auto dead = dead_value_freqs.find(slot);
+    if (dead != dead_value_freqs.end()) value_freq -= dead->second;
+    RETURN(value_freq);
+}
+
+string
+GlassSegmentedDatabase::get_value_lower_bound(Xapian::valueno slot) const
+{
+    LOGCALL(DB, string, "GlassSegmentedDatabase::get_value_lower_bound", slot);
+    string bound;
+    bool have_bound = false;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	// A segment with no values in this slot returns an empty bound, which
+	// would otherwise be the minimum.  A segment's bounds include its dead
+	// documents, so also skip segments where they're all dead.
+	if (!i->has_values(slot)) continue;
+	string sub_bound = i->db->get_value_lower_bound(slot);
+	if (!have_bound || sub_bound < bound) {
+	    bound = sub_bound;
+	    have_bound = true;
+	}
+    }
+    RETURN(bound);
+}
+
+string
+GlassSegmentedDatabase::get_value_upper_bound(Xapian::valueno slot) const
+{
+    LOGCALL(DB, string, "GlassSegmentedDatabase::get_value_upper_bound", slot);
+    string bound;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	if (!i->has_values(slot)) continue;
+	string sub_bound = i->db->get_value_upper_bound(slot);
+	if (sub_bound > bound) bound = sub_bound;
+    }
+    RETURN(bound);
+}
+
+Xapian::termcount
+GlassSegmentedDatabase::get_doclength_lower_bound() const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassSegmentedDatabase::get_doclength_lower_bound", NO_ARGS);
+    Xapian::termcount bound = 0;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	// A bound of 0 means the segment has no documents of non-zero length,
+	// so ignore it (as glass does when merging the statistics).
+	Xapian::termcount sub_bound = i->db->get_doclength_lower_bound();
+	if (sub_bound > 0 && (bound == 0 || sub_bound < bound))
+	    bound = sub_bound;
+    }
+    RETURN(bound);
+}
+
+Xapian::termcount
+GlassSegmentedDatabase::get_doclength_upper_bound() const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassSegmentedDatabase::get_doclength_upper_bound", NO_ARGS);
+    Xapian::termcount bound = 0;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	bound = max(bound, i->db->get_doclength_upper_bound());
+    }
+    RETURN(bound);
+}
+
+Xapian::termcount
+GlassSegmentedDatabase::get_wdf_upper_bound(const string & term) const
+{
+    LOGCALL(DB, Xapian::termcount, "GlassSegmentedDatabase::get_wdf_upper_bound", term);
+    Xapian::termcount bound = 0;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	bound = max(bound, i->db->get_wdf_upper_bound(term));
+    }
+    RETURN(bound);
+}
+
+bool
+GlassSegmentedDatabase::term_exists(const string & term) const
+{
+    LOGCALL(DB, bool, "GlassSegmentedDatabase::term_exists", term);
+    check_not_closed();
+    if (dead_freqs.find(term) != dead_freqs.end()) {
+	// The term may only be in dead documents.
+	Xapian::doccount termfreq;
+	get_freqs(term, &termfreq, NULL);
+	RETURN(termfreq != 0);
+    }
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	if (i->db->term_exists(term)) RETURN(true);
+    }
+    RETURN(false);
+}
+
+bool
+GlassSegmentedDatabase::has_positions() const
+{
+    LOGCALL(DB, bool, "GlassSegmentedDatabase::has_positions", NO_ARGS);
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	if (i->db->has_positions()) RETURN(true);
+    }
+    RETURN(false);
+}
+
+string
+GlassSegmentedDatabase::get_uuid() const
+{
+    LOGCALL(DB, string, "GlassSegmentedDatabase::get_uuid", NO_ARGS);
+    RETURN(uuid);
+}
+
+LeafPostList *
+GlassSegmentedDatabase::open_post_list(const string & term) const
+{
+    LOGCALL(DB, LeafPostList *, "GlassSegmentedDatabase::open_post_list", term);
+    check_not_closed();
+    // The only segment can't have any dead documents.
+    if (segments.size() == 1)
+	RETURN(segments[0].db->open_post_list(term));
+
+    // Only segments which index the term need to be in the postlist.  We
+    // wrap the postlist even if there's only one such segment, since a
+    // segment's own postlists would open "nearby" postlists from just that
+    // segment.
+    vector<LeafPostList *> pls;
+    vector<Xapian::docid> first_dids;
+    vector<GlassSegmentFilter> filters;
+    Xapian::doccount termfreq = 0;
+    try {
+	for (size_t i = 0; i != segments.size(); ++i) {
+	    LeafPostList * pl = segments[i].db->open_post_list(term);
+	    if (pl->get_termfreq() == 0) {
+		delete pl;
+		continue;
+	    }
+	    termfreq += pl->get_termfreq();
+	    pls.push_back(pl);
+	    first_dids.push_back(segments[i].first_did);
+	    filters.push_back(get_filter(i));
+	}
+	if (term.empty()) {
+	    termfreq -= dead_doccount;
+	} else {
+	    auto dead = dead_freqs.find(term);
+	    if (dead != dead_freqs.end()) termfreq -= dead->second.first;
+	}
+	bool ordered = !have_replacements(0, segments.size());
+	RETURN(new GlassSegmentPostList(term, pls, first_dids, filters,
+					ordered, termfreq));
+    } catch (...) {
+	vector<LeafPostList *>::const_iterator i;
+	for (i = pls.begin(); i != pls.end(); ++i) {
+	    delete *i;
+	}
+	throw;
+    }
+}
+
+ValueList *
+GlassSegmentedDatabase::open_value_list(Xapian::valueno slot) const
+{
+    LOGCALL(DB, ValueList *, "GlassSegmentedDatabase::open_value_list", slot);
+    check_not_closed();
+    if (segments.size() == 1)
+	RETURN(segments[0].db->open_value_list(slot));
+
+    vector<ValueList *> valuelists;
+    vector<Xapian::docid> first_dids;
+    vector<GlassSegmentFilter> filters;
+    try {
+	for (size_t i = 0; i != segments.size(); ++i) {
+	    const Segment & seg = segments[i];
+	    if (seg.db->get_value_freq(slot) == 0) continue;
+	    valuelists.push_back(seg.db->open_value_list(slot));
+	    first_dids.push_back(seg.first_did);
+	    filters.push_back(get_filter(i));
+	}
+	if (valuelists.size() == 1 && filters[0].empty())
+	    RETURN(valuelists[0]);
+	bool ordered = !have_replacements(0, segments.size());
+	RETURN(new GlassSegmentValueList(valuelists, first_dids, filters,
+					 ordered, slot));
+    } catch (...) {
+	vector<ValueList *>::const_iterator i;
+	for (i = valuelists.begin(); i != valuelists.end(); ++i) {
+	    delete *i;
+	}
+	throw;
+    }
+}
+
+TermList *
+GlassSegmentedDatabase::open_term_list(Xapian::docid did) const
+{
+    LOGCALL(DB, TermList *, "GlassSegmentedDatabase::open_term_list", did);
+    Assert(did != 0);
+    TermList * tl = segments[live_segment(did)].db->open_term_list(did);
+    // Term frequencies need to be for the whole database, not the segment.
+    static_cast<GlassTermList *>(tl)->set_stats_database(this);
+    RETURN(tl);
+}
+
+/** Wrapper which handles a MultiAllTermsList pruning itself.
+ *
+ *  Callers such as wildcard expansion don't expect the termlist returned by
+ *  a backend's open_allterms() to prune, so absorb the replacement here.
+ *  We also adjust the frequencies for dead documents, and skip terms which
+ *  are only in dead documents.
+ */
+class SegmentedAllTermsList : public AllTermsList {
+    /// The termlist being wrapped.
+    TermList * tl;
+
+    /// The database we're listing the terms of.
+    intrusive_ptr<const GlassSegmentedDatabase> db;
+
+    /// Replace tl with @a ret if it isn't NULL.
+    void prune(TermList * ret) {
+	if (ret) {
+	    delete tl;
+	    tl = ret;
+	}
+    }
+
+    /// Skip any terms which are only in dead documents.
+    void skip_dead_terms() {
+	if (db->dead_freqs.empty()) return;
+	while (!tl->at_end() && get_termfreq() == 0) {
+	    prune(tl->next());
+	}
+    }
+
+  public:
+    SegmentedAllTermsList(TermList * tl_,
+			  const GlassSegmentedDatabase * db_)
+	: tl(tl_), db(db_) { }
+
+    ~SegmentedAllTermsList() { delete tl; }
+
+    string get_termname() const { return tl->get_termname(); }
+
+    Xapian::doccount get_termfreq() const {
+	Xapian::doccount termfreq = tl->get_termfreq();
+	auto dead = db->dead_freqs.find(tl->get_termname());
+	if (dead != db->dead_freqs.end()) termfreq -= dead->second.first;
+	return termfreq;
+    }
+
+    Xapian::termcount get_collection_freq() const {
+	Xapian::termcount collfreq = tl->get_collection_freq();
+	auto dead = db->dead_freqs.find(tl->get_termname());
+	if (dead != db->dead_freqs.end()) collfreq -= dead->second.second;
+	return collfreq;
+    }
+
+    TermList * next() {
+	prune(tl->next());
+	skip_dead_terms();
+	return NULL;
+    }
+
+    TermList * skip_to(const string & term) {
+	prune(tl->skip_to(term));
+	skip_dead_terms();
+	return NULL;
+    }
+
+    bool at_end() const { return tl->at_end(); }
+};
+
+TermList *
+GlassSegmentedDatabase::open_allterms(const string & prefix) const
+{
+    LOGCALL(DB, TermList *, "GlassSegmentedDatabase::open_allterms", prefix);
+    check_not_closed();
+    if (segments.size() == 1)
+	RETURN(segments[0].db->open_allterms(prefix));
+    vector<intrusive_ptr<Xapian::Database::Internal> > dbs;
+    dbs.reserve(segments.size());
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	dbs.push_back(i->db);
+    }
+    RETURN(new SegmentedAllTermsList(new MultiAllTermsList(dbs, prefix), this));
+}
+
+PositionList *
+GlassSegmentedDatabase::open_position_list(Xapian::docid did,
+					   const string & term) const
+{
+    LOGCALL(DB, PositionList *, "GlassSegmentedDatabase::open_position_list", did | term);
+    Assert(did != 0);
+    size_t i = segments.size();
+    if (did <= lastdocid) i = find_live(did);
+    // Like glass, we don't check the document exists.
+    if (i == segments.size()) RETURN(new GlassPositionList);
+    RETURN(segments[i].db->open_position_list(did, term));
+}
+
+Xapian::Document::Internal *
+GlassSegmentedDatabase::open_document(Xapian::docid did, bool lazy) const
+{
+    LOGCALL(DB, Xapian::Document::Internal *, "GlassSegmentedDatabase::open_document", did | lazy);
+    Assert(did != 0);
+    size_t i = segments.size();
+    if (did <= lastdocid) i = find_live(did);
+    if (i == segments.size()) {
+	if (lazy) RETURN(NULL);
+	throw Xapian::DocNotFoundError("Document " + str(did) + " not found");
+    }
+    Xapian::Document::Internal * doc = segments[i].db->open_document(did, lazy);
+    // Remember the document, so that replacing a document in a committed
+    // segment with itself unmodified doesn't copy it to the new segment.
+    modify_shortcut_document = doc;
+    modify_shortcut_docid = did;
+    RETURN(doc);
+}
+
+TermList *
+GlassSegmentedDatabase::open_spelling_termlist(const string & word) const
+{
+    return aux_db->open_spelling_termlist(word);
+}
+
+TermList *
+GlassSegmentedDatabase::open_spelling_wordlist() const
+{
+    return aux_db->open_spelling_wordlist();
+}
+
+Xapian::doccount
+GlassSegmentedDatabase::get_spelling_frequency(const string & word) const
+{
+    return aux_db->get_spelling_frequency(word);
+}
+
+void
+GlassSegmentedDatabase::add_spelling(const string & word,
+				     Xapian::termcount freqinc) const
+{
+    GlassSegmentedDatabase * self = const_cast<GlassSegmentedDatabase *>(this);
+    self->writable_aux()->add_spelling(word, freqinc);
+}
+
+void
+GlassSegmentedDatabase::remove_spelling(const string & word,
+					Xapian::termcount freqdec) const
+{
+    GlassSegmentedDatabase * self = const_cast<GlassSegmentedDatabase *>(this);
+    self->writable_aux()->remove_spelling(word, freqdec);
+}
+
+TermList *
+GlassSegmentedDatabase::open_synonym_termlist(const string & term) const
+{
+    return aux_db->open_synonym_termlist(term);
+}
+
+TermList *
+GlassSegmentedDatabase::open_synonym_keylist(const string & prefix) const
+{
+    return aux_db->open_synonym_keylist(prefix);
+}
+
+void
+GlassSegmentedDatabase::add_synonym(const string & term,
+				    const string & synonym) const
+{
+    GlassSegmentedDatabase * self = const_cast<GlassSegmentedDatabase *>(this);
+    self->writable_aux()->add_synonym(term, synonym);
+}
+
+void
+GlassSegmentedDatabase::remove_synonym(const string & term,
+				       const string & synonym) const
+{
+    GlassSegmentedDatabase * self = const_cast<GlassSegmentedDatabase *>(this);
+    self->writable_aux()->remove_synonym(term, synonym);
+}
+
+void
+GlassSegmentedDatabase::clear_synonyms(const string & term) const
+{
+    GlassSegmentedDatabase * self = const_cast<GlassSegmentedDatabase *>(this);
+    self->writable_aux()->clear_synonyms(term);
+}
+
+string
+GlassSegmentedDatabase::get_metadata(const string & key) const
+{
+    LOGCALL(DB, string, "GlassSegmentedDatabase::get_metadata", key);
+    RETURN(aux_db->get_metadata(key));
+}
+
+TermList *
+GlassSegmentedDatabase::open_metadata_keylist(const string & prefix) const
+{
+    LOGCALL(DB, TermList *, "GlassSegmentedDatabase::open_metadata_keylist", prefix);
+    RETURN(aux_db->open_metadata_keylist(prefix));
+}
+
+void
+GlassSegmentedDatabase::set_metadata(const string & key, const string & value)
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::set_metadata", key | value);
+    writable_aux()->set_metadata(key, value);
+}
+
+bool
+GlassSegmentedDatabase::reopen()
+{
+    LOGCALL(DB, bool, "GlassSegmentedDatabase::reopen", NO_ARGS);
+    check_not_closed();
+    if (writable) RETURN(false);
+    RETURN(open_segments());
+}
+
+void
+GlassSegmentedDatabase::close()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::close", NO_ARGS);
+    if (closed) return;
+    if (writable && aux_db.get()) {
+	if (transaction_active()) {
+	    cancel();
+	} else {
+	    commit();
+	}
+    }
+    vector<Segment>::iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	i->db->close();
+    }
+    if (aux_db.get()) aux_db->close();
+    lock.release();
+    closed = true;
+}
+
+void
+GlassSegmentedDatabase::commit()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::commit", NO_ARGS);
+    if (transaction_active())
+	throw Xapian::InvalidOperationError("Can't commit during a transaction");
+    // Nothing can have changed since close() committed.
+    if (closed) return;
+
+    // Write out the new segment and the new copy of the spelling, synonym and
+    // metadata database.  Neither is used until they're listed in the
+    // segment list, so replacing that is what commits the changes.
+    if (last_segment_uncommitted) {
+	Segment & seg = segments.back();
+	const GlassSegmentDeletions & deletions = *seg.deletions;
+	if (seg.db->get_doccount() == 0 && deletions.deleted.empty()) {
+	    discard_new_segment();
+	} else {
+	    if (!deletions.deleted.empty()) {
+		seg.db->set_metadata(DELETED_KEY,
+				     encode_docids(deletions.deleted));
+		seg.db->set_metadata(REPLACED_KEY,
+				     encode_docids(deletions.replaced));
+	    }
+	    // The transaction isn't flushed, so this doesn't commit it.
+	    seg.db->commit_transaction();
+	    seg.db->commit();
+	    seg.writable = false;
+	    last_segment_uncommitted = false;
+	}
+    }
+    if (aux_writable) {
+	aux_db->commit_transaction();
+	aux_db->commit();
+	aux_name = new_aux_name;
+	aux_writable = false;
+    }
+
+    committed_lastdocid = lastdocid;
+    change_count = 0;
+    // Readers may still open the old copy of the spelling, synonym and
+    // metadata database, so it's removed when a writer next opens the
+    // database, like the segments replaced by a merge.
+    write_segments_file();
+
+    merge_if_needed();
+}
+
+void
+GlassSegmentedDatabase::cancel()
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::cancel", NO_ARGS);
+    // Discard the segment and the copy of the spelling, synonym and metadata
+    // database started since the last commit.
+    if (last_segment_uncommitted) {
+	discard_new_segment();
+	// The new segment may have deleted documents from older segments.
+	find_dead_copies();
+    }
+    if (aux_writable) {
+	aux_db->cancel_transaction();
+	aux_db->close();
+	try {
+	    removedir(segment_path(new_aux_name));
+	} catch (const Xapian::DatabaseError &) {
+	    // The next writer to open the database will remove it.
+	}
+	aux_db = new GlassDatabase(segment_path(aux_name));
+	aux_writable = false;
+    }
+    lastdocid = committed_lastdocid;
+    change_count = 0;
+}
+
+void
+GlassSegmentedDatabase::note_change()
+{
+    if (++change_count >= flush_threshold && !transaction_active())
+	commit();
+}
+
+Xapian::docid
+GlassSegmentedDatabase::add_document(const Xapian::Document & document)
+{
+    LOGCALL(DB, Xapian::docid, "GlassSegmentedDatabase::add_document", document);
+    if (lastdocid == Xapian::docid(-1))
+	throw Xapian::DatabaseError("Run out of docids - you'll have to use copydatabase to eliminate any gaps before you can add more documents");
+    Xapian::docid did = lastdocid + 1;
+    new_segment()->replace_document(did, document);
+    lastdocid = did;
+    note_change();
+    RETURN(did);
+}
+
+void
+GlassSegmentedDatabase::delete_document(Xapian::docid did)
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::delete_document", did);
+    Assert(did != 0);
+    size_t i = live_segment(did);
+    if (did == modify_shortcut_docid) {
+	modify_shortcut_document = NULL;
+	modify_shortcut_docid = 0;
+    }
+    Segment & seg = segments[i];
+    if (seg.writable) {
+	seg.db->delete_document(did);
+	seg.deletions->replaced.erase(did);
+    } else {
+	// Check the document exists (this throws DocNotFoundError if not).
+	(void)seg.db->get_doclength(did);
+	new_segment();
+	segments.back().deletions->deleted.insert(did);
+	add_dead_copy(i, did);
+    }
+    note_change();
+}
+
+void
+GlassSegmentedDatabase::replace_document(Xapian::docid did,
+					 const Xapian::Document & document)
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::replace_document", did | document);
+    Assert(did != 0);
+    size_t i = segments.size();
+    if (did <= lastdocid) i = find_live(did);
+    if (did > lastdocid || (i != segments.size() && segments[i].writable)) {
+	// The document is new, or already in the new segment.
+	new_segment()->replace_document(did, document);
+	if (did > lastdocid) lastdocid = did;
+    } else {
+	if (did == modify_shortcut_docid) {
+	    if (document.internal.get() == modify_shortcut_document &&
+		!document.internal->modified()) {
+		// Replacing a document with itself unchanged doesn't do
+		// anything.
+		return;
+	    }
+	    modify_shortcut_document = NULL;
+	    modify_shortcut_docid = 0;
+	}
+	// Add the new copy before marking the old one as dead, since the
+	// document may be read lazily from the old copy.
+	new_segment()->replace_document(did, document);
+	GlassSegmentDeletions & deletions = *segments.back().deletions;
+	deletions.deleted.insert(did);
+	deletions.replaced.insert(did);
+	if (i != segments.size()) add_dead_copy(i, did);
+    }
+    // Replacing a document read from the database with itself unchanged
+    // doesn't do anything, so don't count it.
+    if (document.get_docid() != did || document.internal->modified())
+	note_change();
+}
+
+int
+GlassSegmentedDatabase::get_backend_info(string * path) const
+{
+    if (path) *path = db_dir;
+    return BACKEND_GLASS_SEGMENTED;
+}
+
+void
+GlassSegmentedDatabase::get_used_docid_range(Xapian::docid & first,
+					     Xapian::docid & last) const
+{
+    LOGCALL_VOID(DB, "GlassSegmentedDatabase::get_used_docid_range", first | last);
+    // This includes any dead documents at the ends of the range.
+    first = last = 0;
+    vector<Segment>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+	if (i->db->get_doccount() == 0) continue;
+	Xapian::docid sub_first, sub_last;
+	i->db->get_used_docid_range(sub_first, sub_last);
+	if (first == 0 || sub_first < first) first = sub_first;
+	if (sub_last > last) last = sub_last;
+    }
+}
@@ -0,0 +1,402 @@
+/** @file glass_segmented.h
+ * @brief A database made up of immutable glass segments
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_SEGMENTED_H
+#define XAPIAN_INCLUDED_GLASS_SEGMENTED_H
+
+#include "backends/backends.h"
+#include "backends/database.h"
+#include "backends/flint_lock.h"
+#include "glass_segmentdeletions.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** A database made up of immutable glass segments.
+ *
+ *  The directory holds a file "iamsegmented" listing the segments (each of
+ *  which is a glass database in a subdirectory) and the first docid each
+ *  one covers.  A segment covers the docids from its first docid up to the
+ *  first docid of the next segment, and the last segment covers all the
+ *  docids after its first.
+ *
+ *  A segment is never modified once it has been committed.  The changes
+ *  since the last commit go into a new segment: added documents, new copies
+ *  of documents replaced in older segments, and the set of docids whose
+ *  copies in older segments are dead (see GlassSegmentDeletions).  These
+ *  sets are stored in the new segment, and their sizes are listed in
+ *  "iamsegmented", so atomically replacing that file commits everything.
+ *
+ *  Postlists and value streams combine those of the segments, skipping dead
+ *  entries.  Statistics are sums over the segments, less the contributions
+ *  of the dead copies, which we work out when the database is opened.
+ *
+ *  After each commit, runs of segments of similar sizes are merged, which
+ *  keeps the number of segments logarithmic in the number of documents.
+ *
+ *  Spelling, synonym and user metadata are kept in a separate glass
+ *  database, which is copied the first time they're changed after each
+ *  commit.
+ */
+class GlassSegmentedDatabase : public Xapian::Database::Internal {
+    friend class SegmentedAllTermsList;
+
+    /// Don't allow assignment.
+    void operator=(const GlassSegmentedDatabase &);
+
+    /// Don't allow copying.
+    GlassSegmentedDatabase(const GlassSegmentedDatabase &);
+
+    /// A segment of the database.
+    struct Segment {
+	/// The subdirectory holding this segment.
+	std::string name;
+
+	/// The first docid which this segment covers.
+	Xapian::docid first_did;
+
+	/// The database for this segment.
+	Xapian::Internal::intrusive_ptr<Xapian::Database::Internal> db;
+
+	/// Is this the new segment, which hasn't been committed yet?
+	bool writable;
+
+	/// Documents this segment deletes or replaces in older segments.
+	Xapian::Internal::intrusive_ptr<GlassSegmentDeletions> deletions;
+
+	/// Number of documents in this segment which are dead.
+	Xapian::doccount dead_count;
+
+	/// Number of dead documents in this segment with a value in each slot.
+	std::map<Xapian::valueno, Xapian::doccount> dead_value_freqs;
+
+	/// Does this segment have any live values in slot @a slot?
+	bool has_values(Xapian::valueno slot) const {
+	    Xapian::doccount value_freq = db->get_value_freq(slot);
+	    if (value_freq == 0) return false;
+	    auto dead = dead_value_freqs.find(slot);
+	    return dead == dead_value_freqs.end() || dead->second < value_freq;
+	}
+
+	Segment(const std::string & name_, Xapian::docid first_did_)
+	    : name(name_), first_did(first_did_), writable(false),
+	      deletions(new GlassSegmentDeletions), dead_count(0) { }
+    };
+
+    /// The directory the database is in.
+    std::string db_dir;
+
+    /// Flags the database was opened with.
+    int flags;
+
+    /// The block size to use when creating segments.
+    int block_size;
+
+    /// Is this database open for writing?
+    bool writable;
+
+    /// Lock object (only used when writable).
+    FlintLock lock;
+
+    /// Has close() been called?
+    bool closed;
+
+    /// Throw Xapian::DatabaseError if close() has been called.
+    void check_not_closed() const;
+
+    /// The segments, in ascending order of first_did.
+    std::vector<Segment> segments;
+
+    /// The last docid used.
+    Xapian::docid lastdocid;
+
+    /// The last docid used as of the last commit.
+    Xapian::docid committed_lastdocid;
+
+    /// The UUID of the database (segments have their own UUIDs).
+    std::string uuid;
+
+    /// Number to use in the name of the next segment created.
+    unsigned next_segment;
+
+    /// Was the last segment created since the last commit?
+    bool last_segment_uncommitted;
+
+    /// The subdirectory holding the spelling, synonym and metadata database.
+    std::string aux_name;
+
+    /// The spelling, synonym and metadata database.
+    Xapian::Internal::intrusive_ptr<Xapian::Database::Internal> aux_db;
+
+    /// Has aux_db been copied to a new subdirectory since the last commit?
+    bool aux_writable;
+
+    /// The subdirectory aux_db was copied to.
+    std::string new_aux_name;
+
+    /// Number of dead copies of documents.
+    Xapian::doccount dead_doccount;
+
+    /// Total length of the dead copies of documents.
+    totlen_t dead_length;
+
+    /// Term and collection frequencies of terms in dead copies.
+    std::map<std::string, std::pair<Xapian::doccount, Xapian::termcount>> dead_freqs;
+
+    /// Number of dead copies of documents with a value in each slot.
+    std::map<Xapian::valueno, Xapian::doccount> dead_value_freqs;
+
+    /// The document most recently returned by open_document().
+    mutable const Xapian::Document::Internal * modify_shortcut_document;
+
+    /// The docid of modify_shortcut_document.
+    mutable Xapian::docid modify_shortcut_docid;
+
+    /// Number of changes since the last commit.
+    Xapian::doccount change_count;
+
+    /// Number of changes after which to commit automatically.
+    Xapian::doccount flush_threshold;
+
+    /// Count a change, and commit if there have been enough.
+    void note_change();
+
+    /// The contents of "iamsegmented" the last time we read or wrote it.
+    std::string segments_file_contents;
+
+    /// Return the path of the segment called @a name.
+    std::string segment_path(const std::string & name) const {
+	return db_dir + "/" + name;
+    }
+
+    /// Read the contents of "iamsegmented".
+    std::string read_segments_file() const;
+
+    /** Parse the contents of "iamsegmented".
+     *
+     *  Sets uuid, lastdocid, committed_lastdocid and next_segment, and fills in
+     *  @a new_segments (without opening them), @a sizes (the sizes of each
+     *  segment's sets of deleted and replaced docids) and @a new_aux_name_.
+     */
+    void parse_segments_file(const std::string & contents,
+			     std::vector<Segment> & new_segments,
+			     std::vector<std::pair<Xapian::doccount, Xapian::doccount>> & sizes,
+			     std::string & new_aux_name_);
+
+    /// Read the deleted and replaced docids stored in segment @a seg.
+    void read_deletions(Segment & seg,
+			Xapian::doccount deleted_size,
+			Xapian::doccount replaced_size) const;
+
+    /// Write "iamsegmented" describing the current segments.
+    void write_segments_file();
+
+    /** Open the segments listed in "iamsegmented" for reading.
+     *
+     *  Any segments we already have open which are still listed are reused
+     *  (and reopened).
+     *
+     *  @return true if anything changed.
+     */
+    bool open_segments();
+
+    /// Create a new database.
+    void create();
+
+    /// Return the new segment, starting it if there isn't one yet.
+    Xapian::Database::Internal * new_segment();
+
+    /// Cancel and remove the new segment.
+    void discard_new_segment();
+
+    /// Return aux_db, copying it first if it hasn't been since the last commit.
+    Xapian::Database::Internal * writable_aux();
+
+    /// Remove any segment directories which aren't listed.
+    void remove_unused_segments();
+
+    /// Return the index of the segment covering @a did.
+    size_t find_segment(Xapian::docid did) const;
+
+    /** Return the index of the segment with the live copy of @a did.
+     *
+     *  Only segments before @a end are considered, and the copies in them
+     *  are only counted as dead if a segment before @a end deletes them.
+     *
+     *  @return segments.size() if segment @a end - 1 or an earlier one
+     *	    deletes @a did without replacing it.  The returned segment
+     *	    may not actually have a document @a did.
+     */
+    size_t find_copy(Xapian::docid did, size_t end) const;
+
+    /// Return the index of the segment with the live copy of @a did.
+    size_t find_live(Xapian::docid did) const {
+	return find_copy(did, segments.size());
+    }
+
+    /** Return the index of the segment with the live copy of @a did.
+     *
+     *  @exception Xapian::DocNotFoundError if @a did has been deleted.
+     */
+    size_t live_segment(Xapian::docid did) const;
+
+    /// Return a filter for the dead entries in segment @a i.
+    GlassSegmentFilter get_filter(size_t i) const;
+
+    /// Are any documents in segments [@a begin, @a end) out of order?
+    bool have_replacements(size_t begin, size_t end) const;
+
+    /** Note that the copy of @a did in segment @a i is dead.
+     *
+     *  Updates the statistics for the dead copies, unless segment @a i
+     *  doesn't actually have a document @a did.
+     */
+    void add_dead_copy(size_t i, Xapian::docid did);
+
+    /// Work out the statistics for the dead copies from scratch.
+    void find_dead_copies();
+
+    /** Copy the live documents in segments [@a begin, @a end) to @a out.
+     *
+     *  @param deletions  Set to the deleted and replaced docids from before
+     *			  segment @a begin.
+     */
+    void copy_live_documents(size_t begin, size_t end,
+			     Xapian::Database::Internal * out,
+			     GlassSegmentDeletions & deletions) const;
+
+    /// Merge segments [@a begin, @a end) into one.
+    void merge_segments(size_t begin, size_t end);
+
+    /// Merge segments if there are enough of similar sizes.
+    void merge_if_needed();
+
+  public:
+    /** Open a segmented database.
+     *
+     *  @param db_dir_	    The directory the database is in.
+     *  @param writable_    Open for writing?
+     *  @param flags_	    If @a writable_, the flags to open with, as for
+     *			    GlassWritableDatabase; otherwise 0 or
+     *			    Xapian::DB_PIN_REVISION.
+     *  @param block_size_  Block size to use for new segments.
+     */
+    GlassSegmentedDatabase(const std::string & db_dir_, bool writable_,
+			   int flags_, int block_size_ = 0);
+
+    ~GlassSegmentedDatabase();
+
+    /// Does @a path contain a segmented database?
+    static bool database_exists(const std::string & path);
+
+    /** Append databases to compact in place of this one to @a out.
+     *
+     *  These are the segments and the spelling, synonym and metadata
+     *  database.  If any segment has dead documents or documents out of
+     *  docid order, the live documents are first copied to a temporary
+     *  glass database instead, since the compactor can't skip them.
+     *
+     *  @return The path of the temporary database, which the caller should
+     *		remove after compacting, or an empty string if there isn't
+     *		one.
+     */
+    std::string get_segment_databases(std::vector<Xapian::Internal::intrusive_ptr<Xapian::Database::Internal>> & out) const;
+
+    /** Virtual methods of Database::Internal. */
+    //@{
+    void readahead_for_query(const Xapian::Query & query);
+
+    void add_table_counts(std::map<std::string, TableCounts> & counts) const;
+
+    Xapian::doccount get_doccount() const;
+    Xapian::docid get_lastdocid() const;
+    totlen_t get_total_length() const;
+    Xapian::doclength get_avlength() const;
+    Xapian::termcount get_doclength(Xapian::docid did) const;
+    Xapian::termcount get_unique_terms(Xapian::docid did) const;
+    void get_freqs(const std::string & term,
+		   Xapian::doccount * termfreq_ptr,
+		   Xapian::termcount * collfreq_ptr) const;
+    Xapian::doccount get_value_freq(Xapian::valueno slot) const;
+    std::string get_value_lower_bound(Xapian::valueno slot) const;
+    std::string get_value_upper_bound(Xapian::valueno slot) const;
+    Xapian::termcount get_doclength_lower_bound() const;
+    Xapian::termcount get_doclength_upper_bound() const;
+    Xapian::termcount get_wdf_upper_bound(const std::string & term) const;
+    bool term_exists(const std::string & term) const;
+    bool has_positions() const;
+
+    std::string get_uuid() const;
+
+    LeafPostList * open_post_list(const std::string & term) const;
+    ValueList * open_value_list(Xapian::valueno slot) const;
+    TermList * open_term_list(Xapian::docid did) const;
+    TermList * open_allterms(const std::string & prefix) const;
+    PositionList * open_position_list(Xapian::docid did,
+				      const std::string & term) const;
+    Xapian::Document::Internal * open_document(Xapian::docid did,
+					       bool lazy) const;
+
+    TermList * open_spelling_termlist(const std::string & word) const;
+    TermList * open_spelling_wordlist() const;
+    Xapian::doccount get_spelling_frequency(const std::string & word) const;
+    void add_spelling(const std::string & word,
+		      Xapian::termcount freqinc) const;
+    void remove_spelling(const std::string & word,
+			 Xapian::termcount freqdec) const;
+
+    TermList * open_synonym_termlist(const std::string & term) const;
+    TermList * open_synonym_keylist(const std::string & prefix) const;
+    void add_synonym(const std::string & term,
+		     const std::string & synonym) const;
+    void remove_synonym(const std::string & term,
+			const std::string & synonym) const;
+    void clear_synonyms(const std::string & term) const;
+
+    std::string get_metadata(const std::string & key) const;
+    TermList * open_metadata_keylist(const std::string & prefix) const;
+    void set_metadata(const std::string & key, const std::string & value);
+
+    bool reopen();
+    void close();
+
+    void commit();
+    void cancel();
+
+    Xapian::docid add_document(const Xapian::Document & document);
+    // Stop the compiler hiding the other overloads (the default
+    // implementations use the docid versions below).
+#ifndef _MSC_VER
+    using Xapian::Database::Internal::delete_document;
+    using Xapian::Database::Internal::replace_document;
+#endif
+    void delete_document(Xapian::docid did);
+    void replace_document(Xapian::docid did,
+			  const Xapian::Document & document);
+
+    int get_backend_info(std::string * path) const;
+
+    void get_used_docid_range(Xapian::docid & first,
+			      Xapian::docid & last) const;
+    //@}
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_SEGMENTED_H
@@ -0,0 +1,220 @@
+/** @file glass_segmentpostlist.cc
+ * @brief Postlist for a GlassSegmentedDatabase
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "glass_segmentpostlist.h"
+
+#include <algorithm>
+
+#include "debuglog.h"
+#include "omassert.h"
+
+using namespace std;
+
+GlassSegmentPostList::GlassSegmentPostList(const string & term_,
+					   vector<LeafPostList *> & pls_,
+					   const vector<Xapian::docid> & first_dids_,
+					   vector<GlassSegmentFilter> & filters_,
+					   bool ordered_,
+					   Xapian::doccount termfreq_)
+    : LeafPostList(term_), first_dids(first_dids_), current(0),
+      termfreq(termfreq_), ordered(ordered_), started(false)
+{
+    LOGCALL_CTOR(DB, "GlassSegmentPostList", term_ | pls_.size() | ordered_ | termfreq_);
+    AssertEq(pls_.size(), first_dids_.size());
+    AssertEq(pls_.size(), filters_.size());
+    swap(pls, pls_);
+    swap(filters, filters_);
+}
+
+GlassSegmentPostList::~GlassSegmentPostList()
+{
+    vector<LeafPostList *>::const_iterator i;
+    for (i = pls.begin(); i != pls.end(); ++i) {
+	delete *i;
+    }
+}
+
+void
+GlassSegmentPostList::skip_dead(size_t i, double w_min)
+{
+    const GlassSegmentFilter & filter = filters[i];
+    if (filter.empty()) return;
+    while (!pls[i]->at_end() && filter.is_dead(pls[i]->get_docid())) {
+	pls[i]->next(w_min);
+    }
+}
+
+void
+GlassSegmentPostList::skip_exhausted(double w_min)
+{
+    while (pls[current]->at_end()) {
+	if (++current == pls.size())
+	    return;
+	pls[current]->next(w_min);
+	skip_dead(current, w_min);
+    }
+}
+
+void
+GlassSegmentPostList::find_lowest()
+{
+    current = pls.size();
+    Xapian::docid lowest = 0;
+    for (size_t i = 0; i != pls.size(); ++i) {
+	if (pls[i]->at_end()) continue;
+	Xapian::docid did = pls[i]->get_docid();
+	if (current == pls.size() || did < lowest) {
+	    current = i;
+	    lowest = did;
+	}
+    }
+}
+
+void
+GlassSegmentPostList::set_profile(Xapian::MatchProfile::Internal * profile_)
+{
+    LeafPostList::set_profile(profile_);
+    // The segments' postlists do the actual work, so they count it.
+    vector<LeafPostList *>::const_iterator i;
+    for (i = pls.begin(); i != pls.end(); ++i) {
+	(*i)->set_profile(profile_);
+    }
+}
+
+Xapian::doccount
+GlassSegmentPostList::get_termfreq() const
+{
+    return termfreq;
+}
+
+Xapian::docid
+GlassSegmentPostList::get_docid() const
+{
+    Assert(!at_end());
+    return pls[current]->get_docid();
+}
+
+Xapian::termcount
+GlassSegmentPostList::get_doclength() const
+{
+    Assert(!at_end());
+    return pls[current]->get_doclength();
+}
+
+Xapian::termcount
+GlassSegmentPostList::get_unique_terms() const
+{
+    Assert(!at_end());
+    return pls[current]->get_unique_terms();
+}
+
+Xapian::termcount
+GlassSegmentPostList::get_wdf() const
+{
+    Assert(!at_end());
+    return pls[current]->get_wdf();
+}
+
+PositionList *
+GlassSegmentPostList::read_position_list()
+{
+    Assert(!at_end());
+    return pls[current]->read_position_list();
+}
+
+PositionList *
+GlassSegmentPostList::open_position_list() const
+{
+    Assert(!at_end());
+    return pls[current]->open_position_list();
+}
+
+PostList *
+GlassSegmentPostList::next(double w_min)
+{
+    LOGCALL(DB, PostList *, "GlassSegmentPostList::next", w_min);
+    if (current == pls.size()) RETURN(NULL);
+    if (ordered) {
+	pls[current]->next(w_min);
+	skip_dead(current, w_min);
+	skip_exhausted(w_min);
+	RETURN(NULL);
+    }
+
+    if (started) {
+	pls[current]->next(w_min);
+	skip_dead(current, w_min);
+    } else {
+	for (size_t i = 0; i != pls.size(); ++i) {
+	    pls[i]->next(w_min);
+	    skip_dead(i, w_min);
+	}
+	started = true;
+    }
+    find_lowest();
+    RETURN(NULL);
+}
+
+PostList *
+GlassSegmentPostList::skip_to(Xapian::docid did, double w_min)
+{
+    LOGCALL(DB, PostList *, "GlassSegmentPostList::skip_to", did | w_min);
+    if (current == pls.size()) RETURN(NULL);
+    if (ordered) {
+	// Jump straight to the segment which covers did, if it's a later one.
+	vector<Xapian::docid>::const_iterator i;
+	i = upper_bound(first_dids.begin() + current + 1, first_dids.end(), did);
+	current = (i - first_dids.begin()) - 1;
+	pls[current]->skip_to(did, w_min);
+	skip_dead(current, w_min);
+	skip_exhausted(w_min);
+	RETURN(NULL);
+    }
+
+    for (size_t i = 0; i != pls.size(); ++i) {
+	if (started && (pls[i]->at_end() || pls[i]->get_docid() >= did))
+	    continue;
+	pls[i]->skip_to(did, w_min);
+	skip_dead(i, w_min);
+    }
+    started = true;
+    find_lowest();
+    RETURN(NULL);
+}
+
+bool
+GlassSegmentPostList::at_end() const
+{
+    return current == pls.size();
+}
+
+string
+GlassSegmentPostList::get_description() const
+{
+    string desc = "GlassSegmentPostList(";
+    vector<LeafPostList *>::const_iterator i;
+    for (i = pls.begin(); i != pls.end(); ++i) {
+	if (i != pls.begin()) desc += ", ";
+	desc += (*i)->get_description();
+    }
+    desc += ')';
+    return desc;
+}
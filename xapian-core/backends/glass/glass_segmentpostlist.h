@@ -0,0 +1,123 @@
+/** @file glass_segmentpostlist.h
+ * @brief Postlist for a GlassSegmentedDatabase
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_SEGMENTPOSTLIST_H
+#define XAPIAN_INCLUDED_GLASS_SEGMENTPOSTLIST_H
+
+#include "api/leafpostlist.h"
+#include "glass_segmentdeletions.h"
+
+#include <string>
+#include <vector>
+
+/** Postlist for a GlassSegmentedDatabase.
+ *
+ *  Entries for documents which a newer segment deletes or replaces are
+ *  skipped.  If no segment holds replacements for docids before its own
+ *  range, the segments cover disjoint ranges of docids in ascending order,
+ *  so we just iterate the postlist from each segment in turn.  Otherwise we
+ *  merge the postlists by docid.
+ */
+class GlassSegmentPostList : public LeafPostList {
+    /// Don't allow assignment.
+    void operator=(const GlassSegmentPostList &);
+
+    /// Don't allow copying.
+    GlassSegmentPostList(const GlassSegmentPostList &);
+
+    /// The postlist from each segment.
+    std::vector<LeafPostList *> pls;
+
+    /// The first docid covered by each segment.
+    std::vector<Xapian::docid> first_dids;
+
+    /// Which entries of each segment's postlist are dead.
+    std::vector<GlassSegmentFilter> filters;
+
+    /** Index of the postlist we're currently in.
+     *
+     *  This is pls.size() once we've reached the end.
+     */
+    size_t current;
+
+    /// The total term frequency.
+    Xapian::doccount termfreq;
+
+    /// Are the segments' postlists in ascending docid order?
+    bool ordered;
+
+    /// Have we started iterating (only used when not ordered)?
+    bool started;
+
+    /// Move postlist @a i on past any dead entries.
+    void skip_dead(size_t i, double w_min);
+
+    /// Move on from any segments we've reached the end of.
+    void skip_exhausted(double w_min);
+
+    /// Set current to the postlist with the lowest docid.
+    void find_lowest();
+
+  public:
+    /** Construct.
+     *
+     *  @param term_	    The term (empty for the all-docs postlist).
+     *  @param pls_	    The postlist from each segment.  We take ownership
+     *			    of these, and @a pls_ is left empty.
+     *  @param first_dids_  The first docid covered by each segment.
+     *  @param filters_	    Which entries of each postlist are dead.
+     *			    @a filters_ is left empty.
+     *  @param ordered_	    Are the postlists in ascending docid order?
+     *  @param termfreq_    The term frequency.
+     */
+    GlassSegmentPostList(const std::string & term_,
+			 std::vector<LeafPostList *> & pls_,
+			 const std::vector<Xapian::docid> & first_dids_,
+			 std::vector<GlassSegmentFilter> & filters_,
+			 bool ordered_,
+			 Xapian::doccount termfreq_);
+
+    ~GlassSegmentPostList();
+
+    void set_profile(Xapian::MatchProfile::Internal * profile_);
+
+    Xapian::doccount get_termfreq() const;
+
+    Xapian::docid get_docid() const;
+
+    Xapian::termcount get_doclength() const;
+
+    Xapian::termcount get_unique_terms() const;
+
+    Xapian::termcount get_wdf() const;
+
+    PositionList * read_position_list();
+
+    PositionList * open_position_list() const;
+
+    PostList * next(double w_min);
+
+    PostList * skip_to(Xapian::docid did, double w_min);
+
+    bool at_end() const;
+
+    std::string get_description() const;
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_SEGMENTPOSTLIST_H
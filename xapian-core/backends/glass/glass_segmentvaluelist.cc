@@ -0,0 +1,196 @@
+/** @file glass_segmentvaluelist.cc
+ * @brief Value stream for a GlassSegmentedDatabase
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "glass_segmentvaluelist.h"
+
+#include <algorithm>
+
+#include "omassert.h"
+#include "str.h"
+
+using namespace std;
+
+GlassSegmentValueList::GlassSegmentValueList(vector<ValueList *> & valuelists_,
+					     const vector<Xapian::docid> & first_dids_,
+					     vector<GlassSegmentFilter> & filters_,
+					     bool ordered_,
+					     Xapian::valueno slot_)
+    : first_dids(first_dids_), current(0), slot(slot_), ordered(ordered_),
+      started(false)
+{
+    AssertEq(valuelists_.size(), first_dids_.size());
+    AssertEq(valuelists_.size(), filters_.size());
+    swap(valuelists, valuelists_);
+    swap(filters, filters_);
+    if (ordered) {
+	// check() can't skip dead entries, so only use it if there are none.
+	for (const auto& filter : filters) {
+	    if (!filter.empty()) {
+		ordered = false;
+		break;
+	    }
+	}
+    }
+}
+
+GlassSegmentValueList::~GlassSegmentValueList()
+{
+    vector<ValueList *>::const_iterator i;
+    for (i = valuelists.begin(); i != valuelists.end(); ++i) {
+	delete *i;
+    }
+}
+
+void
+GlassSegmentValueList::skip_dead(size_t i)
+{
+    const GlassSegmentFilter & filter = filters[i];
+    if (filter.empty()) return;
+    while (!valuelists[i]->at_end() &&
+	   filter.is_dead(valuelists[i]->get_docid())) {
+	valuelists[i]->next();
+    }
+}
+
+void
+GlassSegmentValueList::skip_exhausted()
+{
+    while (valuelists[current]->at_end()) {
+	if (++current == valuelists.size())
+	    return;
+	valuelists[current]->next();
+    }
+}
+
+void
+GlassSegmentValueList::find_lowest()
+{
+    current = valuelists.size();
+    Xapian::docid lowest = 0;
+    for (size_t i = 0; i != valuelists.size(); ++i) {
+	if (valuelists[i]->at_end()) continue;
+	Xapian::docid did = valuelists[i]->get_docid();
+	if (current == valuelists.size() || did < lowest) {
+	    current = i;
+	    lowest = did;
+	}
+    }
+}
+
+Xapian::docid
+GlassSegmentValueList::get_docid() const
+{
+    Assert(!at_end());
+    return valuelists[current]->get_docid();
+}
+
+Xapian::valueno
+GlassSegmentValueList::get_valueno() const
+{
+    return slot;
+}
+
+string
+GlassSegmentValueList::get_value() const
+{
+    Assert(!at_end());
+    return valuelists[current]->get_value();
+}
+
+bool
+GlassSegmentValueList::at_end() const
+{
+    return current == valuelists.size();
+}
+
+void
+GlassSegmentValueList::next()
+{
+    if (current == valuelists.size()) return;
+    if (ordered) {
+	valuelists[current]->next();
+	skip_exhausted();
+	return;
+    }
+
+    if (started) {
+	valuelists[current]->next();
+	skip_dead(current);
+    } else {
+	for (size_t i = 0; i != valuelists.size(); ++i) {
+	    valuelists[i]->next();
+	    skip_dead(i);
+	}
+	started = true;
+    }
+    find_lowest();
+}
+
+void
+GlassSegmentValueList::skip_to(Xapian::docid did)
+{
+    if (current == valuelists.size()) return;
+    if (ordered) {
+	// Jump straight to the segment which covers did, if it's a later one.
+	vector<Xapian::docid>::const_iterator i;
+	i = upper_bound(first_dids.begin() + current + 1, first_dids.end(), did);
+	current = (i - first_dids.begin()) - 1;
+	valuelists[current]->skip_to(did);
+	skip_exhausted();
+	return;
+    }
+
+    for (size_t i = 0; i != valuelists.size(); ++i) {
+	ValueList * vl = valuelists[i];
+	if (started && (vl->at_end() || vl->get_docid() >= did))
+	    continue;
+	vl->skip_to(did);
+	skip_dead(i);
+    }
+    started = true;
+    find_lowest();
+}
+
+bool
+GlassSegmentValueList::check(Xapian::docid did)
+{
+    if (current == valuelists.size()) return true;
+    if (!ordered) {
+	skip_to(did);
+	return true;
+    }
+    vector<Xapian::docid>::const_iterator i;
+    i = upper_bound(first_dids.begin() + current + 1, first_dids.end(), did);
+    current = (i - first_dids.begin()) - 1;
+    if (!valuelists[current]->check(did))
+	return false;
+    skip_exhausted();
+    return true;
+}
+
+string
+GlassSegmentValueList::get_description() const
+{
+    string desc = "GlassSegmentValueList(slot=";
+    desc += str(slot);
+    desc += ')';
+    return desc;
+}
@@ -0,0 +1,111 @@
+/** @file glass_segmentvaluelist.h
+ * @brief Value stream for a GlassSegmentedDatabase
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_SEGMENTVALUELIST_H
+#define XAPIAN_INCLUDED_GLASS_SEGMENTVALUELIST_H
+
+#include "backends/valuelist.h"
+#include "glass_segmentdeletions.h"
+
+#include <vector>
+
+/** Value stream for a GlassSegmentedDatabase.
+ *
+ *  This works like GlassSegmentPostList: entries for dead documents are
+ *  skipped, and the value streams are iterated in turn if the segments are
+ *  in ascending docid order, or else merged by docid.
+ */
+class GlassSegmentValueList : public ValueList {
+    /// Don't allow assignment.
+    void operator=(const GlassSegmentValueList &);
+
+    /// Don't allow copying.
+    GlassSegmentValueList(const GlassSegmentValueList &);
+
+    /// The value stream from each segment.
+    std::vector<ValueList *> valuelists;
+
+    /// The first docid covered by each segment.
+    std::vector<Xapian::docid> first_dids;
+
+    /// Which entries of each segment's value stream are dead.
+    std::vector<GlassSegmentFilter> filters;
+
+    /** Index of the value stream we're currently in.
+     *
+     *  This is valuelists.size() once we've reached the end.
+     */
+    size_t current;
+
+    /// The value slot we're iterating.
+    Xapian::valueno slot;
+
+    /// Are the segments' value streams in ascending docid order?
+    bool ordered;
+
+    /// Have we started iterating (only used when not ordered)?
+    bool started;
+
+    /// Move value stream @a i on past any dead entries.
+    void skip_dead(size_t i);
+
+    /// Move on from any segments we've reached the end of.
+    void skip_exhausted();
+
+    /// Set current to the value stream with the lowest docid.
+    void find_lowest();
+
+  public:
+    /** Construct.
+     *
+     *  @param valuelists_  The value stream from each segment.  We take
+     *			    ownership of these, and @a valuelists_ is left
+     *			    empty.
+     *  @param first_dids_  The first docid covered by each segment.
+     *  @param filters_	    Which entries of each value stream are dead.
+     *			    @a filters_ is left empty.
+     *  @param ordered_	    Are the value streams in ascending docid order?
+     *  @param slot_	    The value slot.
+     */
+    GlassSegmentValueList(std::vector<ValueList *> & valuelists_,
+			  const std::vector<Xapian::docid> & first_dids_,
+			  std::vector<GlassSegmentFilter> & filters_,
+			  bool ordered_,
+			  Xapian::valueno slot_);
+
+    ~GlassSegmentValueList();
+
+    Xapian::docid get_docid() const;
+
+    Xapian::valueno get_valueno() const;
+
+    std::string get_value() const;
+
+    bool at_end() const;
+
+    void next();
+
+    void skip_to(Xapian::docid did);
+
+    bool check(Xapian::docid did);
+
+    std::string get_description() const;
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_SEGMENTVALUELIST_H
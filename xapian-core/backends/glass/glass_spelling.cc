@@ -25,14 +25,19 @@
 
 #include "expand/expandweight.h"
 #include "glass_spelling.h"
+#include "glass_cursor.h"
 #include "omassert.h"
 #include "expand/ortermlist.h"
 #include "pack.h"
+#include "stringutils.h"
 
 #include "../prefix_compressed_strings.h"
 
+#include <xapian/unicode.h>
+
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <queue>
 #include <vector>
 #include <set>
@@ -41,58 +46,199 @@
 using namespace Glass;
 using namespace std;
 
+/// Key of the entry which records the deletion index parameters.
+#define DELETION_INDEX_KEY "D"
+
+/// Maximum number of deletions indexed for each word.
+#define DELETION_INDEX_MAX_DELETIONS 2
+
+/// Number of leading characters of each word which deletions are made from.
+#define DELETION_INDEX_PREFIX_LEN 7
+
+/// Key of the entry which records the term n-gram index parameters.
+#define TERM_NGRAM_INDEX_KEY "N"
+
+/// Length in bytes of the n-grams which terms are indexed under.
+#define TERM_NGRAM_LEN 3
+
+/** Recursively generate the variants of a word with characters deleted.
+ *
+ *  We never delete the last remaining character, so the empty string is
+ *  never generated.
+ */
+static void
+add_deletions(vector<unsigned> & chars, size_t start, unsigned deletions,
+	      set<string> & result)
+{
+    if (deletions == 0 || chars.size() <= 1) return;
+    for (size_t i = start; i < chars.size(); ++i) {
+	// Skip runs of the same character - deleting any of them gives the
+	// same result.
+	if (i > start && chars[i] == chars[i - 1]) continue;
+	unsigned ch = chars[i];
+	chars.erase(chars.begin() + i);
+	string variant;
+	for (unsigned c : chars) {
+	    Xapian::Unicode::append_utf8(variant, c);
+	}
+	result.insert(variant);
+	add_deletions(chars, i, deletions - 1, result);
+	chars.insert(chars.begin() + i, ch);
+    }
+}
+
+/** Generate the deletion index keys for a word.
+ *
+ *  These are the first @a prefix_len characters of @a word, and all the
+ *  variants of them with up to @a max_deletions characters deleted, each with
+ *  DELETION_INDEX_KEY prepended.
+ */
+static void
+get_deletion_keys(const string & word, unsigned max_deletions,
+		  unsigned prefix_len, set<string> & keys)
+{
+    vector<unsigned> chars;
+    for (Xapian::Utf8Iterator u(word); u != Xapian::Utf8Iterator(); ++u) {
+	if (chars.size() == prefix_len) break;
+	chars.push_back(*u);
+    }
+    set<string> variants;
+    string prefix;
+    for (unsigned c : chars) {
+	Xapian::Unicode::append_utf8(prefix, c);
+    }
+    variants.insert(prefix);
+    add_deletions(chars, 0, max_deletions, variants);
+    for (const string & variant : variants) {
+	keys.insert(DELETION_INDEX_KEY + variant);
+    }
+}
+
+bool
+GlassSpellingTable::has_words() const
+{
+    unique_ptr<GlassCursor> cursor(cursor_get());
+    // A lazy table which hasn't been created yet has no cursor.
+    if (!cursor.get()) return false;
+    cursor->find_entry_ge("W");
+    return !cursor->after_end() && startswith(cursor->current_key, 'W');
+}
+
+bool
+GlassSpellingTable::get_deletion_index_params(unsigned & max_deletions,
+					      unsigned & prefix_len) const
+{
+    string data;
+    if (get_exact_entry(DELETION_INDEX_KEY, data)) {
+	const char * p = data.data();
+	const char * end = p + data.size();
+	if (!unpack_uint(&p, end, &max_deletions) ||
+	    !unpack_uint_last(&p, end, &prefix_len) ||
+	    prefix_len == 0) {
+	    throw Xapian::DatabaseCorruptError("Bad spelling deletion index "
+					       "parameters");
+	}
+	return true;
+    }
+
+    // We can only start a deletion index if there aren't any words yet,
+    // except for those in the current batch of changes (which will all have
+    // been added to deletion_deltas).  The table may not be empty even then,
+    // since the term n-gram index is stored in it too.
+    if (!want_deletion_index) return false;
+    if (!deletion_deltas.empty() || !has_words()) {
+	max_deletions = DELETION_INDEX_MAX_DELETIONS;
+	prefix_len = DELETION_INDEX_PREFIX_LEN;
+	return true;
+    }
+    return false;
+}
+
 void
-GlassSpellingTable::merge_changes()
+GlassSpellingTable::merge_wordlist_changes(const string & key,
+					   const set<string> & changes)
 {
-    map<fragment, set<string> >::const_iterator i;
-    for (i = termlist_deltas.begin(); i != termlist_deltas.end(); ++i) {
-	string key = i->first;
-	const set<string> & changes = i->second;
-
-	set<string>::const_iterator d = changes.begin();
-	if (d == changes.end()) continue;
-
-	string updated;
-	string current;
-	PrefixCompressedStringWriter out(updated);
-	if (get_exact_entry(key, current)) {
-	    PrefixCompressedStringItor in(current);
-	    updated.reserve(current.size()); // FIXME plus some?
-	    while (!in.at_end() && d != changes.end()) {
-		const string & word = *in;
-		Assert(d != changes.end());
-		int cmp = word.compare(*d);
-		if (cmp < 0) {
-		    out.append(word);
-		    ++in;
-		} else if (cmp > 0) {
-		    out.append(*d);
-		    ++d;
-		} else {
-		    // If an existing entry is in the changes list, that means
-		    // we should remove it.
-		    ++in;
-		    ++d;
-		}
-	    }
-	    if (!in.at_end()) {
-		// FIXME : easy to optimise this to a fix-up and substring copy.
-		while (!in.at_end()) {
-		    out.append(*in++);
-		}
+    set<string>::const_iterator d = changes.begin();
+    if (d == changes.end()) return;
+
+    string updated;
+    string current;
+    PrefixCompressedStringWriter out(updated);
+    if (get_exact_entry(key, current)) {
+	PrefixCompressedStringItor in(current);
+	updated.reserve(current.size()); // FIXME plus some?
+	while (!in.at_end() && d != changes.end()) {
+	    const string & word = *in;
+	    Assert(d != changes.end());
+	    int cmp = word.compare(*d);
+	    if (cmp < 0) {
+		out.append(word);
+		++in;
+	    } else if (cmp > 0) {
+		out.append(*d);
+		++d;
+	    } else {
+		// If an existing entry is in the changes list, that means
+		// we should remove it.
+		++in;
+		++d;
 	    }
 	}
-	while (d != changes.end()) {
-	    out.append(*d++);
+	if (!in.at_end()) {
+	    // FIXME : easy to optimise this to a fix-up and substring copy.
+	    while (!in.at_end()) {
+		out.append(*in++);
+	    }
 	}
-	if (!updated.empty()) {
-	    add(key, updated);
-	} else {
-	    del(key);
+    }
+    while (d != changes.end()) {
+	out.append(*d++);
+    }
+    if (!updated.empty()) {
+	add(key, updated);
+    } else {
+	del(key);
+    }
+}
+
+void
+GlassSpellingTable::merge_changes()
+{
+    string params;
+    if (!deletion_deltas.empty() &&
+	!get_exact_entry(DELETION_INDEX_KEY, params)) {
+	pack_uint(params, unsigned(DELETION_INDEX_MAX_DELETIONS));
+	pack_uint_last(params, unsigned(DELETION_INDEX_PREFIX_LEN));
+	add(DELETION_INDEX_KEY, params);
+    }
+
+    if ((want_term_ngram_index || !term_ngram_deltas.empty()) &&
+	!term_ngram_index_marker) {
+	if (!get_exact_entry(TERM_NGRAM_INDEX_KEY, params)) {
+	    params.resize(0);
+	    pack_uint_last(params, unsigned(TERM_NGRAM_LEN));
+	    add(TERM_NGRAM_INDEX_KEY, params);
 	}
+	term_ngram_index_marker = true;
+    }
+
+    map<fragment, set<string> >::const_iterator i;
+    for (i = termlist_deltas.begin(); i != termlist_deltas.end(); ++i) {
+	merge_wordlist_changes(i->first, i->second);
     }
     termlist_deltas.clear();
 
+    map<string, set<string> >::const_iterator k;
+    for (k = deletion_deltas.begin(); k != deletion_deltas.end(); ++k) {
+	merge_wordlist_changes(k->first, k->second);
+    }
+    deletion_deltas.clear();
+
+    for (k = term_ngram_deltas.begin(); k != term_ngram_deltas.end(); ++k) {
+	merge_wordlist_changes(k->first, k->second);
+    }
+    term_ngram_deltas.clear();
+
     map<string, Xapian::termcount>::const_iterator j;
     for (j = wordfreq_changes.begin(); j != wordfreq_changes.end(); ++j) {
 	string key = "W" + j->first;
@@ -126,6 +272,97 @@ GlassSpellingTable::toggle_fragment(fragment frag, const string & word)
     }
 }
 
+void
+GlassSpellingTable::toggle_deletion(const string & key, const string & word)
+{
+    set<string> & changes = deletion_deltas[key];
+    pair<set<string>::iterator, bool> res = changes.insert(word);
+    if (!res.second) {
+	// word is already in the set, so remove it.
+	changes.erase(res.first);
+    }
+}
+
+void
+GlassSpellingTable::toggle_term_ngram(const string & key, const string & term)
+{
+    set<string> & changes = term_ngram_deltas[key];
+    pair<set<string>::iterator, bool> res = changes.insert(term);
+    if (!res.second) {
+	// term is already in the set, so remove it.
+	changes.erase(res.first);
+    }
+}
+
+bool
+GlassSpellingTable::has_term_ngram_index() const
+{
+    if (want_term_ngram_index || !term_ngram_deltas.empty()) return true;
+    string data;
+    return get_exact_entry(TERM_NGRAM_INDEX_KEY, data);
+}
+
+bool
+GlassSpellingTable::term_ngram_index_pending() const
+{
+    if (!want_term_ngram_index || term_ngram_index_marker) return false;
+    string data;
+    term_ngram_index_marker = get_exact_entry(TERM_NGRAM_INDEX_KEY, data);
+    return !term_ngram_index_marker;
+}
+
+void
+GlassSpellingTable::toggle_term(const string & term)
+{
+    if (term.size() < TERM_NGRAM_LEN) return;
+    set<string> done;
+    for (size_t start = 0; start <= term.size() - TERM_NGRAM_LEN; ++start) {
+	string key(TERM_NGRAM_INDEX_KEY);
+	key.append(term, start, TERM_NGRAM_LEN);
+	// Don't toggle the same n-gram twice or it will cancel out.
+	if (done.insert(key).second)
+	    toggle_term_ngram(key, term);
+    }
+}
+
+TermList *
+GlassSpellingTable::open_substring_termlist(const string & substring)
+{
+    if (substring.size() < TERM_NGRAM_LEN) return NULL;
+
+    // Merge any pending changes to disk, but don't call commit() so they
+    // won't be switched live.
+    if (!term_ngram_deltas.empty()) merge_changes();
+
+    string data;
+    if (!get_exact_entry(TERM_NGRAM_INDEX_KEY, data)) return NULL;
+
+    // Every term containing substring is in the list for each of its
+    // n-grams, so we just need to check the terms in the shortest list.
+    string shortest;
+    for (size_t start = 0;
+	 start <= substring.size() - TERM_NGRAM_LEN;
+	 ++start) {
+	string key(TERM_NGRAM_INDEX_KEY);
+	key.append(substring, start, TERM_NGRAM_LEN);
+	if (!get_exact_entry(key, data)) {
+	    // No terms contain this n-gram.
+	    shortest.resize(0);
+	    break;
+	}
+	if (start == 0 || data.size() < shortest.size())
+	    swap(shortest, data);
+    }
+
+    string encoded;
+    PrefixCompressedStringWriter out(encoded);
+    for (PrefixCompressedStringItor in(shortest); !in.at_end(); ++in) {
+	if ((*in).find(substring) != string::npos)
+	    out.append(*in);
+    }
+    return new GlassSpellingTermList(encoded);
+}
+
 void
 GlassSpellingTable::add_word(const string & word, Xapian::termcount freqinc)
 {
@@ -247,6 +484,15 @@ GlassSpellingTable::toggle_word(const string & word)
 		toggle_fragment(buf, word);
 	}
     }
+
+    unsigned max_deletions, prefix_len;
+    if (get_deletion_index_params(max_deletions, prefix_len)) {
+	set<string> keys;
+	get_deletion_keys(word, max_deletions, prefix_len, keys);
+	for (const string & key : keys) {
+	    toggle_deletion(key, word);
+	}
+    }
 }
 
 struct TermListGreaterApproxSize {
@@ -265,6 +511,32 @@ GlassSpellingTable::open_termlist(const string & word)
     // won't be switched live.
     if (!wordfreq_changes.empty()) merge_changes();
 
+    unsigned max_deletions, prefix_len;
+    if (get_deletion_index_params(max_deletions, prefix_len)) {
+	// Look up each deletion variant of word and take the union of the
+	// lists found, which gives us all the words sharing a variant.  This
+	// is much more selective than the trigram lists, so we don't need to
+	// use those at all.
+	set<string> keys;
+	get_deletion_keys(word, max_deletions, prefix_len, keys);
+	set<string> candidates;
+	string data;
+	for (const string & key : keys) {
+	    if (!get_exact_entry(key, data)) continue;
+	    for (PrefixCompressedStringItor in(data); !in.at_end(); ++in) {
+		candidates.insert(*in);
+	    }
+	}
+	if (candidates.empty()) return NULL;
+
+	string encoded;
+	PrefixCompressedStringWriter out(encoded);
+	for (const string & candidate : candidates) {
+	    out.append(candidate);
+	}
+	return new GlassSpellingTermList(encoded);
+    }
+
     // Build a priority queue of TermList objects which returns those of
     // greatest approximate size first.
     priority_queue<TermList*, vector<TermList*>, TermListGreaterApproxSize> pq;
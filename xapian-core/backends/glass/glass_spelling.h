@@ -63,6 +63,31 @@ using Glass::RootInfo;
 class GlassSpellingTable : public GlassLazyTable {
     void toggle_word(const std::string & word);
     void toggle_fragment(Glass::fragment frag, const std::string & word);
+    void toggle_deletion(const std::string & key, const std::string & word);
+    void toggle_term_ngram(const std::string & key, const std::string & term);
+
+    /** Merge changes to the list of words stored under @a key.
+     *
+     *  @param key	The key of the list.
+     *  @param changes	The words to toggle the presence of.
+     */
+    void merge_wordlist_changes(const std::string & key,
+				const std::set<std::string> & changes);
+
+    /// Are there any committed spelling words?
+    bool has_words() const;
+
+    /** Get the parameters of the deletion index, if there is one.
+     *
+     *  @param max_deletions	Set to the maximum number of deletions.
+     *  @param prefix_len	Set to the number of leading characters of each
+     *				word which deletions are generated from.
+     *
+     *  @return true if there's a deletion index (or we're about to create
+     *		one), false otherwise.
+     */
+    bool get_deletion_index_params(unsigned & max_deletions,
+				   unsigned & prefix_len) const;
 
     std::map<std::string, Xapian::termcount> wordfreq_changes;
 
@@ -76,6 +101,40 @@ class GlassSpellingTable : public GlassLazyTable {
      */
     std::map<Glass::fragment, std::set<std::string> > termlist_deltas;
 
+    /** Changes to make to the deletion index lists.
+     *
+     *  These are xor-ed with the lists on disk in the same way as
+     *  termlist_deltas, but keyed by the full key of the list.
+     */
+    std::map<std::string, std::set<std::string> > deletion_deltas;
+
+    /** Changes to make to the term n-gram index lists.
+     *
+     *  These are xor-ed with the lists on disk in the same way as
+     *  termlist_deltas, but keyed by the full key of the list.
+     */
+    std::map<std::string, std::set<std::string> > term_ngram_deltas;
+
+    /** Create a term n-gram index if there isn't one?
+     *
+     *  Set by enable_term_ngram_index().
+     */
+    bool want_term_ngram_index = false;
+
+    /** Has the term n-gram index marker been found or written?
+     *
+     *  Used to avoid looking for the marker each time is_modified() is
+     *  called.
+     */
+    mutable bool term_ngram_index_marker = false;
+
+    /** Create a deletion index if the table is empty?
+     *
+     *  The deletion index has to contain every word, so we can only start
+     *  one when there aren't any words yet.
+     */
+    bool want_deletion_index;
+
     /** Used to track an upper bound on wordfreq. */
     Xapian::termcount wordfreq_upper_bound = 0;
 
@@ -87,12 +146,17 @@ class GlassSpellingTable : public GlassLazyTable {
      *
      *  @param dbdir		The directory the glass database is stored in.
      *  @param readonly		true if we're opening read-only, else false.
+     *  @param deletion_index	true to create a deletion index if the table
+     *				is empty.
      */
-    GlassSpellingTable(const std::string & dbdir, bool readonly)
-	: GlassLazyTable("spelling", dbdir + "/spelling.", readonly) { }
+    GlassSpellingTable(const std::string & dbdir, bool readonly,
+		       bool deletion_index = false)
+	: GlassLazyTable("spelling", dbdir + "/spelling.", readonly),
+	  want_deletion_index(deletion_index) { }
 
     GlassSpellingTable(int fd, off_t offset_, bool readonly)
-	: GlassLazyTable("spelling", fd, offset_, readonly) { }
+	: GlassLazyTable("spelling", fd, offset_, readonly),
+	  want_deletion_index(false) { }
 
     /** Merge in batched-up changes.
      *
@@ -105,6 +169,36 @@ class GlassSpellingTable : public GlassLazyTable {
 
     TermList * open_termlist(const std::string & word);
 
+    /** Start a term n-gram index.
+     *
+     *  The caller must ensure there aren't any terms in the database yet, and
+     *  must call toggle_term() for every term subsequently added or removed.
+     */
+    void enable_term_ngram_index() { want_term_ngram_index = true; }
+
+    /// Is there a term n-gram index (or are we about to create one)?
+    bool has_term_ngram_index() const;
+
+    /** Do we still need to write the term n-gram index marker?
+     *
+     *  This lets a commit with no other changes create the index.
+     */
+    bool term_ngram_index_pending() const;
+
+    /** Toggle the presence of a term in the term n-gram index.
+     *
+     *  This should be called when a term is added to the database (i.e. its
+     *  termfreq becomes non-zero) and when it is removed.
+     */
+    void toggle_term(const std::string & term);
+
+    /** Open a list of the terms which contain @a substring.
+     *
+     *  @return NULL if there's no term n-gram index, or @a substring is too
+     *		short to look up in it.
+     */
+    TermList * open_substring_termlist(const std::string & substring);
+
     Xapian::doccount get_word_frequency(const std::string & word) const;
 
     void set_wordfreq_upper_bound(Xapian::termcount ub) {
@@ -119,7 +213,8 @@ class GlassSpellingTable : public GlassLazyTable {
      */
 
     bool is_modified() const {
-	return !wordfreq_changes.empty() || GlassTable::is_modified();
+	return !wordfreq_changes.empty() || !term_ngram_deltas.empty() ||
+	       term_ngram_index_pending() || GlassTable::is_modified();
     }
 
     /** Returns updated wordfreq upper bound. */
@@ -133,6 +228,10 @@ class GlassSpellingTable : public GlassLazyTable {
 	// Discard batched-up changes.
 	wordfreq_changes.clear();
 	termlist_deltas.clear();
+	deletion_deltas.clear();
+	term_ngram_deltas.clear();
+	// A marker written since the last commit is discarded too.
+	term_ngram_index_marker = false;
 
 	GlassTable::cancel(root_info, rev);
     }
@@ -166,7 +166,9 @@ GlassTable::read_block(uint4 n, byte * p) const
 	GlassTable::throw_database_closed();
     AssertRel(n,<,free_list.get_first_unused_block());
 
-    io_read_block(handle, reinterpret_cast<char *>(p), block_size, n, offset);
+    unsigned calls = io_read_block(handle, reinterpret_cast<char *>(p),
+				   block_size, n, offset);
+    counts.count_block_read(block_size, calls);
 
     if (GET_LEVEL(p) != LEVEL_FREELIST) {
 	int dir_end = DIR_END(p);
@@ -312,7 +314,10 @@ void
 GlassTable::block_to_cursor(Glass::Cursor * C_, int j, uint4 n) const
 {
     LOGCALL_VOID(DB, "GlassTable::block_to_cursor", (void*)C_ | j | n);
-    if (n == C_[j].get_n()) return;
+    if (n == C_[j].get_n()) {
+	++counts.cache_hits;
+	return;
+    }
 
     if (writable && C_[j].rewrite) {
 	Assert(C == C_);
@@ -325,6 +330,7 @@ GlassTable::block_to_cursor(Glass::Cursor * C_, int j, uint4 n) const
     const byte * p;
     if (n == C[j].get_n()) {
 	p = C_[j].clone(C[j]);
+	++counts.cache_hits;
     } else {
 	byte * q = C_[j].init(block_size);
 	read_block(n, q);
@@ -1461,6 +1467,7 @@ GlassTable::readahead_key(const string &key) const
 	last_readahead = n;
 	if (!io_readahead_block(handle, block_size, n, offset))
 	    RETURN(false);
+	++counts.readahead_hints;
     }
     RETURN(true);
 }
@@ -1519,6 +1526,7 @@ GlassTable::read_tag(Glass::Cursor * C_, string *tag, bool keep_compressed) cons
 	    if (compressed && !keep_compressed) {
 		comp_stream.decompress_start();
 		decompress = true;
+		++counts.tags_inflated;
 	    }
 	}
 	bool last = item.last_component();
@@ -38,6 +38,7 @@
 #include "stringutils.h"
 #include "wordaccess.h"
 
+#include "backends/tablecounts.h"
 #include "common/compression_stream.h"
 
 #include <algorithm>
@@ -694,6 +695,12 @@ class GlassTable {
 	 */
 	bool is_modified() const { return Btree_modified; }
 
+	/// Return the counts of the work this table has done.
+	const TableCounts & get_counts() const { return counts; }
+
+	/// Return the name of the table.
+	const char * get_tablename() const { return tablename; }
+
 	/** Set the maximum item size given the block capacity.
 	 *
 	 *  At least this many items of maximum size must fit into a block.
@@ -720,6 +727,15 @@ class GlassTable {
 	    changes_obj = changes;
 	}
 
+	/** Set the revisions pinned by readers in this process.
+	 *
+	 *  Blocks which these revisions may be using won't be reused.  The
+	 *  object is not owned by the table.
+	 */
+	void set_revision_pins(const GlassRevisionPins * pins) {
+	    free_list.set_revision_pins(pins);
+	}
+
 	/// Throw an exception indicating that the database is closed.
 	XAPIAN_NORETURN(static void throw_database_closed());
 
@@ -896,6 +912,9 @@ class GlassTable {
 	/// Last block readahead_key() preread.
 	mutable uint4 last_readahead;
 
+	/// Counts of the work this table has done.
+	mutable TableCounts counts;
+
 	/// offset to start of table in file.
 	off_t offset;
 
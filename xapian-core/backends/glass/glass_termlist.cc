@@ -96,7 +96,13 @@ GlassTermList::accumulate_stats(Xapian::Internal::ExpandStats & stats) const
 {
     LOGCALL_VOID(DB, "GlassTermList::accumulate_stats", stats);
     Assert(!at_end());
-    stats.accumulate(current_wdf, doclen, get_termfreq(), db->get_doccount());
+    Xapian::doccount doccount;
+    if (stats_db.get()) {
+	doccount = stats_db->get_doccount();
+    } else {
+	doccount = db->get_doccount();
+    }
+    stats.accumulate(current_wdf, doclen, get_termfreq(), doccount);
 }
 
 string
@@ -117,8 +123,13 @@ Xapian::doccount
 GlassTermList::get_termfreq() const
 {
     LOGCALL(DB, Xapian::doccount, "GlassTermList::get_termfreq", NO_ARGS);
-    if (current_termfreq == 0)
-	db->get_freqs(current_term, &current_termfreq, NULL);
+    if (current_termfreq == 0) {
+	if (stats_db.get()) {
+	    stats_db->get_freqs(current_term, &current_termfreq, NULL);
+	} else {
+	    db->get_freqs(current_term, &current_termfreq, NULL);
+	}
+    }
     RETURN(current_termfreq);
 }
 
@@ -82,6 +82,14 @@ class GlassTermList : public TermList {
      */
     mutable Xapian::doccount current_termfreq;
 
+    /** The database to get term frequencies and the document count from.
+     *
+     *  This is NULL to use @a db, but is set when @a db is a segment of a
+     *  GlassSegmentedDatabase, since the statistics need to be for the whole
+     *  database.
+     */
+    Xapian::Internal::intrusive_ptr<const Xapian::Database::Internal> stats_db;
+
   public:
     /// Create a new GlassTermList object for document @a did_ in DB @a db_
     GlassTermList(Xapian::Internal::intrusive_ptr<const GlassDatabase> db_,
@@ -93,6 +101,11 @@ class GlassTermList : public TermList {
      */
     Xapian::termcount get_doclength() const;
 
+    /// Get term frequencies and the document count from @a stats_db_.
+    void set_stats_database(const Xapian::Database::Internal * stats_db_) {
+	stats_db = stats_db_;
+    }
+
     /** Return approximate size of this termlist.
      *
      *  For a GlassTermList, this value will always be exact.
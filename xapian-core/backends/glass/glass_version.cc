@@ -322,7 +322,8 @@ GlassVersion::write(glass_revision_number_t new_rev, int flags)
 
 bool
 GlassVersion::sync(const string & tmpfile,
-		   glass_revision_number_t new_rev, int flags)
+		   glass_revision_number_t new_rev, int flags,
+		   const string & real_file)
 {
     Assert(new_rev > rev || rev == 0);
 
@@ -358,7 +359,8 @@ GlassVersion::sync(const string & tmpfile,
 	}
 
 	if (!tmpfile.empty()) {
-	    if (!io_tmp_rename(tmpfile, db_dir + "/iamglass")) {
+	    if (!io_tmp_rename(tmpfile, real_file.empty() ?
+					db_dir + "/iamglass" : real_file)) {
 		return false;
 	    }
 	}
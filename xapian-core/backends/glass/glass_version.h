@@ -182,8 +182,14 @@ class GlassVersion {
 
     const std::string write(glass_revision_number_t new_rev, int flags);
 
+    /** Sync the version file written by write() and make it live.
+     *
+     *  @param real_file  If non-empty, rename the new version file to this
+     *			  instead of to "iamglass".
+     */
     bool sync(const std::string & tmpfile,
-	      glass_revision_number_t new_rev, int flags);
+	      glass_revision_number_t new_rev, int flags,
+	      const std::string & real_file = std::string());
 
     glass_revision_number_t get_revision() const { return rev; }
 
@@ -208,6 +214,9 @@ class GlassVersion {
 	return std::string(buf, 36);
     }
 
+    /// Give the database a new UUID.
+    void new_uuid() { uuid_generate(uuid); }
+
 #if 0 // Unused currently.
     /// Set the UUID from 16 byte binary value @a data.
     void set_uuid(const void * data) {
@@ -27,6 +27,7 @@
 
 #include "debuglog.h"
 
+#include "backends/document.h"
 #include "expand/expandweight.h"
 #include "inmemory_document.h"
 #include "inmemory_alltermslist.h"
@@ -46,17 +47,71 @@ using Xapian::Internal::intrusive_ptr;
 inline void
 InMemoryTerm::add_posting(const InMemoryPosting & post)
 {
+    // Documents are usually added in ascending docid order, so check for
+    // appending first.
+    if (docs.empty() || docs.back().did < post.did) {
+	docs.push_back(post);
+	return;
+    }
+
     // Add document to right place in list
     vector<InMemoryPosting>::iterator p;
     p = lower_bound(docs.begin(), docs.end(),
 		    post, InMemoryPostingLessThan());
     if (p == docs.end() || InMemoryPostingLessThan()(post, *p)) {
 	docs.insert(p, post);
-    } else if (!p->valid) {
-	*p = post;
     } else {
-	(*p).merge(post);
+	// We only add each term/doc pair once, after removing any previous
+	// posting for it.
+	Assert(!p->valid);
+	*p = post;
+    }
+}
+
+const InMemoryPosting *
+InMemoryTerm::find_posting(Xapian::docid did) const
+{
+    InMemoryPosting key;
+    key.did = did;
+    vector<InMemoryPosting>::const_iterator p;
+    p = lower_bound(docs.begin(), docs.end(), key, InMemoryPostingLessThan());
+    if (p == docs.end() || p->did != did) return NULL;
+    return &*p;
+}
+
+void
+InMemoryTerm::remove_posting(Xapian::docid did)
+{
+    InMemoryPosting * p = const_cast<InMemoryPosting *>(find_posting(did));
+    if (!p || !p->valid) return;
+    // Just invalidate the posting - otherwise we need to erase in a vector
+    // (inefficient) and we break any posting lists iterating over this
+    // posting list.
+    p->valid = false;
+    unused_positions += p->positions_size;
+    if (unused_positions > positions.size() / 2) compact_positions();
+}
+
+void
+InMemoryTerm::compact_positions()
+{
+    vector<Xapian::termpos> new_positions;
+    new_positions.reserve(positions.size() - unused_positions);
+    vector<InMemoryPosting>::iterator p;
+    for (p = docs.begin(); p != docs.end(); ++p) {
+	if (!p->valid) {
+	    p->positions_start = 0;
+	    p->positions_size = 0;
+	    continue;
+	}
+	vector<Xapian::termpos>::const_iterator start;
+	start = positions.begin() + p->positions_start;
+	p->positions_start = new_positions.size();
+	new_positions.insert(new_positions.end(),
+			     start, start + p->positions_size);
     }
+    swap(positions, new_positions);
+    unused_positions = 0;
 }
 
 inline void
@@ -66,11 +121,8 @@ InMemoryDoc::add_posting(const InMemoryTermEntry & post)
     vector<InMemoryTermEntry>::iterator p;
     p = lower_bound(terms.begin(), terms.end(),
 		    post, InMemoryTermEntryLessThan());
-    if (p == terms.end() || InMemoryTermEntryLessThan()(post, *p)) {
-	terms.insert(p, post);
-    } else {
-	(*p).merge(post);
-    }
+    Assert(p == terms.end() || InMemoryTermEntryLessThan()(post, *p));
+    terms.insert(p, post);
 }
 
 //////////////
@@ -83,6 +135,7 @@ InMemoryPostList::InMemoryPostList(intrusive_ptr<const InMemoryDatabase> db_,
 	: LeafPostList(term_),
 	  pos(imterm.docs.begin()),
 	  end(imterm.docs.end()),
+	  positions(&imterm.positions),
 	  termfreq(imterm.term_freq),
 	  started(false),
 	  db(db_)
@@ -120,20 +173,28 @@ InMemoryPostList::next(double /*w_min*/)
 }
 
 PostList *
-InMemoryPostList::skip_to(Xapian::docid did, double w_min)
+InMemoryPostList::skip_to(Xapian::docid did, double /*w_min*/)
 {
     if (db->is_closed()) InMemoryDatabase::throw_database_closed();
-    // FIXME - see if we can make more efficient, perhaps using better
-    // data structure.  Note, though, that a binary search of
-    // the remaining list may NOT be a good idea (search time is then
-    // O(log {length of list}), as opposed to O(distance we want to skip)
-    // Since we will frequently only be skipping a short distance, this
-    // could well be worse.
     started = true;
     Assert(!at_end());
-    while (!at_end() && (*pos).did < did) {
-	(void) next(w_min);
+    if (pos->did >= did) return NULL;
+
+    // A binary search of the whole of the rest of the list would cost
+    // O(log {length of list}) even when we're only skipping a short distance
+    // (which is common), so gallop forwards to find a range containing the
+    // target and then binary search just that.
+    vector<InMemoryPosting>::difference_type step = 1;
+    while (end - pos > step && pos[step].did < did) {
+	pos += step;
+	step *= 2;
     }
+    vector<InMemoryPosting>::const_iterator range_end = end;
+    if (end - pos > step) range_end = pos + step + 1;
+    InMemoryPosting key;
+    key.did = did;
+    pos = lower_bound(pos, range_end, key, InMemoryPostingLessThan());
+    while (pos != end && !pos->valid) ++pos;
     return NULL;
 }
 
@@ -167,7 +228,8 @@ PositionList *
 InMemoryPostList::read_position_list()
 {
     if (db->is_closed()) InMemoryDatabase::throw_database_closed();
-    mypositions.set_data(pos->positions);
+    const Xapian::termpos * p = positions->data() + pos->positions_start;
+    mypositions.set_data(p, p + pos->positions_size);
     return &mypositions;
 }
 
@@ -175,7 +237,8 @@ PositionList *
 InMemoryPostList::open_position_list() const
 {
     if (db->is_closed()) InMemoryDatabase::throw_database_closed();
-    return new InMemoryPositionList(pos->positions);
+    const Xapian::termpos * p = positions->data() + pos->positions_start;
+    return new InMemoryPositionList(p, p + pos->positions_size);
 }
 
 Xapian::termcount
@@ -267,8 +330,10 @@ InMemoryTermList::skip_to(const string & term)
     if (rare(db->is_closed()))
 	InMemoryDatabase::throw_database_closed();
 
-    while (pos != end && pos->tname < term) {
-	++pos;
+    if (pos != end && pos->tname < term) {
+	InMemoryTermEntry key;
+	key.tname = term;
+	pos = lower_bound(pos, end, key, InMemoryTermEntryLessThan());
     }
 
     started = true;
@@ -287,7 +352,7 @@ Xapian::termcount
 InMemoryTermList::positionlist_count() const
 {
     if (db->is_closed()) InMemoryDatabase::throw_database_closed();
-    return db->positionlist_count(did, (*pos).tname);
+    return (*pos).positions_size;
 }
 
 Xapian::PositionIterator
@@ -621,15 +686,11 @@ InMemoryDatabase::positionlist_count(Xapian::docid did,
     if (!doc_exists(did)) {
 	return 0;
     }
-    const InMemoryDoc &doc = termlists[did-1];
-
-    vector<InMemoryTermEntry>::const_iterator i;
-    for (i = doc.terms.begin(); i != doc.terms.end(); ++i) {
-	if (i->tname == tname) {
-	    return i->positions.size();
-	}
-    }
-    return 0;
+    map<string, InMemoryTerm>::const_iterator t = postlists.find(tname);
+    if (t == postlists.end()) return 0;
+    const InMemoryPosting * posting = t->second.find_posting(did);
+    if (!posting || !posting->valid) return 0;
+    return posting->positions_size;
 }
 
 PositionList * 
@@ -638,12 +699,13 @@ InMemoryDatabase::open_position_list(Xapian::docid did,
 {
     if (closed) InMemoryDatabase::throw_database_closed();
     if (usual(doc_exists(did))) {
-	const InMemoryDoc &doc = termlists[did-1];
-
-	vector<InMemoryTermEntry>::const_iterator i;
-	for (i = doc.terms.begin(); i != doc.terms.end(); ++i) {
-	    if (i->tname == tname) {
-		return new InMemoryPositionList(i->positions);
+	map<string, InMemoryTerm>::const_iterator t = postlists.find(tname);
+	if (t != postlists.end()) {
+	    const InMemoryPosting * posting = t->second.find_posting(did);
+	    if (posting && posting->valid) {
+		const Xapian::termpos * p = t->second.positions.data();
+		p += posting->positions_start;
+		return new InMemoryPositionList(p, p + posting->positions_size);
 	    }
 	}
     }
@@ -724,23 +786,7 @@ InMemoryDatabase::delete_document(Xapian::docid did)
     // InMemory structure without being very inefficient.
     if (totdocs == 0) positions_present = false;
 
-    vector<InMemoryTermEntry>::const_iterator i;
-    for (i = termlists[did - 1].terms.begin();
-	 i != termlists[did - 1].terms.end();
-	 ++i) {
-	map<string, InMemoryTerm>::iterator t = postlists.find(i->tname);
-	Assert(t != postlists.end());
-	t->second.collection_freq -= i->wdf;
-	--t->second.term_freq;
-	vector<InMemoryPosting>::iterator posting = t->second.docs.begin();
-	while (posting != t->second.docs.end()) {
-	    // Just zero out erased doc ids - otherwise we need to erase
-	    // in a vector (inefficient) and we break any posting lists
-	    // iterating over this posting list.
-	    if (posting->did == did) posting->valid = false;
-	    ++posting;
-	}
-    }
+    remove_postings(did);
     termlists[did-1].terms.clear();
 }
 
@@ -752,6 +798,11 @@ InMemoryDatabase::replace_document(Xapian::docid did,
 
     if (closed) InMemoryDatabase::throw_database_closed();
 
+    // The document may have been read from this database and be waiting to
+    // read its terms lazily from the postings we're about to remove, so make
+    // sure it has them first.  We'd need them loaded to index it anyway.
+    document.internal->need_terms();
+
     if (doc_exists(did)) { 
 	map<Xapian::valueno, string>::const_iterator j;
 	for (j = valuelists[did-1].begin(); j != valuelists[did-1].end(); ++j) {
@@ -775,23 +826,7 @@ InMemoryDatabase::replace_document(Xapian::docid did,
 	termlists[did - 1].is_valid = true;
     }
 
-    vector<InMemoryTermEntry>::const_iterator i;
-    for (i = termlists[did - 1].terms.begin();
-	 i != termlists[did - 1].terms.end();
-	 ++i) {
-	map<string, InMemoryTerm>::iterator t = postlists.find(i->tname);
-	Assert(t != postlists.end());
-	t->second.collection_freq -= i->wdf;
-	--t->second.term_freq;
-	vector<InMemoryPosting>::iterator posting = t->second.docs.begin();
-	while (posting != t->second.docs.end()) {
-	    // Just invalidate erased doc ids - otherwise we need to erase
-	    // in a vector (inefficient) and we break any posting lists
-	    // iterating over this posting list.
-	    if (posting->did == did) posting->valid = false;
-	    ++posting;
-	}
-    }
+    remove_postings(did);
 
     doclengths[did - 1] = 0;
     doclists[did - 1] = document.get_data();
@@ -827,27 +862,47 @@ InMemoryDatabase::finish_add_doc(Xapian::docid did, const Xapian::Document &docu
     }
 
     InMemoryDoc doc(true);
+    doc.terms.reserve(document.termlist_count());
     Xapian::TermIterator i = document.termlist_begin();
     for ( ; i != document.termlist_end(); ++i) {
-	make_term(*i);
-
-	LOGLINE(DB, "InMemoryDatabase::finish_add_doc(): adding term " << *i);
+	InMemoryTermEntry termentry;
+	termentry.tname = *i;
+	termentry.wdf = i.get_wdf();
+
+	LOGLINE(DB, "InMemoryDatabase::finish_add_doc(): adding term " <<
+		    termentry.tname);
+	InMemoryTerm & term = postlists[termentry.tname];
+
+	// Make the posting, appending its positions to those for the term.
+	InMemoryPosting posting;
+	posting.did = did;
+	posting.wdf = termentry.wdf;
+	posting.valid = true;
+	posting.positions_start = term.positions.size();
 	Xapian::PositionIterator j = i.positionlist_begin();
-	if (j == i.positionlist_end()) {
-	    /* Make sure the posting exists, even without a position. */
-	    make_posting(&doc, *i, did, 0, i.get_wdf(), false);
-	} else {
-	    positions_present = true;
-	    for ( ; j != i.positionlist_end(); ++j) {
-		make_posting(&doc, *i, did, *j, i.get_wdf());
-	    }
+	for ( ; j != i.positionlist_end(); ++j) {
+	    term.positions.push_back(*j);
 	}
+	posting.positions_size = term.positions.size() - posting.positions_start;
+	termentry.positions_size = posting.positions_size;
+	if (posting.positions_size) positions_present = true;
+	term.add_posting(posting);
+
+	term.collection_freq += termentry.wdf;
+	++term.term_freq;
 
 	Assert(did > 0 && did <= doclengths.size());
-	doclengths[did - 1] += i.get_wdf();
-	totlen += i.get_wdf();
-	postlists[*i].collection_freq += i.get_wdf();
-	++postlists[*i].term_freq;
+	doclengths[did - 1] += termentry.wdf;
+	totlen += termentry.wdf;
+
+	// The document's terms are returned in sorted order, so we can just
+	// append the termentry.
+	if (usual(doc.terms.empty() ||
+		  InMemoryTermEntryLessThan()(doc.terms.back(), termentry))) {
+	    doc.terms.push_back(termentry);
+	} else {
+	    doc.add_posting(termentry);
+	}
     }
     swap(termlists[did - 1], doc);
 
@@ -855,9 +910,18 @@ InMemoryDatabase::finish_add_doc(Xapian::docid did, const Xapian::Document &docu
 }
 
 void
-InMemoryDatabase::make_term(const string & tname)
+InMemoryDatabase::remove_postings(Xapian::docid did)
 {
-    postlists[tname];  // Initialise, if not already there.
+    vector<InMemoryTermEntry>::const_iterator i;
+    for (i = termlists[did - 1].terms.begin();
+	 i != termlists[did - 1].terms.end();
+	 ++i) {
+	map<string, InMemoryTerm>::iterator t = postlists.find(i->tname);
+	Assert(t != postlists.end());
+	t->second.collection_freq -= i->wdf;
+	--t->second.term_freq;
+	t->second.remove_posting(did);
+    }
 }
 
 Xapian::docid
@@ -872,43 +936,6 @@ InMemoryDatabase::make_doc(const string & docdata)
     return termlists.size();
 }
 
-void InMemoryDatabase::make_posting(InMemoryDoc * doc,
-				    const string & tname,
-				    Xapian::docid did,
-				    Xapian::termpos position,
-				    Xapian::termcount wdf,
-				    bool use_position)
-{
-    Assert(doc);
-    Assert(postlists.find(tname) != postlists.end());
-    Assert(did > 0 && did <= termlists.size());
-    Assert(did > 0 && did <= doclengths.size());
-    Assert(doc_exists(did));
-
-    // Make the posting
-    InMemoryPosting posting;
-    posting.did = did;
-    if (use_position) {
-	posting.positions.push_back(position);
-    }
-    posting.wdf = wdf;
-    posting.valid = true;
-
-    // Now record the posting
-    postlists[tname].add_posting(posting);
-
-    // Make the termentry
-    InMemoryTermEntry termentry;
-    termentry.tname = tname;
-    if (use_position) {
-	termentry.positions.push_back(position);
-    }
-    termentry.wdf = wdf;
-
-    // Now record the termentry
-    doc->add_posting(termentry);
-}
-
 bool
 InMemoryDatabase::term_exists(const string & tname) const
 {
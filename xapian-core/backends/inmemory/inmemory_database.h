@@ -46,38 +46,27 @@ using namespace std;
 class InMemoryPosting {
     public:
 	Xapian::docid did;
-	bool valid;
-	vector<Xapian::termpos> positions; // Sorted vector of positions
 	Xapian::termcount wdf;
+	bool valid;
 
-	// Merge two postings (same term/doc pair, new positional info)
-	void merge(const InMemoryPosting & post) {
-	    Assert(did == post.did);
+	/** Offset of this posting's positions in InMemoryTerm::positions.
+	 *
+	 *  The positions are stored there in ascending order, so a posting
+	 *  doesn't need a heap allocation of its own for them.
+	 */
+	size_t positions_start;
 
-	    positions.insert(positions.end(),
-			     post.positions.begin(),
-			     post.positions.end());
-	    // FIXME - inefficient - use merge (and list<>)?
-	    sort(positions.begin(), positions.end());
-	}
+	/// Number of positions this posting has.
+	Xapian::termcount positions_size;
 };
 
 class InMemoryTermEntry {
     public:
 	string tname;
-	vector<Xapian::termpos> positions; // Sorted vector of positions
 	Xapian::termcount wdf;
 
-	// Merge two postings (same term/doc pair, new positional info)
-	void merge(const InMemoryTermEntry & post) {
-	    Assert(tname == post.tname);
-
-	    positions.insert(positions.end(),
-			     post.positions.begin(),
-			     post.positions.end());
-	    // FIXME - inefficient - use merge (and list<>)?
-	    sort(positions.begin(), positions.end());
-	}
+	/// Number of positions (which are stored in the InMemoryPosting).
+	Xapian::termcount positions_size;
 };
 
 // Compare by document ID
@@ -104,12 +93,38 @@ class InMemoryTerm {
 	// Sorted list of documents indexing this term.
 	vector<InMemoryPosting> docs;
 
+	/** Positional data for all the postings in docs.
+	 *
+	 *  Each posting refers to a contiguous range of this vector.  Ranges
+	 *  belonging to invalidated postings are left in place until they make
+	 *  up more than half the vector, at which point compact_positions() is
+	 *  called.
+	 */
+	vector<Xapian::termpos> positions;
+
+	/// Number of entries in positions not used by valid postings.
+	size_t unused_positions;
+
 	Xapian::termcount term_freq;
 	Xapian::termcount collection_freq;
 
-	InMemoryTerm() : term_freq(0), collection_freq(0) {}
+	InMemoryTerm()
+	    : unused_positions(0), term_freq(0), collection_freq(0) {}
 
 	void add_posting(const InMemoryPosting & post);
+
+	/** Find the posting for document @a did.
+	 *
+	 *  Returns NULL if there isn't one (an invalidated entry may still be
+	 *  returned, so the caller needs to check InMemoryPosting::valid).
+	 */
+	const InMemoryPosting * find_posting(Xapian::docid did) const;
+
+	/// Invalidate the posting for document @a did.
+	void remove_posting(Xapian::docid did);
+
+	/// Discard the positional data of invalidated postings.
+	void compact_positions();
 };
 
 /// Class representing a document and the terms indexing it.
@@ -138,6 +153,10 @@ class InMemoryPostList : public LeafPostList {
     private:
 	vector<InMemoryPosting>::const_iterator pos;
 	vector<InMemoryPosting>::const_iterator end;
+
+	/// The term's positional data.
+	const vector<Xapian::termpos> * positions;
+
 	Xapian::doccount termfreq;
 	bool started;
 
@@ -237,7 +256,9 @@ class InMemoryDocument;
 
 /** A database held entirely in memory.
  *
- *  This is a prototype database, mainly used for debugging and testing.
+ *  Postings are kept in a vector per term, sorted by docid, so postlists can
+ *  be iterated and skipped through cheaply, and the terms are kept in a sorted
+ *  map.  Updates are applied immediately, so there are no transactions.
  */
 class InMemoryDatabase : public Xapian::Database::Internal {
     friend class InMemoryAllDocsPostList;
@@ -266,8 +287,6 @@ class InMemoryDatabase : public Xapian::Database::Internal {
     InMemoryDatabase& operator=(const InMemoryDatabase &);
     InMemoryDatabase(const InMemoryDatabase &);
 
-    void make_term(const string & tname);
-
     bool doc_exists(Xapian::docid did) const;
     Xapian::docid make_doc(const string & docdata);
 
@@ -275,12 +294,8 @@ class InMemoryDatabase : public Xapian::Database::Internal {
     void finish_add_doc(Xapian::docid did, const Xapian::Document &document);
     void add_values(Xapian::docid did, const map<Xapian::valueno, string> &values_);
 
-    void make_posting(InMemoryDoc * doc,
-		      const string & tname,
-		      Xapian::docid did,
-		      Xapian::termpos position,
-		      Xapian::termcount wdf,
-		      bool use_position = true);
+    /// Remove the postings for document @a did from the postlists.
+    void remove_postings(Xapian::docid did);
 
     //@{
     /** Implementation of virtual methods: see Database for details.
@@ -26,12 +26,21 @@
 #include "debuglog.h"
 #include "omassert.h"
 
+#include <algorithm>
+
 InMemoryPositionList::InMemoryPositionList(const OmDocumentTerm::term_positions & positions_)
     : positions(positions_), mypos(positions.begin()),
       iterating_in_progress(false) 
 {
 }
 
+InMemoryPositionList::InMemoryPositionList(const Xapian::termpos * begin,
+					   const Xapian::termpos * end)
+    : positions(begin, end), mypos(positions.begin()),
+      iterating_in_progress(false)
+{
+}
+
 void
 InMemoryPositionList::set_data(const OmDocumentTerm::term_positions & positions_)
 {
@@ -40,6 +49,15 @@ InMemoryPositionList::set_data(const OmDocumentTerm::term_positions & positions_
     iterating_in_progress = false;
 }
 
+void
+InMemoryPositionList::set_data(const Xapian::termpos * begin,
+			       const Xapian::termpos * end)
+{
+    positions.assign(begin, end);
+    mypos = positions.begin();
+    iterating_in_progress = false;
+}
+
 Xapian::termcount
 InMemoryPositionList::get_size() const
 {
@@ -69,7 +87,10 @@ void
 InMemoryPositionList::skip_to(Xapian::termpos termpos)
 {
     if (!iterating_in_progress) iterating_in_progress = true;
-    while (!at_end() && *mypos < termpos) ++mypos;
+    if (!at_end() && *mypos < termpos) {
+	vector<Xapian::termpos>::const_iterator end = positions.end();
+	mypos = lower_bound(mypos, end, termpos);
+    }
 }
 
 bool
@@ -62,9 +62,17 @@ class InMemoryPositionList : public PositionList
 	/// Construct, fill list with data, and move the position to the start.
 	InMemoryPositionList(const OmDocumentTerm::term_positions & positions_);
 
+	/// Construct from a range of positions, and move to the start.
+	InMemoryPositionList(const Xapian::termpos * begin,
+			     const Xapian::termpos * end);
+
 	/// Fill list with data, and move the position to the start.
 	void set_data(const OmDocumentTerm::term_positions & positions_);
 
+	/// Fill list from a range of positions, and move to the start.
+	void set_data(const Xapian::termpos * begin,
+		      const Xapian::termpos * end);
+
 	/// Gets size of position list.
 	Xapian::termcount get_size() const;
 
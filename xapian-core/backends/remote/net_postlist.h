@@ -49,8 +49,8 @@ class NetworkPostList : public LeafPostList {
 
     Xapian::doccount termfreq;
 
-    /// Append a posting to the end of the postlist.
-    void append_posting(const string & serialised) {
+    /// Append a batch of postings to the end of the postlist.
+    void append_postings(const string & serialised) {
 	Assert(pos == NULL);
 	Assert(!started);
 	postings.append(serialised);
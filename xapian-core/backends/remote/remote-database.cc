@@ -75,6 +75,9 @@ RemoteDatabase::RemoteDatabase(int fd, double timeout_,
 	  cached_stats_valid(),
 	  mru_valstats(),
 	  mru_slot(Xapian::BAD_VALUENO),
+	  pipelined(writable && (flags & Xapian::DB_PIPELINE_WRITES)),
+	  pipeline_pending(false),
+	  pipeline_lastdocid(0),
 	  timeout(timeout_)
 {
 #ifndef __WIN32__
@@ -96,9 +99,17 @@ RemoteDatabase::RemoteDatabase(int fd, double timeout_,
 
     update_stats(MSG_MAX);
 
+    // The server supports compressed messages (since it supports our protocol
+    // version), so ask it to compress large replies, and compress large
+    // messages we send.  There's no reply to this, so it doesn't cost a
+    // round-trip.
+    send_message(MSG_COMPRESS, encode_length(DEFAULT_COMPRESS_MIN));
+    link.set_compress_min(DEFAULT_COMPRESS_MIN);
+
     if (writable) {
-	if (flags & Xapian::DB_RETRY_LOCK) {
-	    const string & body = encode_length(flags & Xapian::DB_RETRY_LOCK);
+	flags &= Xapian::DB_RETRY_LOCK | Xapian::DB_PIPELINE_WRITES;
+	if (flags) {
+	    const string & body = encode_length(flags);
 	    update_stats(MSG_WRITEACCESS, body);
 	} else {
 	    update_stats(MSG_WRITEACCESS);
@@ -174,15 +185,23 @@ RemoteDatabase::open_term_list(Xapian::docid did) const
     string term;
     char type;
     while ((type = get_message(message)) == REPLY_TERMLIST) {
-	NetworkTermListItem item;
+	// Each message holds a batch of items.
 	p = message.data();
 	p_end = p + message.size();
-	decode_length(&p, p_end, item.wdf);
-	decode_length(&p, p_end, item.termfreq);
-	term.resize(size_t((unsigned char)*p++));
-	term.append(p, p_end);
-	item.tname = term;
-	items.push_back(item);
+	while (p != p_end) {
+	    NetworkTermListItem item;
+	    decode_length(&p, p_end, item.wdf);
+	    decode_length(&p, p_end, item.termfreq);
+	    if (p == p_end)
+		throw_bad_message(context);
+	    term.resize(size_t((unsigned char)*p++));
+	    size_t len;
+	    decode_length_and_check(&p, p_end, len);
+	    term.append(p, len);
+	    p += len;
+	    item.tname = term;
+	    items.push_back(item);
+	}
     }
     if (type != REPLY_DONE)
 	throw_bad_message(context);
@@ -208,14 +227,22 @@ RemoteDatabase::open_allterms(const string & prefix) const {
     string message;
     char type;
     while ((type = get_message(message)) == REPLY_ALLTERMS) {
-	NetworkTermListItem item;
+	// Each message holds a batch of items.
 	const char * p = message.data();
 	const char * p_end = p + message.size();
-	decode_length(&p, p_end, item.termfreq);
-	term.resize(size_t((unsigned char)*p++));
-	term.append(p, p_end);
-	item.tname = term;
-	items.push_back(item);
+	while (p != p_end) {
+	    NetworkTermListItem item;
+	    decode_length(&p, p_end, item.termfreq);
+	    if (p == p_end)
+		throw_bad_message(context);
+	    term.resize(size_t((unsigned char)*p++));
+	    size_t len;
+	    decode_length_and_check(&p, p_end, len);
+	    term.append(p, len);
+	    p += len;
+	    item.tname = term;
+	    items.push_back(item);
+	}
     }
     if (type != REPLY_DONE)
 	throw_bad_message(context);
@@ -244,8 +271,10 @@ RemoteDatabase::read_post_list(const string &term, NetworkPostList & pl) const
     Xapian::doccount termfreq;
     decode_length(&p, p_end, termfreq);
 
+    // Each message holds a batch of postings, which we just append to the
+    // encoded postlist - NetworkPostList decodes them as it is iterated.
     while ((type = get_message(message)) == REPLY_POSTLISTITEM) {
-	pl.append_posting(message);
+	pl.append_postings(message);
     }
     if (type != REPLY_DONE)
 	throw_bad_message(context);
@@ -264,12 +293,15 @@ RemoteDatabase::open_position_list(Xapian::docid did, const string &term) const
     char type;
     Xapian::termpos lastpos = static_cast<Xapian::termpos>(-1);
     while ((type = get_message(message)) == REPLY_POSITIONLIST) {
+	// Each message holds a batch of positions.
 	const char * p = message.data();
 	const char * p_end = p + message.size();
-	Xapian::termpos inc;
-	decode_length(&p, p_end, inc);
-	lastpos += inc + 1;
-	positions.push_back(lastpos);
+	while (p != p_end) {
+	    Xapian::termpos inc;
+	    decode_length(&p, p_end, inc);
+	    lastpos += inc + 1;
+	    positions.push_back(lastpos);
+	}
     }
     if (type != REPLY_DONE)
 	throw_bad_message(context);
@@ -584,9 +616,41 @@ RemoteDatabase::get_message(string &result, reply_type required_type) const
     return type;
 }
 
+void
+RemoteDatabase::check_pipeline() const
+{
+    pipeline_pending = false;
+    // The server replies to MSG_KEEPALIVE with the first error from the
+    // pipelined changes since we last checked, if there was one.
+    send_message(MSG_KEEPALIVE, string());
+    string message;
+    try {
+	get_message(message, REPLY_DONE);
+    } catch (...) {
+	// The changes after the failing one were discarded, so we'll need to
+	// ask the server for the last docid.
+	pipeline_lastdocid = 0;
+	throw;
+    }
+}
+
 void
 RemoteDatabase::send_message(message_type type, const string &message) const
 {
+    if (pipeline_pending) {
+	switch (type) {
+	    case MSG_REPLACEDOCUMENT:
+	    case MSG_REPLACEDOCUMENTTERM:
+	    case MSG_DELETEDOCUMENT:
+	    case MSG_DELETEDOCUMENTTERM:
+		// These don't get a reply in pipelined mode.
+		break;
+	    default:
+		// Anything else may wait for a reply, so first find out if
+		// any of the pipelined changes failed.
+		check_pipeline();
+	}
+    }
     double end_time = RealTime::end_time(timeout);
     link.send_message(static_cast<unsigned char>(type), message, end_time);
 }
@@ -729,6 +793,7 @@ RemoteDatabase::cancel()
 {
     cached_stats_valid = false;
     mru_slot = Xapian::BAD_VALUENO;
+    pipeline_lastdocid = 0;
 
     send_message(MSG_CANCEL, string());
 }
@@ -739,6 +804,27 @@ RemoteDatabase::add_document(const Xapian::Document & doc)
     cached_stats_valid = false;
     mru_slot = Xapian::BAD_VALUENO;
 
+    if (pipelined) {
+	// Pick the docid ourselves so we don't need to wait for a reply, and
+	// send the document to the server to be stored under that docid.
+	if (pipeline_lastdocid == 0) {
+	    update_stats();
+	    pipeline_lastdocid = lastdocid;
+	    // The stats won't include the document we're adding.
+	    cached_stats_valid = false;
+	}
+	Xapian::docid did = pipeline_lastdocid + 1;
+	if (rare(did == 0)) {
+	    throw Xapian::DatabaseError("Run out of docids - you'll have to use copydatabase to eliminate any gaps before you can add more documents");
+	}
+	string message = encode_length(did);
+	message += serialise_document(doc);
+	send_message(MSG_REPLACEDOCUMENT, message);
+	pipeline_pending = true;
+	pipeline_lastdocid = did;
+	return did;
+    }
+
     send_message(MSG_ADDDOCUMENT, serialise_document(doc));
 
     string message;
@@ -758,6 +844,10 @@ RemoteDatabase::delete_document(Xapian::docid did)
     mru_slot = Xapian::BAD_VALUENO;
 
     send_message(MSG_DELETEDOCUMENT, encode_length(did));
+    if (pipelined) {
+	pipeline_pending = true;
+	return;
+    }
     string dummy;
     get_message(dummy, REPLY_DONE);
 }
@@ -769,6 +859,7 @@ RemoteDatabase::delete_document(const std::string & unique_term)
     mru_slot = Xapian::BAD_VALUENO;
 
     send_message(MSG_DELETEDOCUMENTTERM, unique_term);
+    if (pipelined) pipeline_pending = true;
 }
 
 void
@@ -782,6 +873,11 @@ RemoteDatabase::replace_document(Xapian::docid did,
     message += serialise_document(doc);
 
     send_message(MSG_REPLACEDOCUMENT, message);
+    if (pipelined) {
+	pipeline_pending = true;
+	if (did > pipeline_lastdocid && pipeline_lastdocid != 0)
+	    pipeline_lastdocid = did;
+    }
 }
 
 Xapian::docid
@@ -797,6 +893,14 @@ RemoteDatabase::replace_document(const std::string & unique_term,
 
     send_message(MSG_REPLACEDOCUMENTTERM, message);
 
+    if (pipelined) {
+	pipeline_pending = true;
+	// If no document has unique_term, the server will add one, so we
+	// don't know the last docid any more.
+	pipeline_lastdocid = 0;
+	return 0;
+    }
+
     get_message(message, REPLY_ADDDOCUMENT);
 
     const char * p = message.data();
@@ -87,6 +87,27 @@ class RemoteDatabase : public Xapian::Database::Internal {
      */
     mutable Xapian::valueno mru_slot;
 
+    /// Are we sending changes without waiting for replies?
+    bool pipelined;
+
+    /** Have changes been sent since the last check for pipeline errors?
+     *
+     *  Only used if @a pipelined is true.
+     */
+    mutable bool pipeline_pending;
+
+    /** The last docid we've allocated in pipelined mode.
+     *
+     *  0 if this needs to be fetched from the server before it can be used.
+     */
+    mutable Xapian::docid pipeline_lastdocid;
+
+    /** Check whether any pipelined changes failed.
+     *
+     *  If they did, the error is thrown.
+     */
+    void check_pipeline() const;
+
     bool update_stats(message_type msg_code = MSG_UPDATE,
 		      const std::string & body = std::string()) const;
 
@@ -103,7 +124,8 @@ class RemoteDatabase : public Xapian::Database::Internal {
      *			operations will never timeout.
      *  @param context_ The context to return with any error messages.
      *	@param writable	Is this a WritableDatabase?
-     *	@param flags	Xapian::DB_RETRY_LOCK or 0.
+     *	@param flags	Bitwise-or of Xapian::DB_RETRY_LOCK and/or
+     *			Xapian::DB_PIPELINE_WRITES, or 0.
      */
     RemoteDatabase(int fd, double timeout_, const string & context_,
 		   bool writable, int flags);
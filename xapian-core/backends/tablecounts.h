@@ -0,0 +1,84 @@
+/** @file tablecounts.h
+ * @brief Counts of the work done by a database table
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_TABLECOUNTS_H
+#define XAPIAN_INCLUDED_TABLECOUNTS_H
+
+/** Counts of the work done by a database table.
+ *
+ *  The counts only ever increase, so the work done by an operation can be
+ *  found by taking the difference of the counts before and after it.
+ */
+struct TableCounts {
+    /// Number of blocks read from disk.
+    unsigned long long blocks_read;
+
+    /// Number of bytes read from disk.
+    unsigned long long bytes_read;
+
+    /// Number of read system calls made to read blocks.
+    unsigned long long pread_calls;
+
+    /// Number of readahead hints given to the OS.
+    unsigned long long readahead_hints;
+
+    /// Number of cursors rebuilt because the table was modified.
+    unsigned long long cursor_rebuilds;
+
+    /// Number of compressed tags decompressed.
+    unsigned long long tags_inflated;
+
+    /// Number of block lookups satisfied by a block already in a cursor.
+    unsigned long long cache_hits;
+
+    TableCounts()
+	: blocks_read(0), bytes_read(0), pread_calls(0), readahead_hints(0),
+	  cursor_rebuilds(0), tags_inflated(0), cache_hits(0) { }
+
+    /// Count reading a block of @a size bytes using @a calls system calls.
+    void count_block_read(unsigned size, unsigned calls) {
+	++blocks_read;
+	bytes_read += size;
+	pread_calls += calls;
+    }
+
+    TableCounts & operator+=(const TableCounts & o) {
+	blocks_read += o.blocks_read;
+	bytes_read += o.bytes_read;
+	pread_calls += o.pread_calls;
+	readahead_hints += o.readahead_hints;
+	cursor_rebuilds += o.cursor_rebuilds;
+	tags_inflated += o.tags_inflated;
+	cache_hits += o.cache_hits;
+	return *this;
+    }
+
+    TableCounts & operator-=(const TableCounts & o) {
+	blocks_read -= o.blocks_read;
+	bytes_read -= o.bytes_read;
+	pread_calls -= o.pread_calls;
+	readahead_hints -= o.readahead_hints;
+	cursor_rebuilds -= o.cursor_rebuilds;
+	tags_inflated -= o.tags_inflated;
+	cache_hits -= o.cache_hits;
+	return *this;
+    }
+};
+
+#endif // XAPIAN_INCLUDED_TABLECOUNTS_H
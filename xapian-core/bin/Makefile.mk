@@ -13,6 +13,11 @@ bin_PROGRAMS +=\
 	bin/xapian-replicate\
 	bin/xapian-replicate-server
 
+if BUILD_BACKEND_GLASS
+bin_PROGRAMS +=\
+	bin/xapian-bulkload
+endif
+
 if BUILD_BACKEND_CHERT
 noinst_PROGRAMS +=\
 	bin/xapian-inspect
@@ -25,6 +30,11 @@ dist_man_MANS +=\
 	bin/xapian-delve.1\
 	bin/xapian-replicate.1\
 	bin/xapian-replicate-server.1
+
+if BUILD_BACKEND_GLASS
+dist_man_MANS +=\
+	bin/xapian-bulkload.1
+endif
 endif
 endif
 
@@ -40,6 +50,13 @@ dist_man_MANS +=\
 endif
 endif
 
+bin_xapian_bulkload_CPPFLAGS = $(AM_CPPFLAGS)
+bin_xapian_bulkload_SOURCES = bin/xapian-bulkload.cc\
+	common/fileutils.cc\
+	common/msvc_dirent.cc\
+	common/str.cc
+bin_xapian_bulkload_LDADD = $(ldflags) libgetopt.la $(libxapian_la)
+
 bin_xapian_check_SOURCES = bin/xapian-check.cc
 bin_xapian_check_LDADD = $(ldflags) $(libxapian_la)
 
@@ -81,6 +98,9 @@ bin_xapian_tcpsrv_SOURCES = bin/xapian-tcpsrv.cc
 bin_xapian_tcpsrv_LDADD = $(ldflags) libgetopt.la $(libxapian_la)
 
 if DOCUMENTATION_RULES
+bin/xapian-bulkload.1: bin/xapian-bulkload$(EXEEXT) makemanpage
+	./makemanpage bin/xapian-bulkload $(srcdir)/bin/xapian-bulkload.cc bin/xapian-bulkload.1
+
 bin/xapian-check.1: bin/xapian-check$(EXEEXT) makemanpage
 	./makemanpage bin/xapian-check $(srcdir)/bin/xapian-check.cc bin/xapian-check.1
 
@@ -0,0 +1,426 @@
+/** @file xapian-bulkload.cc
+ * @brief Build a new database from text by merging sorted runs.
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include <xapian.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fileutils.h"
+#include "filetests.h"
+#include "gnu_getopt.h"
+#include "safedirent.h"
+#include "safeerrno.h"
+#include "safesysstat.h"
+#include "str.h"
+
+using namespace std;
+
+#define PROG_NAME "xapian-bulkload"
+#define PROG_DESC "Build a new database from text files by merging sorted runs"
+
+#define OPT_HELP 1
+#define OPT_VERSION 2
+
+/// How many documents to pass to add_documents() at once.
+#define ADD_BATCH_SIZE 500
+
+static void show_usage() {
+    cout << "Usage: " PROG_NAME " [OPTIONS] DESTINATION_DATABASE [FILE...]\n\n"
+"Index each paragraph of the text FILEs (or of standard input if no FILEs are\n"
+"given) as a document.  The documents are indexed into temporary databases of\n"
+"--run-size documents each, which are merged into DESTINATION_DATABASE by\n"
+"compaction, so the postlists are written sequentially rather than updated\n"
+"in place.\n\n"
+"Options:\n"
+"  -s, --stemmer=LANG   Stem words using LANG (default: no stemming)\n"
+"  -r, --run-size=N     Index N documents into each temporary database\n"
+"                       (default 10000)\n"
+"  -w, --merge-width=N  Merge at most N temporary databases at once (default 16)\n"
+"  -t, --tmpdir=DIR     Put the temporary databases in DIR, which must not\n"
+"                       already exist (default DESTINATION_DATABASE.tmp)\n"
+"  -b, --blocksize=B    Set the blocksize in bytes (e.g. 4096) or K (e.g. 4K)\n"
+"                       (must be between 2K and 64K and a power of 2, default 8K)\n"
+"  -F, --fuller         Enable fuller compaction (not recommended if you plan to\n"
+"                       update the database)\n"
+"  -q, --quiet          Don't report progress\n"
+"  --help               display this help and exit\n"
+"  --version            output version information and exit" << endl;
+}
+
+class MyCompactor : public Xapian::Compactor {
+    bool quiet;
+
+  public:
+    MyCompactor() : quiet(false) { }
+
+    void set_quiet(bool quiet_) { quiet = quiet_; }
+
+    void set_status(const string & table, const string & status);
+};
+
+void
+MyCompactor::set_status(const string & table, const string & status)
+{
+    if (quiet)
+	return;
+    if (!status.empty())
+	cout << '\r' << table << ": " << status << endl;
+    else
+	cout << table << " ..." << flush;
+}
+
+/** Merge sorted runs of documents, a bounded number at a time.
+ *
+ *  Each run is a glass database which was written in docid order.  When
+ *  merge_width runs of the same level have accumulated, they're merged into
+ *  one run of the next level, so no merge has to open more than merge_width
+ *  databases, and each document is copied O(log(number of runs)) times.
+ */
+class RunMerger {
+    /// Directory to put the runs in.
+    string tmpdir;
+
+    /// The maximum number of runs to merge at once.
+    size_t merge_width;
+
+    /// The number of runs named so far.
+    unsigned run_count;
+
+    /// The runs at each level, in docid order within each level.
+    vector<vector<string>> levels;
+
+    MyCompactor & compactor;
+
+    bool quiet;
+
+    /// Merge @a runs into @a dest and remove them.
+    void merge(const vector<string> & runs, const string & dest,
+	       unsigned flags, size_t block_size) {
+	Xapian::Database src;
+	for (const string & run : runs) {
+	    src.add_database(Xapian::Database(run));
+	}
+	src.compact(dest, flags, block_size, compactor);
+	src.close();
+	for (const string & run : runs) {
+	    removedir(run);
+	}
+    }
+
+  public:
+    RunMerger(const string & tmpdir_, size_t merge_width_,
+	      MyCompactor & compactor_, bool quiet_)
+	: tmpdir(tmpdir_), merge_width(merge_width_), run_count(0),
+	  compactor(compactor_), quiet(quiet_) { }
+
+    /// Return a path for a new run.
+    string new_run_path() {
+	return tmpdir + "/run" + str(run_count++);
+    }
+
+    /// Add the run at @a path, which must follow all the runs added so far.
+    void add_run(const string & path) {
+	if (levels.empty()) levels.resize(1);
+	levels[0].push_back(path);
+	for (size_t level = 0; levels[level].size() >= merge_width; ++level) {
+	    if (level + 1 == levels.size()) levels.resize(level + 2);
+	    string merged = new_run_path();
+	    if (!quiet)
+		cout << "Merging " << levels[level].size() << " runs into "
+		     << merged << endl;
+	    // Runs only need to be written quickly, not compactly.
+	    merge(levels[level], merged, Xapian::Compactor::STANDARD, 0);
+	    levels[level].clear();
+	    levels[level + 1].push_back(merged);
+	}
+    }
+
+    /** Merge all the runs into @a dest.
+     *
+     *  Runs on higher levels hold earlier documents, so merge from the
+     *  highest level down to keep the documents in order.
+     */
+    void finish(const string & dest, unsigned flags, size_t block_size) {
+	vector<string> runs;
+	for (size_t level = levels.size(); level-- != 0; ) {
+	    runs.insert(runs.end(), levels[level].begin(), levels[level].end());
+	}
+	levels.clear();
+	if (runs.empty()) {
+	    Xapian::WritableDatabase(dest, Xapian::DB_CREATE |
+					   Xapian::DB_BACKEND_GLASS,
+				     block_size).close();
+	    return;
+	}
+	if (!quiet)
+	    cout << "Merging " << runs.size() << " runs into " << dest << endl;
+	merge(runs, dest, flags, block_size);
+    }
+};
+
+/// Index the documents read from @a in, starting a new run every run_size.
+static void
+index_file(istream & in, Xapian::TermGenerator & indexer,
+	   vector<Xapian::Document> & batch, Xapian::doccount & run_docs,
+	   Xapian::WritableDatabase & run, string & run_path,
+	   Xapian::doccount run_size, RunMerger & merger)
+{
+    string para;
+    while (true) {
+	string line;
+	if (in.eof()) {
+	    if (para.empty()) break;
+	} else {
+	    getline(in, line);
+	}
+
+	if (line.empty()) {
+	    if (!para.empty()) {
+		Xapian::Document doc;
+		doc.set_data(para);
+		indexer.set_document(doc);
+		indexer.index_text(para);
+		batch.push_back(doc);
+		para.resize(0);
+
+		if (run_path.empty()) {
+		    run_path = merger.new_run_path();
+		    // The runs are temporary, so don't wait for them to be
+		    // synced to disk.
+		    run = Xapian::WritableDatabase(run_path,
+						   Xapian::DB_CREATE |
+						   Xapian::DB_BACKEND_GLASS |
+						   Xapian::DB_NO_SYNC);
+		}
+		if (batch.size() == ADD_BATCH_SIZE ||
+		    run_docs + batch.size() == run_size) {
+		    run.add_documents(batch);
+		    run_docs += batch.size();
+		    batch.clear();
+		}
+		if (run_docs == run_size) {
+		    run.commit();
+		    run.close();
+		    merger.add_run(run_path);
+		    run_path.resize(0);
+		    run_docs = 0;
+		}
+	    }
+	} else {
+	    if (!para.empty()) para += ' ';
+	    para += line;
+	}
+    }
+}
+
+/// Remove @a tmpdir and any runs left in it by a failed build.
+static void
+remove_tmpdir(const string & tmpdir)
+{
+    vector<string> runs;
+    DIR * dir = opendir(tmpdir.c_str());
+    if (dir == NULL) return;
+    while (true) {
+	struct dirent * entry = readdir(dir);
+	if (entry == NULL) break;
+	string name(entry->d_name);
+	if (name != "." && name != "..") runs.push_back(name);
+    }
+    closedir(dir);
+    try {
+	for (const string & run : runs) {
+	    removedir(tmpdir + "/" + run);
+	}
+	removedir(tmpdir);
+    } catch (const Xapian::Error &error) {
+	cerr << PROG_NAME": Couldn't remove '" << tmpdir << "': "
+	     << error.get_description() << endl;
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    const char * opts = "s:r:w:t:b:Fq";
+    const struct option long_opts[] = {
+	{"stemmer",	required_argument, 0, 's'},
+	{"run-size",	required_argument, 0, 'r'},
+	{"merge-width",	required_argument, 0, 'w'},
+	{"tmpdir",	required_argument, 0, 't'},
+	{"blocksize",	required_argument, 0, 'b'},
+	{"fuller",	no_argument, 0, 'F'},
+	{"quiet",	no_argument, 0, 'q'},
+	{"help",	no_argument, 0, OPT_HELP},
+	{"version",	no_argument, 0, OPT_VERSION},
+	{NULL,		0, 0, 0}
+    };
+
+    MyCompactor compactor;
+    Xapian::Compactor::compaction_level level = Xapian::Compactor::FULL;
+    size_t block_size = 0;
+    Xapian::doccount run_size = 10000;
+    size_t merge_width = 16;
+    string tmpdir;
+    Xapian::Stem stemmer;
+    bool quiet = false;
+
+    int c;
+    while ((c = gnu_getopt_long(argc, argv, opts, long_opts, 0)) != -1) {
+	switch (c) {
+	    case 's':
+		try {
+		    stemmer = Xapian::Stem(optarg);
+		} catch (const Xapian::InvalidArgumentError &) {
+		    cerr << PROG_NAME": Unknown stemming language '" << optarg
+			 << "'" << endl;
+		    exit(1);
+		}
+		break;
+	    case 'r': {
+		char *p;
+		run_size = strtoul(optarg, &p, 10);
+		if (*p || run_size == 0) {
+		    cerr << PROG_NAME": Bad value '" << optarg
+			 << "' passed for run-size" << endl;
+		    exit(1);
+		}
+		break;
+	    }
+	    case 'w': {
+		char *p;
+		merge_width = strtoul(optarg, &p, 10);
+		if (*p || merge_width < 2) {
+		    cerr << PROG_NAME": Bad value '" << optarg
+			 << "' passed for merge-width, must be at least 2"
+			 << endl;
+		    exit(1);
+		}
+		break;
+	    }
+	    case 't':
+		tmpdir = optarg;
+		break;
+	    case 'b': {
+		char *p;
+		block_size = strtoul(optarg, &p, 10);
+		if (block_size <= 64 && (*p == 'K' || *p == 'k')) {
+		    ++p;
+		    block_size *= 1024;
+		}
+		if (*p || block_size < 2048 || block_size > 65536 ||
+		    (block_size & (block_size - 1)) != 0) {
+		    cerr << PROG_NAME": Bad value '" << optarg
+			 << "' passed for blocksize, must be a power of 2 between 2K and 64K"
+			 << endl;
+		    exit(1);
+		}
+		break;
+	    }
+	    case 'F':
+		level = compactor.FULLER;
+		break;
+	    case 'q':
+		quiet = true;
+		compactor.set_quiet(true);
+		break;
+	    case OPT_HELP:
+		cout << PROG_NAME " - " PROG_DESC "\n\n";
+		show_usage();
+		exit(0);
+	    case OPT_VERSION:
+		cout << PROG_NAME " - " PACKAGE_STRING << endl;
+		exit(0);
+	    default:
+		show_usage();
+		exit(1);
+	}
+    }
+
+    if (argc - optind < 1) {
+	show_usage();
+	exit(1);
+    }
+
+    // Path to the database to create.
+    string destdir = argv[optind++];
+    if (tmpdir.empty()) tmpdir = destdir + ".tmp";
+
+    // Check now rather than after all the indexing has been done.
+    if (file_exists(destdir) || dir_exists(destdir)) {
+	cerr << PROG_NAME": '" << destdir << "' already exists" << endl;
+	exit(1);
+    }
+
+    if (mkdir(tmpdir.c_str(), 0755) < 0) {
+	cerr << PROG_NAME": Couldn't create directory '" << tmpdir << "': "
+	     << strerror(errno) << endl;
+	exit(1);
+    }
+
+    try {
+	RunMerger merger(tmpdir, merge_width, compactor, quiet);
+	Xapian::TermGenerator indexer;
+	indexer.set_stemmer(stemmer);
+
+	vector<Xapian::Document> batch;
+	Xapian::doccount run_docs = 0;
+	Xapian::WritableDatabase run;
+	string run_path;
+	if (optind == argc) {
+	    index_file(cin, indexer, batch, run_docs, run, run_path, run_size,
+		       merger);
+	}
+	for (int i = optind; i < argc; ++i) {
+	    ifstream in(argv[i]);
+	    if (!in) {
+		cerr << PROG_NAME": Couldn't open '" << argv[i] << "'" << endl;
+		run = Xapian::WritableDatabase();
+		remove_tmpdir(tmpdir);
+		exit(1);
+	    }
+	    index_file(in, indexer, batch, run_docs, run, run_path, run_size,
+		       merger);
+	}
+	if (!run_path.empty()) {
+	    run.add_documents(batch);
+	    run.commit();
+	    run.close();
+	    merger.add_run(run_path);
+	}
+
+	merger.finish(destdir, level, block_size);
+	removedir(tmpdir);
+    } catch (const Xapian::Error &error) {
+	cerr << argv[0] << ": " << error.get_description() << endl;
+	// Otherwise the next attempt would fail to create tmpdir.
+	remove_tmpdir(tmpdir);
+	exit(1);
+    } catch (const char * msg) {
+	cerr << argv[0] << ": " << msg << endl;
+	remove_tmpdir(tmpdir);
+	exit(1);
+    }
+}
@@ -82,10 +82,23 @@ show_help()
 	    "goto X : Goto entry X (alias 'g')\n"
 	    "until X: Display entries until X (alias 'u')\n"
 	    "open X : Open table X instead (alias 'o') - e.g. open postlist\n"
+	    "stats  : Show counts of the I/O done so far (alias 's')\n"
 	    "help   : Show this (alias 'h' or '?')\n"
 	    "quit   : Quit this utility (alias 'q')" << endl;
 }
 
+static void
+show_stats(const TableCounts & counts)
+{
+    cout << "Blocks read: " << counts.blocks_read << "\n"
+	    "Bytes read: " << counts.bytes_read << "\n"
+	    "Read calls: " << counts.pread_calls << "\n"
+	    "Readahead hints: " << counts.readahead_hints << "\n"
+	    "Cursor rebuilds: " << counts.cursor_rebuilds << "\n"
+	    "Tags inflated: " << counts.tags_inflated << "\n"
+	    "Cursor cache hits: " << counts.cache_hits << endl;
+}
+
 static void
 do_until(ChertCursor & cursor, const string & target)
 {
@@ -262,6 +275,9 @@ wait_for_input:
 		else if (!endswith(table_name, '.'))
 		    table_name += '.';
 		goto open_different_table;
+	    } else if (input == "s" || input == "stats") {
+		show_stats(table.get_counts());
+		goto wait_for_input;
 	    } else if (input == "q" || input == "quit") {
 		break;
 	    } else if (input == "h" || input == "help" || input == "?") {
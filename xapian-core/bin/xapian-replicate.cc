@@ -62,6 +62,8 @@ static void show_usage() {
 "                      no timeout (default: " STRINGIZE(DEFAULT_TIMEOUT) ")\n"
 "  -f, --force-copy    force a full copy of the database to be sent (and then\n"
 "                      replicate as normal)\n"
+"  -j, --parallel=N    fetch any full copy of the database over N connections\n"
+"                      at once (default: 1)\n"
 "  -o, --one-shot      replicate only once and then exit\n"
 "  -q, --quiet         only report errors\n"
 "  -v, --verbose       be more verbose\n"
@@ -72,7 +74,7 @@ static void show_usage() {
 int
 main(int argc, char **argv)
 {
-    const char * opts = "h:p:m:i:r:t:ofqv";
+    const char * opts = "h:p:m:i:r:t:j:ofqv";
     const struct option long_opts[] = {
 	{"host",	required_argument,	0, 'h'},
 	{"port",	required_argument,	0, 'p'},
@@ -82,6 +84,7 @@ main(int argc, char **argv)
 	{"timeout",	required_argument,	0, 't'},
 	{"one-shot",	no_argument,		0, 'o'},
 	{"force-copy",	no_argument,		0, 'f'},
+	{"parallel",	required_argument,	0, 'j'},
 	{"quiet",	no_argument,		0, 'q'},
 	{"verbose",	no_argument,		0, 'v'},
 	{"help",	no_argument, 0, OPT_HELP},
@@ -98,6 +101,7 @@ main(int argc, char **argv)
     bool force_copy = false;
     int reader_close_time = READER_CLOSE_TIME;
     int timeout = DEFAULT_TIMEOUT;
+    int connections = 1;
 
     int c;
     while ((c = gnu_getopt_long(argc, argv, opts, long_opts, 0)) != -1) {
@@ -123,6 +127,13 @@ main(int argc, char **argv)
 	    case 'f':
 		force_copy = true;
 		break;
+	    case 'j':
+		connections = atoi(optarg);
+		if (connections < 1) {
+		    cerr << "--parallel must be at least 1\n";
+		    exit(1);
+		}
+		break;
 	    case 'o':
 		one_shot = true;
 		break;
@@ -180,7 +191,8 @@ main(int argc, char **argv)
 	    }
 	    Xapian::ReplicationInfo info;
 	    client.update_from_master(dbpath, masterdb, info,
-				      reader_close_time, force_copy);
+				      reader_close_time, force_copy,
+				      connections);
 	    if (verbosity == VERBOSE) {
 		cout << "Update complete: "
 		     << info.fullcopy_count << " copies, "
@@ -130,7 +130,7 @@ BitWriter::encode(size_t value, size_t outof)
 }
 
 void
-BitWriter::encode_interpolative(const vector<Xapian::termpos> &pos, int j, int k)
+BitWriter::encode_interpolative(const Xapian::termpos * pos, int j, int k)
 {
     // "Interpolative code" - for an algorithm description, see "Managing
     // Gigabytes" - pages 126-127 in the second edition.  You can probably
@@ -57,7 +57,7 @@ class BitWriter {
     }
 
     /// Perform interpolative encoding of pos elements between j and k.
-    void encode_interpolative(const std::vector<Xapian::termpos> &pos, int j, int k);
+    void encode_interpolative(const Xapian::termpos * pos, int j, int k);
 };
 
 /// Read a stream created by BitWriter.
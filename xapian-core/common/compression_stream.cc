@@ -76,6 +76,36 @@ CompressionStream::compress(const char* buf, size_t* p_size) {
     return out;
 }
 
+void
+CompressionStream::compress_chunk(const char* p, size_t len, bool finish,
+				  string& buf)
+{
+    Bytef blk[8192];
+
+    deflate_zstream->next_in = (Bytef*)const_cast<char*>(p);
+    deflate_zstream->avail_in = (uInt)len;
+
+    while (true) {
+	deflate_zstream->next_out = blk;
+	deflate_zstream->avail_out = (uInt)sizeof(blk);
+	int err = deflate(deflate_zstream, finish ? Z_FINISH : Z_NO_FLUSH);
+	if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR) {
+	    string msg = "deflate failed";
+	    if (deflate_zstream->msg) {
+		msg += " (";
+		msg += deflate_zstream->msg;
+		msg += ')';
+	    }
+	    throw Xapian::DatabaseError(msg);
+	}
+
+	buf.append(reinterpret_cast<const char *>(blk),
+		   deflate_zstream->next_out - blk);
+	if (finish ? err == Z_STREAM_END : deflate_zstream->avail_out != 0)
+	    return;
+    }
+}
+
 bool
 CompressionStream::decompress_chunk(const char* p, int len, string & buf)
 {
@@ -88,6 +118,10 @@ CompressionStream::decompress_chunk(const char* p, int len, string & buf)
 	inflate_zstream->next_out = blk;
 	inflate_zstream->avail_out = (uInt)sizeof(blk);
 	int err = inflate(inflate_zstream, Z_SYNC_FLUSH);
+	if (err == Z_BUF_ERROR && inflate_zstream->avail_in == 0) {
+	    // No progress was possible without more input.
+	    return false;
+	}
 	if (err != Z_OK && err != Z_STREAM_END) {
 	    if (err == Z_MEM_ERROR) throw std::bad_alloc();
 	    string msg = "inflate failed";
@@ -102,7 +136,10 @@ CompressionStream::decompress_chunk(const char* p, int len, string & buf)
 	buf.append(reinterpret_cast<const char *>(blk),
 		   inflate_zstream->next_out - blk);
 	if (err == Z_STREAM_END) return true;
-	if (inflate_zstream->avail_in == 0) return false;
+	// If the output block was filled, there may be more output pending even
+	// if all the input has been consumed.
+	if (inflate_zstream->avail_in == 0 &&
+	    inflate_zstream->avail_out != 0) return false;
     }
 }
 
@@ -122,7 +159,7 @@ CompressionStream::lazy_alloc_deflate_zstream() {
 
     // -15 means raw deflate with 32K LZ77 window (largest)
     // memLevel 9 is the highest (8 is default)
-    int err = deflateInit2(deflate_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+    int err = deflateInit2(deflate_zstream, compress_level, Z_DEFLATED,
 			   -15, 9, compress_strategy);
     if (rare(err != Z_OK)) {
 	if (err == Z_MEM_ERROR) {
@@ -29,6 +29,8 @@
 class CompressionStream {
     int compress_strategy;
 
+    int compress_level;
+
     size_t out_len;
 
     char* out;
@@ -50,9 +52,13 @@ class CompressionStream {
      *
      *  @param compress_strategy_	Z_DEFAULT_STRATEGY,
      *					Z_FILTERED, Z_HUFFMAN_ONLY, or Z_RLE.
+     *  @param compress_level_		Z_DEFAULT_COMPRESSION, or 1 (fastest)
+     *					to 9 (smallest output).
      */
-    explicit CompressionStream(int compress_strategy_ = Z_DEFAULT_STRATEGY)
+    explicit CompressionStream(int compress_strategy_ = Z_DEFAULT_STRATEGY,
+			       int compress_level_ = Z_DEFAULT_COMPRESSION)
 	: compress_strategy(compress_strategy_),
+	  compress_level(compress_level_),
 	  out_len(0),
 	  out(NULL),
 	  deflate_zstream(NULL),
@@ -63,6 +69,15 @@ class CompressionStream {
 
     const char* compress(const char* buf, size_t* p_size);
 
+    void compress_start() { lazy_alloc_deflate_zstream(); }
+
+    /** Compress a chunk of a stream, appending the output to @a buf.
+     *
+     *  @param finish	true if this is the final chunk.
+     */
+    void compress_chunk(const char* p, size_t len, bool finish,
+			std::string& buf);
+
     void decompress_start() { lazy_alloc_inflate_zstream(); }
 
     /** Returns true if this was the final chunk. */
@@ -175,19 +175,21 @@ io_readahead_block(int fd, size_t n, off_t b, off_t o)
 }
 #endif
 
-void
+unsigned
 io_read_block(int fd, char * p, size_t n, off_t b, off_t o)
 {
     o += b * n;
+    unsigned calls = 0;
     // Prefer pread if available since it's typically implemented as a
     // separate syscall, and that eliminates the overhead of an extra syscall
     // per block read.
 #ifdef HAVE_PREAD
     while (true) {
 	ssize_t c = pread(fd, p, n, o);
+	++calls;
 	// We should get a full read most of the time, so streamline that case.
 	if (usual(c == ssize_t(n)))
-	    return;
+	    return calls;
 	// -1 is error, 0 is EOF
 	if (c <= 0) {
 	    // We get EINTR if the syscall was interrupted by a signal.
@@ -206,9 +208,10 @@ io_read_block(int fd, char * p, size_t n, off_t b, off_t o)
 	throw_block_error("Error seeking to block ", b, errno);
     while (true) {
 	ssize_t c = read(fd, p, n);
+	++calls;
 	// We should get a full read most of the time, so streamline that case.
 	if (usual(c == ssize_t(n)))
-	    return;
+	    return calls;
 	if (c <= 0) {
 	    // We get EINTR if the syscall was interrupted by a signal.
 	    // In this case we should retry the read.
@@ -129,8 +129,11 @@ bool io_readahead_block(int fd, size_t n, off_t b, off_t o = 0);
 inline bool io_readahead_block(int, size_t, off_t, off_t = 0) { return false; }
 #endif
 
-/// Read block b size n bytes into buffer p from file descriptor fd, offset o.
-void io_read_block(int fd, char * p, size_t n, off_t b, off_t o = 0);
+/** Read block b size n bytes into buffer p from file descriptor fd, offset o.
+ *
+ *  Returns the number of read system calls made (usually 1).
+ */
+unsigned io_read_block(int fd, char * p, size_t n, off_t b, off_t o = 0);
 
 /// Write block b size n bytes from buffer p to file descriptor fd, offset o.
 void io_write_block(int fd, const char * p, size_t n, off_t b, off_t o = 0);
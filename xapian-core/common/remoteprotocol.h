@@ -49,8 +49,12 @@
 // 37: 1.3.1 Prefix-compress termlists.
 // 38: 1.3.2 Stats serialisation now includes collection freq, and more...
 // 39: 1.3.3 New query operator OP_WILDCARD; sort keys in serialised MSet.
-#define XAPIAN_REMOTE_PROTOCOL_MAJOR_VERSION 39
-#define XAPIAN_REMOTE_PROTOCOL_MINOR_VERSION 0
+// 40: 1.3.7 Send postlists, termlists, positionlists and allterms in batches.
+// 40.1: 1.3.7 Support pipelined writes.
+// 40.2: 1.3.7 Support compressed messages.
+// 40.3: 1.3.7 New query operator OP_EDIT_DISTANCE.
+#define XAPIAN_REMOTE_PROTOCOL_MAJOR_VERSION 40
+#define XAPIAN_REMOTE_PROTOCOL_MINOR_VERSION 3
 
 /** Message types (client -> server).
  *
@@ -89,6 +93,7 @@ enum message_type {
     MSG_METADATAKEYLIST,	// Iterator for metadata keys
     MSG_FREQS,			// Get termfreq and collfreq
     MSG_UNIQUETERMS,		// Get number of unique terms in doc
+    MSG_COMPRESS,		// Start compressing messages
     MSG_MAX
 };
 
@@ -109,7 +114,7 @@ enum reply_type {
     REPLY_TERMLIST,		// Get Termlist
     REPLY_POSITIONLIST,		// Get PositionList
     REPLY_POSTLISTSTART,	// Start of a postlist
-    REPLY_POSTLISTITEM,		// Item in body of a postlist
+    REPLY_POSTLISTITEM,		// Batch of items in body of a postlist
     REPLY_VALUE,		// Document Value
     REPLY_ADDDOCUMENT,		// Add Document
     REPLY_RESULTS,		// Results (MSet)
@@ -25,8 +25,16 @@
 
 #include "xapian/error.h"
 
+#include "xapian/version.h" // For XAPIAN_HAS_REMOTE_BACKEND
+
 #include "io_utils.h"
 #include "posixy_wrapper.h"
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+# include "net/length.h"
+# include "net/remoteconnection.h"
+# include "replicationprotocol.h"
+# include <zlib.h>
+#endif
 
 #include "safeerrno.h"
 #include "safefcntl.h"
@@ -35,6 +43,8 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 using namespace std;
@@ -64,3 +74,121 @@ write_and_clear_changes(int changes_fd, string & buf, size_t bytes)
     }
     buf.erase(0, bytes);
 }
+
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+/// Append the checksum of a range to @a out.
+static void
+append_range_checksum(string & out, const char * p, size_t len)
+{
+    const Bytef * data = reinterpret_cast<const Bytef *>(p);
+    // A CRC-32 and an Adler-32 of the same data fail in unrelated ways, so
+    // between them we get close to 64 bits of protection against a false
+    // match, which matters as a false match leaves the replica corrupt.
+    uLong crc = crc32(crc32(0L, Z_NULL, 0), data, uInt(len));
+    uLong adler = adler32(adler32(0L, Z_NULL, 0), data, uInt(len));
+    for (int shift = 24; shift >= 0; shift -= 8)
+	out += char(crc >> shift);
+    for (int shift = 24; shift >= 0; shift -= 8)
+	out += char(adler >> shift);
+}
+
+void
+checksum_file_ranges(int fd, string & out)
+{
+    string buf(REPL_COPY_RANGE_SIZE, '\0');
+    while (true) {
+	size_t len = io_read(fd, &buf[0], buf.size(), 0);
+	if (len == 0) break;
+	append_range_checksum(out, buf.data(), len);
+	if (len < buf.size()) break;
+    }
+}
+
+/** Decode the start of the copy information.
+ *
+ *  @param p	Pointer to a pointer to the copy information, which will be
+ *		advanced past the part of the copy to send.
+ *  @param end	Pointer to the end of the copy information.
+ *  @param[out] part	Which part of the copy to send.
+ *  @param[out] nparts	How many parts the copy is split into, or 0 if the
+ *			whole copy should be sent.
+ */
+static void
+decode_copy_part(const char ** p, const char * end,
+		 unsigned & part, unsigned & nparts)
+{
+    part = nparts = 0;
+    if (*p == end) return;
+    decode_length(p, end, nparts);
+    decode_length(p, end, part);
+    if (nparts && part >= nparts)
+	throw Xapian::NetworkError("Bad part of database copy requested");
+}
+
+bool
+copy_info_is_part(const string & copy_info)
+{
+    const char * p = copy_info.data();
+    unsigned part, nparts;
+    decode_copy_part(&p, p + copy_info.size(), part, nparts);
+    return nparts != 0;
+}
+
+void
+send_db_file(RemoteConnection & conn, const string & leaf, int fd,
+	     const string & copy_info, double end_time)
+{
+    conn.send_message(REPL_REPLY_DB_FILENAME, leaf, end_time);
+
+    // Find what the replica already has of this file.
+    const char * p = copy_info.data();
+    const char * end = p + copy_info.size();
+    unsigned part, nparts;
+    decode_copy_part(&p, end, part, nparts);
+    const char * sums = NULL;
+    size_t sums_len = 0;
+    while (p != end) {
+	size_t len;
+	decode_length_and_check(&p, end, len);
+	bool match = (len == leaf.size() && memcmp(p, leaf.data(), len) == 0);
+	p += len;
+	decode_length_and_check(&p, end, len);
+	if (match) {
+	    sums = p;
+	    sums_len = len;
+	    break;
+	}
+	p += len;
+    }
+
+    if (sums == NULL && nparts == 0) {
+	// The replica has nothing to start from, so just send the whole file.
+	conn.send_file(REPL_REPLY_DB_FILEDATA, fd, end_time);
+	return;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) < 0)
+	throw Xapian::DatabaseError("Couldn't stat file to copy", errno);
+    off_t size = sb.st_size;
+    conn.send_message(REPL_REPLY_DB_FILEDIFF, encode_length(size), end_time);
+
+    if (nparts == 0) nparts = 1;
+    string msg, sum;
+    for (off_t r = part; r * off_t(REPL_COPY_RANGE_SIZE) < size; r += nparts) {
+	off_t offset = r * off_t(REPL_COPY_RANGE_SIZE);
+	size_t len = size_t(min(size - offset, off_t(REPL_COPY_RANGE_SIZE)));
+	msg = encode_length(offset);
+	size_t header_len = msg.size();
+	msg.resize(header_len + len);
+	io_read_block(fd, &msg[header_len], len, 0, offset);
+	if (size_t(r) < sums_len / 8) {
+	    sum.resize(0);
+	    append_range_checksum(sum, msg.data() + header_len, len);
+	    // The replica already has this range.
+	    if (memcmp(sum.data(), sums + r * 8, 8) == 0) continue;
+	}
+	conn.send_message(REPL_REPLY_DB_FILERANGE, msg, end_time);
+    }
+}
+#endif
@@ -23,6 +23,8 @@
 
 #include <string>
 
+class RemoteConnection;
+
 /** Create a new changeset file, and return an open fd for writing to it.
  *
  *  Creates the changeset directory, if required.
@@ -53,4 +55,41 @@ create_changeset_file(const std::string & changeset_dir,
 void
 write_and_clear_changes(int changes_fd, std::string & buf, size_t bytes);
 
+/** Append checksums for each range of a file to a string.
+ *
+ *  The file is split into ranges of REPL_COPY_RANGE_SIZE bytes (the last
+ *  range may be shorter) and 8 bytes of checksum are appended for each.
+ *
+ *  @param fd	The file to checksum (read from the current position).
+ *  @param out	The string to append the checksums to.
+ */
+void
+checksum_file_ranges(int fd, std::string & out);
+
+/** Check if we've been asked to send just one part of a database copy.
+ *
+ *  @param copy_info	Information about the copy, as passed to
+ *			Database::Internal::write_changesets_to_fd().
+ */
+bool
+copy_info_is_part(const std::string & copy_info);
+
+/** Send a file which is part of a database copy.
+ *
+ *  If the replica has told us what it already has of this file, or we're
+ *  only sending one part of the copy, only the ranges needed are sent.
+ *  Otherwise the whole file is sent.
+ *
+ *  @param conn	The connection to send the file over.
+ *  @param leaf	The leafname of the file.
+ *  @param fd	The file to send.
+ *  @param copy_info	Information about the copy, as passed to
+ *			Database::Internal::write_changesets_to_fd().
+ *  @param end_time	If this time is reached, an exception will be thrown
+ *			(0.0 for no timeout).
+ */
+void
+send_db_file(RemoteConnection & conn, const std::string & leaf, int fd,
+	     const std::string & copy_info, double end_time);
+
 #endif // XAPIAN_INCLUDED_REPLICATE_UTILS_H
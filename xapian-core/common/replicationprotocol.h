@@ -23,8 +23,12 @@
 
 // Versions:
 // 1: Initial support
-#define XAPIAN_REPLICATION_PROTOCOL_MAJOR_VERSION 1
-#define XAPIAN_REPLICATION_PROTOCOL_MINOR_VERSION 0
+// 2: 1.3.7 Large messages from the server may be compressed.
+// 2.1: 1.3.7 Support resumable and parallel database copies.
+// 2.2: 1.3.7 Client can ask if a database copy is needed before sending
+//	checksums.
+#define XAPIAN_REPLICATION_PROTOCOL_MAJOR_VERSION 2
+#define XAPIAN_REPLICATION_PROTOCOL_MINOR_VERSION 2
 
 // Reply types (master -> slave)
 enum replicate_reply_type {
@@ -34,7 +38,10 @@ enum replicate_reply_type {
     REPL_REPLY_DB_FILENAME,	// The name of a file in a DB copy.
     REPL_REPLY_DB_FILEDATA,	// Contents of a file in a DB copy.
     REPL_REPLY_DB_FOOTER,	// End of a whole DB copy.
-    REPL_REPLY_CHANGESET	// A changeset file is being sent.
+    REPL_REPLY_CHANGESET,	// A changeset file is being sent.
+    REPL_REPLY_DB_FILEDIFF,	// Size of a file in a DB copy, sent by range.
+    REPL_REPLY_DB_FILERANGE,	// A range of a file in a DB copy.
+    REPL_REPLY_COPY_NEEDED	// Whether a DB copy is needed.
 };
 
 // The maximum number of copies of a database to send in a single conversation.
@@ -42,4 +49,9 @@ enum replicate_reply_type {
 // sent.
 #define MAX_DB_COPIES_PER_CONVERSATION 5
 
+// The size of the ranges which files are split into for a DB copy when the
+// replica already has some of the data.  Each range is checksummed, and only
+// those ranges which differ are sent.
+#define REPL_COPY_RANGE_SIZE (256 * 1024)
+
 #endif // XAPIAN_INCLUDED_REPLICATIONPROTOCOL_H
@@ -13,6 +13,7 @@ xapianinclude_HEADERS =\
 	include/xapian/constants.h\
 	include/xapian/constinfo.h\
 	include/xapian/database.h\
+	include/xapian/databasestats.h\
 	include/xapian/dbfactory.h\
 	include/xapian/deprecated.h\
 	include/xapian/derefwrapper.h\
@@ -24,6 +25,7 @@ xapianinclude_HEADERS =\
 	include/xapian/intrusive_ptr.h\
 	include/xapian/iterator.h\
 	include/xapian/keymaker.h\
+	include/xapian/matchprofile.h\
 	include/xapian/matchspy.h\
 	include/xapian/mset.h\
 	include/xapian/positioniterator.h\
@@ -58,6 +58,7 @@
 
 // Access to databases, documents, etc.
 #include <xapian/database.h>
+#include <xapian/databasestats.h>
 #include <xapian/dbfactory.h>
 #include <xapian/document.h>
 #include <xapian/positioniterator.h>
@@ -71,6 +72,7 @@
 // Searching
 #include <xapian/enquire.h>
 #include <xapian/eset.h>
+#include <xapian/matchprofile.h>
 #include <xapian/mset.h>
 #include <xapian/expanddecider.h>
 #include <xapian/keymaker.h>
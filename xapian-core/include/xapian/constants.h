@@ -144,6 +144,22 @@ const int DB_NO_TERMLIST	 = 0x20;
  */
 const int DB_RETRY_LOCK		 = 0x40;
 
+/** Maintain a deletion index for spelling suggestions.
+ *
+ *  By default, candidate spelling corrections are found by looking for words
+ *  which share trigrams with the word being checked.  If this flag is
+ *  specified, a glass database will instead index variants of the start of
+ *  each word in the spelling dictionary with up to two characters deleted, so
+ *  candidates can be found with a handful of exact lookups.  This makes
+ *  get_spelling_suggestion() faster at the cost of a larger spelling table.
+ *
+ *  The deletion index must contain every word in the spelling dictionary, so
+ *  this flag only takes effect if the spelling dictionary is empty.  Once
+ *  started, the deletion index is maintained whether or not this flag is
+ *  specified when the database is subsequently opened.
+ */
+const int DB_SPELLING_DELETION_INDEX = 0x80;
+
 /** Use the glass backend.
  *
  *  When opening a WritableDatabase, this means create a glass database if a
@@ -186,14 +202,97 @@ const int DB_BACKEND_STUB	 = 0x300;
  *  A new empty database is created, so when creating a Database object this
  *  creates an empty read-only database - sometimes useful to avoid special
  *  casing this situation, but otherwise of limited use.  It's more useful
- *  when creating a WritableDatabase object, though beware that the current
- *  inmemory backend implementation was not built for performance and
- *  scalability.
+ *  when creating a WritableDatabase object, for example for a temporary
+ *  database which is rebuilt rather than updated.  Indexing into it and
+ *  searching it are both faster than using a disk based backend, but the
+ *  whole database must fit in memory and it doesn't support transactions,
+ *  spelling data or synonyms.
  *
  *  This provides an equivalent to Xapian::InMemory::open() in Xapian 1.2.
  */
 const int DB_BACKEND_INMEMORY	 = 0x400;
 
+/** Maintain an n-gram index of the terms in the database.
+ *
+ *  If this flag is specified, a glass database will also index every term
+ *  under each three byte substring of it, which allows OP_WILDCARD patterns
+ *  starting with a wildcard (e.g. "*phone*" or "*ing") to be expanded
+ *  without checking every term in the database.
+ *
+ *  The index must contain every term, so this flag only takes effect if the
+ *  database has no documents.  Once started, the index is maintained
+ *  whether or not this flag is specified when the database is subsequently
+ *  opened.
+ */
+const int DB_TERM_NGRAM_INDEX	 = 0x800;
+
+/** Don't wait for each change to a remote database to be acknowledged.
+ *
+ *  By default, add_document(), delete_document(docid) and
+ *  replace_document(unique_term, doc) on a remote WritableDatabase each wait
+ *  for the server to reply, which costs a network round-trip per call.  If
+ *  this flag is passed to Xapian::Remote::open_writable(), these calls instead
+ *  return as soon as the change has been sent, and the server applies the
+ *  changes in order.
+ *
+ *  Any error from these changes is reported by the next call which needs to
+ *  communicate with the server (e.g. commit()), and the changes after the
+ *  failing one in the same batch are discarded.  The docid returned by
+ *  add_document() is allocated by the client, and
+ *  replace_document(unique_term, doc) returns 0 as the docid isn't known
+ *  without waiting.
+ *
+ *  This flag is ignored by other backends.
+ */
+const int DB_PIPELINE_WRITES	 = 0x1000;
+
+/** Keep the revision being read available while a writer commits.
+ *
+ *  A Database open for reading searches the revision which was current when
+ *  it was opened (or last reopened).  By default, once a writer has committed
+ *  a newer revision, it may reuse blocks which only the older revision needs,
+ *  and then Xapian::DatabaseModifiedError will be thrown when the reader tries
+ *  to use them.
+ *
+ *  If this flag is specified when opening a Database for reading, a
+ *  WritableDatabase open on the same database in the same process won't
+ *  reuse any blocks the revision being read might need until the Database
+ *  is reopened, closed or destroyed.  So searches can run alongside commits
+ *  for as long as they need to, without DatabaseModifiedError.  The database
+ *  will grow while an old revision is pinned like this.
+ *
+ *  Writers in other processes aren't aware of the pin, and it has no effect
+ *  if the writer uses Xapian::DB_DANGEROUS.  This flag is currently only
+ *  supported by the glass backend, and is ignored by other backends.
+ */
+const int DB_PIN_REVISION	 = 0x2000;
+
+/** Create a glass database made up of segments.
+ *
+ *  A segmented database is a directory of glass databases ("segments").
+ *  Committed segments are never modified: all the changes between commits
+ *  go into a new segment, so commit() only writes out the changed documents'
+ *  data rather than merging their postings into the existing postlists.
+ *  Replacing or deleting a document in an older segment stores the new copy
+ *  and the document id in the new segment, and the older copy is skipped
+ *  until a merge drops it.  After a commit, runs of segments of similar
+ *  sizes are merged, which keeps the number of segments small.  Searches see
+ *  a single database.
+ *
+ *  Each commit is atomic, since it only becomes visible when the list of
+ *  segments is replaced.  The first change to spelling, synonym or user
+ *  metadata after a commit copies the database holding them, so that is
+ *  slow if there's a lot of such data.  Segments replaced by a merge and old
+ *  copies of that database are left for readers which are opening them, and
+ *  removed the next time the database is opened for writing.  Replication
+ *  and Xapian::Database::check() aren't supported for segmented databases.
+ *
+ *  This flag only has an effect when a new glass database is created - an
+ *  existing segmented database is detected automatically, and the flag is
+ *  ignored when opening an existing unsegmented database.
+ */
+const int DB_SEGMENTED		 = 0x4000;
+
 #ifdef XAPIAN_LIB_BUILD
 /** @internal Bit mask for backend codes. */
 const int DB_BACKEND_MASK_	 = 0x700;
@@ -267,6 +366,25 @@ const int DBCOMPACT_MULTIPASS = 8;
  */
 const int DBCOMPACT_SINGLE_FILE = 16;
 
+/** Store per-term impact bounds in the output.
+ *
+ *  For each term, the exact maximum wdf and the minimum length of the
+ *  documents it indexes are recorded, which allows the matcher to use much
+ *  tighter upper bounds on the weight a term can contribute, and so to
+ *  terminate early more often.  The bounds are only used until the database
+ *  is next modified, so this is mostly useful for static databases which are
+ *  rebuilt rather than updated.
+ *
+ *  Calculating the bounds requires holding the length of every document in
+ *  memory (8 bytes per document) plus each term's bounds (roughly the length
+ *  of the term plus a few bytes) until the compaction finishes, so this
+ *  needs considerably more memory than a normal compaction of a large
+ *  database.
+ *
+ *  Only supported by the glass backend currently.
+ */
+const int DBCOMPACT_IMPACT_BOUNDS = 32;
+
 }
 
 #endif /* XAPIAN_INCLUDED_CONSTANTS_H */
@@ -34,6 +34,7 @@
 #include <vector>
 
 #include <xapian/attributes.h>
+#include <xapian/databasestats.h>
 #include <xapian/deprecated.h>
 #include <xapian/intrusive_ptr.h>
 #include <xapian/types.h>
@@ -482,6 +483,19 @@ class XAPIAN_VISIBILITY_DEFAULT Database {
 	 */
 	std::string get_uuid() const;
 
+	/** Get counts of the I/O done by this database.
+	 *
+	 *  The counts are for the tables of this Database object, since it
+	 *  was opened.  If there are multiple sub-databases, the counts for
+	 *  each table are summed across them.  Remote databases and backends
+	 *  other than glass and chert don't keep counts, so contribute
+	 *  nothing.
+	 *
+	 *  The returned object is a snapshot, so to find the I/O done by an
+	 *  operation, call this method before and after it and subtract.
+	 */
+	Xapian::DatabaseStats get_stats() const;
+
 	/** Check the integrity of a database or database table.
 	 *
 	 *  @param path	Path to database or table
@@ -537,6 +551,10 @@ class XAPIAN_VISIBILITY_DEFAULT Database {
 	 *   - Xapian::DBCOMPACT_SINGLE_FILE
 	 *		Produce a single-file database (only supported for
 	 *		glass currently).
+	 *   - Xapian::DBCOMPACT_IMPACT_BOUNDS
+	 *		Store per-term impact bounds to tighten weight upper
+	 *		bounds used by the matcher (only supported for glass
+	 *		currently).
 	 *
 	 *  @param block_size This specifies the block size (in bytes) for
 	 *		to use for the output.  For glass, the block size must
@@ -585,6 +603,10 @@ class XAPIAN_VISIBILITY_DEFAULT Database {
 	 *		Produce a single-file database (only supported for
 	 *		glass currently) - this flag is implied in this form
 	 *		and need not be specified explicitly.
+	 *   - Xapian::DBCOMPACT_IMPACT_BOUNDS
+	 *		Store per-term impact bounds to tighten weight upper
+	 *		bounds used by the matcher (only supported for glass
+	 *		currently).
 	 *
 	 *  @param block_size This specifies the block size (in bytes) for
 	 *		to use for the output.  For glass, the block size must
@@ -631,6 +653,10 @@ class XAPIAN_VISIBILITY_DEFAULT Database {
 	 *   - Xapian::DBCOMPACT_SINGLE_FILE
 	 *		Produce a single-file database (only supported for
 	 *		glass currently).
+	 *   - Xapian::DBCOMPACT_IMPACT_BOUNDS
+	 *		Store per-term impact bounds to tighten weight upper
+	 *		bounds used by the matcher (only supported for glass
+	 *		currently).
 	 *
 	 *  @param block_size This specifies the block size (in bytes) for
 	 *		to use for the output.  For glass, the block size must
@@ -686,6 +712,10 @@ class XAPIAN_VISIBILITY_DEFAULT Database {
 	 *		Produce a single-file database (only supported for
 	 *		glass currently) - this flag is implied in this form
 	 *		and need not be specified explicitly.
+	 *   - Xapian::DBCOMPACT_IMPACT_BOUNDS
+	 *		Store per-term impact bounds to tighten weight upper
+	 *		bounds used by the matcher (only supported for glass
+	 *		currently).
 	 *
 	 *  @param block_size This specifies the block size (in bytes) for
 	 *		to use for the output.  For glass, the block size must
@@ -837,6 +867,51 @@ class XAPIAN_VISIBILITY_DEFAULT WritableDatabase : public Database {
 	 */
 	XAPIAN_DEPRECATED(void flush()) { commit(); }
 
+	/** Compact the database in place, a table at a time.
+	 *
+	 *  Each call commits any pending modifications, then writes a
+	 *  compacted copy of the next table of the database and swaps it in
+	 *  for the original.  Because each call only handles one table, you
+	 *  can carry on modifying the database between calls, for example:
+	 *
+	 *  @code
+	 *  while (db.compact_incrementally()) {
+	 *      // Add, replace or delete some documents.
+	 *      db.commit();
+	 *  }
+	 *  @endcode
+	 *
+	 *  Readers which are already open carry on using the revision they
+	 *  have open until they call reopen().  Any iterators over this
+	 *  WritableDatabase are invalidated.
+	 *
+	 *  The database gets a new UUID, so replicas of it will be updated by
+	 *  copying the whole database.
+	 *
+	 *  This is currently only supported by the glass backend.
+	 *
+	 *  @param flags	Xapian::Compactor::STANDARD, FULL or FULLER, as
+	 *			for Xapian::Compactor::set_compaction_level()
+	 *			(default: STANDARD).
+	 *  @param max_io_rate	Limit on the rate at which to copy the table, in
+	 *			bytes per second, so that compaction doesn't
+	 *			starve searches of I/O (default: 0, which means
+	 *			no limit).
+	 *
+	 *  @return true if there are more tables to compact, or false if the
+	 *	    call compacted the last table (or there was nothing to do).
+	 *
+	 *  @exception Xapian::InvalidOperationError will be thrown if a
+	 *	       transaction is in progress.
+	 *
+	 *  @exception Xapian::UnimplementedError will be thrown if the
+	 *	       backend doesn't support compacting in place.
+	 *
+	 *  @exception Xapian::DatabaseError will be thrown if a problem occurs
+	 *	       while compacting the database.
+	 */
+	bool compact_incrementally(unsigned flags = 0, double max_io_rate = 0.0);
+
 	/** Begin a transaction.
 	 *
 	 *  In Xapian a transaction is a group of modifications to the database
@@ -962,6 +1037,38 @@ class XAPIAN_VISIBILITY_DEFAULT WritableDatabase : public Database {
 	 */
 	Xapian::docid add_document(const Xapian::Document & document);
 
+	/** Add a batch of new documents to the database.
+	 *
+	 *  The effect is the same as calling add_document() for each document
+	 *  in @a docs in turn, so they are given consecutive new document IDs.
+	 *  But the postings of the whole batch are gathered by term before
+	 *  being buffered, which is usually quite a bit faster than adding
+	 *  the documents one at a time.
+	 *
+	 *  Only one thread can modify a database, but the documents can be
+	 *  built in parallel: each thread needs its own Document,
+	 *  TermGenerator and Stem objects (a copy of a Stem object shares
+	 *  state with the original, so construct a new one for each thread).
+	 *  The documents can then be handed to the thread which owns the
+	 *  WritableDatabase a batch at a time.  A batch of a few hundred
+	 *  documents is usually enough to get most of the benefit.
+	 *
+	 *  If an exception is thrown, all the changes since the last commit
+	 *  are discarded, as they are if add_document() fails.
+	 *
+	 *  @param docs	The new documents to be added.
+	 *
+	 *  @return	The document ID of the first document added (or 0 if
+	 *		@a docs is empty).
+	 *
+	 *  @exception Xapian::DatabaseError will be thrown if a problem occurs
+	 *             while writing to the database.
+	 *
+	 *  @exception Xapian::DatabaseCorruptError will be thrown if the
+	 *             database is in a corrupt state.
+	 */
+	Xapian::docid add_documents(const std::vector<Xapian::Document> & docs);
+
 	/** Delete a document from the database.
 	 *
 	 *  This method removes the document with the specified document ID
@@ -0,0 +1,111 @@
+/** @file  databasestats.h
+ *  @brief Class holding counts of the I/O done by a database
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_DATABASESTATS_H
+#define XAPIAN_INCLUDED_DATABASESTATS_H
+
+#if !defined XAPIAN_IN_XAPIAN_H && !defined XAPIAN_LIB_BUILD
+# error "Never use <xapian/databasestats.h> directly; include <xapian.h> instead."
+#endif
+
+#include <string>
+
+#include <xapian/intrusive_ptr.h>
+#include <xapian/visibility.h>
+
+namespace Xapian {
+
+/** Class holding counts of the I/O done by a database.
+ *
+ *  This is a snapshot of the counts returned by Database::get_stats().  The
+ *  counts cover the work done by the tables of the Database object since it
+ *  was opened, and are only kept for local glass and chert databases.
+ *
+ *  Each method takes the name of a table (e.g. "postlist", "termlist",
+ *  "position", "docdata" for glass or "record" for chert) and returns the
+ *  count for that table, or the total for all the tables if @a table is
+ *  empty.
+ */
+class XAPIAN_VISIBILITY_DEFAULT DatabaseStats {
+  public:
+    /// Class representing the DatabaseStats internals.
+    class Internal;
+    /// @private @internal Reference counted internals.
+    Xapian::Internal::intrusive_ptr<Internal> internal;
+
+    /** Copying is allowed.
+     *
+     *  The internals are reference counted, so copying is cheap.
+     */
+    DatabaseStats(const DatabaseStats & o);
+
+    /** Copying is allowed.
+     *
+     *  The internals are reference counted, so assignment is cheap.
+     */
+    DatabaseStats & operator=(const DatabaseStats & o);
+
+    /// Default constructor - all the counts are zero.
+    DatabaseStats();
+
+    /// @private @internal Wrap an existing Internal.
+    explicit DatabaseStats(Internal * internal_);
+
+    /// Destructor.
+    ~DatabaseStats();
+
+    /// Number of blocks read from disk.
+    unsigned long long get_blocks_read(const std::string & table = std::string()) const;
+
+    /// Number of bytes read from disk.
+    unsigned long long get_bytes_read(const std::string & table = std::string()) const;
+
+    /** Number of read system calls made to read blocks.
+     *
+     *  This is usually the same as the number of blocks read, but can be
+     *  more if a read is interrupted or only partly satisfied.
+     */
+    unsigned long long get_pread_calls(const std::string & table = std::string()) const;
+
+    /** Number of readahead hints given to the operating system.
+     *
+     *  Currently these are only given for the postlist table, for the terms
+     *  in each query run.
+     */
+    unsigned long long get_readahead_hints(const std::string & table = std::string()) const;
+
+    /** Number of cursors rebuilt because the table was modified.
+     *
+     *  This only happens for a WritableDatabase.
+     */
+    unsigned long long get_cursor_rebuilds(const std::string & table = std::string()) const;
+
+    /// Number of compressed tags which have been decompressed.
+    unsigned long long get_tags_inflated(const std::string & table = std::string()) const;
+
+    /// Number of block lookups satisfied by a block already in a cursor.
+    unsigned long long get_cache_hits(const std::string & table = std::string()) const;
+
+    /// Return a string describing this object.
+    std::string get_description() const;
+};
+
+}
+
+#endif // XAPIAN_INCLUDED_DATABASESTATS_H
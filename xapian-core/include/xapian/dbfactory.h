@@ -197,6 +197,8 @@ Database open(const std::string &host, unsigned int port, useconds_t timeout = 1
  *				Xapian::NetworkTimeoutError is thrown.  A
  *				timeout of 0 means don't timeout.  (Default is
  *				10000ms, which is 10 seconds).
+ * @param flags		Xapian::DB_RETRY_LOCK, Xapian::DB_PIPELINE_WRITES,
+ *			a bitwise-or of these, or 0.
  */
 XAPIAN_VISIBILITY_DEFAULT
 WritableDatabase open_writable(const std::string &host, unsigned int port, useconds_t timeout = 0, useconds_t connect_timeout = 10000, int flags = 0);
@@ -231,7 +233,8 @@ Database open(const std::string &program, const std::string &args, useconds_t ti
  *			for any individual operation on the remote database
  *			then Xapian::NetworkTimeoutError is thrown.  (Default
  *			is 0, which means don't timeout).
- * @param flags		Xapian::DB_RETRY_LOCK or 0.
+ * @param flags		Xapian::DB_RETRY_LOCK, Xapian::DB_PIPELINE_WRITES,
+ *			a bitwise-or of these, or 0.
  */
 XAPIAN_VISIBILITY_DEFAULT
 WritableDatabase open_writable(const std::string &program, const std::string &args, useconds_t timeout = 0, int flags = 0);
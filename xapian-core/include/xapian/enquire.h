@@ -460,6 +460,19 @@ class XAPIAN_VISIBILITY_DEFAULT Enquire {
 	 */
 	void set_time_limit(double time_limit);
 
+	/** Enable or disable profiling of matches.
+	 *
+	 *  If enabled, get_mset() records the time spent in each phase of the
+	 *  match and counts of the work done, which can be read from the
+	 *  returned MSet using MSet::get_profile().  This adds a little
+	 *  overhead, so it is disabled by default.
+	 *
+	 *  Only work done for local databases is counted.
+	 *
+	 *  @param profiling  true to enable profiling (default: false)
+	 */
+	void set_profiling(bool profiling);
+
 	/** Get (a portion of) the match set for the current query.
 	 *
 	 *  @param first     the first item in the result set to return.
@@ -0,0 +1,175 @@
+/** @file  matchprofile.h
+ *  @brief Class describing the work done to run a query
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_MATCHPROFILE_H
+#define XAPIAN_INCLUDED_MATCHPROFILE_H
+
+#if !defined XAPIAN_IN_XAPIAN_H && !defined XAPIAN_LIB_BUILD
+# error "Never use <xapian/matchprofile.h> directly; include <xapian.h> instead."
+#endif
+
+#include <string>
+
+#include <xapian/intrusive_ptr.h>
+#include <xapian/termiterator.h>
+#include <xapian/types.h>
+#include <xapian/visibility.h>
+
+namespace Xapian {
+
+/** Class describing the work done to run a query.
+ *
+ *  A profile is only gathered if Enquire::set_profiling() has been called,
+ *  and is returned by MSet::get_profile().  Otherwise all the times and
+ *  counts are zero and the strings are empty.
+ *
+ *  Times are in seconds.  The counts of postlist and table activity are only
+ *  gathered for local databases - currently postlist counts (other than
+ *  weight calculations) are only kept by the glass backend, and table counts
+ *  are only kept for glass and chert databases.
+ *
+ *  Postlist counts are only gathered for the leaf postlists (those for
+ *  terms), not for the AND, OR, phrase and other nodes of the postlist
+ *  tree.  The counts for a term are totalled over all the subdatabases, and
+ *  over all the places the term appears in the query.  They can be read for
+ *  each term (see get_terms_begin()), or totalled over all the terms.
+ */
+class XAPIAN_VISIBILITY_DEFAULT MatchProfile {
+  public:
+    /// Class representing the MatchProfile internals.
+    class Internal;
+    /// @private @internal Reference counted internals.
+    Xapian::Internal::intrusive_ptr<Internal> internal;
+
+    /** Copying is allowed.
+     *
+     *  The internals are reference counted, so copying is cheap.
+     */
+    MatchProfile(const MatchProfile & o);
+
+    /** Copying is allowed.
+     *
+     *  The internals are reference counted, so assignment is cheap.
+     */
+    MatchProfile & operator=(const MatchProfile & o);
+
+    /// Default constructor - creates an empty profile.
+    MatchProfile();
+
+    /// @private @internal Wrap an existing Internal.
+    explicit MatchProfile(Internal * internal_);
+
+    /// Destructor.
+    ~MatchProfile();
+
+    /// Total time taken by Enquire::get_mset().
+    double get_total_time() const;
+
+    /** Time taken to build the postlist tree.
+     *
+     *  This includes gathering the statistics needed for weighting and
+     *  opening the postlists.
+     */
+    double get_build_time() const;
+
+    /// Time spent finding matching documents (including weighting them).
+    double get_match_time() const;
+
+    /// Time spent calculating document weights.
+    double get_weight_time() const;
+
+    /// Time spent collapsing documents.
+    double get_collapse_time() const;
+
+    /// Time spent sorting the final results.
+    double get_sort_time() const;
+
+    /// Number of candidate documents the matcher considered.
+    Xapian::doccount get_docs_considered() const;
+
+    /// Number of next() calls on the leaf postlists.
+    unsigned long long get_next_calls() const;
+
+    /// Number of skip_to() calls on the leaf postlists.
+    unsigned long long get_skip_to_calls() const;
+
+    /// Number of postings the leaf postlists decoded.
+    unsigned long long get_postings_decoded() const;
+
+    /// Number of times a leaf postlist calculated a weight.
+    unsigned long long get_weight_calls() const;
+
+    /** Start iterating the terms which have postlist counts.
+     *
+     *  The terms are returned in ascending order.  The empty term is
+     *  included if the query used the postlist of all documents.
+     */
+    TermIterator get_terms_begin() const;
+
+    /// End iterator corresponding to get_terms_begin().
+    TermIterator XAPIAN_NOTHROW(get_terms_end() const) {
+	return TermIterator();
+    }
+
+    /// Number of next() calls on the leaf postlists for @a term.
+    unsigned long long get_next_calls(const std::string & term) const;
+
+    /// Number of skip_to() calls on the leaf postlists for @a term.
+    unsigned long long get_skip_to_calls(const std::string & term) const;
+
+    /// Number of postings the leaf postlists for @a term decoded.
+    unsigned long long get_postings_decoded(const std::string & term) const;
+
+    /// Number of times a leaf postlist for @a term calculated a weight.
+    unsigned long long get_weight_calls(const std::string & term) const;
+
+    /** Number of blocks read from disk from a table.
+     *
+     *  @param table	The table name (e.g. "postlist", "termlist",
+     *			"position", "docdata").
+     */
+    unsigned long long get_blocks_read(const std::string & table) const;
+
+    /** Number of block lookups in a table satisfied by a cursor's cache.
+     *
+     *  @param table	The table name (e.g. "postlist", "termlist",
+     *			"position", "docdata").
+     */
+    unsigned long long get_cache_hits(const std::string & table) const;
+
+    /** Return a description of the optimised postlist tree.
+     *
+     *  This is the tree which was used to run the match, after the query
+     *  optimiser has done its work.  If there's more than one database, the
+     *  descriptions of each database's subtree are combined.
+     */
+    std::string get_postlist_tree() const;
+
+    /** Return a string describing this object.
+     *
+     *  This includes the times, the counts for each term (see the class
+     *  documentation for how these are totalled), and the counts for each
+     *  table.
+     */
+    std::string get_description() const;
+};
+
+}
+
+#endif // XAPIAN_INCLUDED_MATCHPROFILE_H
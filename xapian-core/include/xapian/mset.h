@@ -32,6 +32,7 @@
 #include <xapian/attributes.h>
 #include <xapian/document.h>
 #include <xapian/intrusive_ptr.h>
+#include <xapian/matchprofile.h>
 #include <xapian/stem.h>
 #include <xapian/types.h>
 #include <xapian/visibility.h>
@@ -95,6 +96,13 @@ class XAPIAN_VISIBILITY_DEFAULT MSet {
     double get_max_attained() const;
     double get_max_possible() const;
 
+    /** Return the profile of the match which produced this MSet.
+     *
+     *  A profile is only gathered if Enquire::set_profiling() was called
+     *  before the match was run - otherwise an empty profile is returned.
+     */
+    Xapian::MatchProfile get_profile() const;
+
     enum {
 	SNIPPET_BACKGROUND_MODEL = 1,
 	SNIPPET_EXHAUSTIVE = 2
@@ -126,6 +134,32 @@ class XAPIAN_VISIBILITY_DEFAULT MSet {
 			const std::string & hi_end = "</b>",
 			const std::string & omit = "...") const;
 
+    /** Generate a snippet using stored word offsets.
+     *
+     *  This is like the other form of snippet(), but uses the offsets of
+     *  the words in @a text which TermGenerator stored in value slot @a
+     *  offsets_slot of document @a did (see
+     *  TermGenerator::set_offsets_slot()).  The best part of the text is
+     *  found from the positions of the query terms in the document, so only
+     *  the part of the text which is returned needs to be looked at, which
+     *  is much faster for long texts.
+     *
+     *  The background model isn't used in this case, so the
+     *  SNIPPET_BACKGROUND_MODEL flag is ignored.
+     *
+     *  If the document has no offsets stored for @a text (e.g. it was
+     *  indexed without them), this falls back to parsing @a text.
+     */
+    std::string snippet(const std::string & text,
+			Xapian::docid did,
+			Xapian::valueno offsets_slot,
+			size_t length = 500,
+			const Xapian::Stem & stemmer = Xapian::Stem(),
+			unsigned flags = SNIPPET_EXHAUSTIVE,
+			const std::string & hi_start = "<b>",
+			const std::string & hi_end = "</b>",
+			const std::string & omit = "...") const;
+
     /** Prefetch hint a range of items.
      *
      *  For a remote database, this may start a pipelined fetched of the
@@ -111,6 +111,27 @@ class XAPIAN_VISIBILITY_DEFAULT Query {
 	OP_MAX = 14,
 	OP_WILDCARD = 15,
 
+	/** Match terms within an edit distance of a target.
+	 *
+	 *  This expands to all the terms in the database which are within a
+	 *  specified number of edits of a target term, where an edit is
+	 *  inserting, deleting or substituting a character, or transposing
+	 *  two adjacent characters.  The expansion is limited in the same
+	 *  ways as OP_WILDCARD, and the terms are combined with OP_SYNONYM
+	 *  (or OP_OR or OP_MAX).
+	 *
+	 *  This is useful for searches which tolerate typing mistakes.  For
+	 *  example, this expands "fish" to any of "fish", "dish", "fist",
+	 *  "fishy" and "ifsh" which are present:
+	 *
+	 *  <pre>
+	 *  Xapian::Query query(Xapian::Query::OP_EDIT_DISTANCE, "fish", 0,
+	 *			Xapian::Query::WILDCARD_LIMIT_ERROR,
+	 *			Xapian::Query::OP_SYNONYM, 1);
+	 *  </pre>
+	 */
+	OP_EDIT_DISTANCE = 16,
+
 	OP_INVALID = 99,
 
 	LEAF_TERM = 100,
@@ -141,7 +162,32 @@ class XAPIAN_VISIBILITY_DEFAULT Query {
 	 *  to evaluate than the full expansion, using only the most frequent
 	 *  terms tends to give better results too.
 	 */
-	WILDCARD_LIMIT_MOST_FREQUENT
+	WILDCARD_LIMIT_MOST_FREQUENT,
+#ifdef XAPIAN_LIB_BUILD
+	/** @internal Bit mask for the WILDCARD_LIMIT_* values. */
+	WILDCARD_LIMIT_MASK_ = 0x03,
+#endif
+	/** Support "*" in OP_WILDCARD patterns.
+	 *
+	 *  This flag can be combined with the WILDCARD_LIMIT_* value using
+	 *  bitwise or.  When it's specified, "*" in the pattern matches zero or
+	 *  more characters, and the pattern must match the whole term - so
+	 *  "*phone*" matches any term containing "phone", "*ing" matches terms
+	 *  ending "ing" and "foo" only matches "foo".
+	 *
+	 *  Patterns which don't start with a fixed prefix are most efficient
+	 *  if the database was created with Xapian::DB_TERM_NGRAM_INDEX,
+	 *  otherwise every term in the database needs to be checked.
+	 */
+	WILDCARD_PATTERN_MULTI = 0x10,
+	/** Support "?" in OP_WILDCARD patterns.
+	 *
+	 *  Like WILDCARD_PATTERN_MULTI, but "?" in the pattern matches exactly
+	 *  one (UTF-8) character.
+	 */
+	WILDCARD_PATTERN_SINGLE = 0x20,
+	/// Support "*" and "?" in OP_WILDCARD patterns.
+	WILDCARD_PATTERN_GLOB = WILDCARD_PATTERN_MULTI|WILDCARD_PATTERN_SINGLE
     };
 
     /// Default constructor.
@@ -202,18 +248,24 @@ class XAPIAN_VISIBILITY_DEFAULT Query {
     Query(op op_, Xapian::valueno slot,
 	  const std::string & begin, const std::string & end);
 
-    /** Query constructor for OP_WILDCARD queries.
+    /** Query constructor for OP_WILDCARD and OP_EDIT_DISTANCE queries.
      *
-     *  @param op	Must be OP_WILDCARD
-     *  @param pattern	The wildcard pattern - currently this is just a string
-     *			and the wildcard expands to terms which start with
-     *			exactly this string.
+     *  @param op	Must be OP_WILDCARD or OP_EDIT_DISTANCE
+     *  @param pattern	For OP_WILDCARD, the wildcard pattern - by default
+     *			this is just a string and the wildcard expands to
+     *			terms which start with exactly this string (but see
+     *			@a WILDCARD_PATTERN_MULTI).  For
+     *			OP_EDIT_DISTANCE, the target term, which expands to
+     *			terms within an edit distance of 2 of it.
      *	@param max_expansion	The maximum number of terms to expand to
      *				(default: 0, which means no limit)
      *	@param max_type	How to enforce max_expansion - one of
      *			@a WILDCARD_LIMIT_ERROR (the default),
      *			@a WILDCARD_LIMIT_FIRST or
-     *			@a WILDCARD_LIMIT_MOST_FREQUENT.
+     *			@a WILDCARD_LIMIT_MOST_FREQUENT.  For
+     *			OP_WILDCARD, this can be combined with
+     *			@a WILDCARD_PATTERN_MULTI and/or
+     *			@a WILDCARD_PATTERN_SINGLE using bitwise or.
      *			When searching multiple databases, the expansion limit
      *			is currently applied independently for each database,
      *			so the total number of terms may be higher than the
@@ -228,6 +280,35 @@ class XAPIAN_VISIBILITY_DEFAULT Query {
 	  int max_type = WILDCARD_LIMIT_ERROR,
 	  op combiner = OP_SYNONYM);
 
+    /** Query constructor for OP_EDIT_DISTANCE queries.
+     *
+     *  @param op	Must be OP_EDIT_DISTANCE
+     *  @param target	The target term.
+     *	@param max_expansion	The maximum number of terms to expand to
+     *				(0 means no limit)
+     *	@param max_type	How to enforce max_expansion - one of
+     *			@a WILDCARD_LIMIT_ERROR,
+     *			@a WILDCARD_LIMIT_FIRST or
+     *			@a WILDCARD_LIMIT_MOST_FREQUENT.
+     *	@param combiner The @op to combine the terms with - one of
+     *			@a OP_SYNONYM, @a OP_OR or @a OP_MAX.
+     *	@param edit_distance	The maximum number of edits a term can be from
+     *				@a target (counted in Unicode characters).
+     *				At most 255 is allowed.
+     *	@param min_prefix_len	Only expand to terms which share the first
+     *				@a min_prefix_len Unicode characters of
+     *				@a target (default: 0).  Requiring a short
+     *				common prefix greatly reduces the number of
+     *				terms which need to be considered.
+     */
+    Query(op op_,
+	  const std::string & target,
+	  Xapian::termcount max_expansion,
+	  int max_type,
+	  op combiner,
+	  unsigned edit_distance,
+	  size_t min_prefix_len = 0);
+
     template<typename I>
     Query(op op_, I begin, I end, Xapian::termcount window = 0)
     {
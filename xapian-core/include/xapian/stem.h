@@ -54,6 +54,13 @@ class XAPIAN_VISIBILITY_DEFAULT StemImplementation
     /// Stem the specified word.
     virtual std::string operator()(const std::string & word) = 0;
 
+    /** Stem the specified word, setting @a result to the stem.
+     *
+     *  The default implementation assigns the result of operator()(word),
+     *  but subclasses can override this to reuse the storage of @a result.
+     */
+    virtual void stem_into(const std::string & word, std::string & result);
+
     /// Return a string describing this object.
     virtual std::string get_description() const = 0;
 };
@@ -138,6 +145,17 @@ class XAPIAN_VISIBILITY_DEFAULT Stem {
      */
     std::string operator()(const std::string &word) const;
 
+    /** Stem a word, setting @a result to the stem.
+     *
+     *  This gives the same stem as operator()(), but reuses the storage of
+     *  @a result, so stemming words in a loop needn't allocate a new string
+     *  for each one.
+     *
+     *  @param word		a word to stem.
+     *  @param result	string to set to the stem.
+     */
+    void stem_into(const std::string &word, std::string &result) const;
+
     /// Return a string describing this object.
     std::string get_description() const;
 
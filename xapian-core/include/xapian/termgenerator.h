@@ -158,6 +158,23 @@ class XAPIAN_VISIBILITY_DEFAULT TermGenerator {
      */
     void set_max_word_length(unsigned max_word_length);
 
+    /** Store the byte offsets of indexed words in a value slot.
+     *
+     *  If set, each call to index_text() stores the offset of the end of each
+     *  word it gives a term position to in value slot @a slot of the
+     *  document, replacing any offsets stored by an earlier call.
+     *  MSet::snippet() can use these to find the best part of the text from
+     *  the positions of the query terms, rather than parsing the whole text.
+     *
+     *  So that the offsets match the text the snippet is generated from, this
+     *  should only be set while indexing that text (typically the body of the
+     *  document).
+     *
+     *  @param slot	The value slot to use, or Xapian::BAD_VALUENO (the
+     *			default) to not store offsets.
+     */
+    void set_offsets_slot(Xapian::valueno slot = Xapian::BAD_VALUENO);
+
     /** Index some text.
      *
      * @param itor	Utf8Iterator pointing to the text to index.
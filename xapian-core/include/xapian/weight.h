@@ -357,6 +357,9 @@ class XAPIAN_VISIBILITY_DEFAULT Weight {
      *
      *  This bound does not include any zero-length documents.
      *
+     *  When weighting a term, this may instead be a (tighter) lower bound on
+     *  the length of the documents indexed by that term.
+     *
      *  This should only be used by get_maxpart() and get_maxextra().
      */
     Xapian::termcount get_doclength_lower_bound() const {
@@ -143,6 +143,16 @@ Stem::operator()(const std::string &word) const
     return internal->operator()(word);
 }
 
+void
+Stem::stem_into(const std::string &word, std::string &result) const
+{
+    if (!internal.get() || word.empty()) {
+	result = word;
+	return;
+    }
+    internal->stem_into(word, result);
+}
+
 string
 Stem::get_description() const
 {
@@ -132,13 +132,19 @@ namespace Xapian {
 
 StemImplementation::~StemImplementation() { }
 
+void
+StemImplementation::stem_into(const string & word, string & result)
+{
+    result = operator()(word);
+}
+
 SnowballStemImplementation::~SnowballStemImplementation()
 {
     lose_s(p);
 }
 
-string
-SnowballStemImplementation::operator()(const string & word)
+void
+SnowballStemImplementation::run_stemmer(const string & word)
 {
     const symbol * s = reinterpret_cast<const symbol *>(word.data());
     replace_s(0, l, word.size(), s);
@@ -147,7 +153,30 @@ SnowballStemImplementation::operator()(const string & word)
 	// FIXME: Is there a better choice of exception class?
 	throw Xapian::InternalError("stemming exception!");
     }
-    return string(reinterpret_cast<const char *>(p), l);
+}
+
+string
+SnowballStemImplementation::operator()(const string & word)
+{
+    string result;
+    stem_into(word, result);
+    return result;
+}
+
+void
+SnowballStemImplementation::stem_into(const string & word, string & result)
+{
+    auto i = cache.find(word);
+    if (i != cache.end()) {
+	result = i->second;
+	return;
+    }
+    run_stemmer(word);
+    result.assign(reinterpret_cast<const char *>(p), l);
+    // Rather than tracking which entries are least recently used, just start
+    // again when the cache is full - the common words soon get added again.
+    if (cache.size() >= CACHE_SIZE) cache.clear();
+    cache.emplace(word, result);
 }
 
 /* Code for character groupings: utf8 cases */
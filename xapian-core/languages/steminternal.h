@@ -26,6 +26,7 @@
 
 #include <cstdlib>
 #include <string>
+#include <unordered_map>
 
 typedef unsigned char symbol;
 
@@ -84,6 +85,19 @@ namespace Xapian {
 class SnowballStemImplementation : public StemImplementation {
     int slice_check();
 
+    /** Maximum number of entries in cache.
+     *
+     *  Word frequencies follow Zipf's law, so a few thousand words account
+     *  for most of the words in typical text.
+     */
+    static const size_t CACHE_SIZE = 4096;
+
+    /// Words stemmed recently, and their stems.
+    std::unordered_map<std::string, std::string> cache;
+
+    /// Run the stemmer on @a word, leaving the stem in p and l.
+    void run_stemmer(const std::string & word);
+
   protected:
     symbol * p;
     int c, l, lb, bra, ket;
@@ -137,6 +151,9 @@ class SnowballStemImplementation : public StemImplementation {
     /// Stem the specified word.
     virtual std::string operator()(const std::string & word);
 
+    /// Stem the specified word, setting @a result to the stem.
+    virtual void stem_into(const std::string & word, std::string & result);
+
     /// Virtual method implemented by the subclass to actually do the work.
     virtual int stem() = 0;
 };
@@ -1,6 +1,7 @@
 noinst_HEADERS +=\
 	matcher/andmaybepostlist.h\
 	matcher/andnotpostlist.h\
+	matcher/boolorpostlist.h\
 	matcher/branchpostlist.h\
 	matcher/collapser.h\
 	matcher/const_database_wrapper.h\
@@ -40,6 +41,7 @@ EXTRA_DIST +=\
 lib_src +=\
 	matcher/andmaybepostlist.cc\
 	matcher/andnotpostlist.cc\
+	matcher/boolorpostlist.cc\
 	matcher/branchpostlist.cc\
 	matcher/collapser.cc\
 	matcher/const_database_wrapper.cc\
@@ -0,0 +1,399 @@
+/** @file boolorpostlist.cc
+ * @brief N-way OR postlist for when the weights aren't needed
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "boolorpostlist.h"
+
+#include "branchpostlist.h"
+#include "debuglog.h"
+#include "omassert.h"
+
+#include <algorithm>
+
+using namespace std;
+
+BoolOrPostList::~BoolOrPostList()
+{
+    if (plist) {
+	for (size_t i = 0; i < n_kids; ++i) {
+	    delete plist[i].pl;
+	}
+	delete [] plist;
+    }
+    delete [] block_bits;
+    delete [] block_wdf;
+    delete [] block_subqs;
+}
+
+void
+BoolOrPostList::sift_down()
+{
+    PostListAndDocID item = plist[0];
+    size_t i = 0;
+    while (true) {
+	size_t child = 2 * i + 1;
+	if (child >= n_kids) break;
+	if (child + 1 < n_kids && plist[child + 1].did < plist[child].did)
+	    ++child;
+	if (item.did <= plist[child].did) break;
+	plist[i] = plist[child];
+	i = child;
+    }
+    plist[i] = item;
+}
+
+void
+BoolOrPostList::pop_top()
+{
+    delete plist[0].pl;
+    if (--n_kids) {
+	plist[0] = plist[n_kids];
+	sift_down();
+    }
+}
+
+void
+BoolOrPostList::start(Xapian::docid did_min)
+{
+    for (size_t i = 0; i < n_kids; ++i) {
+	if (did_min) {
+	    skip_to_handling_prune(plist[i].pl, did_min, 0.0, matcher);
+	} else {
+	    next_handling_prune(plist[i].pl, 0.0, matcher);
+	}
+	if (plist[i].pl->at_end()) {
+	    delete plist[i].pl;
+	    plist[i--] = plist[--n_kids];
+	    continue;
+	}
+	plist[i].did = plist[i].pl->get_docid();
+    }
+
+    make_heap(plist, plist + n_kids,
+	      [](const PostListAndDocID & a, const PostListAndDocID & b) {
+		  return a.did > b.did;
+	      });
+
+    if (db && n_kids > 1) {
+	block_bits = new block_word_t[BLOCK_SIZE / WORD_BITS]();
+	block_wdf = new Xapian::termcount[BLOCK_SIZE]();
+	block_subqs = new Xapian::termcount[BLOCK_SIZE]();
+    }
+}
+
+void
+BoolOrPostList::advance(Xapian::docid did_min)
+{
+    // Advance the sub-postlists which are at the current docid, and any which
+    // are before did_min (if did_min is non-zero).
+    if (did_min <= did) did_min = did + 1;
+    while (n_kids && plist[0].did < did_min) {
+	PostListAndDocID & top = plist[0];
+	if (top.did + 1 == did_min) {
+	    next_handling_prune(top.pl, 0.0, matcher);
+	} else {
+	    skip_to_handling_prune(top.pl, did_min, 0.0, matcher);
+	}
+	if (top.pl->at_end()) {
+	    pop_top();
+	} else {
+	    top.did = top.pl->get_docid();
+	    sift_down();
+	}
+    }
+}
+
+bool
+BoolOrPostList::find_in_block(unsigned off)
+{
+    if (off >= block_used) return false;
+    unsigned w = off / WORD_BITS;
+    block_word_t word = block_bits[w] & (~block_word_t(0) << (off % WORD_BITS));
+    while (word == 0) {
+	if (++w >= (block_used + WORD_BITS - 1) / WORD_BITS) return false;
+	word = block_bits[w];
+    }
+    off = w * WORD_BITS;
+#if defined __GNUC__
+    // GCC 3.4 added __builtin_ctz() (with l and ll variants).
+    if (sizeof(block_word_t) == sizeof(unsigned long))
+	off += __builtin_ctzl(word);
+    else
+	off += __builtin_ctzll(word);
+#else
+    while ((word & 1) == 0) {
+	word >>= 1;
+	++off;
+    }
+#endif
+    did = block_start + off;
+    return true;
+}
+
+PostList *
+BoolOrPostList::next_block()
+{
+    if (n_kids <= 1) {
+	if (n_kids == 0) {
+	    // We've reached the end of all posting lists.
+	    did = 0;
+	    return NULL;
+	}
+	// Only one sub-postlist is left, so replace ourselves with it.
+	n_kids = 0;
+	return plist[0].pl;
+    }
+
+    if (!block_bits) {
+	did = plist[0].did;
+	return NULL;
+    }
+
+    // Gather the postings for the next BLOCK_SIZE docids into the bitmap.
+    // Each sub-postlist is advanced through all its postings in the block
+    // before being put back in the heap.
+    fill_n(block_bits, (block_used + WORD_BITS - 1) / WORD_BITS, 0);
+    fill_n(block_wdf, block_used, 0);
+    fill_n(block_subqs, block_used, 0);
+    block_used = 0;
+    block_start = plist[0].did;
+    Xapian::docid block_last = block_start + (BLOCK_SIZE - 1);
+    if (block_last < block_start) block_last = Xapian::docid(-1);
+    while (n_kids && plist[0].did <= block_last) {
+	PostListAndDocID & top = plist[0];
+	do {
+	    unsigned off = top.did - block_start;
+	    block_bits[off / WORD_BITS] |= block_word_t(1) << (off % WORD_BITS);
+	    block_wdf[off] += top.pl->get_wdf();
+	    block_subqs[off] += top.pl->count_matching_subqs();
+	    if (off >= block_used) block_used = off + 1;
+	    next_handling_prune(top.pl, 0.0, matcher);
+	    if (top.pl->at_end()) break;
+	    top.did = top.pl->get_docid();
+	} while (top.did <= block_last);
+	if (top.pl->at_end()) {
+	    pop_top();
+	} else {
+	    sift_down();
+	}
+    }
+
+    bool found = find_in_block(0);
+    AssertEq(found, true);
+    (void)found;
+    return NULL;
+}
+
+Xapian::termcount
+BoolOrPostList::sum_wdf(size_t i) const
+{
+    // Entries below one which isn't at did in the heap can't be at did.
+    if (i >= n_kids || plist[i].did != did) return 0;
+    return plist[i].pl->get_wdf() + sum_wdf(2 * i + 1) + sum_wdf(2 * i + 2);
+}
+
+Xapian::termcount
+BoolOrPostList::sum_subqs(size_t i) const
+{
+    if (i >= n_kids || plist[i].did != did) return 0;
+    return plist[i].pl->count_matching_subqs() +
+	   sum_subqs(2 * i + 1) + sum_subqs(2 * i + 2);
+}
+
+Xapian::doccount
+BoolOrPostList::get_termfreq_min() const
+{
+    Xapian::doccount result = 0;
+    for (size_t i = 0; i < n_kids; ++i) {
+	result = max(result, plist[i].pl->get_termfreq_min());
+    }
+    return result;
+}
+
+Xapian::doccount
+BoolOrPostList::get_termfreq_max() const
+{
+    // Maximum is if all sub-postlists are disjoint.
+    Xapian::doccount result = 0;
+    for (size_t i = 0; i < n_kids; ++i) {
+	Xapian::doccount tf_max = plist[i].pl->get_termfreq_max();
+	Xapian::doccount old_result = result;
+	result += tf_max;
+	// Catch overflowing the type too.
+	if (result < old_result || result >= db_size)
+	    return db_size;
+    }
+    return result;
+}
+
+Xapian::doccount
+BoolOrPostList::get_termfreq_est() const
+{
+    LOGCALL(MATCH, Xapian::doccount, "BoolOrPostList::get_termfreq_est", NO_ARGS);
+    if (rare(db_size == 0))
+	RETURN(0);
+    // We calculate the estimate assuming independence:
+    // P(a or b or ...) = 1 - (1 - P(a)) . (1 - P(b)) . ...
+    double scale = 1.0 / db_size;
+    double P_none = 1.0;
+    for (size_t i = 0; i < n_kids; ++i) {
+	P_none *= 1.0 - plist[i].pl->get_termfreq_est() * scale;
+    }
+    RETURN(static_cast<Xapian::doccount>((1.0 - P_none) * db_size + 0.5));
+}
+
+TermFreqs
+BoolOrPostList::get_termfreq_est_using_stats(
+	const Xapian::Weight::Internal & stats) const
+{
+    LOGCALL(MATCH, TermFreqs, "BoolOrPostList::get_termfreq_est_using_stats", stats);
+    // We calculate the estimate assuming independence, as for
+    // get_termfreq_est().
+
+    // Our caller should have ensured this.
+    Assert(stats.collection_size);
+    double scale = 1.0 / stats.collection_size;
+    double P_none = 1.0;
+    double Pr_none = 1.0;
+    double Pc_none = 1.0;
+    for (size_t i = 0; i < n_kids; ++i) {
+	TermFreqs freqs(plist[i].pl->get_termfreq_est_using_stats(stats));
+	P_none *= 1.0 - freqs.termfreq * scale;
+	if (stats.total_term_count != 0)
+	    Pc_none *= 1.0 - double(freqs.collfreq) / stats.total_term_count;
+	// If the rset is empty, the relevant termfreq estimate should be 0.
+	if (stats.rset_size != 0)
+	    Pr_none *= 1.0 - double(freqs.reltermfreq) / stats.rset_size;
+    }
+    RETURN(TermFreqs(Xapian::doccount((1.0 - P_none) * stats.collection_size + 0.5),
+		     Xapian::doccount((1.0 - Pr_none) * stats.rset_size + 0.5),
+		     Xapian::termcount((1.0 - Pc_none) * stats.total_term_count + 0.5)));
+}
+
+double
+BoolOrPostList::get_maxweight() const
+{
+    return 0;
+}
+
+Xapian::docid
+BoolOrPostList::get_docid() const
+{
+    return did;
+}
+
+Xapian::termcount
+BoolOrPostList::get_doclength() const
+{
+    Assert(did);
+    if (block_bits)
+	return db->get_doclength(did);
+    return plist[0].pl->get_doclength();
+}
+
+Xapian::termcount
+BoolOrPostList::get_unique_terms() const
+{
+    Assert(did);
+    if (block_bits)
+	return db->get_unique_terms(did);
+    return plist[0].pl->get_unique_terms();
+}
+
+double
+BoolOrPostList::get_weight() const
+{
+    return 0;
+}
+
+bool
+BoolOrPostList::at_end() const
+{
+    return (did == 0);
+}
+
+double
+BoolOrPostList::recalc_maxweight()
+{
+    return 0;
+}
+
+PostList *
+BoolOrPostList::next(double)
+{
+    LOGCALL(MATCH, PostList *, "BoolOrPostList::next", NO_ARGS);
+    if (did == 0) {
+	start(0);
+    } else if (block_bits) {
+	if (find_in_block(did - block_start + 1))
+	    RETURN(NULL);
+    } else {
+	advance(0);
+    }
+    RETURN(next_block());
+}
+
+PostList *
+BoolOrPostList::skip_to(Xapian::docid did_min, double)
+{
+    LOGCALL(MATCH, PostList *, "BoolOrPostList::skip_to", did_min);
+    if (did == 0) {
+	start(did_min);
+	RETURN(next_block());
+    }
+    if (did_min <= did)
+	RETURN(NULL);
+    if (block_bits) {
+	if (did_min - block_start < BLOCK_SIZE &&
+	    find_in_block(did_min - block_start))
+	    RETURN(NULL);
+	// All the sub-postlists are already past the current block, so
+	// advance() will only move on those before did_min.
+    }
+    advance(did_min);
+    RETURN(next_block());
+}
+
+string
+BoolOrPostList::get_description() const
+{
+    string desc("(");
+    for (size_t i = 0; i < n_kids; ++i) {
+	if (i) desc += " OR ";
+	desc += plist[i].pl->get_description();
+    }
+    desc += ')';
+    return desc;
+}
+
+Xapian::termcount
+BoolOrPostList::get_wdf() const
+{
+    if (block_bits)
+	return block_wdf[did - block_start];
+    return sum_wdf(0);
+}
+
+Xapian::termcount
+BoolOrPostList::count_matching_subqs() const
+{
+    if (block_bits)
+	return block_subqs[did - block_start];
+    return sum_subqs(0);
+}
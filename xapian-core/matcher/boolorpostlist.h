@@ -0,0 +1,213 @@
+/** @file boolorpostlist.h
+ * @brief N-way OR postlist for when the weights aren't needed
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_BOOLORPOSTLIST_H
+#define XAPIAN_INCLUDED_BOOLORPOSTLIST_H
+
+#include "backends/database.h"
+#include "api/postlist.h"
+
+#include <cstdint>
+
+class MultiMatch;
+
+/** N-way OR postlist for when the weights aren't needed.
+ *
+ *  This is used for boolean OR, and for the OR under OP_SYNONYM (where
+ *  SynonymPostList supplies the weights).  The sub-postlists are kept in a
+ *  heap ordered by their current docid, so each posting costs O(log n)
+ *  rather than the O(n) of a tree of binary OrPostList objects in the worst
+ *  case.
+ *
+ *  For wide unions (e.g. a wildcard which expands to thousands of terms),
+ *  a range of docids at a time can instead be gathered into a bitmap, with
+ *  the wdf and number of matching subqueries for each docid accumulated
+ *  alongside.  Each sub-postlist is then only touched once per block, which
+ *  is much cheaper when many of the sub-postlists are dense.
+ */
+class BoolOrPostList : public PostList {
+    /// Don't allow assignment.
+    void operator=(const BoolOrPostList &);
+
+    /// Don't allow copying.
+    BoolOrPostList(const BoolOrPostList &);
+
+    /// A sub-postlist and its current docid.
+    struct PostListAndDocID {
+	PostList * pl;
+	Xapian::docid did;
+    };
+
+    /// Type used for the words of the block bitmap.
+    typedef uint64_t block_word_t;
+
+    /// Number of docids covered by each block.
+    static const unsigned BLOCK_SIZE = 2048;
+
+    /// Number of bits in each word of the block bitmap.
+    static const unsigned WORD_BITS = 64;
+
+    /// The current docid, or zero if we haven't started or are at_end.
+    Xapian::docid did;
+
+    /** The number of sub-postlists.
+     *
+     *  In block mode this doesn't include any postings already gathered
+     *  into the current block.
+     */
+    size_t n_kids;
+
+    /** Array of sub-postlists.
+     *
+     *  Once we've started, this is a heap with the entry with the lowest
+     *  docid at the top.
+     */
+    PostListAndDocID * plist;
+
+    /// The number of documents in the database.
+    Xapian::doccount db_size;
+
+    /// Pointer to the matcher object, so we can report pruning.
+    MultiMatch *matcher;
+
+    /** The database, for looking up document lengths in block mode.
+     *
+     *  NULL if we aren't using block mode.
+     */
+    const Xapian::Database::Internal * db;
+
+    /// The first docid in the current block.
+    Xapian::docid block_start;
+
+    /// Bitmap of the docids in the current block, or NULL if not block mode.
+    block_word_t * block_bits;
+
+    /// Sum of the wdfs for each docid in the current block.
+    Xapian::termcount * block_wdf;
+
+    /// Number of matching subqueries for each docid in the current block.
+    Xapian::termcount * block_subqs;
+
+    /// One more than the highest offset used in the current block.
+    unsigned block_used;
+
+    /// Restore the heap property after the top entry's docid increases.
+    void sift_down();
+
+    /// Remove the top entry of the heap (which must be at_end).
+    void pop_top();
+
+    /** Start the sub-postlists off.
+     *
+     *  @param did_min	Skip each sub-postlist to this docid (or just call
+     *			next() if it is 0).
+     */
+    void start(Xapian::docid did_min);
+
+    /** Advance the sub-postlists to after the current docid, or to @a did_min
+     *  if that's later.
+     */
+    void advance(Xapian::docid did_min);
+
+    /** Find the first docid in the current block at or after offset @a off.
+     *
+     *  @return true if one was found (and did has been set to it).
+     */
+    bool find_in_block(unsigned off);
+
+    /** Move on to the next block, or to the next docid if not in block mode.
+     *
+     *  @return A PostList to replace this one with, or NULL.
+     */
+    PostList * next_block();
+
+    /// Sum the wdfs of the sub-postlists in the heap at @a did from entry @a i.
+    Xapian::termcount sum_wdf(size_t i) const;
+
+    /// Count the subqueries in the heap matching @a did from entry @a i.
+    Xapian::termcount sum_subqs(size_t i) const;
+
+  public:
+    /** Construct from 2 random-access iterators to a container of PostList*,
+     *  a pointer to the matcher, the document collection size, and the
+     *  database if block mode should be used (or NULL if not).
+     */
+    template <class RandomItor>
+    BoolOrPostList(RandomItor pl_begin, RandomItor pl_end,
+		   MultiMatch * matcher_, Xapian::doccount db_size_,
+		   const Xapian::Database::Internal * db_ = NULL)
+	: did(0), n_kids(pl_end - pl_begin), plist(NULL),
+	  db_size(db_size_), matcher(matcher_), db(db_),
+	  block_start(0), block_bits(NULL), block_wdf(NULL),
+	  block_subqs(NULL), block_used(0)
+    {
+	plist = new PostListAndDocID[n_kids];
+	for (size_t i = 0; i != n_kids; ++i) {
+	    plist[i].pl = pl_begin[i];
+	    plist[i].did = 0;
+	}
+    }
+
+    ~BoolOrPostList();
+
+    Xapian::doccount get_termfreq_min() const;
+
+    Xapian::doccount get_termfreq_max() const;
+
+    Xapian::doccount get_termfreq_est() const;
+
+    TermFreqs get_termfreq_est_using_stats(
+	const Xapian::Weight::Internal & stats) const;
+
+    double get_maxweight() const;
+
+    Xapian::docid get_docid() const;
+
+    Xapian::termcount get_doclength() const;
+
+    Xapian::termcount get_unique_terms() const;
+
+    double get_weight() const;
+
+    bool at_end() const;
+
+    double recalc_maxweight();
+
+    PositionList * read_position_list() {
+	return NULL;
+    }
+
+    Internal *next(double w_min);
+
+    Internal *skip_to(Xapian::docid, double w_min);
+
+    std::string get_description() const;
+
+    /** get_wdf() for BoolOrPostlists returns the sum of the wdfs of the
+     *  sub postlists which match the current docid.
+     *
+     *  The wdf isn't really meaningful in many situations, but if the lists
+     *  are being combined as a synonym we want the sum of the wdfs, so we do
+     *  that in general.
+     */
+    Xapian::termcount get_wdf() const;
+
+    Xapian::termcount count_matching_subqs() const;
+};
+
+#endif // XAPIAN_INCLUDED_BOOLORPOSTLIST_H
@@ -170,6 +170,12 @@ ConstDatabaseWrapper::get_spelling_frequency(const string & word) const
     return realdb->get_spelling_frequency(word);
 }
 
+TermList *
+ConstDatabaseWrapper::open_substring_termlist(const string & substring) const
+{
+    return realdb->open_substring_termlist(substring);
+}
+
 TermList *
 ConstDatabaseWrapper::open_synonym_termlist(const string & term) const
 {
@@ -218,6 +224,12 @@ ConstDatabaseWrapper::get_uuid() const
     return realdb->get_uuid();
 }
 
+bool
+ConstDatabaseWrapper::changesets_available(const string & start_revision) const
+{
+    return realdb->changesets_available(start_revision);
+}
+
 void
 ConstDatabaseWrapper::invalidate_doc_object(Xapian::Document::Internal * obj) const
 {
@@ -339,7 +351,8 @@ ConstDatabaseWrapper::replace_document(const string &,
 
 void
 ConstDatabaseWrapper::write_changesets_to_fd(int, const std::string &, bool,
-					     Xapian::ReplicationInfo *)
+					     Xapian::ReplicationInfo *,
+					     const std::string &)
 {
     nonconst_access();
 }
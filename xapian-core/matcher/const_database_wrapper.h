@@ -83,6 +83,7 @@ class ConstDatabaseWrapper : public Xapian::Database::Internal {
     TermList * open_spelling_termlist(const string & word) const;
     TermList * open_spelling_wordlist() const;
     Xapian::doccount get_spelling_frequency(const string & word) const;
+    TermList * open_substring_termlist(const string & substring) const;
     TermList * open_synonym_termlist(const string & term) const;
     TermList * open_synonym_keylist(const string & prefix) const;
     string get_metadata(const string & key) const;
@@ -91,6 +92,7 @@ class ConstDatabaseWrapper : public Xapian::Database::Internal {
     Xapian::Document::Internal * collect_document(Xapian::docid did) const;
     string get_revision_info() const;
     string get_uuid() const;
+    bool changesets_available(const std::string & start_revision) const;
     void invalidate_doc_object(Xapian::Document::Internal * obj) const;
     int get_backend_info(std::string * path) const { return realdb->get_backend_info(path); }
 
@@ -114,7 +116,8 @@ class ConstDatabaseWrapper : public Xapian::Database::Internal {
     void replace_document(Xapian::docid, const Xapian::Document &);
     Xapian::docid replace_document(const string &, const Xapian::Document &);
     void write_changesets_to_fd(int, const std::string &, bool,
-				Xapian::ReplicationInfo *);
+				Xapian::ReplicationInfo *,
+				const std::string &);
 };
 
 #endif /* XAPIAN_INCLUDED_CONST_DATABASE_WRAPPER_H */
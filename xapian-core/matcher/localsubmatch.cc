@@ -28,6 +28,7 @@
 #include "api/emptypostlist.h"
 #include "extraweightpostlist.h"
 #include "api/leafpostlist.h"
+#include "multimatch.h"
 #include "omassert.h"
 #include "queryoptimiser.h"
 #include "synonympostlist.h"
@@ -284,6 +285,8 @@ LocalSubMatch::open_post_list(const string& term,
 	qopt->set_hint_postlist(pl);
     }
 
+    if (qopt->matcher) pl->set_profile(qopt->matcher->get_profile());
+
     if (lazy_weight) {
 	// Term came from a wildcard, but we may already have that term in the
 	// query anyway, so check before accumulating its TermFreqs.
@@ -261,6 +261,17 @@ class MultipleMatchSpy : public Xapian::MatchSpy {
     void operator()(const Xapian::Document &doc, double wt);
 };
 
+/// Call pl->get_weight(), adding the time taken to profile if non-NULL.
+static inline double
+get_weight(const PostList * pl, Xapian::MatchProfile::Internal * profile)
+{
+    if (usual(!profile)) return pl->get_weight();
+    double start = RealTime::now();
+    double wt = pl->get_weight();
+    profile->weight_time += RealTime::now() - start;
+    return wt;
+}
+
 void 
 MultipleMatchSpy::operator()(const Xapian::Document &doc, double wt) {
     LOGCALL_VOID(MATCH, "MultipleMatchSpy::operator()", doc | wt);
@@ -287,7 +298,8 @@ MultiMatch::MultiMatch(const Xapian::Database &db_,
 		       Xapian::Weight::Internal & stats,
 		       const Xapian::Weight * weight_,
 		       const vector<Xapian::Internal::opt_intrusive_ptr<Xapian::MatchSpy>> & matchspies_,
-		       bool have_sorter, bool have_mdecider)
+		       bool have_sorter, bool have_mdecider,
+		       Xapian::MatchProfile::Internal * profile_)
 	: db(db_), query(query_),
 	  collapse_max(collapse_max_), collapse_key(collapse_key_),
 	  percent_cutoff(percent_cutoff_), weight_cutoff(weight_cutoff_),
@@ -297,12 +309,15 @@ MultiMatch::MultiMatch(const Xapian::Database &db_,
 	  time_limit(time_limit_),
 	  weight(weight_),
 	  is_remote(db.internal.size()),
-	  matchspies(matchspies_)
+	  matchspies(matchspies_),
+	  profile(profile_)
 {
-    LOGCALL_CTOR(MATCH, "MultiMatch", db_ | query_ | qlen | omrset | collapse_max_ | collapse_key_ | percent_cutoff_ | weight_cutoff_ | int(order_) | sort_key_ | int(sort_by_) | sort_value_forward_ | time_limit_| stats | weight_ | matchspies_ | have_sorter | have_mdecider);
+    LOGCALL_CTOR(MATCH, "MultiMatch", db_ | query_ | qlen | omrset | collapse_max_ | collapse_key_ | percent_cutoff_ | weight_cutoff_ | int(order_) | sort_key_ | int(sort_by_) | sort_value_forward_ | time_limit_| stats | weight_ | matchspies_ | have_sorter | have_mdecider | profile_);
 
     if (query.empty()) return;
 
+    double start_time = profile ? RealTime::now() : 0.0;
+
     Xapian::doccount number_of_subdbs = db.internal.size();
     vector<Xapian::RSet> subrsets;
     split_rset_by_db(omrset, number_of_subdbs, subrsets);
@@ -349,6 +364,8 @@ MultiMatch::MultiMatch(const Xapian::Database &db_,
     stats.set_query(query);
     prepare_sub_matches(leaves, stats);
     stats.set_bounds_from_db(db);
+
+    if (profile) profile->build_time += RealTime::now() - start_time;
 }
 
 double
@@ -402,6 +419,8 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
     }
 #endif
 
+    double start_time = profile ? RealTime::now() : 0.0;
+
     // Start matchers.
     for (auto && leaf : leaves) {
 	leaf->start_match(0, first + maxitems, first + check_at_least, stats);
@@ -460,6 +479,13 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
     LOGLINE(MATCH, "pl = (" << pl->get_description() << ")");
     recalculate_w_max = false;
 
+    if (profile) {
+	profile->postlist_tree = pl->get_description();
+	double now = RealTime::now();
+	profile->build_time += now - start_time;
+	start_time = now;
+    }
+
     Xapian::doccount matches_upper_bound = pl->get_termfreq_max();
     Xapian::doccount matches_lower_bound = 0;
     Xapian::doccount matches_estimated   = pl->get_termfreq_est();
@@ -553,6 +579,9 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
     // Is the mset a valid heap?
     bool is_heap = false;
 
+    // Number of candidate documents we've looked at.
+    Xapian::doccount candidates = 0;
+
     while (true) {
 	bool pushback;
 
@@ -586,6 +615,7 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 	    LOGLINE(MATCH, "Reached end of potential matches");
 	    break;
 	}
+	++candidates;
 
 	// Only calculate the weight if we need it for mcmp, or there's a
 	// percentage or weight cutoff in effect.  Otherwise we calculate it
@@ -593,7 +623,7 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 	double wt = 0.0;
 	bool calculated_weight = false;
 	if (sort_by != VAL || min_weight > 0.0) {
-	    wt = pl->get_weight();
+	    wt = get_weight(pl.get(), profile);
 	    if (wt < min_weight) {
 		LOGLINE(MATCH, "Rejecting potential match due to insufficient weight");
 		continue;
@@ -629,7 +659,7 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 		    // processing needed.
 		    LOGLINE(MATCH, "Making note of match item which sorts lower than min_item");
 		    ++docs_matched;
-		    if (!calculated_weight) wt = pl->get_weight();
+		    if (!calculated_weight) wt = get_weight(pl.get(), profile);
 		    if (matchspy) {
 			matchspy->operator()(doc, wt);
 		    }
@@ -640,7 +670,7 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 		    // We've seen enough items - we can drop this one.
 		    LOGLINE(MATCH, "Dropping candidate which sorts lower than min_item");
 		    // FIXME: hmm, match decider might have rejected this...
-		    if (!calculated_weight) wt = pl->get_weight();
+		    if (!calculated_weight) wt = get_weight(pl.get(), profile);
 		    if (wt > greatest_wt) goto new_greatest_weight;
 		    continue;
 		}
@@ -666,7 +696,7 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 		}
 		if (matchspy) {
 		    if (!calculated_weight) {
-			wt = pl->get_weight();
+			wt = get_weight(pl.get(), profile);
 			new_item.wt = wt;
 			calculated_weight = true;
 		    }
@@ -677,7 +707,7 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 
 	if (!calculated_weight) {
 	    // we didn't calculate the weight above, but now we will need it
-	    wt = pl->get_weight();
+	    wt = get_weight(pl.get(), profile);
 	    new_item.wt = wt;
 	}
 
@@ -686,7 +716,13 @@ MultiMatch::get_mset(Xapian::doccount first, Xapian::doccount maxitems,
 	// Perform collapsing on key if requested.
 	if (collapser) {
 	    collapse_result res;
-	    res = collapser.process(new_item, pl.get(), vsdoc, mcmp);
+	    if (rare(profile)) {
+		double collapse_start = RealTime::now();
+		res = collapser.process(new_item, pl.get(), vsdoc, mcmp);
+		profile->collapse_time += RealTime::now() - collapse_start;
+	    } else {
+		res = collapser.process(new_item, pl.get(), vsdoc, mcmp);
+	    }
 	    if (res == REJECTED) {
 		// If we're sorting by relevance primarily, then we throw away
 		// the lower weighted document anyway.
@@ -846,6 +882,11 @@ new_greatest_weight:
     // done with posting list tree
     pl.reset(NULL);
 
+    if (profile) {
+	profile->docs_considered += candidates;
+	profile->match_time += RealTime::now() - start_time;
+    }
+
     double percent_scale = 0;
     if (!items.empty() && greatest_wt > 0) {
 #ifdef XAPIAN_HAS_REMOTE_BACKEND
@@ -1059,6 +1100,8 @@ new_greatest_weight:
 
     LOGLINE(MATCH, items.size() << " items in potential mset");
 
+    if (profile) start_time = RealTime::now();
+
     if (first > 0) {
 	// Remove unwanted leading entries
 	if (items.size() <= first) {
@@ -1082,6 +1125,8 @@ new_greatest_weight:
     // Need a stable sort, but this is provided by comparison operator
     sort(items.begin(), items.end(), mcmp);
 
+    if (profile) profile->sort_time += RealTime::now() - start_time;
+
     if (!items.empty()) {
 	LOGLINE(MATCH, "min weight in mset = " << items.back().wt);
 	LOGLINE(MATCH, "max weight in mset = " << items[0].wt);
@@ -25,6 +25,7 @@
 #define OM_HGUARD_MULTIMATCH_H
 
 #include "submatch.h"
+#include "api/matchprofileinternal.h"
 
 #include <vector>
 
@@ -73,6 +74,9 @@ class MultiMatch
 	/// The matchspies to use.
 	const vector<Xapian::Internal::opt_intrusive_ptr<Xapian::MatchSpy>> & matchspies;
 
+	/// The profile to fill in, or NULL if not profiling.
+	Xapian::MatchProfile::Internal * profile;
+
 	/** get the maxweight that the postlist pl may return, calling
 	 *  recalc_maxweight if recalculate_w_max is set, and unsetting it.
 	 *  Must only be called on the top of the postlist tree.
@@ -99,6 +103,7 @@ class MultiMatch
 	 *  @param matchspies_ Any the MatchSpy objects in use.
 	 *  @param have_sorter Is there a sorter in use?
 	 *  @param have_mdecider Is there a Xapian::MatchDecider in use?
+	 *  @param profile_  The profile to fill in (or NULL for no profiling)
 	 */
 	MultiMatch(const Xapian::Database &db_,
 		   const Xapian::Query & query,
@@ -116,7 +121,8 @@ class MultiMatch
 		   Xapian::Weight::Internal & stats,
 		   const Xapian::Weight *wtscheme,
 		   const vector<Xapian::Internal::opt_intrusive_ptr<Xapian::MatchSpy>> & matchspies_,
-		   bool have_sorter, bool have_mdecider);
+		   bool have_sorter, bool have_mdecider,
+		   Xapian::MatchProfile::Internal * profile_ = NULL);
 
 	/** Run the match and generate an MSet object.
 	 *
@@ -136,6 +142,11 @@ class MultiMatch
 	void recalc_maxweight() {
 	    recalculate_w_max = true;
 	}
+
+	/// Return the profile to fill in, or NULL if not profiling.
+	Xapian::MatchProfile::Internal * get_profile() const {
+	    return profile;
+	}
 };
 
 #endif /* OM_HGUARD_MULTIMATCH_H */
@@ -82,7 +82,8 @@ class ProgClient : public RemoteDatabase {
      *  @param args	Any arguments to the program.
      *  @param timeout	Timeout for communication (in seconds).
      *  @param writable	Is this a WritableDatabase?
-     *  @param flags	Xapian::DB_RETRY_LOCK or 0.
+     *  @param flags	Bitwise-or of Xapian::DB_RETRY_LOCK and/or
+     *			Xapian::DB_PIPELINE_WRITES, or 0.
      */
     ProgClient(const std::string &progname,
 	       const std::string &arg,
@@ -33,6 +33,7 @@
 #include <climits>
 #include <string>
 
+#include "compression_stream.h"
 #include "debuglog.h"
 #include "fd.h"
 #include "filetests.h"
@@ -47,6 +48,23 @@ using namespace std;
 
 #define CHUNKSIZE 4096
 
+/// Flag set in the type code of a compressed message.
+#define COMPRESSED_FLAG 0x80
+
+/** Size of the parts of compressed data from send_file().
+ *
+ *  Each part is sent as a message, so this should be large enough that the
+ *  message headers aren't a significant overhead.
+ */
+#define COMPRESSED_PART_SIZE 65536
+
+XAPIAN_NORETURN(static void throw_bad_compressed_message());
+static void
+throw_bad_compressed_message()
+{
+    throw Xapian::NetworkError("Bad compressed message received");
+}
+
 XAPIAN_NORETURN(static void throw_database_closed());
 static void
 throw_database_closed()
@@ -73,7 +91,9 @@ update_overlapped_offset(WSAOVERLAPPED & overlapped, DWORD n)
 
 RemoteConnection::RemoteConnection(int fdin_, int fdout_,
 				   const string & context_)
-    : fdin(fdin_), fdout(fdout_), context(context_)
+    : fdin(fdin_), fdout(fdout_), chunked_data_left(0),
+      chunked_compressed(false), chunked_more(false), chunked_type(0),
+      compress_min(0), comp_stream(NULL), context(context_)
 {
 #ifdef __WIN32__
     memset(&overlapped, 0, sizeof(overlapped));
@@ -85,13 +105,25 @@ RemoteConnection::RemoteConnection(int fdin_, int fdout_,
 #endif
 }
 
-#ifdef __WIN32__
 RemoteConnection::~RemoteConnection()
 {
+#ifdef __WIN32__
     if (overlapped.hEvent)
 	CloseHandle(overlapped.hEvent);
-}
 #endif
+    delete comp_stream;
+}
+
+CompressionStream &
+RemoteConnection::get_comp_stream()
+{
+    if (!comp_stream) {
+	// Compressing messages as they're sent needs to be fast to be a win, so
+	// use the fastest compression level.
+	comp_stream = new CompressionStream(Z_DEFAULT_STRATEGY, Z_BEST_SPEED);
+    }
+    return *comp_stream;
+}
 
 bool
 RemoteConnection::read_at_least(size_t min_len, double end_time)
@@ -221,6 +253,27 @@ RemoteConnection::send_message(char type, const string &message,
 			       double end_time)
 {
     LOGCALL_VOID(REMOTE, "RemoteConnection::send_message", type | message | end_time);
+    if (compress_min && message.size() >= compress_min) {
+	size_t size = message.size();
+	const char * p = get_comp_stream().compress(message.data(), &size);
+	if (p) {
+	    // The message data is a flag byte saying this is the only part,
+	    // then the compressed data.  compress() only succeeds if it saves
+	    // at least a byte, so this is never longer than the original.
+	    string compressed(1, '\0');
+	    compressed.append(p, size);
+	    send_raw_message(char(type | COMPRESSED_FLAG), compressed, end_time);
+	    return;
+	}
+    }
+    send_raw_message(type, message, end_time);
+}
+
+void
+RemoteConnection::send_raw_message(char type, const string &message,
+				   double end_time)
+{
+    LOGCALL_VOID(REMOTE, "RemoteConnection::send_raw_message", type | message | end_time);
     if (fdout == -1)
 	throw_database_closed();
 
@@ -339,6 +392,35 @@ RemoteConnection::send_file(char type, int fd, double end_time)
     // FIXME: Use sendfile() or similar if available?
 
     char buf[CHUNKSIZE];
+
+    if (compress_min && size >= off_t(compress_min)) {
+	// We don't know how large the compressed data will be until we've
+	// compressed it all, so send it as a series of messages, each starting
+	// with a flag byte which says if more parts follow.
+	CompressionStream & comp = get_comp_stream();
+	comp.compress_start();
+	char compressed_type = char(type | COMPRESSED_FLAG);
+	string part(1, '\1');
+	while (true) {
+	    ssize_t res;
+	    do {
+		res = read(fd, buf, sizeof(buf));
+	    } while (res < 0 && errno == EINTR);
+	    if (res < 0) throw Xapian::NetworkError("read failed", errno);
+	    size -= res;
+	    bool finish = (size <= 0 || res == 0);
+	    comp.compress_chunk(buf, size_t(res), finish, part);
+	    if (finish) {
+		part[0] = '\0';
+		send_raw_message(compressed_type, part, end_time);
+		return;
+	    }
+	    if (part.size() >= COMPRESSED_PART_SIZE) {
+		send_raw_message(compressed_type, part, end_time);
+		part.resize(1);
+	    }
+	}
+    }
     buf[0] = type;
     size_t c = 1;
     {
@@ -468,7 +550,7 @@ RemoteConnection::sniff_next_message_type(double end_time)
 
     if (!read_at_least(1, end_time))
 	RETURN(-1);
-    unsigned char type = buffer[0];
+    unsigned char type = buffer[0] & ~COMPRESSED_FLAG;
     RETURN(type);
 }
 
@@ -476,6 +558,39 @@ int
 RemoteConnection::get_message(string &result, double end_time)
 {
     LOGCALL(REMOTE, int, "RemoteConnection::get_message", result | end_time);
+    int type = get_raw_message(result, end_time);
+    if (type < 0 || !(type & COMPRESSED_FLAG))
+	RETURN(type);
+
+    string compressed;
+    swap(compressed, result);
+    result.resize(0);
+    CompressionStream & comp = get_comp_stream();
+    comp.decompress_start();
+    while (true) {
+	if (compressed.empty())
+	    throw_bad_compressed_message();
+	bool more = (compressed[0] != '\0');
+	bool done = comp.decompress_chunk(compressed.data() + 1,
+					  int(compressed.size() - 1), result);
+	if (!more) {
+	    if (!done)
+		throw_bad_compressed_message();
+	    break;
+	}
+	int part_type = get_raw_message(compressed, end_time);
+	if (part_type < 0)
+	    RETURN(-1);
+	if (part_type != type)
+	    throw_bad_compressed_message();
+    }
+    RETURN(type & ~COMPRESSED_FLAG);
+}
+
+int
+RemoteConnection::get_raw_message(string &result, double end_time)
+{
+    LOGCALL(REMOTE, int, "RemoteConnection::get_raw_message", result | end_time);
     if (fdin == -1)
 	throw_database_closed();
 
@@ -517,6 +632,35 @@ int
 RemoteConnection::get_message_chunked(double end_time)
 {
     LOGCALL(REMOTE, int, "RemoteConnection::get_message_chunked", end_time);
+    int type = get_message_header(end_time);
+    chunked_compressed = (type >= 0 && (type & COMPRESSED_FLAG));
+    if (!chunked_compressed)
+	RETURN(type);
+
+    chunked_type = type;
+    if (!start_compressed_part(end_time))
+	RETURN(-1);
+    get_comp_stream().decompress_start();
+    RETURN(type & ~COMPRESSED_FLAG);
+}
+
+bool
+RemoteConnection::start_compressed_part(double end_time)
+{
+    if (chunked_data_left == 0)
+	throw_bad_compressed_message();
+    if (!read_at_least(1, end_time))
+	return false;
+    chunked_more = (buffer[0] != '\0');
+    buffer.erase(0, 1);
+    --chunked_data_left;
+    return true;
+}
+
+int
+RemoteConnection::get_message_header(double end_time)
+{
+    LOGCALL(REMOTE, int, "RemoteConnection::get_message_header", end_time);
     typedef UNSIGNED_OFF_T uoff_t;
 
     if (fdin == -1)
@@ -527,7 +671,7 @@ RemoteConnection::get_message_chunked(double end_time)
     uoff_t len = static_cast<unsigned char>(buffer[1]);
     if (len != 0xff) {
 	chunked_data_left = len;
-	char type = buffer[0];
+	unsigned char type = buffer[0];
 	buffer.erase(0, 2);
 	RETURN(type);
     }
@@ -587,6 +731,33 @@ RemoteConnection::get_message_chunk(string &result, size_t at_least,
 	throw_database_closed();
 
     if (at_least <= result.size()) RETURN(true);
+
+    if (chunked_compressed) {
+	CompressionStream & comp = get_comp_stream();
+	while (result.size() < at_least) {
+	    if (chunked_data_left == 0) {
+		if (!chunked_more)
+		    RETURN(0);
+		// Move on to the next part of the message.
+		int type = get_message_header(end_time);
+		if (type < 0)
+		    RETURN(-1);
+		if (type != chunked_type)
+		    throw_bad_compressed_message();
+		if (!start_compressed_part(end_time))
+		    RETURN(-1);
+		continue;
+	    }
+	    if (!read_at_least(1, end_time))
+		RETURN(-1);
+	    size_t n = min(off_t(buffer.size()), chunked_data_left);
+	    comp.decompress_chunk(buffer.data(), int(n), result);
+	    buffer.erase(0, n);
+	    chunked_data_left -= n;
+	}
+	RETURN(1);
+    }
+
     at_least -= result.size();
 
     bool read_enough = (off_t(at_least) <= chunked_data_left);
@@ -631,6 +802,18 @@ RemoteConnection::receive_file(const string &file, double end_time)
 	throw Xapian::NetworkError("Couldn't open file for writing: " + file, errno);
 
     int type = get_message_chunked(end_time);
+    if (chunked_compressed) {
+	string buf;
+	int res;
+	do {
+	    res = get_message_chunk(buf, CHUNKSIZE, end_time);
+	    if (res < 0)
+		RETURN(-1);
+	    write_all(fd, buf.data(), buf.size());
+	    buf.resize(0);
+	} while (res > 0);
+	RETURN(type);
+    }
     do {
 	off_t min_read = min(chunked_data_left, off_t(CHUNKSIZE));
 	if (!read_at_least(min_read, end_time))
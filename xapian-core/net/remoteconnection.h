@@ -110,6 +110,8 @@ inline int socket_errno() {
 # define CLOSESOCKET(S) close(S)
 #endif
 
+class CompressionStream;
+
 inline int eai_to_xapian(int e) {
     // Under WIN32, the EAI_* constants are defined to be WSA_* constants with
     // roughly equivalent meanings, so we can just let them be handled as any
@@ -159,12 +161,24 @@ inline int eai_to_xapian(int e) {
     return e;
 }
 
+/** The default size at or above which to try compressing messages.
+ *
+ *  Smaller messages usually don't compress well enough to be worth the CPU
+ *  time.
+ */
+const size_t DEFAULT_COMPRESS_MIN = 4096;
+
 /** A RemoteConnection object provides a bidirectional connection to another
  *  RemoteConnection object on a remote machine.
  *
  *  The connection is implemented using a pair of file descriptors.  Messages
  *  with a single byte type code and arbitrary data as the contents can be
  *  sent and received.
+ *
+ *  Messages may be sent compressed, which is flagged by setting the top bit
+ *  of the type code.  Compressed messages are always decompressed on receipt,
+ *  but are only sent once set_compress_min() has been called, so the caller
+ *  needs to first check that the other end supports them.
  */
 class RemoteConnection {
     /// Don't allow assignment.
@@ -194,6 +208,35 @@ class RemoteConnection {
     /// Remaining bytes of message data still to come over fdin for a chunked read.
     off_t chunked_data_left;
 
+    /// Is the message being read in chunks compressed?
+    bool chunked_compressed;
+
+    /** Are there more parts of the compressed message being read in chunks?
+     *
+     *  A compressed message sent by send_file() is split into several parts,
+     *  each sent as a message, so we don't need to know the compressed size
+     *  in advance.
+     */
+    bool chunked_more;
+
+    /// The type code (including the compressed flag) of a chunked read.
+    unsigned char chunked_type;
+
+    /** Size at or above which we compress messages we send.
+     *
+     *  If 0, we don't compress them.
+     */
+    size_t compress_min;
+
+    /** Zlib state for compressing and decompressing messages.
+     *
+     *  NULL until we first need it.
+     */
+    CompressionStream * comp_stream;
+
+    /// Get comp_stream, allocating it if necessary.
+    CompressionStream & get_comp_stream();
+
     /** Read until there are at least min_len bytes in buffer.
      *
      *  If for some reason this isn't possible, returns false upon EOF and
@@ -208,6 +251,31 @@ class RemoteConnection {
      */
     bool read_at_least(size_t min_len, double end_time);
 
+    /** Read one message from fdin without decompressing it.
+     *
+     *  @return	Message type code (including any compressed flag) or -1 for
+     *		EOF.
+     */
+    int get_raw_message(std::string &result, double end_time);
+
+    /** Read the header of a message from fdin.
+     *
+     *  Sets chunked_data_left to the length of the message data.
+     *
+     *  @return	Message type code (including any compressed flag) or -1 for
+     *		EOF.
+     */
+    int get_message_header(double end_time);
+
+    /** Read the flag byte at the start of a part of a compressed message.
+     *
+     *  @return false on EOF, otherwise true.
+     */
+    bool start_compressed_part(double end_time);
+
+    /// Send a message without compressing it.
+    void send_raw_message(char type, const std::string & s, double end_time);
+
 #ifdef __WIN32__
     /** On Windows we use overlapped IO.  We share an overlapped structure
      *  for both reading and writing, as we know that we always wait for
@@ -235,10 +303,18 @@ class RemoteConnection {
     RemoteConnection(int fdin_, int fdout_,
 		     const std::string & context_ = std::string());
 
-#ifdef __WIN32__
     /// Destructor
     ~RemoteConnection();
-#endif
+
+    /** Compress messages we send if they're at least @a min_size bytes.
+     *
+     *  The other end must support compressed messages.  By default, messages
+     *  aren't compressed.
+     *
+     *  @param min_size	Size at or above which to try compressing messages,
+     *			or 0 to disable compression.
+     */
+    void set_compress_min(size_t min_size) { compress_min = min_size; }
 
     /** See if there is data available to read.
      *
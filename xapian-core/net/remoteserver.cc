@@ -57,12 +57,20 @@ throw_read_only()
 /// Class to throw when we receive the connection closing message.
 struct ConnectionClosed { };
 
+/** Size at which to send a batch of items in a list.
+ *
+ *  Sending each item of a postlist or termlist as a separate message means
+ *  a couple of system calls per item, which dominates the time taken to
+ *  send a long list, so we batch up items into messages of about this size.
+ */
+static const size_t LIST_BATCH_SIZE = 8192;
+
 RemoteServer::RemoteServer(const std::vector<std::string> &dbpaths,
 			   int fdin_, int fdout_,
 			   double active_timeout_, double idle_timeout_,
 			   bool writable_)
     : RemoteConnection(fdin_, fdout_, std::string()),
-      db(NULL), wdb(NULL), writable(writable_),
+      db(NULL), wdb(NULL), writable(writable_), pipelined(false),
       active_timeout(active_timeout_), idle_timeout(idle_timeout_)
 {
     // Catch errors opening the database and propagate them to the client.
@@ -192,6 +200,7 @@ RemoteServer::run()
 		&RemoteServer::msg_openmetadatakeylist,
 		&RemoteServer::msg_freqs,
 		&RemoteServer::msg_uniqueterms,
+		&RemoteServer::msg_compress,
 	    };
 
 	    string message;
@@ -201,6 +210,34 @@ RemoteServer::run()
 		errmsg += str(type);
 		throw Xapian::InvalidArgumentError(errmsg);
 	    }
+	    if (pipelined) {
+		switch (type) {
+		    case MSG_REPLACEDOCUMENT:
+		    case MSG_REPLACEDOCUMENTTERM:
+		    case MSG_DELETEDOCUMENT:
+		    case MSG_DELETEDOCUMENTTERM:
+			// The client isn't waiting for a reply to these, so
+			// keep the first error to report when it next asks,
+			// and discard any further changes until then.
+			if (pipeline_error.empty()) {
+			    try {
+				(this->*(dispatch[type]))(message);
+			    } catch (const Xapian::NetworkError &) {
+				throw;
+			    } catch (const Xapian::Error &e) {
+				pipeline_error = serialise_error(e);
+			    }
+			}
+			continue;
+		}
+		if (!pipeline_error.empty()) {
+		    // Report the error instead of acting on this message.
+		    string error;
+		    error.swap(pipeline_error);
+		    send_message(REPLY_EXCEPTION, error);
+		    continue;
+		}
+	    }
 	    (this->*(dispatch[type]))(message);
 	} catch (const Xapian::NetworkTimeoutError & e) {
 	    try {
@@ -249,12 +286,18 @@ RemoteServer::msg_allterms(const string &message)
 	    prev.resize(255);
 	const string & v = *t;
 	size_t reuse = common_prefix_length(prev, v);
-	reply = encode_length(t.get_termfreq());
+	reply += encode_length(t.get_termfreq());
 	reply.append(1, char(reuse));
+	reply += encode_length(v.size() - reuse);
 	reply.append(v, reuse, string::npos);
-	send_message(REPLY_ALLTERMS, reply);
+	if (reply.size() >= LIST_BATCH_SIZE) {
+	    send_message(REPLY_ALLTERMS, reply);
+	    reply.resize(0);
+	}
 	prev = v;
     }
+    if (!reply.empty())
+	send_message(REPLY_ALLTERMS, reply);
 
     send_message(REPLY_DONE, string());
 }
@@ -269,19 +312,26 @@ RemoteServer::msg_termlist(const string &message)
 
     send_message(REPLY_DOCLENGTH, encode_length(db->get_doclength(did)));
     string prev;
+    string reply;
     const Xapian::TermIterator end = db->termlist_end(did);
     for (Xapian::TermIterator t = db->termlist_begin(did); t != end; ++t) {
 	if (rare(prev.size() > 255))
 	    prev.resize(255);
 	const string & v = *t;
 	size_t reuse = common_prefix_length(prev, v);
-	string reply = encode_length(t.get_wdf());
+	reply += encode_length(t.get_wdf());
 	reply += encode_length(t.get_termfreq());
 	reply.append(1, char(reuse));
+	reply += encode_length(v.size() - reuse);
 	reply.append(v, reuse, string::npos);
-	send_message(REPLY_TERMLIST, reply);
+	if (reply.size() >= LIST_BATCH_SIZE) {
+	    send_message(REPLY_TERMLIST, reply);
+	    reply.resize(0);
+	}
 	prev = v;
     }
+    if (!reply.empty())
+	send_message(REPLY_TERMLIST, reply);
 
     send_message(REPLY_DONE, string());
 }
@@ -296,13 +346,20 @@ RemoteServer::msg_positionlist(const string &message)
     string term(p, p_end - p);
 
     Xapian::termpos lastpos = static_cast<Xapian::termpos>(-1);
+    string reply;
     const Xapian::PositionIterator end = db->positionlist_end(did, term);
     for (Xapian::PositionIterator i = db->positionlist_begin(did, term);
 	 i != end; ++i) {
 	Xapian::termpos pos = *i;
-	send_message(REPLY_POSITIONLIST, encode_length(pos - lastpos - 1));
+	reply += encode_length(pos - lastpos - 1);
+	if (reply.size() >= LIST_BATCH_SIZE) {
+	    send_message(REPLY_POSITIONLIST, reply);
+	    reply.resize(0);
+	}
 	lastpos = pos;
     }
+    if (!reply.empty())
+	send_message(REPLY_POSITIONLIST, reply);
 
     send_message(REPLY_DONE, string());
 }
@@ -317,17 +374,22 @@ RemoteServer::msg_postlist(const string &message)
     send_message(REPLY_POSTLISTSTART, encode_length(termfreq) + encode_length(collfreq));
 
     Xapian::docid lastdocid = 0;
+    string reply;
     const Xapian::PostingIterator end = db->postlist_end(term);
     for (Xapian::PostingIterator i = db->postlist_begin(term);
 	 i != end; ++i) {
 
 	Xapian::docid newdocid = *i;
-	string reply = encode_length(newdocid - lastdocid - 1);
+	reply += encode_length(newdocid - lastdocid - 1);
 	reply += encode_length(i.get_wdf());
-
-	send_message(REPLY_POSTLISTITEM, reply);
+	if (reply.size() >= LIST_BATCH_SIZE) {
+	    send_message(REPLY_POSTLISTITEM, reply);
+	    reply.resize(0);
+	}
 	lastdocid = newdocid;
     }
+    if (!reply.empty())
+	send_message(REPLY_POSTLISTITEM, reply);
 
     send_message(REPLY_DONE, string());
 }
@@ -344,6 +406,8 @@ RemoteServer::msg_writeaccess(const string & msg)
     if (p != p_end) {
 	unsigned flag_bits;
 	decode_length(&p, p_end, flag_bits);
+	pipelined = (flag_bits & Xapian::DB_PIPELINE_WRITES);
+	flag_bits &= ~Xapian::DB_PIPELINE_WRITES;
 	flags |= flag_bits &~ Xapian::DB_ACTION_MASK_;
 	if (p != p_end) {
 	    throw Xapian::NetworkError("Junk at end of MSG_WRITEACCESS");
@@ -621,6 +685,19 @@ RemoteServer::msg_uniqueterms(const string &message)
     send_message(REPLY_UNIQUETERMS, encode_length(db->get_unique_terms(did)));
 }
 
+void
+RemoteServer::msg_compress(const string &message)
+{
+    const char *p = message.data();
+    const char *p_end = p + message.size();
+    size_t min_size;
+    decode_length(&p, p_end, min_size);
+    if (p != p_end) {
+	throw Xapian::NetworkError("Junk at end of MSG_COMPRESS");
+    }
+    set_compress_min(min_size);
+}
+
 void
 RemoteServer::msg_commit(const string &)
 {
@@ -668,7 +745,8 @@ RemoteServer::msg_deletedocument(const string & message)
 
     wdb->delete_document(did);
 
-    send_message(REPLY_DONE, string());
+    if (!pipelined)
+	send_message(REPLY_DONE, string());
 }
 
 void
@@ -709,7 +787,8 @@ RemoteServer::msg_replacedocumentterm(const string & message)
 
     Xapian::docid did = wdb->replace_document(unique_term, unserialise_document(string(p, p_end)));
 
-    send_message(REPLY_ADDDOCUMENT, encode_length(did));
+    if (!pipelined)
+	send_message(REPLY_ADDDOCUMENT, encode_length(did));
 }
 
 void
@@ -52,6 +52,19 @@ class XAPIAN_VISIBILITY_DEFAULT RemoteServer : private RemoteConnection {
     /// Do we support writing?
     bool writable;
 
+    /** Is the client sending changes without waiting for replies?
+     *
+     *  Set if the client passes Xapian::DB_PIPELINE_WRITES with
+     *  MSG_WRITEACCESS.
+     */
+    bool pipelined;
+
+    /** The first error from a pipelined change.
+     *
+     *  Empty if there hasn't been one since the client last checked.
+     */
+    std::string pipeline_error;
+
     /** Timeout for actions during a conversation.
      *
      *  The timeout is specified in seconds.  If the timeout is exceeded then a
@@ -170,6 +183,9 @@ class XAPIAN_VISIBILITY_DEFAULT RemoteServer : private RemoteConnection {
     // get number of unique terms
     void msg_uniqueterms(const std::string & message);
 
+    // start compressing messages
+    void msg_compress(const std::string & message);
+
   public:
     /** Construct a RemoteServer.
      *
@@ -71,7 +71,8 @@ class RemoteTcpClient : SOCKET_INITIALIZER_MIXIN public RemoteDatabase {
      *  @param timeout		Timeout during communication after successfully
      *				connecting (in seconds).
      *	@param writable		Is this a WritableDatabase?
-     *	@param flags		Xapian::DB_RETRY_LOCK or 0.
+     *	@param flags		Bitwise-or of Xapian::DB_RETRY_LOCK and/or
+     *				Xapian::DB_PIPELINE_WRITES, or 0.
      */
     RemoteTcpClient(const std::string & hostname, int port,
 		    double timeout_, double timeout_connect, bool writable,
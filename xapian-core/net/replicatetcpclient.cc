@@ -24,16 +24,24 @@
 
 #include "api/replication.h"
 
+#include "length.h"
+#include "replicationprotocol.h"
 #include "socket_utils.h"
 #include "tcpclient.h"
 
+#include <xapian/error.h>
+
+#include <vector>
+
 using namespace std;
 
-ReplicateTcpClient::ReplicateTcpClient(const string & hostname, int port,
-				       double timeout_connect,
-				       double socket_timeout)
-    : socket(open_socket(hostname, port, timeout_connect)),
-      remconn(-1, socket)
+ReplicateTcpClient::ReplicateTcpClient(const string & hostname_, int port_,
+				       double timeout_connect_,
+				       double socket_timeout_)
+    : hostname(hostname_), port(port_), timeout_connect(timeout_connect_),
+      socket_timeout(socket_timeout_),
+      socket(open_socket(hostname, port, timeout_connect)),
+      remconn(socket, socket)
 {
     set_socket_timeouts(socket, socket_timeout);
 }
@@ -50,13 +58,57 @@ ReplicateTcpClient::update_from_master(const std::string & path,
 				       const std::string & masterdb,
 				       Xapian::ReplicationInfo & info,
 				       double reader_close_time,
-				       bool force_copy)
+				       bool force_copy,
+				       unsigned connections)
 {
     Xapian::DatabaseReplica replica(path);
-    remconn.send_message('R',
-			 force_copy ? string() : replica.get_revision_info(),
-			 0.0);
+    string revision;
+    if (!force_copy)
+	revision = replica.get_revision_info();
+    // Ask whether a copy of the whole database is needed before working out
+    // what we have which it could reuse, as that means reading all our files.
+    remconn.send_message('A', string(), 0.0);
+    remconn.send_message('R', revision, 0.0);
     remconn.send_message('D', masterdb, 0.0);
+    string buf;
+    int type = remconn.get_message(buf, 0.0);
+    if (type != REPL_REPLY_COPY_NEEDED) {
+	if (type < 0)
+	    throw Xapian::NetworkError("Connection closed unexpectedly");
+	throw Xapian::NetworkError("Bad replication server message");
+    }
+    bool copy_needed = (buf == "1");
+    string copy_info;
+    if (copy_needed)
+	copy_info = replica.get_copy_info();
+    if (copy_needed && connections > 1) {
+	// Fetch the parts of the copy over several connections at once.
+	vector<int> sockets;
+	try {
+	    for (unsigned part = 0; part != connections; ++part) {
+		int s = open_socket(hostname, port, timeout_connect);
+		sockets.push_back(s);
+		set_socket_timeouts(s, socket_timeout);
+		RemoteConnection conn(-1, s);
+		buf = encode_length(part);
+		buf += encode_length(connections);
+		conn.send_message('P', buf, 0.0);
+		conn.send_message('C', copy_info, 0.0);
+		conn.send_message('R', revision, 0.0);
+		conn.send_message('D', masterdb, 0.0);
+	    }
+	    replica.prefetch_copy(sockets);
+	} catch (...) {
+	    for (int s : sockets) close_fd_or_socket(s);
+	    throw;
+	}
+	for (int s : sockets) close_fd_or_socket(s);
+	// Our copy info is now out of date.
+	copy_info = replica.get_copy_info();
+    }
+    // The master waits for this before sending anything else, so remconn
+    // can't have read ahead into data the replica needs.
+    remconn.send_message('C', copy_info, 0.0);
     replica.set_read_fd(socket);
     info.clear();
     bool more;
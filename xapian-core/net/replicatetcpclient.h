@@ -40,10 +40,26 @@ class XAPIAN_VISIBILITY_DEFAULT ReplicateTcpClient SOCKET_INITIALIZER_MIXIN {
     /// Don't allow copying.
     ReplicateTcpClient(const ReplicateTcpClient &);
 
+    /// The hostname of the replication server.
+    std::string hostname;
+
+    /// The port of the replication server.
+    int port;
+
+    /// Timeout for trying to connect (in seconds).
+    double timeout_connect;
+
+    /// Socket timeout (in seconds); 0 for no timeout.
+    double socket_timeout;
+
     /// The socket fd.
     int socket;
 
-    /// Write-only connection to the server.
+    /** Connection to the server.
+     *
+     *  Only used to read the reply saying whether a DB copy is needed - the
+     *  DatabaseReplica reads the rest of the conversation.
+     */
     RemoteConnection remconn;
 
     /** Attempt to open a TCP/IP socket connection to a replication server.
@@ -71,11 +87,21 @@ class XAPIAN_VISIBILITY_DEFAULT ReplicateTcpClient SOCKET_INITIALIZER_MIXIN {
     ReplicateTcpClient(const std::string & hostname, int port,
 		       double timeout_connect, double socket_timeout);
 
+    /** Update a replica from the master.
+     *
+     *  @param connections	If a copy of the whole database is needed,
+     *				fetch it over this many extra connections at
+     *				once.  The usual single connection is then
+     *				used to fill in anything which changed while
+     *				they were running.  1 means don't make any
+     *				extra connections.
+     */
     void update_from_master(const std::string & path,
 			    const std::string & remotedb,
 			    Xapian::ReplicationInfo & info,
 			    double reader_close_time,
-			    bool force_copy);
+			    bool force_copy,
+			    unsigned connections = 1);
 
     /** Destructor. */
     ~ReplicateTcpClient();
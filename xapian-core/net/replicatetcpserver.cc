@@ -24,6 +24,10 @@
 
 #include <xapian/error.h>
 #include "api/replication.h"
+#include "length.h"
+#include "replicationprotocol.h"
+
+#include <algorithm>
 
 using namespace std;
 
@@ -39,13 +43,38 @@ ReplicateTcpServer::~ReplicateTcpServer() {
 void
 ReplicateTcpServer::handle_one_connection(int socket)
 {
-    RemoteConnection client(socket, -1);
+    RemoteConnection client(socket, socket);
     try {
+	// The client may first tell us which part of a database copy it wants
+	// over this connection, and what it already has, or ask us whether it
+	// needs to tell us what it already has.
+	string buf;
+	unsigned part = 0, nparts = 0;
+	string copy_info;
+	bool ask = false;
+	int type;
+	while (true) {
+	    type = client.get_message(buf, 0.0);
+	    if (type == 'P') {
+		const char * p = buf.data();
+		const char * end = p + buf.size();
+		decode_length(&p, end, part);
+		decode_length(&p, end, nparts);
+	    } else if (type == 'C') {
+		swap(copy_info, buf);
+	    } else if (type == 'A') {
+		ask = true;
+	    } else {
+		break;
+	    }
+	}
+
 	// Read start_revision from the client.
 	string start_revision;
-	if (client.get_message(start_revision, 0.0) != 'R') {
+	if (type != 'R') {
 	    throw Xapian::NetworkError("Bad replication client message");
 	}
+	swap(start_revision, buf);
 
 	// Read dbname from the client.
 	string dbname;
@@ -60,7 +89,24 @@ ReplicateTcpServer::handle_one_connection(int socket)
 	dbpath += '/';
 	dbpath += dbname;
 	Xapian::DatabaseMaster master(dbpath);
-	master.write_changesets_to_fd(socket, start_revision, NULL);
+	if (ask && !nparts) {
+	    // Only a copy of the whole database can use what the client
+	    // already has, and working that out means the client reading all
+	    // its files, so tell it whether a copy is needed and wait for it.
+	    bool copy_needed = master.copy_needed(start_revision);
+	    client.send_message(REPL_REPLY_COPY_NEEDED,
+				string(1, copy_needed ? '1' : '0'), 0.0);
+	    if (client.get_message(copy_info, 0.0) != 'C') {
+		throw Xapian::NetworkError("Bad replication client message (3)");
+	    }
+	}
+	if (nparts) {
+	    master.write_copy_part_to_fd(socket, start_revision, copy_info,
+					 part, nparts);
+	} else {
+	    master.write_changesets_to_fd(socket, start_revision, NULL,
+					  copy_info);
+	}
     } catch (...) {
 	// Ignore exceptions.
     }
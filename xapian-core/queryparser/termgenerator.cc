@@ -94,6 +94,12 @@ TermGenerator::set_max_word_length(unsigned max_word_length)
     internal->max_word_length = max_word_length;
 }
 
+void
+TermGenerator::set_offsets_slot(Xapian::valueno slot)
+{
+    internal->offsets_slot = slot;
+}
+
 void
 TermGenerator::index_text(const Xapian::Utf8Iterator & itor,
 			  Xapian::termcount weight,
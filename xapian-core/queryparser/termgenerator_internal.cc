@@ -30,6 +30,7 @@
 #include <xapian/stem.h>
 #include <xapian/unicode.h>
 
+#include "pack.h"
 #include "stringutils.h"
 
 #include <algorithm>
@@ -57,6 +58,56 @@ inline unsigned check_wordchar(unsigned ch) {
     return 0;
 }
 
+/// Is byte @a ch an ASCII character which Unicode::is_wordchar() accepts?
+inline bool
+is_ascii_wordchar(char ch) {
+    // C_isalnum() is false for bytes >= 0x80.
+    return C_isalnum(ch) || ch == '_';
+}
+
+/** Skip any ASCII non-word characters at the current position.
+ *
+ *  This just examines the bytes, which is much cheaper than decoding and
+ *  looking up the category of each character.
+ */
+inline void
+skip_ascii_nonwordchars(Utf8Iterator & itor)
+{
+    const char * p = itor.raw();
+    const char * end = p + itor.left();
+    const char * q = p;
+    while (q != end && static_cast<unsigned char>(*q) < 0x80 &&
+	   !is_ascii_wordchar(*q)) {
+	++q;
+    }
+    if (q != p) itor.assign(q, end - q);
+}
+
+/** Append the run of ASCII word characters after the current position.
+ *
+ *  The characters are lowercased and appended to @a term, and @a itor is
+ *  left on the last of them.  The current character must be ASCII.
+ *
+ *  @return the last character appended, or 0 if there wasn't a run.
+ */
+inline unsigned
+append_ascii_wordchars(Utf8Iterator & itor, string & term)
+{
+    const char * p = itor.raw() + 1;
+    const char * end = itor.raw() + itor.left();
+    const char * q = p;
+    while (q != end && is_ascii_wordchar(*q)) ++q;
+    if (q == p) return 0;
+    size_t old_size = term.size();
+    term.append(p, q - p);
+    for (size_t i = old_size; i != term.size(); ++i) {
+	term[i] = C_tolower(term[i]);
+    }
+    --q;
+    itor.assign(q, end - q);
+    return static_cast<unsigned char>(term.back());
+}
+
 inline bool
 should_stem(const std::string & term)
 {
@@ -140,6 +191,7 @@ parse_terms(Utf8Iterator itor, bool cjk_ngram, bool with_positions, ACTION actio
 	// Advance to the start of the next term.
 	unsigned ch;
 	while (true) {
+	    skip_ascii_nonwordchars(itor);
 	    if (itor == Utf8Iterator()) return;
 	    ch = check_wordchar(*itor);
 	    if (ch) break;
@@ -179,6 +231,7 @@ parse_terms(Utf8Iterator itor, bool cjk_ngram, bool with_positions, ACTION actio
 			return;
 		}
 		while (true) {
+		    skip_ascii_nonwordchars(itor);
 		    if (itor == Utf8Iterator()) return;
 		    ch = check_wordchar(*itor);
 		    if (ch) break;
@@ -190,6 +243,11 @@ parse_terms(Utf8Iterator itor, bool cjk_ngram, bool with_positions, ACTION actio
 	    do {
 		Unicode::append_utf8(term, ch);
 		prevch = ch;
+		if (static_cast<unsigned char>(*itor.raw()) < 0x80) {
+		    // Copy any following ASCII word characters in one go.
+		    unsigned lastch = append_ascii_wordchars(itor, term);
+		    if (lastch) prevch = lastch;
+		}
 		if (++itor == Utf8Iterator() ||
 		    (cjk_ngram && CJK::codepoint_is_cjk(*itor)))
 		    goto endofterm;
@@ -247,13 +305,41 @@ TermGenerator::Internal::index_text(Utf8Iterator itor, termcount wdf_inc,
 
     if (!stopper.get()) stop_mode = STOPWORDS_NONE;
 
+    // Reused for each stemmed term, to avoid allocating a string for each.
+    string stem, stem_buf;
+
+    // If we're storing offsets, they're encoded as the length of the text,
+    // the position of the first word, then the difference between the end
+    // offset of each word and that of the previous one.  Words get
+    // consecutive positions, so we don't need to store those.
+    bool store_offsets = (offsets_slot != Xapian::BAD_VALUENO && with_positions);
+    size_t text_len = itor.left();
+    size_t prev_end = 0;
+    string offsets;
+    if (store_offsets) {
+	pack_uint(offsets, text_len);
+	pack_uint(offsets, termpos + 1);
+    }
+
     parse_terms(itor, cjk_ngram, with_positions,
-	[=](const string & term, bool positional, const Utf8Iterator &) {
+	[=, &stem, &stem_buf, &prev_end, &offsets](const string & term,
+						   bool positional,
+						   const Utf8Iterator & it) {
 	    if (term.size() > max_word_length) return true;
 
 	    if (stop_mode == STOPWORDS_IGNORE && (*stopper)(term))
 		return true;
 
+	    if (store_offsets &&
+		((strategy == TermGenerator::STEM_SOME ||
+		  strategy == TermGenerator::STEM_NONE) ?
+		 positional : stemmer.internal.get() != NULL)) {
+		// This word is about to be given the next term position.
+		size_t term_end = text_len - it.left();
+		pack_uint(offsets, term_end - prev_end);
+		prev_end = term_end;
+	    }
+
 	    if (strategy == TermGenerator::STEM_SOME ||
 		strategy == TermGenerator::STEM_NONE) {
 		if (positional) {
@@ -280,12 +366,13 @@ TermGenerator::Internal::index_text(Utf8Iterator itor, termcount wdf_inc,
 	    }
 
 	    // Add stemmed form without positional information.
-	    string stem;
+	    stem.resize(0);
 	    if (strategy != TermGenerator::STEM_ALL) {
 		stem += "Z";
 	    }
 	    stem += prefix;
-	    stem += stemmer(term);
+	    stemmer.stem_into(term, stem_buf);
+	    stem += stem_buf;
 	    if (strategy != TermGenerator::STEM_SOME && with_positions) {
 		doc.add_posting(stem, ++termpos, wdf_inc);
 	    } else {
@@ -293,6 +380,8 @@ TermGenerator::Internal::index_text(Utf8Iterator itor, termcount wdf_inc,
 	    }
 	    return true;
 	});
+
+    if (store_offsets) doc.add_value(offsets_slot, offsets);
 }
 
 struct Sniplet {
@@ -677,6 +766,7 @@ MSet::Internal::snippet(const string & text,
     vector<string> phrase;
     if (longest_phrase) phrase.resize(longest_phrase - 1);
     size_t phrase_next = 0;
+    string stem, stem_buf;
     parse_terms(Utf8Iterator(text), cjk_ngram, true,
 	[&](const string & term, bool positional, const Utf8Iterator & it) {
 	    // FIXME: Don't hardcode this here.
@@ -720,8 +810,9 @@ MSet::Internal::snippet(const string & text,
 		    goto relevance_done;
 		}
 
-		string stem = "Z";
-		stem += stemmer(term);
+		stem.assign(1, 'Z');
+		stemmer.stem_into(term, stem_buf);
+		stem += stem_buf;
 		if (check_term(loose_terms, stats, stem, relevance)) {
 		    // Matched stemmed term.
 		    highlight = 1;
@@ -825,4 +916,172 @@ relevance_done:
     return result;
 }
 
+
+/** Decode the word offsets stored by TermGenerator::set_offsets_slot().
+ *
+ *  @return false if @a data isn't a valid set of offsets for a text of
+ *	    @a text_len bytes.
+ */
+static bool
+decode_offsets(const string & data, size_t text_len,
+	       Xapian::termpos & first_pos, vector<size_t> & ends)
+{
+    const char * p = data.data();
+    const char * end = p + data.size();
+    size_t len;
+    if (!unpack_uint(&p, end, &len) || len != text_len ||
+	!unpack_uint(&p, end, &first_pos)) {
+	return false;
+    }
+    size_t term_end = 0;
+    while (p != end) {
+	size_t delta;
+	if (!unpack_uint(&p, end, &delta)) return false;
+	term_end += delta;
+	if (term_end > text_len) return false;
+	ends.push_back(term_end);
+    }
+    return true;
+}
+
+string
+MSet::Internal::snippet(const string & text,
+			Xapian::docid did,
+			Xapian::valueno offsets_slot,
+			size_t length,
+			const Xapian::Stem & stemmer,
+			unsigned flags,
+			const string & hi_start,
+			const string & hi_end,
+			const string & omit) const
+{
+    if (hi_start.empty() && hi_end.empty() && text.size() <= length) {
+	// Too easy!
+	return text;
+    }
+
+    const Xapian::Database & db = enquire->db;
+    Xapian::termpos first_pos;
+    vector<size_t> ends;
+    if (!decode_offsets(db.get_document(did).get_value(offsets_slot),
+			text.size(), first_pos, ends)) {
+	// No usable offsets, so parse the text.
+	return snippet(text, length, stemmer, flags, hi_start, hi_end, omit);
+    }
+
+    // The relevance and highlight length of each word, worked out from the
+    // positions of the query terms.  Matches are recorded in increasing
+    // order of precedence (wildcards, stemmed terms, unstemmed terms, then
+    // exact phrases), each overriding any earlier match for the same word,
+    // which gives the same result as the checks parsing the text makes.
+    size_t n_words = ends.size();
+    vector<double> relevance(n_words);
+    vector<size_t> highlight(n_words);
+    auto mark = [&](Xapian::PositionIterator pos, double r, size_t h) {
+	for ( ; pos != Xapian::PositionIterator(); ++pos) {
+	    if (*pos < first_pos) continue;
+	    size_t i = *pos - first_pos;
+	    if (i >= n_words) break;
+	    relevance[i] = r;
+	    highlight[i] = h;
+	}
+    };
+
+    if (stats) {
+	double min_tw = 0, max_tw = 0;
+	stats->get_max_termweight(min_tw, max_tw);
+	if (max_tw == 0.0) max_tw = 1.0;
+
+	list<vector<string>> exact_phrases;
+	map<string, double> loose_terms;
+	list<string> wildcards;
+	size_t longest_phrase = 0;
+	check_query(enquire->get_query(), exact_phrases, loose_terms,
+		    wildcards, longest_phrase);
+
+	// Words which match a wildcard or a stemmed query term have to be
+	// found from the document's unprefixed terms.
+	bool want_stems = false;
+	for (const auto & i : loose_terms) {
+	    if (startswith(i.first, 'Z')) {
+		want_stems = true;
+		break;
+	    }
+	}
+	if (want_stems || !wildcards.empty()) {
+	    string stem, stem_buf;
+	    for (Xapian::TermIterator t = db.termlist_begin(did);
+		 t != db.termlist_end(did); ++t) {
+		const string & term = *t;
+		if (term.empty() || C_isupper(term[0])) continue;
+		for (auto&& pattern : wildcards) {
+		    if (startswith(term, pattern)) {
+			mark(t.positionlist_begin(), max_tw + min_tw, 1);
+			break;
+		    }
+		}
+		if (!want_stems) continue;
+		stem.assign(1, 'Z');
+		stemmer.stem_into(term, stem_buf);
+		stem += stem_buf;
+		double r;
+		if (check_term(loose_terms, stats, stem, r)) {
+		    mark(t.positionlist_begin(), r + max_tw, 1);
+		}
+	    }
+	}
+
+	vector<string> terms;
+	terms.reserve(loose_terms.size());
+	for (const auto & i : loose_terms) terms.push_back(i.first);
+	for (const string & term : terms) {
+	    double r;
+	    if (check_term(loose_terms, stats, term, r)) {
+		mark(db.positionlist_begin(did, term), r + max_tw, 1);
+	    }
+	}
+
+	for (const auto & phrase : exact_phrases) {
+	    // A match ends at each position of the last term which has the
+	    // other terms in the positions before it.
+	    size_t n = phrase.size();
+	    vector<vector<Xapian::termpos>> positions(n);
+	    for (size_t i = 0; i != n; ++i) {
+		positions[i].assign(db.positionlist_begin(did, phrase[i]),
+				    db.positionlist_end(did, phrase[i]));
+	    }
+	    for (Xapian::termpos pos : positions[n - 1]) {
+		if (pos < first_pos + (n - 1) || pos - first_pos >= n_words)
+		    continue;
+		bool match = true;
+		for (size_t i = 0; i != n - 1; ++i) {
+		    Xapian::termpos want = pos - (n - 1 - i);
+		    if (!binary_search(positions[i].begin(),
+				       positions[i].end(), want)) {
+			match = false;
+			break;
+		    }
+		}
+		if (match) {
+		    relevance[pos - first_pos] = max_tw * n;
+		    highlight[pos - first_pos] = n;
+		}
+	    }
+	}
+    }
+
+    SnipPipe snip(length);
+    for (size_t i = 0; i != n_words; ++i) {
+	if (!snip.pump(relevance[i], ends[i], highlight[i], flags)) break;
+    }
+
+    snip.done();
+
+    // Put together the snippet.
+    string result;
+    while (snip.drain(text, hi_start, hi_end, omit, result)) { }
+
+    return result;
+}
+
 }
@@ -42,10 +42,12 @@ class TermGenerator::Internal : public Xapian::Internal::intrusive_base {
     TermGenerator::flags flags;
     unsigned max_word_length;
     WritableDatabase db;
+    Xapian::valueno offsets_slot;
 
   public:
     Internal() : strategy(STEM_SOME), stopper(NULL), termpos(0),
-	flags(TermGenerator::flags(0)), max_word_length(64) { }
+	flags(TermGenerator::flags(0)), max_word_length(64),
+	offsets_slot(Xapian::BAD_VALUENO) { }
     void index_text(Utf8Iterator itor,
 		    termcount weight,
 		    const std::string & prefix,
@@ -46,7 +46,10 @@
 # include "safesyswait.h"
 #endif
 
+#include <algorithm>
 #include <fstream>
+#include <map>
+#include <vector>
 
 using namespace std;
 
@@ -425,11 +428,14 @@ DEFINE_TESTCASE(replacedoc8, writable) {
 }
 
 /// Test coverage for DatabaseModifiedError.
-DEFINE_TESTCASE(databasemodified1, writable && !inmemory && !remote) {
+DEFINE_TESTCASE(databasemodified1, writable && !inmemory && !remote && !segmented) {
     // The inmemory backend doesn't support revisions.
     //
     // The remote backend doesn't work as expected here, I think due to
     // test harness issues.
+    //
+    // The segmented backend adds documents to new segments, so the reader's
+    // segment isn't modified.
     Xapian::WritableDatabase db(get_writable_database());
     Xapian::Document doc;
     doc.set_data("cargo");
@@ -467,6 +473,286 @@ DEFINE_TESTCASE(databasemodified1, writable && !inmemory && !remote) {
     return true;
 }
 
+/// Test that DB_PIN_REVISION avoids DatabaseModifiedError.
+DEFINE_TESTCASE(pinrevision1, glass) {
+    Xapian::WritableDatabase db = get_named_writable_database("pinrevision1");
+    Xapian::Document doc;
+    doc.set_data("cargo");
+    doc.add_term("abc");
+    doc.add_term("def");
+    doc.add_term("ghi");
+    const int N = 500;
+    for (int i = 0; i < N; ++i) {
+	db.add_document(doc);
+    }
+    db.commit();
+
+    string path = get_named_writable_database_path("pinrevision1");
+    Xapian::Database rodb(path, Xapian::DB_PIN_REVISION);
+    TEST_EQUAL(rodb.get_doccount(), N);
+
+    // Make enough changes that the blocks of the pinned revision would
+    // otherwise be reused (compare databasemodified1).
+    doc.add_term("jkl");
+    for (int round = 0; round < 5; ++round) {
+	for (Xapian::docid did = 1; did <= N; did += 7) {
+	    db.replace_document(did, doc);
+	}
+	db.add_document(doc);
+	db.commit();
+    }
+
+    TEST_EQUAL(rodb.get_doccount(), N);
+    TEST_EQUAL(rodb.get_termfreq("abc"), N);
+    TEST_EQUAL(rodb.get_termfreq("jkl"), 0);
+    Xapian::TermIterator t = rodb.termlist_begin(N - 1);
+    TEST_EQUAL(*t, "abc");
+    TEST_EQUAL(rodb.get_document(1).get_data(), "cargo");
+    Xapian::Enquire enq(rodb);
+    enq.set_query(Xapian::Query("abc"));
+    TEST_EQUAL(enq.get_mset(0, 10).get_matches_estimated(), N);
+
+    // Reopening moves the pin to the latest revision.
+    TEST(rodb.reopen());
+    TEST_EQUAL(rodb.get_doccount(), N + 5);
+    TEST_EQUAL(rodb.get_termfreq("jkl"), 5 + (N + 6) / 7);
+
+    // Once the pin is released, the blocks are reused.
+    rodb.close();
+    for (int round = 0; round < 5; ++round) {
+	db.add_document(doc);
+	db.commit();
+    }
+    db.close();
+    TEST_EQUAL(Xapian::Database::check(path), 0);
+
+    return true;
+}
+
+/// Return the number of segments listed in a segmented database's directory.
+static int
+count_segments(const string & path)
+{
+    ifstream in((path + "/iamsegmented").c_str());
+    string line;
+    int lines = 0;
+    while (getline(in, line)) ++lines;
+    // Three header lines, then one line per segment.
+    return lines - 3;
+}
+
+/// Check the docids in a postlist and value stream of a segmented database.
+static void
+check_segmented_docids(const Xapian::Database & db,
+		       const vector<Xapian::docid> & dids)
+{
+    vector<Xapian::docid> got;
+    Xapian::PostingIterator p;
+    for (p = db.postlist_begin("all"); p != db.postlist_end("all"); ++p) {
+	got.push_back(*p);
+	TEST_EQUAL(p.get_doclength(), db.get_doclength(*p));
+    }
+    TEST(got == dids);
+
+    got.clear();
+    Xapian::ValueIterator v;
+    for (v = db.valuestream_begin(0); v != db.valuestream_end(0); ++v) {
+	TEST_EQUAL(*v, str(v.get_docid()));
+	got.push_back(v.get_docid());
+    }
+    TEST(got == dids);
+
+    // skip_to() across segments.
+    p = db.postlist_begin("all");
+    p.skip_to(dids.back());
+    TEST(p != db.postlist_end("all"));
+    TEST_EQUAL(*p, dids.back());
+    v = db.valuestream_begin(0);
+    TEST(v.check(dids[dids.size() / 2]));
+    TEST_EQUAL(v.get_docid(), dids[dids.size() / 2]);
+}
+
+/// Test adding, replacing and deleting across segments and merges.
+DEFINE_TESTCASE(segmented1, segmented) {
+    Xapian::WritableDatabase db = get_named_writable_database("segmented1");
+    string path = get_named_writable_database_path("segmented1");
+    vector<Xapian::docid> dids;
+    // Commit after each document, so each starts a new segment.  Every ten
+    // segments of the same size get merged.
+    for (Xapian::docid did = 1; did <= 35; ++did) {
+	Xapian::Document doc;
+	doc.add_term("all");
+	doc.add_posting("n" + str(did), 1);
+	doc.add_value(0, str(did));
+	TEST_EQUAL(db.add_document(doc), did);
+	db.commit();
+	dids.push_back(did);
+    }
+    TEST_EQUAL(count_segments(path), 8);
+    TEST_EQUAL(db.get_doccount(), 35);
+    TEST_EQUAL(db.get_termfreq("all"), 35);
+    TEST_EQUAL(db.get_value_lower_bound(0), "1");
+    TEST_EQUAL(db.get_value_upper_bound(0), "9");
+    check_segmented_docids(db, dids);
+
+    Xapian::Database rodb(path);
+    TEST_EQUAL(rodb.get_doccount(), 35);
+
+    // Replace a document in a merged segment, delete one in the newest
+    // segment, and add one with a gap in the docids.
+    Xapian::Document doc;
+    doc.add_term("all");
+    doc.add_term("new");
+    doc.add_value(0, "5");
+    db.replace_document(5, doc);
+    db.delete_document(33);
+    doc.add_value(0, "40");
+    db.replace_document(40, doc);
+    TEST_EXCEPTION(Xapian::DocNotFoundError, db.delete_document(41));
+    dids.erase(dids.begin() + 32);
+    dids.push_back(40);
+
+    // The changes are visible before they're committed.
+    TEST_EQUAL(db.get_doccount(), 35);
+    TEST_EQUAL(db.get_lastdocid(), 40);
+    TEST_EQUAL(db.get_termfreq("new"), 2);
+    TEST_EQUAL(db.get_termfreq("n5"), 0);
+    check_segmented_docids(db, dids);
+    db.commit();
+
+    TEST_EQUAL(rodb.get_doccount(), 35);
+    TEST_EQUAL(rodb.get_termfreq("n5"), 1);
+    TEST(rodb.reopen());
+    TEST_EQUAL(rodb.get_lastdocid(), 40);
+    TEST_EQUAL(rodb.get_termfreq("n5"), 0);
+    TEST_EQUAL(rodb.get_termfreq("n33"), 0);
+    check_segmented_docids(rodb, dids);
+
+    Xapian::Enquire enq(rodb);
+    enq.set_query(Xapian::Query(Xapian::Query::OP_OR,
+				Xapian::Query("new"), Xapian::Query("n34")));
+    Xapian::MSet mset = enq.get_mset(0, 10);
+    TEST_EQUAL(mset.size(), 3);
+    vector<Xapian::docid> matches(mset.begin(), mset.end());
+    sort(matches.begin(), matches.end());
+    TEST_EQUAL(matches[0], 5);
+    TEST_EQUAL(matches[1], 34);
+    TEST_EQUAL(matches[2], 40);
+
+    // Cancelling a transaction discards the segment it started.
+    int segments = count_segments(path);
+    db.add_document(doc);
+    db.commit();
+    db.begin_transaction();
+    db.add_document(doc);
+    db.cancel_transaction();
+    TEST_EQUAL(db.get_lastdocid(), 41);
+    db.commit();
+    TEST_EQUAL(count_segments(path), segments + 1);
+
+    // Segments replaced by a merge are kept until a writer next opens the
+    // database, since a reader may be about to open them.
+    // "aux1" is created first, so "seg2" holds the first document.
+    TEST(dir_exists(path + "/seg2"));
+    TEST_EQUAL(Xapian::Database(path + "/seg2").get_doccount(), 1);
+
+    // Reopening doesn't need DB_SEGMENTED.
+    db.close();
+    db = Xapian::WritableDatabase(path, Xapian::DB_OPEN);
+    TEST(!dir_exists(path + "/seg2"));
+    TEST_EQUAL(db.get_doccount(), 36);
+    TEST_EQUAL(db.add_document(doc), 42);
+    db.commit();
+
+    return true;
+}
+
+/// Test compacting a segmented database.
+DEFINE_TESTCASE(segmented2, segmented) {
+    Xapian::WritableDatabase db = get_named_writable_database("segmented2");
+    for (int i = 1; i <= 25; ++i) {
+	Xapian::Document doc;
+	doc.add_term("all");
+	doc.add_term("n" + str(i));
+	db.add_document(doc);
+	if (i % 2 == 0) db.commit();
+    }
+    db.delete_document(3);
+    db.set_metadata("key", "value");
+    db.add_synonym("all", "every");
+    db.commit();
+
+    string path = get_named_writable_database_path("segmented2");
+    string outpath = path + "_compacted";
+    rm_rf(outpath);
+    db.compact(outpath);
+    Xapian::Database out(outpath);
+    TEST_EQUAL(out.get_doccount(), 24);
+    TEST_EQUAL(out.get_lastdocid(), 25);
+    TEST_EQUAL(out.get_termfreq("all"), 24);
+    TEST_EQUAL(out.get_termfreq("n25"), 1);
+    TEST_EQUAL(out.get_metadata("key"), "value");
+    TEST_EQUAL(*out.synonyms_begin("all"), "every");
+    TEST_EXCEPTION(Xapian::InvalidArgumentError, db.compact(path));
+
+    return true;
+}
+
+/// Test cancelling deletions and replacements of committed documents.
+DEFINE_TESTCASE(segmented3, segmented) {
+    Xapian::WritableDatabase db = get_named_writable_database("segmented3");
+    string path = get_named_writable_database_path("segmented3");
+    vector<Xapian::docid> dids;
+    for (Xapian::docid did = 1; did <= 4; ++did) {
+	Xapian::Document doc;
+	doc.add_term("all");
+	doc.add_term("n" + str(did));
+	doc.add_value(0, str(did));
+	db.add_document(doc);
+	db.commit();
+	dids.push_back(did);
+    }
+    db.set_metadata("key", "old");
+    db.commit();
+
+    db.begin_transaction();
+    db.delete_document(2);
+    Xapian::Document doc;
+    doc.add_term("all");
+    doc.add_term("new");
+    doc.add_value(0, "3");
+    db.replace_document(3, doc);
+    db.set_metadata("key", "new");
+    TEST_EQUAL(db.get_doccount(), 3);
+    TEST_EQUAL(db.get_termfreq("n3"), 0);
+    TEST_EQUAL(db.get_metadata("key"), "new");
+    db.cancel_transaction();
+
+    TEST_EQUAL(db.get_doccount(), 4);
+    TEST_EQUAL(db.get_termfreq("n3"), 1);
+    TEST_EQUAL(db.get_termfreq("new"), 0);
+    TEST_EQUAL(db.get_metadata("key"), "old");
+    check_segmented_docids(db, dids);
+
+    // Replacing a document with itself unmodified doesn't copy it.
+    int segments = count_segments(path);
+    db.replace_document(2, db.get_document(2));
+    db.commit();
+    TEST_EQUAL(count_segments(path), segments);
+
+    // Deleting the only copy of a term leaves no trace of it.
+    db.delete_document(4);
+    db.commit();
+    dids.pop_back();
+    Xapian::Database rodb(path);
+    TEST(!rodb.term_exists("n4"));
+    TEST(rodb.allterms_begin("n4") == rodb.allterms_end("n4"));
+    TEST_EQUAL(rodb.get_value_freq(0), 3);
+    check_segmented_docids(rodb, dids);
+
+    return true;
+}
+
 /// Regression test for bug#462 fixed in 1.0.19 and 1.1.5.
 DEFINE_TESTCASE(qpmemoryleak1, writable && !inmemory) {
     // Inmemory never throws DatabaseModifiedError.
@@ -766,6 +1052,263 @@ DEFINE_TESTCASE(orcheck1, generated) {
     return true;
 }
 
+static void
+make_wideor1_db(Xapian::WritableDatabase &db, const string &)
+{
+    for (int n = 1; n != 5000; ++n) {
+	Xapian::Document doc;
+	for (int i = 1; i <= 24; ++i) {
+	    if (n % (i + 1) == 0)
+		doc.add_term("T" + str(i), i);
+	}
+	if (n % 97 == 0)
+	    doc.add_term("R");
+	doc.add_term("X", n % 7 + 1);
+	db.add_document(doc);
+    }
+}
+
+/// Weight which encodes the wdf and document length.
+class WdfLengthWeight : public Xapian::Weight {
+  public:
+    WdfLengthWeight() {
+	need_stat(WDF);
+	need_stat(DOC_LENGTH);
+	need_stat(DOC_LENGTH_MAX);
+    }
+
+    void init(double) { }
+
+    Weight * clone() const {
+	return new WdfLengthWeight();
+    }
+
+    double get_sumpart(Xapian::termcount wdf,
+		       Xapian::termcount doclen,
+		       Xapian::termcount) const {
+	return wdf * 65536.0 + doclen;
+    }
+
+    double get_maxpart() const {
+	return get_doclength_upper_bound() * 65537.0;
+    }
+
+    double get_sumextra(Xapian::termcount, Xapian::termcount) const {
+	return 0;
+    }
+
+    double get_maxextra() const {
+	return 0;
+    }
+};
+
+/// Test OR and OP_SYNONYM with enough subqueries to use block mode.
+DEFINE_TESTCASE(wideor1, generated && !remote) {
+    Xapian::Database db = get_database("wideor1", make_wideor1_db);
+    vector<Xapian::Query> subqs;
+    map<Xapian::docid, Xapian::termcount> wdfs;
+    for (int i = 1; i <= 24; ++i) {
+	string term = "T" + str(i);
+	subqs.push_back(Xapian::Query(term));
+	Xapian::PostingIterator p;
+	for (p = db.postlist_begin(term); p != db.postlist_end(term); ++p) {
+	    wdfs[*p] += p.get_wdf();
+	}
+    }
+    Xapian::Query syn(Xapian::Query::OP_SYNONYM, subqs.begin(), subqs.end());
+    Xapian::Query bool_or(Xapian::Query::OP_OR, subqs.begin(), subqs.end());
+    bool_or = Xapian::Query(Xapian::Query::OP_SCALE_WEIGHT, bool_or, 0.0);
+
+    Xapian::Enquire enq(db);
+    enq.set_weighting_scheme(WdfLengthWeight());
+    enq.set_query(syn);
+    Xapian::MSet mset = enq.get_mset(0, db.get_doccount());
+    TEST_EQUAL(mset.size(), wdfs.size());
+    for (Xapian::MSetIterator i = mset.begin(); i != mset.end(); ++i) {
+	double expect = wdfs[*i] * 65536.0 + db.get_doclength(*i);
+	TEST_EQUAL_DOUBLE(i.get_weight(), expect);
+    }
+
+    enq.set_query(bool_or);
+    mset = enq.get_mset(0, db.get_doccount());
+    TEST_EQUAL(mset.size(), wdfs.size());
+
+    // Check skip_to() by combining with a rarer term.
+    Xapian::Query q_r("R");
+    vector<Xapian::docid> expect;
+    Xapian::PostingIterator p;
+    for (p = db.postlist_begin("R"); p != db.postlist_end("R"); ++p) {
+	if (wdfs.find(*p) != wdfs.end())
+	    expect.push_back(*p);
+    }
+    TEST_REL(expect.size(), >, 0);
+
+    enq.set_query(Xapian::Query(Xapian::Query::OP_AND, q_r, syn));
+    mset = enq.get_mset(0, db.get_doccount());
+    TEST_EQUAL(mset.size(), expect.size());
+    for (Xapian::MSetIterator i = mset.begin(); i != mset.end(); ++i) {
+	double expect_wt = wdfs[*i] * 65536.0 + db.get_doclength(*i) +
+			   65536.0 + db.get_doclength(*i);
+	TEST_EQUAL_DOUBLE(i.get_weight(), expect_wt);
+    }
+
+    enq.set_query(Xapian::Query(Xapian::Query::OP_FILTER, q_r, bool_or));
+    enq.set_docid_order(Xapian::Enquire::ASCENDING);
+    enq.set_weighting_scheme(Xapian::BoolWeight());
+    mset = enq.get_mset(0, db.get_doccount());
+    TEST_EQUAL(mset.size(), expect.size());
+    for (size_t i = 0; i != expect.size(); ++i) {
+	TEST_EQUAL(*mset[i], expect[i]);
+    }
+
+    return true;
+}
+
+/// Check lists which are too long to send over the remote protocol in one go.
+DEFINE_TESTCASE(biglists1, writable) {
+    Xapian::WritableDatabase db = get_writable_database();
+    Xapian::Document doc;
+    for (Xapian::termpos pos = 1; pos != 5000; ++pos) {
+	doc.add_posting("pos", pos * 3);
+    }
+    for (int i = 0; i != 3000; ++i) {
+	doc.add_term("x" + str(i));
+    }
+    for (int n = 1; n <= 10000; ++n) {
+	doc.add_term("all", n % 5 + 1);
+	doc.add_term("t" + str(n));
+	db.add_document(doc);
+	doc.clear_terms();
+    }
+    db.commit();
+
+    Xapian::docid did = 0;
+    Xapian::PostingIterator p;
+    for (p = db.postlist_begin("all"); p != db.postlist_end("all"); ++p) {
+	TEST_EQUAL(*p, ++did);
+	TEST_EQUAL(p.get_wdf(), did % 5 + 1);
+    }
+    TEST_EQUAL(did, 10000);
+
+    Xapian::termcount count = 0;
+    Xapian::TermIterator t;
+    string prev;
+    for (t = db.allterms_begin("t"); t != db.allterms_end("t"); ++t) {
+	TEST_REL(prev, <, *t);
+	TEST_EQUAL(t.get_termfreq(), 1);
+	prev = *t;
+	++count;
+    }
+    TEST_EQUAL(count, 10000);
+
+    count = 0;
+    for (t = db.termlist_begin(1); t != db.termlist_end(1); ++t) {
+	++count;
+    }
+    TEST_EQUAL(count, 3003);
+
+    Xapian::termpos expect_pos = 0;
+    Xapian::PositionIterator pos;
+    for (pos = db.positionlist_begin(1, "pos");
+	 pos != db.positionlist_end(1, "pos"); ++pos) {
+	expect_pos += 3;
+	TEST_EQUAL(*pos, expect_pos);
+    }
+    TEST_EQUAL(expect_pos, 4999 * 3);
+
+    return true;
+}
+
+/// Feature test for Xapian::DB_PIPELINE_WRITES.
+DEFINE_TESTCASE(pipelinewrites1, writable && !inmemory) {
+    {
+	Xapian::WritableDatabase db_init = get_writable_database();
+	Xapian::Document doc;
+	doc.add_term("Q0");
+	db_init.add_document(doc);
+	db_init.commit();
+    }
+
+    Xapian::WritableDatabase db =
+	get_writable_database_again(Xapian::DB_PIPELINE_WRITES);
+    for (Xapian::docid i = 1; i <= 100; ++i) {
+	Xapian::Document doc;
+	doc.add_term("Q" + str(i));
+	doc.set_data(str(i));
+	TEST_EQUAL(db.add_document(doc), i + 1);
+    }
+
+    Xapian::Document doc;
+    doc.add_term("Q50");
+    doc.set_data("fifty");
+    db.replace_document("Q50", doc);
+    db.delete_document(3);
+    doc = Xapian::Document();
+    doc.add_term("Qnew");
+    // This adds a document, so the next docid has to be fetched from the
+    // server in pipelined mode.
+    db.replace_document("Qnew", doc);
+    doc = Xapian::Document();
+    doc.add_term("Qlast");
+    TEST_EQUAL(db.add_document(doc), 103);
+    db.commit();
+
+    TEST_EQUAL(db.get_doccount(), 102);
+    TEST_EQUAL(db.get_lastdocid(), 103);
+    TEST_EQUAL(db.get_document(51).get_data(), "fifty");
+    TEST_EQUAL(db.get_document(100).get_data(), "99");
+    TEST_EQUAL(db.get_termfreq("Q2"), 0);
+    TEST_EQUAL(*db.postlist_begin("Qnew"), 102);
+
+    // An error should be reported by the next call which talks to the
+    // server, and the changes after it discarded.
+    bool thrown = false;
+    try {
+	db.delete_document(1000);
+	db.add_document(doc);
+	db.commit();
+    } catch (const Xapian::DocNotFoundError &) {
+	thrown = true;
+    }
+    TEST(thrown);
+    TEST_EQUAL(db.get_doccount(), 102);
+    TEST_EQUAL(db.add_document(doc), 104);
+    db.commit();
+    TEST_EQUAL(db.get_termfreq("Qlast"), 2);
+
+    return true;
+}
+
+/// Check large messages (which the remote backend compresses) survive intact.
+DEFINE_TESTCASE(compressedmessages1, writable) {
+    Xapian::WritableDatabase db = get_writable_database();
+    Xapian::Document doc;
+    string data;
+    for (int i = 0; i != 100000; ++i) {
+	data += "line ";
+	data += str(i % 100);
+	data += '\n';
+    }
+    doc.set_data(data);
+    for (int i = 0; i != 1000; ++i) {
+	doc.add_term("term" + str(i));
+    }
+    Xapian::docid did = db.add_document(doc);
+    db.commit();
+
+    Xapian::Document doc2 = db.get_document(did);
+    TEST_EQUAL(doc2.get_data(), data);
+    TEST_EQUAL(doc2.termlist_count(), 1000);
+    Xapian::termcount n = 0;
+    for (Xapian::TermIterator t = db.allterms_begin("term");
+	 t != db.allterms_end("term"); ++t) {
+	++n;
+    }
+    TEST_EQUAL(n, 1000);
+
+    return true;
+}
+
 /** Regression test for bug fixed in 1.2.1 and 1.0.21.
  *
  *  We failed to mark the Btree as unmodified after cancel().
@@ -1433,3 +1976,130 @@ DEFINE_TESTCASE(exactxor1, backend) {
 
     return true;
 }
+
+/// Test Enquire::set_profiling() and MSet::get_profile().
+DEFINE_TESTCASE(matchprofile1, backend && !remote) {
+    Xapian::Database db = get_database("apitest_simpledata");
+    Xapian::Enquire enq(db);
+    enq.set_query(Xapian::Query(Xapian::Query::OP_OR,
+				Xapian::Query("this"),
+				Xapian::Query("paragraph")));
+
+    // Profiling is off by default, so the profile should be empty.
+    Xapian::MSet mset = enq.get_mset(0, 10);
+    Xapian::MatchProfile profile = mset.get_profile();
+    TEST_EQUAL(profile.get_total_time(), 0);
+    TEST_EQUAL(profile.get_docs_considered(), 0);
+    TEST_EQUAL(profile.get_weight_calls(), 0);
+    TEST(profile.get_postlist_tree().empty());
+
+    enq.set_profiling(true);
+    mset = enq.get_mset(0, 10);
+    profile = mset.get_profile();
+    tout << profile.get_description() << endl;
+    TEST_REL(profile.get_total_time(),>=,profile.get_build_time());
+    TEST_REL(profile.get_match_time(),>=,profile.get_weight_time());
+    TEST_REL(profile.get_docs_considered(),>=,mset.size());
+    TEST_REL(profile.get_weight_calls(),>,0);
+    TEST(!profile.get_postlist_tree().empty());
+
+    // Check the counts for each term.
+    Xapian::TermIterator t = profile.get_terms_begin();
+    TEST(t != profile.get_terms_end());
+    TEST_EQUAL(*t, "paragraph");
+    ++t;
+    TEST(t != profile.get_terms_end());
+    TEST_EQUAL(*t, "this");
+    ++t;
+    TEST(t == profile.get_terms_end());
+    TEST_REL(profile.get_weight_calls("this"),>,0);
+    TEST_EQUAL(profile.get_weight_calls("this") +
+	       profile.get_weight_calls("paragraph"),
+	       profile.get_weight_calls());
+    TEST_EQUAL(profile.get_weight_calls("nosuchterm"), 0);
+
+    // The profile belongs to the MSet, so another match shouldn't change it.
+    Xapian::doccount docs_considered = profile.get_docs_considered();
+    enq.set_query(Xapian::Query("this"));
+    Xapian::MSet mset2 = enq.get_mset(0, 1);
+    TEST_EQUAL(mset.get_profile().get_docs_considered(), docs_considered);
+
+    enq.set_profiling(false);
+    mset = enq.get_mset(0, 10);
+    TEST_EQUAL(mset.get_profile().get_docs_considered(), 0);
+
+    return true;
+}
+
+/// Test the postlist and table counts in a MatchProfile.
+DEFINE_TESTCASE(matchprofile2, glass || segmented) {
+    Xapian::Database db = get_database("etext");
+    Xapian::Enquire enq(db);
+    enq.set_query(Xapian::Query(Xapian::Query::OP_AND,
+				Xapian::Query("the"),
+				Xapian::Query("king")));
+    enq.set_profiling(true);
+    Xapian::MSet mset = enq.get_mset(0, 10);
+    Xapian::MatchProfile profile = mset.get_profile();
+    tout << profile.get_description() << endl;
+    TEST_REL(profile.get_postings_decoded(),>,0);
+    TEST_REL(profile.get_skip_to_calls(),>,0);
+    TEST_REL(profile.get_postings_decoded("the"),>,0);
+    TEST_REL(profile.get_postings_decoded("king"),>,0);
+    TEST_EQUAL(profile.get_postings_decoded("the") +
+	       profile.get_postings_decoded("king"),
+	       profile.get_postings_decoded());
+    TEST_EQUAL(profile.get_next_calls("the") +
+	       profile.get_next_calls("king"),
+	       profile.get_next_calls());
+    TEST_EQUAL(profile.get_skip_to_calls("the") +
+	       profile.get_skip_to_calls("king"),
+	       profile.get_skip_to_calls());
+    TEST_EQUAL(profile.get_postings_decoded("nosuchterm"), 0);
+    TEST_REL(profile.get_blocks_read("postlist") +
+	     profile.get_cache_hits("postlist"),>,0);
+    TEST_EQUAL(profile.get_blocks_read("nosuchtable"), 0);
+
+    return true;
+}
+
+/// Test Database::get_stats().
+DEFINE_TESTCASE(iostats1, chert || glass || segmented) {
+    Xapian::Database db = get_database("etext");
+    Xapian::DatabaseStats before = db.get_stats();
+    tout << before.get_description() << endl;
+
+    Xapian::Enquire enq(db);
+    enq.set_query(Xapian::Query(Xapian::Query::OP_OR,
+				Xapian::Query("the"),
+				Xapian::Query("king")));
+    Xapian::MSet mset = enq.get_mset(0, 10);
+    for (Xapian::MSetIterator i = mset.begin(); i != mset.end(); ++i) {
+	(void)i.get_document().get_data();
+    }
+
+    Xapian::DatabaseStats after = db.get_stats();
+    tout << after.get_description() << endl;
+    TEST_REL(after.get_blocks_read("postlist") +
+	     after.get_cache_hits("postlist"),>,
+	     before.get_blocks_read("postlist") +
+	     before.get_cache_hits("postlist"));
+    TEST_REL(after.get_blocks_read(),>,0);
+    TEST_REL(after.get_bytes_read(),>=,after.get_blocks_read());
+    TEST_REL(after.get_pread_calls(),>=,after.get_blocks_read());
+    TEST_EQUAL(after.get_blocks_read(),
+	       after.get_blocks_read("postlist") +
+	       after.get_blocks_read("position") +
+	       after.get_blocks_read("termlist") +
+	       after.get_blocks_read("synonym") +
+	       after.get_blocks_read("spelling") +
+	       after.get_blocks_read(get_dbtype() == "chert" ? "record" : "docdata"));
+    TEST_EQUAL(after.get_blocks_read("nosuchtable"), 0);
+
+    // The counts are a snapshot, so shouldn't change after they're taken.
+    unsigned long long blocks_read = before.get_blocks_read();
+    TEST_REL(blocks_read,<=,after.get_blocks_read());
+    TEST_EQUAL(before.get_blocks_read(), blocks_read);
+
+    return true;
+}
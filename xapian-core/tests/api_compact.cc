@@ -27,6 +27,7 @@
 #include <xapian.h>
 
 #include "apitest.h"
+#include "backendmanager.h"
 #include "dbcheck.h"
 #include "filetests.h"
 #include "str.h"
@@ -35,6 +36,7 @@
 
 #include <cstdlib>
 #include <fstream>
+#include <vector>
 
 #include <sys/types.h>
 #include "safesysstat.h"
@@ -663,3 +665,252 @@ DEFINE_TESTCASE(compactsingle1, glass) {
 
     return true;
 }
+
+// Test DBCOMPACT_IMPACT_BOUNDS.
+DEFINE_TESTCASE(compactimpactbounds1, glass) {
+    Xapian::Database indb(get_database("apitest_simpledata"));
+    string outdbpath = get_named_writable_database_path("compactimpactbounds1");
+    rm_rf(outdbpath);
+
+    indb.compact(outdbpath, Xapian::DBCOMPACT_IMPACT_BOUNDS);
+
+    {
+	Xapian::Database outdb(outdbpath);
+	dbcheck(outdb, outdb.get_doccount(), outdb.get_doccount());
+	TEST_EQUAL(Xapian::Database::check(outdbpath, 0, &tout), 0);
+
+	bool tighter = false;
+	for (Xapian::TermIterator t = outdb.allterms_begin();
+	     t != outdb.allterms_end(); ++t) {
+	    Xapian::termcount max_wdf = 0;
+	    for (Xapian::PostingIterator p = outdb.postlist_begin(*t);
+		 p != outdb.postlist_end(*t); ++p) {
+		max_wdf = max(max_wdf, p.get_wdf());
+	    }
+	    // The bound should be exact.
+	    TEST_EQUAL(outdb.get_wdf_upper_bound(*t), max_wdf);
+	    if (max_wdf < indb.get_wdf_upper_bound(*t))
+		tighter = true;
+	}
+	TEST(tighter);
+
+	// The empty term's key holds the revision, so mustn't be read as
+	// bounds.
+	TEST_EQUAL(outdb.get_wdf_upper_bound(string()),
+		   indb.get_wdf_upper_bound(string()));
+	Xapian::Enquire enq_all(outdb);
+	enq_all.set_query(Xapian::Query::MatchAll);
+	TEST_EQUAL(enq_all.get_mset(0, 10).size(), outdb.get_doccount());
+
+	// Check that search results are unaffected.
+	Xapian::Enquire enq_in(indb), enq_out(outdb);
+	Xapian::Query query(Xapian::Query::OP_OR,
+			    Xapian::Query("this"), Xapian::Query("paragraph"));
+	enq_in.set_query(query);
+	enq_out.set_query(query);
+	Xapian::MSet mset_in = enq_in.get_mset(0, 3);
+	Xapian::MSet mset_out = enq_out.get_mset(0, 3);
+	TEST(mset_range_is_same(mset_in, 0, mset_out, 0, mset_in.size()));
+    }
+
+    // Once the database is modified, the stored bounds must not be used.
+    {
+	Xapian::WritableDatabase db(outdbpath, Xapian::DB_OPEN);
+	Xapian::Document doc;
+	doc.add_term("paragraph", 100);
+	db.add_document(doc);
+	TEST_REL(db.get_wdf_upper_bound("paragraph"),>=,100);
+	db.commit();
+	TEST_REL(db.get_wdf_upper_bound("paragraph"),>=,100);
+    }
+
+    Xapian::Database outdb(outdbpath);
+    TEST_REL(outdb.get_wdf_upper_bound("paragraph"),>=,100);
+    TEST_EQUAL(Xapian::Database::check(outdbpath, 0, &tout), 0);
+
+    return true;
+}
+
+// Test DBCOMPACT_IMPACT_BOUNDS with very sparse docids.
+DEFINE_TESTCASE(compactimpactbounds2, glass) {
+    Xapian::WritableDatabase indb =
+	get_named_writable_database("compactimpactbounds2in");
+    Xapian::Document doc;
+    doc.add_term("foo", 3);
+    doc.add_term("bar");
+    indb.replace_document(1, doc);
+    doc.add_term("foo", 2);
+    indb.replace_document(0xfffffff0, doc);
+    indb.commit();
+
+    string outdbpath = get_named_writable_database_path("compactimpactbounds2");
+    rm_rf(outdbpath);
+
+    // This used to need memory proportional to the highest docid.
+    indb.compact(outdbpath,
+		 Xapian::DBCOMPACT_NO_RENUMBER | Xapian::DBCOMPACT_IMPACT_BOUNDS);
+
+    Xapian::Database outdb(outdbpath);
+    TEST_EQUAL(outdb.get_doccount(), 2);
+    TEST_EQUAL(outdb.get_lastdocid(), 0xfffffff0);
+    TEST_EQUAL(outdb.get_wdf_upper_bound("foo"), 5);
+    TEST_EQUAL(outdb.get_wdf_upper_bound("bar"), 1);
+    TEST_EQUAL(outdb.get_doclength(0xfffffff0), 6);
+
+    return true;
+}
+
+// Test WritableDatabase::compact_incrementally().
+DEFINE_TESTCASE(compactinplace1, glass) {
+    Xapian::WritableDatabase db = get_named_writable_database("compactinplace1");
+    string path = get_named_writable_database_path("compactinplace1");
+    for (int i = 1; i <= 1000; ++i) {
+	Xapian::Document doc;
+	doc.add_term("all");
+	doc.add_term("Q" + str(i));
+	doc.add_posting("word" + str(i % 7), 1);
+	doc.set_data(string(100, 'x'));
+	doc.add_value(0, str(i));
+	db.add_document(doc);
+    }
+    db.commit();
+    for (Xapian::docid did = 1; did <= 1000; did += 2) {
+	db.delete_document(did);
+    }
+    db.commit();
+
+    string old_uuid = db.get_uuid();
+    Xapian::Database reader(path);
+    TEST_EQUAL(reader.get_doccount(), 500);
+
+    db.begin_transaction();
+    TEST_EXCEPTION(Xapian::InvalidOperationError, db.compact_incrementally());
+    db.cancel_transaction();
+
+    Xapian::doccount calls = 0;
+    do {
+	++calls;
+	// Interleave modifications with compaction.
+	Xapian::Document doc;
+	doc.add_term("all");
+	doc.add_term("new");
+	db.add_document(doc);
+    } while (db.compact_incrementally(Xapian::Compactor::FULL, 1e9));
+    TEST_REL(calls,>,1);
+    db.commit();
+
+    TEST_NOT_EQUAL(db.get_uuid(), old_uuid);
+    TEST_EQUAL(db.get_doccount(), 500 + calls);
+    TEST_EQUAL(db.get_termfreq("all"), 500 + calls);
+    TEST_EQUAL(db.get_termfreq("new"), calls);
+    TEST_EQUAL(db.get_document(2).get_data(), string(100, 'x'));
+    TEST_EQUAL(db.get_document(1000).get_value(0), "1000");
+
+    // The reader should still see the revision it had open.
+    TEST_EQUAL(reader.get_doccount(), 500);
+    TEST_EQUAL(reader.get_termfreq("new"), 0);
+    TEST_EQUAL(reader.postlist_begin("Q2").get_doclength(), 3);
+    TEST(reader.reopen());
+    TEST_EQUAL(reader.get_doccount(), 500 + calls);
+    TEST_EQUAL(reader.get_uuid(), db.get_uuid());
+
+    // A second pass should start from the first table again.
+    TEST(db.compact_incrementally(Xapian::Compactor::FULLER));
+    db.close();
+
+    TEST_EQUAL(Xapian::Database::check(path, 0, &tout), 0);
+    Xapian::Database check_db(path);
+    TEST_EQUAL(check_db.get_doccount(), 500 + calls);
+    Xapian::PositionIterator p = check_db.positionlist_begin(1000, "word6");
+    TEST(p != check_db.positionlist_end(1000, "word6"));
+    TEST_EQUAL(*p, 1);
+
+    return true;
+}
+
+/// Test xapian-bulkload gives the same database as add_document().
+DEFINE_TESTCASE(bulkload1, glass) {
+    string path = get_named_writable_database_path("bulkload1");
+    string ref_path = get_named_writable_database_path("bulkload1ref");
+    string input = path + ".txt";
+    rm_rf(path);
+    rm_rf(path + ".tmp");
+
+    Xapian::WritableDatabase ref(ref_path,
+				 Xapian::DB_CREATE_OR_OVERWRITE |
+				 Xapian::DB_BACKEND_GLASS);
+    Xapian::TermGenerator indexer;
+    {
+	ofstream out(input.c_str());
+	for (int i = 1; i <= 25; ++i) {
+	    // Two lines for some paragraphs, which are joined with a space.
+	    string para = "doc" + str(i) + " common word" + str(i % 4) +
+			  " common";
+	    out << para;
+	    if (i % 3 == 0) {
+		string line = "second line " + str(i * 7 % 5);
+		out << '\n' << line;
+		para += ' ';
+		para += line;
+	    }
+	    out << "\n\n";
+
+	    Xapian::Document doc;
+	    doc.set_data(para);
+	    indexer.set_document(doc);
+	    indexer.index_text(para);
+	    ref.add_document(doc);
+	}
+    }
+    ref.commit();
+
+    // A small run size and merge width force several levels of merging.
+    string cmd = XAPIAN_BIN_PATH "xapian-bulkload -q -r 3 -w 2 ";
+    cmd += path;
+    cmd += ' ';
+    cmd += input;
+    TEST_EQUAL(system(cmd.c_str()), 0);
+    TEST(!dir_exists(path + ".tmp"));
+
+    Xapian::Database db(path);
+    TEST_EQUAL(Xapian::Database::check(path, 0, &tout), 0);
+    TEST_EQUAL(db.get_doccount(), ref.get_doccount());
+    TEST_EQUAL(db.get_lastdocid(), ref.get_lastdocid());
+    TEST_EQUAL(db.get_avlength(), ref.get_avlength());
+
+    Xapian::TermIterator t = db.allterms_begin();
+    Xapian::TermIterator ref_t = ref.allterms_begin();
+    for ( ; ref_t != ref.allterms_end(); ++t, ++ref_t) {
+	TEST(t != db.allterms_end());
+	const string & term = *ref_t;
+	TEST_EQUAL(*t, term);
+	TEST_EQUAL(t.get_termfreq(), ref_t.get_termfreq());
+	TEST_EQUAL(db.get_collection_freq(term), ref.get_collection_freq(term));
+
+	Xapian::PostingIterator p = db.postlist_begin(term);
+	Xapian::PostingIterator ref_p = ref.postlist_begin(term);
+	for ( ; ref_p != ref.postlist_end(term); ++p, ++ref_p) {
+	    TEST(p != db.postlist_end(term));
+	    TEST_EQUAL(*p, *ref_p);
+	    TEST_EQUAL(p.get_wdf(), ref_p.get_wdf());
+	    TEST_EQUAL(p.get_doclength(), ref_p.get_doclength());
+
+	    Xapian::docid did = *ref_p;
+	    vector<Xapian::termpos> positions(db.positionlist_begin(did, term),
+					      db.positionlist_end(did, term));
+	    vector<Xapian::termpos> ref_positions(
+		ref.positionlist_begin(did, term),
+		ref.positionlist_end(did, term));
+	    TEST(positions == ref_positions);
+	}
+	TEST(p == db.postlist_end(term));
+    }
+    TEST(t == db.allterms_end());
+
+    for (Xapian::docid did = 1; did <= ref.get_lastdocid(); ++did) {
+	TEST_EQUAL(db.get_document(did).get_data(),
+		   ref.get_document(did).get_data());
+    }
+
+    return true;
+}
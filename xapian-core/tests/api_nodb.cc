@@ -28,6 +28,7 @@
 #include <xapian.h>
 
 #include "apitest.h"
+#include "str.h"
 #include "testsuite.h"
 #include "testutils.h"
 
@@ -425,6 +426,77 @@ DEFINE_TESTCASE(addvalue1, !backend) {
     return true;
 }
 
+/// Describe the terms, wdfs and positions of a document.
+static string
+describe_terms(const Xapian::Document & doc)
+{
+    string result;
+    for (Xapian::TermIterator t = doc.termlist_begin();
+	 t != doc.termlist_end(); ++t) {
+	if (!result.empty()) result += ' ';
+	result += *t;
+	result += ':';
+	result += str(t.get_wdf());
+	char sep = '[';
+	for (Xapian::PositionIterator p = t.positionlist_begin();
+	     p != t.positionlist_end(); ++p) {
+	    result += sep;
+	    result += str(*p);
+	    sep = ',';
+	}
+	if (sep == ',') result += ']';
+    }
+    return result;
+}
+
+// Test building up the terms of a new document.
+DEFINE_TESTCASE(addposting2, !backend) {
+    Xapian::Document doc;
+    doc.add_posting("dog", 3);
+    doc.add_posting("cat", 2);
+    doc.add_posting("dog", 1, 2);
+    doc.add_posting("dog", 3);
+    doc.add_term("cat");
+    doc.add_term("ant", 0);
+    TEST_EQUAL(doc.termlist_count(), 3);
+    TEST_EQUAL(describe_terms(doc), "ant:0 cat:2[2] dog:4[1,3]");
+
+    Xapian::TermIterator t = doc.termlist_begin();
+    t.skip_to("b");
+    TEST_EQUAL(*t, "cat");
+    TEST_EQUAL(t.positionlist_count(), 1);
+    t.skip_to("zebra");
+    TEST(t == doc.termlist_end());
+
+    // Add more terms than fit in the initial hash table.
+    for (Xapian::termpos i = 1; i <= 100; ++i) {
+	doc.add_posting("t" + str(i % 50), i);
+    }
+    TEST_EQUAL(doc.termlist_count(), 53);
+    t = doc.termlist_begin();
+    t.skip_to("t7");
+    TEST_EQUAL(*t, "t7");
+    TEST_EQUAL(t.get_wdf(), 2);
+    TEST_EQUAL(t.positionlist_count(), 2);
+    TEST_EQUAL(*t.positionlist_begin(), 7);
+
+    // Modifications which need the terms in the usual form.
+    doc.remove_posting("dog", 3, 1);
+    doc.remove_term("ant");
+    TEST_EXCEPTION(Xapian::InvalidArgumentError, doc.remove_term("ant"));
+    doc.add_posting("dog", 2);
+    TEST_EQUAL(doc.termlist_count(), 52);
+    TEST_EQUAL(describe_terms(doc).substr(0, 25), "cat:2[2] dog:4[1,2] t0:2[");
+
+    doc.clear_terms();
+    TEST_EQUAL(doc.termlist_count(), 0);
+    TEST(doc.termlist_begin() == doc.termlist_end());
+    doc.add_term("again");
+    TEST_EQUAL(describe_terms(doc), "again:1");
+
+    return true;
+}
+
 // tests that the collapsing on termpos optimisation gives correct query length
 DEFINE_TESTCASE(poscollapse2, !backend) {
     Xapian::Query q(Xapian::Query::OP_OR, Xapian::Query("this", 1, 1), Xapian::Query("this", 1, 1));
@@ -29,6 +29,12 @@
 #include "testutils.h"
 
 #include "apitest.h"
+#include "filetests.h"
+#include "unixcmds.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace std;
 
@@ -382,6 +388,353 @@ DEFINE_TESTCASE(dualprefixwildcard1, backend) {
     return true;
 }
 
+/// Simple glob matching for checking OP_WILDCARD with pattern flags.
+static bool
+glob_match(const char * pattern, const char * term)
+{
+    if (*pattern == '*')
+	return glob_match(pattern + 1, term) ||
+	       (*term && glob_match(pattern, term + 1));
+    if (*term == '\0') return *pattern == '\0';
+    if (*pattern == '?' || *pattern == *term)
+	return glob_match(pattern + 1, term + 1);
+    return false;
+}
+
+/// Feature test for WILDCARD_PATTERN_GLOB.
+DEFINE_TESTCASE(wildcardpattern1, backend) {
+    // FIXME: As for wildcard1, the expansion limit is per subdatabase.
+    SKIP_TEST_FOR_BACKEND("multi");
+    Xapian::Database db = get_database("apitest_simpledata");
+    Xapian::Enquire enq(db);
+    enq.set_weighting_scheme(Xapian::BoolWeight());
+    const Xapian::Query::op o = Xapian::Query::OP_WILDCARD;
+    const int flags = Xapian::Query::WILDCARD_PATTERN_GLOB;
+
+    static const char * const patterns[] = {
+	"*ing", "*is*", "t?e*", "*", "th*s", "*e?", "this", "thi", "*ph*",
+	"*zzz*", "s*e*h", "**o", "?", "*th*ee*", "p*ph"
+    };
+    for (const char * pattern : patterns) {
+	tout << pattern << endl;
+	vector<string> expected;
+	for (Xapian::TermIterator t = db.allterms_begin();
+	     t != db.allterms_end(); ++t) {
+	    if (glob_match(pattern, (*t).c_str()))
+		expected.push_back(*t);
+	}
+	Xapian::Query q(o, pattern, 0,
+			Xapian::Query::WILDCARD_LIMIT_ERROR | flags);
+	enq.set_query(q);
+	Xapian::MSet mset = enq.get_mset(0, 20);
+	enq.set_query(Xapian::Query(q.OP_SYNONYM,
+				    expected.begin(), expected.end()));
+	Xapian::MSet mset2 = enq.get_mset(0, 20);
+	TEST_EQUAL(mset.size(), mset2.size());
+	if (!mset.empty())
+	    TEST(mset_range_is_same(mset, 0, mset2, 0, mset.size()));
+
+	if (expected.size() > 1) {
+	    // Check the expansion limit is enforced.
+	    Xapian::Query ql(o, pattern, expected.size() - 1,
+			     Xapian::Query::WILDCARD_LIMIT_ERROR | flags);
+	    enq.set_query(ql);
+	    TEST_EXCEPTION(Xapian::WildcardError, enq.get_mset(0, 10));
+	}
+    }
+
+    // Without the flags, "*" and "?" aren't special.
+    enq.set_query(Xapian::Query(o, "*is"));
+    TEST(enq.get_mset(0, 10).empty());
+
+    return true;
+}
+
+/// Feature test for Xapian::DB_TERM_NGRAM_INDEX.
+DEFINE_TESTCASE(termngramindex1, glass) {
+    string path = get_named_writable_database_path("termngramindex1");
+    int flags = Xapian::DB_CREATE_OR_OVERWRITE |
+		Xapian::DB_BACKEND_GLASS |
+		Xapian::DB_TERM_NGRAM_INDEX;
+    Xapian::WritableDatabase db(path, flags);
+
+    static const char * const docs[] = {
+	"telephone", "phonetic spelling", "xylophone", "sing", "singing",
+	"microphones headphone", "ringing phone"
+    };
+    for (const char * text : docs) {
+	Xapian::Document doc;
+	Xapian::TermGenerator tg;
+	tg.set_document(doc);
+	tg.index_text(text);
+	db.add_document(doc);
+    }
+
+    const int pattern_flags = Xapian::Query::WILDCARD_LIMIT_ERROR |
+			      Xapian::Query::WILDCARD_PATTERN_GLOB;
+    Xapian::Query q_phone(Xapian::Query::OP_WILDCARD, "*phone*", 0,
+			  pattern_flags);
+    Xapian::Query q_ing(Xapian::Query::OP_WILDCARD, "*ing", 0,
+			pattern_flags);
+    Xapian::Query q_phon(Xapian::Query::OP_WILDCARD, "*?phon?", 0,
+			 pattern_flags);
+
+    // Check the index is used before the changes are committed.
+    Xapian::Enquire enq(db);
+    enq.set_weighting_scheme(Xapian::BoolWeight());
+    enq.set_query(q_phone);
+    mset_expect_order(enq.get_mset(0, 10), 1, 2, 3, 6, 7);
+    enq.set_query(q_ing);
+    mset_expect_order(enq.get_mset(0, 10), 2, 4, 5, 7);
+    db.commit();
+
+    Xapian::Database dbr(path);
+    Xapian::Enquire enqr(dbr);
+    enqr.set_weighting_scheme(Xapian::BoolWeight());
+    enqr.set_query(q_phone);
+    mset_expect_order(enqr.get_mset(0, 10), 1, 2, 3, 6, 7);
+    enqr.set_query(q_ing);
+    mset_expect_order(enqr.get_mset(0, 10), 2, 4, 5, 7);
+    enqr.set_query(q_phon);
+    mset_expect_order(enqr.get_mset(0, 10), 1, 3, 6);
+
+    // Check terms are removed from the index.
+    db.delete_document(7);
+    db.delete_document(4);
+    db.commit();
+    dbr.reopen();
+    enqr.set_query(q_phone);
+    mset_expect_order(enqr.get_mset(0, 10), 1, 2, 3, 6);
+    enqr.set_query(q_ing);
+    mset_expect_order(enqr.get_mset(0, 10), 2, 5);
+
+    // Check the index is maintained when the database is opened again
+    // without the flag.
+    db.close();
+    db = Xapian::WritableDatabase(path, Xapian::DB_OPEN);
+    Xapian::Document doc;
+    doc.add_term("smartphone");
+    doc.add_term("string");
+    db.add_document(doc);
+    db.commit();
+    dbr.reopen();
+    enqr.set_query(q_phone);
+    mset_expect_order(enqr.get_mset(0, 10), 1, 2, 3, 6, 8);
+    enqr.set_query(q_ing);
+    mset_expect_order(enqr.get_mset(0, 10), 2, 5, 8);
+
+    // Check the index survives compaction.
+    string out = get_named_writable_database_path("termngramindex1out");
+    rm_rf(out);
+    dbr.compact(out);
+    Xapian::Database dbc(out);
+    Xapian::Enquire enqc(dbc);
+    enqc.set_weighting_scheme(Xapian::BoolWeight());
+    enqc.set_query(q_phone);
+    mset_expect_order(enqc.get_mset(0, 10), 1, 2, 3, 6, 8);
+
+    return true;
+}
+
+/// Check DB_TERM_NGRAM_INDEX takes effect if the first commit has no documents.
+DEFINE_TESTCASE(termngramindex2, glass) {
+    string path = get_named_writable_database_path("termngramindex2");
+    int flags = Xapian::DB_CREATE_OR_OVERWRITE |
+		Xapian::DB_BACKEND_GLASS |
+		Xapian::DB_TERM_NGRAM_INDEX;
+    Xapian::WritableDatabase db(path, flags);
+    db.commit();
+    db.close();
+
+    // The index marker lives in the spelling table, which is only created
+    // when something is written to it.
+    TEST(file_exists(path + "/spelling.glass"));
+
+    // Terms added after opening without the flag must still be indexed.
+    db = Xapian::WritableDatabase(path, Xapian::DB_OPEN);
+    Xapian::Document doc;
+    doc.add_term("smartphone");
+    db.add_document(doc);
+    db.commit();
+
+    Xapian::Database dbr(path);
+    Xapian::Enquire enq(dbr);
+    enq.set_query(Xapian::Query(Xapian::Query::OP_WILDCARD, "*phone", 0,
+				Xapian::Query::WILDCARD_LIMIT_ERROR |
+				Xapian::Query::WILDCARD_PATTERN_GLOB));
+    mset_expect_order(enq.get_mset(0, 10), 1);
+
+    return true;
+}
+
+/// Check DB_TERM_NGRAM_INDEX sees uncommitted changes to existing terms.
+DEFINE_TESTCASE(termngramindex3, glass) {
+    string path = get_named_writable_database_path("termngramindex3");
+    int flags = Xapian::DB_CREATE_OR_OVERWRITE |
+		Xapian::DB_BACKEND_GLASS |
+		Xapian::DB_TERM_NGRAM_INDEX;
+    Xapian::WritableDatabase db(path, flags);
+
+    static const char * const docs[] = {
+	"telephone", "phonetic", "xylophone", "phonetic headphone"
+    };
+    for (const char * term : docs) {
+	Xapian::Document doc;
+	Xapian::TermGenerator tg;
+	tg.set_document(doc);
+	tg.index_text(term);
+	db.add_document(doc);
+    }
+    db.commit();
+
+    // Remove "xylophone" and the last "phonetic", but not "phone...".
+    db.delete_document(3);
+    db.delete_document(2);
+    Xapian::Document doc;
+    doc.add_term("earphone");
+    db.add_document(doc);
+    doc = Xapian::Document();
+    doc.add_term("telephone");
+    db.replace_document(4, doc);
+
+    // Only "earphone" and "telephone" exist now, so a limit of 2 terms
+    // shouldn't be exceeded.
+    Xapian::Query query(Xapian::Query::OP_WILDCARD, "*phone*", 2,
+			Xapian::Query::WILDCARD_LIMIT_ERROR |
+			Xapian::Query::WILDCARD_PATTERN_GLOB);
+    Xapian::Enquire enq(db);
+    enq.set_weighting_scheme(Xapian::BoolWeight());
+    enq.set_query(query);
+    mset_expect_order(enq.get_mset(0, 10), 1, 4, 5);
+
+    db.commit();
+    Xapian::Database dbr(path);
+    Xapian::Enquire enqr(dbr);
+    enqr.set_weighting_scheme(Xapian::BoolWeight());
+    enqr.set_query(query);
+    mset_expect_order(enqr.get_mset(0, 10), 1, 4, 5);
+
+    return true;
+}
+
+/// Simple edit distance for checking OP_EDIT_DISTANCE.
+static int
+osa_distance(const string & a, const string & b)
+{
+    vector<vector<int>> d(a.size() + 1, vector<int>(b.size() + 1));
+    for (size_t i = 0; i <= a.size(); ++i) d[i][0] = int(i);
+    for (size_t j = 0; j <= b.size(); ++j) d[0][j] = int(j);
+    for (size_t i = 1; i <= a.size(); ++i) {
+	for (size_t j = 1; j <= b.size(); ++j) {
+	    int cost = (a[i - 1] != b[j - 1]);
+	    int r = min(d[i - 1][j - 1] + cost, min(d[i - 1][j], d[i][j - 1]) + 1);
+	    if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+		r = min(r, d[i - 2][j - 2] + 1);
+	    d[i][j] = r;
+	}
+    }
+    return d[a.size()][b.size()];
+}
+
+/// Feature test for OP_EDIT_DISTANCE.
+DEFINE_TESTCASE(editdistance1, backend) {
+    // FIXME: As for wildcard1, the expansion limit is per subdatabase.
+    SKIP_TEST_FOR_BACKEND("multi");
+    Xapian::Database db = get_database("apitest_simpledata");
+    Xapian::Enquire enq(db);
+    // A synonym of a single term is simplified to just that term, which is
+    // weighted differently, so just compare the documents matched.
+    enq.set_weighting_scheme(Xapian::BoolWeight());
+    const Xapian::Query::op o = Xapian::Query::OP_EDIT_DISTANCE;
+
+    static const char * const targets[] = {
+	"thou", "paragraf", "wrod", "smiple", "tihs", "x", "", "zzzzzzzz"
+    };
+    for (const char * target : targets) {
+	for (unsigned edist = 0; edist <= 3; ++edist) {
+	    tout << target << " ~" << edist << endl;
+	    vector<string> expected;
+	    for (Xapian::TermIterator t = db.allterms_begin();
+		 t != db.allterms_end(); ++t) {
+		if (osa_distance(target, *t) <= int(edist))
+		    expected.push_back(*t);
+	    }
+	    Xapian::Query q(o, target, 0, Xapian::Query::WILDCARD_LIMIT_ERROR,
+			    Xapian::Query::OP_SYNONYM, edist);
+	    enq.set_query(q);
+	    Xapian::MSet mset = enq.get_mset(0, 20);
+	    enq.set_query(Xapian::Query(q.OP_SYNONYM,
+					expected.begin(), expected.end()));
+	    Xapian::MSet mset2 = enq.get_mset(0, 20);
+	    TEST_EQUAL(mset.size(), mset2.size());
+	    if (!mset.empty())
+		TEST(mset_range_is_same(mset, 0, mset2, 0, mset.size()));
+
+	    if (expected.size() > 1) {
+		// Check the expansion limit is enforced.
+		Xapian::Query ql(o, target, expected.size() - 1,
+				 Xapian::Query::WILDCARD_LIMIT_ERROR,
+				 Xapian::Query::OP_SYNONYM, edist);
+		enq.set_query(ql);
+		TEST_EXCEPTION(Xapian::WildcardError, enq.get_mset(0, 10));
+
+		// Flags in max_type mustn't change how the limit is applied.
+		Xapian::Query qfirst(o, target, expected.size() - 1,
+				     Xapian::Query::WILDCARD_LIMIT_FIRST,
+				     Xapian::Query::OP_SYNONYM, edist);
+		enq.set_query(qfirst);
+		Xapian::MSet mset_first = enq.get_mset(0, 20);
+		Xapian::Query qf(o, target, expected.size() - 1,
+				 Xapian::Query::WILDCARD_LIMIT_FIRST |
+				 Xapian::Query::WILDCARD_PATTERN_GLOB,
+				 Xapian::Query::OP_SYNONYM, edist);
+		enq.set_query(qf);
+		Xapian::MSet mset_flags = enq.get_mset(0, 20);
+		TEST_EQUAL(mset_flags.size(), mset_first.size());
+		if (!mset_first.empty())
+		    TEST(mset_range_is_same(mset_flags, 0, mset_first, 0,
+					    mset_first.size()));
+	    }
+	}
+    }
+
+    // Check requiring a common prefix.
+    Xapian::Query q(o, "wrod", 0, Xapian::Query::WILDCARD_LIMIT_ERROR,
+		    Xapian::Query::OP_SYNONYM, 2, 1);
+    TEST_STRINGS_EQUAL(q.get_description(),
+		       "Query(EDIT_DISTANCE SYNONYM wrod~2 fixed:1)");
+    enq.set_query(q);
+    Xapian::MSet mset = enq.get_mset(0, 20);
+    enq.set_query(Xapian::Query("word"));
+    Xapian::MSet mset2 = enq.get_mset(0, 20);
+    TEST_EQUAL(mset.size(), mset2.size());
+    TEST(mset_range_is_same(mset, 0, mset2, 0, mset.size()));
+
+    return true;
+}
+
+/// Check an unreasonably large edit distance is rejected.
+DEFINE_TESTCASE(editdistance2, !backend) {
+    const Xapian::Query::op o = Xapian::Query::OP_EDIT_DISTANCE;
+    Xapian::Query q(o, "wrod", 0, Xapian::Query::WILDCARD_LIMIT_ERROR,
+		    Xapian::Query::OP_SYNONYM, 255);
+    TEST_EXCEPTION(Xapian::InvalidArgumentError,
+	Xapian::Query(o, "wrod", 0, Xapian::Query::WILDCARD_LIMIT_ERROR,
+		      Xapian::Query::OP_SYNONYM, 256));
+    TEST_EXCEPTION(Xapian::InvalidArgumentError,
+	Xapian::Query(o, "wrod", 0, Xapian::Query::WILDCARD_LIMIT_ERROR,
+		      Xapian::Query::OP_SYNONYM, unsigned(-1)));
+
+    // Patch the serialised edit distance from 255 to 256.
+    string s = q.serialise();
+    string::size_type i = s.find("\xff\x80");
+    TEST(i != string::npos);
+    s[i + 1] = '\x81';
+    TEST_EXCEPTION(Xapian::InvalidArgumentError, Xapian::Query::unserialise(s));
+
+    return true;
+}
+
 struct positional_testcase {
     int window;
     const char * terms[4];
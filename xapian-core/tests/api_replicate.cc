@@ -37,6 +37,7 @@
 #include "safefcntl.h"
 #include "safesysstat.h"
 #include "safeunistd.h"
+#include "str.h"
 #include "testsuite.h"
 #include "testutils.h"
 #include "unixcmds.h"
@@ -45,6 +46,7 @@
 
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 #include <stdlib.h> // For setenv() or putenv()
 
@@ -909,3 +911,133 @@ DEFINE_TESTCASE(replicate7, replicas) {
     rmtmpdir(tempdir);
     return true;
 }
+
+// Test resuming, skipping unchanged data and fetching parts in parallel for
+// full database copies.
+DEFINE_TESTCASE(replicate8, replicas) {
+    UNSET_MAX_CHANGESETS_AFTERWARDS;
+    string tempdir = ".replicatmp";
+    mktmpdir(tempdir);
+    string masterpath = get_named_writable_database_path("master");
+
+    Xapian::WritableDatabase orig(get_named_writable_database("master"));
+    Xapian::DatabaseMaster master(masterpath);
+    // Add enough data that the tables span a good number of ranges, and
+    // which doesn't compress to almost nothing.
+    unsigned seed = 1;
+    for (int i = 0; i != 2000; ++i) {
+	Xapian::Document doc;
+	string data;
+	for (int j = 0; j != 2000; ++j) {
+	    seed = seed * 1103515245 + 12345;
+	    data += char('a' + (seed >> 16) % 26);
+	}
+	doc.set_data(data);
+	doc.add_term("Q" + str(i));
+	doc.add_term("x" + str(i % 37));
+	orig.add_document(doc);
+    }
+    orig.commit();
+
+    string changesetpath = tempdir + "/changeset";
+    off_t full_size;
+    {
+	// Interrupt a copy part way through.
+	Xapian::DatabaseReplica replica(tempdir + "/replica");
+	get_changeset(changesetpath, master, replica, 0, 1, true);
+	full_size = get_file_size(changesetpath);
+	TEST(truncate(changesetpath.c_str(), full_size / 2) == 0);
+	FD fd(open(changesetpath.c_str(), O_RDONLY | O_BINARY));
+	TEST(fd != -1);
+	replica.set_read_fd(fd);
+	TEST_EXCEPTION(Xapian::NetworkError,
+		       replica.apply_next_changeset(NULL, 0));
+    }
+    {
+	// Resuming the copy should only need to send the rest of it.
+	Xapian::DatabaseReplica replica(tempdir + "/replica");
+	{
+	    FD fd(open(changesetpath.c_str(),
+		       O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666));
+	    TEST(fd != -1);
+	    master.write_changesets_to_fd(fd, replica.get_revision_info(), NULL,
+					  replica.get_copy_info());
+	}
+	off_t resume_size = get_file_size(changesetpath);
+	tout << "full copy: " << full_size << " resumed: " << resume_size
+	     << '\n';
+	TEST_REL(resume_size, <, full_size * 3 / 4);
+	TEST_EQUAL(apply_changeset(changesetpath, replica, 0, 1, true), 1);
+	check_equal_dbs(masterpath, tempdir + "/replica");
+    }
+
+    string replicapath = tempdir + "/replica2";
+    {
+	// Fetch a copy in three parts, as if over three connections.
+	Xapian::DatabaseReplica replica(replicapath);
+	string revision = replica.get_revision_info();
+	TEST(master.copy_needed(revision));
+	string copy_info = replica.get_copy_info();
+	vector<int> fds;
+	for (unsigned part = 0; part != 3; ++part) {
+	    string partpath = tempdir + "/part" + str(part);
+	    {
+		FD fd(open(partpath.c_str(),
+			   O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666));
+		TEST(fd != -1);
+		master.write_copy_part_to_fd(fd, revision, copy_info, part, 3);
+	    }
+	    int fd = open(partpath.c_str(), O_RDONLY | O_BINARY);
+	    TEST(fd != -1);
+	    fds.push_back(fd);
+	}
+	replica.prefetch_copy(fds);
+	for (int fd : fds) close(fd);
+
+	// The copy should then need almost nothing sending.
+	{
+	    FD fd(open(changesetpath.c_str(),
+		       O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666));
+	    TEST(fd != -1);
+	    master.write_changesets_to_fd(fd, revision, NULL,
+					  replica.get_copy_info());
+	}
+	off_t final_size = get_file_size(changesetpath);
+	tout << "after prefetch: " << final_size << '\n';
+	TEST_REL(final_size, <, full_size / 10);
+	TEST_EQUAL(apply_changeset(changesetpath, replica, 0, 1, true), 1);
+	check_equal_dbs(masterpath, replicapath);
+	TEST(!master.copy_needed(replica.get_revision_info()));
+    }
+
+    // Change the master without storing changesets, so a full copy is
+    // needed, but most of the data should be unchanged.
+    for (int i = 0; i != 10; ++i) {
+	Xapian::Document doc;
+	doc.set_data("new" + str(i));
+	doc.add_term("Qnew" + str(i));
+	orig.add_document(doc);
+    }
+    orig.commit();
+    {
+	Xapian::DatabaseReplica replica(replicapath);
+	TEST(master.copy_needed(replica.get_revision_info()));
+	{
+	    FD fd(open(changesetpath.c_str(),
+		       O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666));
+	    TEST(fd != -1);
+	    Xapian::ReplicationInfo info;
+	    master.write_changesets_to_fd(fd, replica.get_revision_info(),
+					  &info, replica.get_copy_info());
+	    TEST_EQUAL(info.fullcopy_count, 1);
+	}
+	off_t update_size = get_file_size(changesetpath);
+	tout << "update: " << update_size << '\n';
+	TEST_REL(update_size, <, full_size / 2);
+	TEST_EQUAL(apply_changeset(changesetpath, replica, 0, 1, true), 1);
+	check_equal_dbs(masterpath, replicapath);
+    }
+
+    rmtmpdir(tempdir);
+    return true;
+}
@@ -195,6 +195,12 @@ DEFINE_TESTCASE(serialise_query1, !backend) {
     TEST_EQUAL(q.get_description(), q2.get_description());
     TEST_EQUAL(q.get_description(), "Query(hello@1)");
 
+    q = Xapian::Query(q.OP_EDIT_DISTANCE, "helo", 10,
+		      Xapian::Query::WILDCARD_LIMIT_FIRST, q.OP_MAX, 1, 2);
+    q2 = Xapian::Query::unserialise(q.serialise());
+    TEST_EQUAL(q.get_description(), q2.get_description());
+    TEST_EQUAL(q.get_description(), "Query(EDIT_DISTANCE MAX helo~1 fixed:2)");
+
     q = Xapian::Query(q.OP_OR, Xapian::Query("hello"), Xapian::Query("world"));
     q2 = Xapian::Query::unserialise(q.serialise());
     TEST_EQUAL(q.get_description(), q2.get_description());
@@ -130,9 +130,12 @@ DEFINE_TESTCASE(snippetphrase1, backend) {
     return true;
 }
 
-/// Index file to a DB with TermGenerator.
+/** Index file to a DB with TermGenerator.
+ *
+ *  If @a offsets is true, also store word offsets in slot 0.
+ */
 static void
-make_tg_db(Xapian::WritableDatabase &db, const string & source)
+make_tg_db(Xapian::WritableDatabase &db, const string & source, bool offsets)
 {
     string file = test_driver::get_srcdir();
     file += "/testdata/";
@@ -146,6 +149,7 @@ make_tg_db(Xapian::WritableDatabase &db, const string & source)
 
     Xapian::TermGenerator tg;
     tg.set_stemmer(Xapian::Stem("en"));
+    if (offsets) tg.set_offsets_slot(0);
     while (!input.eof()) {
 	Xapian::Document doc;
 	tg.set_document(doc);
@@ -154,15 +158,25 @@ make_tg_db(Xapian::WritableDatabase &db, const string & source)
 	    getline(input, line);
 	    if (find_if(line.begin(), line.end(), C_isnotspace) == line.end())
 		break;
-	    tg.index_text(line);
+	    if (!offsets) tg.index_text(line);
 	    if (!data.empty()) data += ' ';
 	    data += line;
 	}
+	// The offsets are relative to the text passed to each call, so index
+	// the whole text in one go.
+	if (offsets) tg.index_text(data);
 	doc.set_data(data);
 	db.add_document(doc);
     }
 }
 
+/// Index file to a DB with TermGenerator.
+static void
+make_tg_db(Xapian::WritableDatabase &db, const string & source)
+{
+    make_tg_db(db, source, false);
+}
+
 /// Test snippets in various ways.
 DEFINE_TESTCASE(snippetmisc1, generated) {
     Xapian::Database db = get_database("snippet", make_tg_db, "snippet");
@@ -210,3 +224,68 @@ DEFINE_TESTCASE(snippetmisc1, generated) {
 
     return true;
 }
+
+/// Index file to a DB with TermGenerator, storing word offsets in slot 0.
+static void
+make_tg_offsets_db(Xapian::WritableDatabase &db, const string & source)
+{
+    make_tg_db(db, source, true);
+}
+
+/// Test snippets generated from stored word offsets.
+DEFINE_TESTCASE(snippetoffsets1, generated) {
+    Xapian::Database db = get_database("snippetoffsets", make_tg_offsets_db,
+				       "snippet");
+    Xapian::Enquire enquire(db);
+    Xapian::Stem stem("en");
+    const unsigned flags = Xapian::MSet::SNIPPET_EXHAUSTIVE;
+
+    static const char * words[] = { "do", "we", "have" };
+    Xapian::Query phrase(Xapian::Query::OP_PHRASE, words, words + 3);
+    enquire.set_query(phrase);
+    Xapian::MSet mset = enquire.get_mset(0, 6);
+    TEST_EQUAL(mset.size(), 3);
+    bool found = false;
+    for (Xapian::MSetIterator i = mset.begin(); i != mset.end(); ++i) {
+	const string & text = i.get_document().get_data();
+	if (!startswith(text, "We do have")) continue;
+	TEST_STRINGS_EQUAL(mset.snippet(text, *i, 0, 32, stem),
+			   "We do have we <b>do we have</b> do we.");
+	found = true;
+    }
+    TEST(found);
+
+    // The offsets should give the same snippets as parsing the text does
+    // (when the background model isn't in use).
+    const Xapian::Query queries[] = {
+	phrase,
+	Xapian::Query("Zwelcom") | Xapian::Query("Zmike"),
+	Xapian::Query(Xapian::Query::OP_WILDCARD, "m"),
+	Xapian::Query("much") | Xapian::Query("Zbrien") | phrase,
+    };
+    for (const Xapian::Query & query : queries) {
+	enquire.set_query(query);
+	mset = enquire.get_mset(0, 10);
+	TEST(!mset.empty());
+	for (Xapian::MSetIterator i = mset.begin(); i != mset.end(); ++i) {
+	    const string & text = i.get_document().get_data();
+	    for (size_t len = 5; len < 120; len += 7) {
+		tout << query.get_description() << " docid " << *i
+		     << " length " << len << '\n';
+		TEST_STRINGS_EQUAL(mset.snippet(text, *i, 0, len, stem, flags),
+				   mset.snippet(text, len, stem, flags));
+	    }
+	}
+    }
+
+    // If the text doesn't match the stored offsets, or there aren't any, the
+    // text should be parsed instead.
+    string text = mset.begin().get_document().get_data();
+    text += " Mike's mechanic";
+    TEST_STRINGS_EQUAL(mset.snippet(text, *mset.begin(), 0, 40, stem, flags),
+		       mset.snippet(text, 40, stem, flags));
+    TEST_STRINGS_EQUAL(mset.snippet(text, *mset.begin(), 1, 40, stem, flags),
+		       mset.snippet(text, 40, stem, flags));
+
+    return true;
+}
@@ -28,6 +28,7 @@
 #include "apitest.h"
 #include "testsuite.h"
 #include "testutils.h"
+#include "unixcmds.h"
 
 #include <string>
 
@@ -314,3 +315,94 @@ DEFINE_TESTCASE(spell8, spelling) {
 
     return true;
 }
+
+/// Feature test for Xapian::DB_SPELLING_DELETION_INDEX.
+DEFINE_TESTCASE(spelldeletion1, glass) {
+    string path = get_named_writable_database_path("spelldeletion1");
+    int flags = Xapian::DB_CREATE_OR_OVERWRITE |
+		Xapian::DB_BACKEND_GLASS |
+		Xapian::DB_SPELLING_DELETION_INDEX;
+    Xapian::WritableDatabase db(path, flags);
+
+    db.add_spelling("hello");
+    db.add_spelling("cell", 2);
+    db.add_spelling("zig");
+    db.add_spelling("word");
+    db.add_spelling("transposition");
+    // Check suggestions work before the changes are committed.
+    TEST_EQUAL(db.get_spelling_suggestion("hell"), "cell");
+    db.commit();
+
+    Xapian::Database dbr(path);
+    TEST_EQUAL(dbr.get_spelling_suggestion("hell"), "cell");
+    TEST_EQUAL(dbr.get_spelling_suggestion("helo"), "hello");
+    // Transposition, substitution, insertion and deletion.
+    TEST_EQUAL(dbr.get_spelling_suggestion("izg"), "zig");
+    TEST_EQUAL(dbr.get_spelling_suggestion("sig"), "zig");
+    TEST_EQUAL(dbr.get_spelling_suggestion("ziig"), "zig");
+    TEST_EQUAL(dbr.get_spelling_suggestion("zg"), "zig");
+    TEST_EQUAL(dbr.get_spelling_suggestion("wrod"), "word");
+    TEST_EQUAL(dbr.get_spelling_suggestion("trnasposition"), "transposition");
+    TEST_EQUAL(dbr.get_spelling_suggestion("transpositoin"), "transposition");
+    TEST_EQUAL(dbr.get_spelling_suggestion("xyzzy"), "");
+    // The trigram approach doesn't find substitutions in two character words.
+    db.add_spelling("ox");
+    db.commit();
+    dbr.reopen();
+    TEST_EQUAL(dbr.get_spelling_suggestion("ax"), "ox");
+
+    db.remove_spelling("zig");
+    db.commit();
+    dbr.reopen();
+    TEST_EQUAL(dbr.get_spelling_suggestion("izg"), "");
+
+    // Check the deletion index is maintained when the database is opened
+    // again without the flag.
+    db.close();
+    db = Xapian::WritableDatabase(path, Xapian::DB_OPEN);
+    db.add_spelling("zag");
+    db.commit();
+    dbr.reopen();
+    TEST_EQUAL(dbr.get_spelling_suggestion("zga"), "zag");
+
+    // Check the deletion index survives compaction.
+    string out = get_named_writable_database_path("spelldeletion1out");
+    rm_rf(out);
+    dbr.compact(out);
+    Xapian::Database dbc(out);
+    TEST_EQUAL(dbc.get_spelling_suggestion("hell"), "cell");
+    TEST_EQUAL(dbc.get_spelling_suggestion("zga"), "zag");
+    TEST_EQUAL(dbc.get_spelling_suggestion("trnasposition"), "transposition");
+
+    return true;
+}
+
+/// Check the deletion index starts alongside a term n-gram index.
+DEFINE_TESTCASE(spelldeletion2, glass) {
+    string path = get_named_writable_database_path("spelldeletion2");
+    int flags = Xapian::DB_CREATE_OR_OVERWRITE |
+		Xapian::DB_BACKEND_GLASS |
+		Xapian::DB_TERM_NGRAM_INDEX |
+		Xapian::DB_SPELLING_DELETION_INDEX;
+    Xapian::WritableDatabase db(path, flags);
+    // This commit writes the term n-gram index marker to the spelling table
+    // before there are any spelling words.
+    db.commit();
+
+    Xapian::Document doc;
+    doc.add_term("smartphone");
+    db.add_document(doc);
+    db.add_spelling("ox");
+    db.commit();
+
+    Xapian::Database dbr(path);
+    // The trigram approach doesn't find substitutions in two character words.
+    TEST_EQUAL(dbr.get_spelling_suggestion("ax"), "ox");
+    Xapian::Enquire enq(dbr);
+    enq.set_query(Xapian::Query(Xapian::Query::OP_WILDCARD, "*phone", 0,
+				Xapian::Query::WILDCARD_LIMIT_ERROR |
+				Xapian::Query::WILDCARD_PATTERN_GLOB));
+    TEST_EQUAL(enq.get_mset(0, 10).size(), 1);
+
+    return true;
+}
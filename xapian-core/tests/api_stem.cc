@@ -24,6 +24,9 @@
 
 #include <xapian.h>
 
+#include <string>
+#include <vector>
+
 #include "apitest.h"
 #include "testsuite.h"
 #include "testutils.h"
@@ -87,3 +90,43 @@ DEFINE_TESTCASE(stemlangs2, !backend) {
     }
     return true;
 }
+
+/// Test Stem::stem_into().
+DEFINE_TESTCASE(steminto1, !backend) {
+    Xapian::Stem user(new MyStemImpl);
+    string result = "junk";
+    user.stem_into("food", result);
+    TEST_EQUAL(result, "foo");
+
+    Xapian::Stem none;
+    none.stem_into("loving", result);
+    TEST_EQUAL(result, "loving");
+
+    // Stem enough different words to overflow the cache of recent stems,
+    // and check they stem the same way when stemmed again.
+    Xapian::Stem english("en");
+    vector<string> stems;
+    const char * suffixes[] = { "ed", "ing", "ation", "ously" };
+    for (int pass = 0; pass != 2; ++pass) {
+	size_t j = 0;
+	for (int i = 0; i != 5000; ++i) {
+	    string base;
+	    for (int n = i; n; n /= 26) base += char('a' + n % 26);
+	    for (const char * suffix : suffixes) {
+		english.stem_into(base + suffix, result);
+		if (pass == 0) {
+		    stems.push_back(result);
+		} else {
+		    TEST_EQUAL(result, stems[j++]);
+		}
+	    }
+	}
+	english.stem_into("", result);
+	TEST_EQUAL(result, "");
+	english.stem_into("loving", result);
+	TEST_EQUAL(result, "love");
+	TEST_EQUAL(english("generously"), "generous");
+    }
+
+    return true;
+}
@@ -121,6 +121,10 @@ static const test test_simple[] = {
 
     { "", "fish+chips", "Zchip:1 Zfish:1 chips[2] fish[1]" },
 
+    // Test runs of ASCII word characters next to non-ASCII ones.
+    { "stem=", "H\xc3\x89LLO w\xc3\xb6rld_WIDE \xe2\x84\xaa" "ELVIN caf\xc3\xa9s 3\xc2\xb7" "4 A\xcc\x81" "B",
+      "3[5] 4[6] a\xcc\x81" "b[7] caf\xc3\xa9s[4] h\xc3\xa9llo[1] kelvin[3] w\xc3\xb6rld_wide[2]" },
+
     // Basic CJK tests:
     { "stem=,cjk", "久有归天", "久[1] 久有:1 天[4] 归[3] 归天:1 有[2] 有归:1" },
     { "", "극지라", "극[1] 극지:1 라[3] 지[2] 지라:1" },
@@ -38,12 +38,14 @@
 #include "unixcmds.h"
 
 #include "apitest.h"
+#include "dbcheck.h"
 
 #include "safeunistd.h"
 #include <cmath>
 #include <cstdlib>
 #include <map>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -499,6 +501,50 @@ DEFINE_TESTCASE(adddoc6, writable) {
     return true;
 }
 
+/// Check add_documents() gives the same results as add_document().
+DEFINE_TESTCASE(adddocuments1, writable) {
+    Xapian::WritableDatabase db = get_writable_database();
+
+    vector<Xapian::Document> docs;
+    for (Xapian::doccount i = 0; i != 30; ++i) {
+	Xapian::Document doc;
+	doc.set_data("doc " + str(i));
+	doc.add_value(1, str(i % 7));
+	for (Xapian::termpos p = 1; p <= 20 + i; ++p) {
+	    doc.add_posting("t" + str((p * i) % 11), p);
+	}
+	doc.add_term("all");
+	if (i % 4 == 0) doc.add_boolean_term("Qeven" + str(i));
+	docs.push_back(doc);
+    }
+    Xapian::doccount n = docs.size();
+
+    for (const Xapian::Document & doc : docs) {
+	db.add_document(doc);
+    }
+    TEST_EQUAL(db.add_documents(docs), n + 1);
+    TEST_EQUAL(db.add_documents(vector<Xapian::Document>()), 0);
+    TEST_EQUAL(db.get_doccount(), 2 * n);
+    TEST_EQUAL(db.get_lastdocid(), 2 * n);
+
+    for (int pass = 0; pass != 2; ++pass) {
+	for (Xapian::docid did = 1; did <= n; ++did) {
+	    TEST_EQUAL(docterms_to_string(db, did + n),
+		       docterms_to_string(db, did));
+	    TEST_EQUAL(docstats_to_string(db, did + n),
+		       docstats_to_string(db, did));
+	    Xapian::Document doc = db.get_document(did);
+	    Xapian::Document doc2 = db.get_document(did + n);
+	    TEST_EQUAL(doc2.get_data(), doc.get_data());
+	    TEST_EQUAL(doc2.get_value(1), doc.get_value(1));
+	}
+	db.commit();
+    }
+    dbcheck(db, 2 * n, 2 * n);
+
+    return true;
+}
+
 // tests that database destructors commit if it isn't done explicitly
 DEFINE_TESTCASE(implicitendsession1, writable) {
     Xapian::WritableDatabase db = get_writable_database();
@@ -1213,6 +1259,83 @@ DEFINE_TESTCASE(replacedoc6, writable) {
     return true;
 }
 
+/// Check positions and skip_to() remain correct after many replacements.
+DEFINE_TESTCASE(replacedoc9, writable) {
+    Xapian::WritableDatabase db = get_writable_database();
+
+    const Xapian::docid N = 200;
+    for (Xapian::docid did = 1; did <= N; ++did) {
+	Xapian::Document doc;
+	doc.add_posting("t", did);
+	doc.add_posting("t", did + 1000);
+	doc.add_term("all");
+	db.add_document(doc);
+    }
+    db.commit();
+
+    // Replace the documents in descending order, several times over, so the
+    // positions for later replacements end up out of docid order.
+    for (Xapian::termpos round = 1; round <= 3; ++round) {
+	for (Xapian::docid did = N; did >= 1; --did) {
+	    Xapian::Document doc;
+	    doc.add_posting("t", did * round);
+	    if (did % 2 == 0)
+		doc.add_posting("t", did * round + 5000);
+	    doc.add_term("all");
+	    db.replace_document(did, doc);
+	}
+    }
+    for (Xapian::docid did = 3; did <= N; did += 3) {
+	db.delete_document(did);
+    }
+    db.commit();
+
+    for (Xapian::docid did = 1; did <= N; ++did) {
+	if (did % 3 == 0) continue;
+	Xapian::PositionIterator p = db.positionlist_begin(did, "t");
+	TEST(p != db.positionlist_end(did, "t"));
+	TEST_EQUAL(*p, did * 3);
+	++p;
+	if (did % 2 == 0) {
+	    TEST(p != db.positionlist_end(did, "t"));
+	    TEST_EQUAL(*p, did * 3 + 5000);
+	    ++p;
+	}
+	TEST(p == db.positionlist_end(did, "t"));
+
+	Xapian::TermIterator t = db.termlist_begin(did);
+	t.skip_to("t");
+	TEST(t != db.termlist_end(did));
+	TEST_EQUAL(*t, "t");
+	TEST_EQUAL(t.get_wdf(), did % 2 ? 1 : 2);
+	if (!startswith(get_dbtype(), "remote")) {
+	    // The remote backend doesn't implement positionlist_count().
+	    TEST_EQUAL(t.positionlist_count(), did % 2 ? 1 : 2);
+	}
+    }
+
+    // Try skipping both short and long distances.
+    for (Xapian::docid step = 1; step < N; step = step * 2 + 1) {
+	Xapian::PostingIterator p = db.postlist_begin("t");
+	Xapian::docid target = 1;
+	while (true) {
+	    p.skip_to(target);
+	    Xapian::docid expected = target;
+	    if (expected % 3 == 0) ++expected;
+	    if (expected > N) {
+		TEST(p == db.postlist_end("t"));
+		break;
+	    }
+	    TEST(p != db.postlist_end("t"));
+	    TEST_EQUAL(*p, expected);
+	    TEST_EQUAL(p.get_wdf(), expected % 2 ? 1 : 2);
+	    target = expected + step;
+	}
+    }
+
+    return true;
+}
+
 // Test of new feature: WritableDatabase::replace_document and delete_document
 // can take a unique termname instead of a document id as of Xapian 0.8.2.
 DEFINE_TESTCASE(uniqueterm1, writable) {
@@ -2045,3 +2168,86 @@ DEFINE_TESTCASE(modifyvalues1, writable) {
 
     return true;
 }
+
+/// Describe the postlist for @a term, including wdf and document lengths.
+static string
+describe_postlist(const Xapian::Database & db, const string & term)
+{
+    string result;
+    Xapian::PostingIterator p;
+    for (p = db.postlist_begin(term); p != db.postlist_end(term); ++p) {
+	result += str(*p);
+	result += ':';
+	result += str(p.get_wdf());
+	result += ':';
+	result += str(p.get_doclength());
+	result += ' ';
+    }
+    return result;
+}
+
+/// Check searching uncommitted changes gives the same results as committing.
+DEFINE_TESTCASE(uncommittedsearch1, writable) {
+    Xapian::WritableDatabase db = get_writable_database();
+    for (Xapian::docid did = 1; did <= 60; ++did) {
+	Xapian::Document doc;
+	doc.add_term("all");
+	doc.add_term(did % 2 ? "odd" : "even", did % 5 + 1);
+	if (did % 3 == 0) doc.add_term("three");
+	db.add_document(doc);
+    }
+    db.commit();
+
+    // Add some documents, and delete and modify others (committed and not).
+    for (Xapian::docid did = 61; did <= 90; ++did) {
+	Xapian::Document doc;
+	doc.add_term("all");
+	doc.add_term(did % 2 ? "odd" : "even", did % 7 + 1);
+	if (did % 3 == 0) doc.add_term("three");
+	db.add_document(doc);
+    }
+    for (Xapian::docid did = 4; did <= 90; did += 9) {
+	db.delete_document(did);
+    }
+    for (Xapian::docid did = 2; did <= 90; did += 11) {
+	Xapian::Document doc;
+	doc.add_term("all", 3);
+	doc.add_term("odd", did % 4 + 1);
+	db.replace_document(did, doc);
+    }
+
+    static const char * const terms[] = { "all", "odd", "even", "three", "" };
+    vector<string> before;
+    for (const char * term : terms) {
+	before.push_back(describe_postlist(db, term));
+    }
+
+    // Check skip_to() over the changes too.
+    Xapian::PostingIterator p = db.postlist_begin("odd");
+    p.skip_to(13);
+    TEST_EQUAL(*p, 13);
+    p.skip_to(22);
+    TEST_EQUAL(*p, 23);
+    p.skip_to(61);
+    TEST_EQUAL(*p, 61);
+    p.skip_to(90);
+    TEST_EQUAL(*p, 90);
+    ++p;
+    TEST(p == db.postlist_end("odd"));
+
+    Xapian::Enquire enquire(db);
+    enquire.set_query(Xapian::Query("three"));
+    Xapian::MSet mset = enquire.get_mset(0, 100);
+    TEST_EQUAL(mset.size(), db.get_termfreq("three"));
+
+    db.commit();
+
+    for (size_t i = 0; i != before.size(); ++i) {
+	tout << "Term '" << terms[i] << "'\n";
+	TEST_EQUAL(describe_postlist(db, terms[i]), before[i]);
+    }
+    mset = enquire.get_mset(0, 100);
+    TEST_EQUAL(mset.size(), db.get_termfreq("three"));
+
+    return true;
+}
@@ -115,9 +115,9 @@ get_writable_database_as_database()
 }
 
 Xapian::WritableDatabase
-get_writable_database_again()
+get_writable_database_again(int flags)
 {
-    return backendmanager->get_writable_database_again();
+    return backendmanager->get_writable_database_again(flags);
 }
 
 void
@@ -53,7 +53,7 @@ Xapian::Database get_remote_database(const std::string &db, unsigned timeout);
 
 Xapian::Database get_writable_database_as_database();
 
-Xapian::WritableDatabase get_writable_database_again();
+Xapian::WritableDatabase get_writable_database_again(int flags = 0);
 
 // Skip the test for any backend not of the specified type.
 //
@@ -11,6 +11,7 @@ noinst_HEADERS +=\
 	harness/backendmanager_remote.h\
 	harness/backendmanager_remoteprog.h\
 	harness/backendmanager_remotetcp.h\
+	harness/backendmanager_segmented.h\
 	harness/backendmanager_singlefile.h\
 	harness/cputimer.h\
 	harness/fdtracker.h\
@@ -49,6 +50,7 @@ endif
 if BUILD_BACKEND_GLASS
 testharness_sources +=\
 	harness/backendmanager_glass.cc\
+	harness/backendmanager_segmented.cc\
 	harness/backendmanager_singlefile.cc
 endif
 
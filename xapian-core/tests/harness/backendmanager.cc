@@ -328,7 +328,7 @@ BackendManager::get_writable_database_as_database()
 }
 
 Xapian::WritableDatabase
-BackendManager::get_writable_database_again()
+BackendManager::get_writable_database_again(int)
 {
     string msg = "Backend ";
     msg += get_dbtype();
@@ -182,8 +182,11 @@ class BackendManager {
     /// Create a Database object for the last opened WritableDatabase.
     virtual Xapian::Database get_writable_database_as_database();
 
-    /// Create a WritableDatabase object for the last opened WritableDatabase.
-    virtual Xapian::WritableDatabase get_writable_database_again();
+    /** Create a WritableDatabase object for the last opened WritableDatabase.
+     *
+     *  @param flags	Extra Xapian::DB_* flags to open it with.
+     */
+    virtual Xapian::WritableDatabase get_writable_database_again(int flags = 0);
 
     /** Called after each test, to perform any necessary cleanup.
      *
@@ -58,8 +58,8 @@ BackendManagerChert::get_writable_database_as_database()
 }
 
 Xapian::WritableDatabase
-BackendManagerChert::get_writable_database_again()
+BackendManagerChert::get_writable_database_again(int flags)
 {
     return Xapian::WritableDatabase(".chert/" + last_wdb_name,
-				    Xapian::DB_OPEN|Xapian::DB_BACKEND_CHERT);
+				    Xapian::DB_OPEN|Xapian::DB_BACKEND_CHERT|flags);
 }
@@ -58,8 +58,8 @@ BackendManagerGlass::get_writable_database_as_database()
 }
 
 Xapian::WritableDatabase
-BackendManagerGlass::get_writable_database_again()
+BackendManagerGlass::get_writable_database_again(int flags)
 {
     return Xapian::WritableDatabase(".glass/" + last_wdb_name,
-				    Xapian::DB_OPEN|Xapian::DB_BACKEND_GLASS);
+				    Xapian::DB_OPEN|Xapian::DB_BACKEND_GLASS|flags);
 }
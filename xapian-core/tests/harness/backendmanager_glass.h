@@ -59,7 +59,7 @@ class BackendManagerGlass : public BackendManager {
     Xapian::Database get_writable_database_as_database();
 
     /// Create a WritableDatabase object for the last opened WritableDatabase.
-    Xapian::WritableDatabase get_writable_database_again();
+    Xapian::WritableDatabase get_writable_database_again(int flags = 0);
 };
 
 #endif // XAPIAN_INCLUDED_BACKENDMANAGER_GLASS_H
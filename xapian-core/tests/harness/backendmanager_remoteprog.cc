@@ -90,15 +90,15 @@ BackendManagerRemoteProg::get_writable_database_as_database()
 }
 
 Xapian::WritableDatabase
-BackendManagerRemoteProg::get_writable_database_again()
+BackendManagerRemoteProg::get_writable_database_again(int flags)
 {
     string args = get_writable_database_again_args();
 
 #ifdef HAVE_VALGRIND
     if (RUNNING_ON_VALGRIND) {
 	args.insert(0, XAPIAN_PROGSRV" ");
-	return Xapian::Remote::open_writable("./runsrv", args);
+	return Xapian::Remote::open_writable("./runsrv", args, 0, flags);
     }
 #endif
-    return Xapian::Remote::open_writable(XAPIAN_PROGSRV, args);
+    return Xapian::Remote::open_writable(XAPIAN_PROGSRV, args, 0, flags);
 }
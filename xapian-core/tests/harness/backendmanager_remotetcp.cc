@@ -376,11 +376,11 @@ BackendManagerRemoteTcp::get_writable_database_as_database()
 }
 
 Xapian::WritableDatabase
-BackendManagerRemoteTcp::get_writable_database_again()
+BackendManagerRemoteTcp::get_writable_database_again(int flags)
 {
     string args = get_writable_database_again_args();
     int port = launch_xapian_tcpsrv(args);
-    return Xapian::Remote::open_writable(LOCALHOST, port);
+    return Xapian::Remote::open_writable(LOCALHOST, port, 0, 10000, flags);
 }
 
 void
@@ -62,7 +62,7 @@ class BackendManagerRemoteTcp : public BackendManagerRemote {
     Xapian::Database get_writable_database_as_database();
 
     /// Create a WritableDatabase object for the last opened WritableDatabase.
-    Xapian::WritableDatabase get_writable_database_again();
+    Xapian::WritableDatabase get_writable_database_again(int flags = 0);
 
     /// Called after each test, to perform any necessary cleanup.
     void clean_up();
@@ -0,0 +1,140 @@
+/** @file backendmanager_segmented.cc
+ * @brief BackendManager subclass for segmented databases.
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "backendmanager_segmented.h"
+
+#include "index_utils.h"
+#include "unixcmds.h"
+
+#include <xapian.h>
+
+using namespace std;
+
+/// Number of documents to add between commits.
+#define DOCS_PER_COMMIT 3
+
+BackendManagerSegmented::BackendManagerSegmented(const std::string & subtype_)
+	: subtype(subtype_)
+{
+#ifdef XAPIAN_HAS_GLASS_BACKEND
+    if (subtype == "glass") return;
+#endif
+    throw ("Unknown backend type \"" + subtype + "\" specified for segmented databases");
+}
+
+std::string
+BackendManagerSegmented::get_dbtype() const
+{
+    return "segmented_" + subtype;
+}
+
+void
+BackendManagerSegmented::index_files_in_batches(Xapian::WritableDatabase & db,
+						const string & path,
+						const vector<string> & files,
+						bool commit_all)
+{
+    // Index into a temporary database, then copy the documents across
+    // keeping their docids.
+    string src_path = path + ".src";
+    {
+	Xapian::WritableDatabase src(src_path,
+				     Xapian::DB_CREATE_OR_OVERWRITE|
+				     Xapian::DB_BACKEND_GLASS);
+	FileIndexer(get_datadir(), files).index_to(src);
+	src.commit();
+
+	Xapian::PostingIterator p;
+	Xapian::doccount n = 0;
+	for (p = src.postlist_begin(string()); p != src.postlist_end(string()); ++p) {
+	    db.replace_document(*p, src.get_document(*p));
+	    if (++n % DOCS_PER_COMMIT == 0) db.commit();
+	}
+	if (commit_all) db.commit();
+    }
+    rm_rf(src_path);
+}
+
+string
+BackendManagerSegmented::createdb_segmented(const vector<string> & files)
+{
+    string parent_dir = ".segmented" + subtype;
+    create_dir_if_needed(parent_dir);
+
+    string dbdir = parent_dir + "/db";
+    vector<string>::const_iterator i;
+    for (i = files.begin(); i != files.end(); ++i) {
+	dbdir += '=';
+	dbdir += *i;
+    }
+    // If the database is readonly, we can reuse it if it exists.
+    if (create_dir_if_needed(dbdir)) {
+	// Directory was created, so do the indexing.
+	Xapian::WritableDatabase db(dbdir,
+		Xapian::DB_CREATE|Xapian::DB_BACKEND_GLASS|Xapian::DB_SEGMENTED,
+		2048);
+	index_files_in_batches(db, dbdir, files, true);
+    }
+    return dbdir;
+}
+
+string
+BackendManagerSegmented::do_get_database_path(const vector<string> & files)
+{
+    return createdb_segmented(files);
+}
+
+Xapian::WritableDatabase
+BackendManagerSegmented::get_writable_database(const string & name,
+					       const string & file)
+{
+    string dbdir = get_writable_database_path(name);
+    last_wdb_path = dbdir;
+
+    // For a writable database we need to start afresh each time.
+    rm_rf(dbdir);
+
+    Xapian::WritableDatabase db(dbdir,
+	    Xapian::DB_CREATE|Xapian::DB_BACKEND_GLASS|Xapian::DB_SEGMENTED,
+	    2048);
+    index_files_in_batches(db, dbdir, vector<string>(1, file), false);
+    return db;
+}
+
+string
+BackendManagerSegmented::get_writable_database_path(const string & name)
+{
+    string parent_dir = ".segmented" + subtype;
+    create_dir_if_needed(parent_dir);
+    return parent_dir + "/" + name;
+}
+
+Xapian::Database
+BackendManagerSegmented::get_writable_database_as_database()
+{
+    return Xapian::Database(last_wdb_path, Xapian::DB_BACKEND_GLASS);
+}
+
+Xapian::WritableDatabase
+BackendManagerSegmented::get_writable_database_again(int flags)
+{
+    return Xapian::WritableDatabase(last_wdb_path,
+				    Xapian::DB_OPEN|Xapian::DB_BACKEND_GLASS|flags);
+}
@@ -0,0 +1,81 @@
+/** @file backendmanager_segmented.h
+ * @brief BackendManager subclass for segmented databases.
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_BACKENDMANAGER_SEGMENTED_H
+#define XAPIAN_INCLUDED_BACKENDMANAGER_SEGMENTED_H
+
+#include "backendmanager.h"
+
+#include <string>
+
+#include <xapian/database.h>
+
+/** BackendManager subclass for segmented databases.
+ *
+ *  The test data is committed a few documents at a time, so the databases
+ *  used have several segments and have been through merges.
+ */
+class BackendManagerSegmented : public BackendManager {
+    /// The type to use for the segments.
+    std::string subtype;
+
+    /// The path of the last writable database used.
+    std::string last_wdb_path;
+
+    /// Don't allow assignment.
+    void operator=(const BackendManagerSegmented &);
+
+    /// Don't allow copying.
+    BackendManagerSegmented(const BackendManagerSegmented &);
+
+    /** Index @a files into @a db, committing every few documents.
+     *
+     *  @param commit_all  Commit the last batch of documents too?
+     */
+    void index_files_in_batches(Xapian::WritableDatabase & db,
+				const std::string & path,
+				const std::vector<std::string> & files,
+				bool commit_all);
+
+    std::string createdb_segmented(const std::vector<std::string> & files);
+
+  protected:
+    /// Get the path of the Xapian::Database instance.
+    std::string do_get_database_path(const std::vector<std::string> & files);
+
+  public:
+    BackendManagerSegmented(const std::string & subtype_);
+
+    /// Return a string representing the current database type.
+    std::string get_dbtype() const;
+
+    /// Create a segmented Xapian::WritableDatabase object indexing a file.
+    Xapian::WritableDatabase get_writable_database(const std::string & name,
+						   const std::string & file);
+
+    /// Get the path of a segmented Xapian::WritableDatabase instance.
+    std::string get_writable_database_path(const std::string & name);
+
+    /// Create a Database object for the last opened WritableDatabase.
+    Xapian::Database get_writable_database_as_database();
+
+    /// Create a WritableDatabase object for the last opened WritableDatabase.
+    Xapian::WritableDatabase get_writable_database_again(int flags = 0);
+};
+
+#endif // XAPIAN_INCLUDED_BACKENDMANAGER_SEGMENTED_H
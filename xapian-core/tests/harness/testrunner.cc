@@ -32,6 +32,7 @@
 #include "backendmanager_multi.h"
 #include "backendmanager_remoteprog.h"
 #include "backendmanager_remotetcp.h"
+#include "backendmanager_segmented.h"
 #include "backendmanager_singlefile.h"
 
 #include "stringutils.h"
@@ -89,6 +90,9 @@ TestRunner::set_properties_for_backend(const string & backend_name)
 	    BACKEND|TRANSACTIONS|POSITIONAL|WRITABLE|METADATA|VALUESTATS },
 	{ "singlefile_glass", SINGLEFILE|
 	    BACKEND|POSITIONAL|VALUESTATS },
+	{ "segmented_glass", SEGMENTED|
+	    BACKEND|TRANSACTIONS|POSITIONAL|WRITABLE|SPELLING|METADATA|
+	    SYNONYMS|VALUESTATS|GENERATED },
 	{ NULL, 0 }
     };
 
@@ -145,6 +149,11 @@ TestRunner::run_tests(int argc, char ** argv)
 	    BackendManagerSingleFile m("glass");
 	    do_tests_for_backend(&m);
 	}
+
+	{
+	    BackendManagerSegmented m("glass");
+	    do_tests_for_backend(&m);
+	}
 #endif
 
 #ifdef XAPIAN_HAS_CHERT_BACKEND
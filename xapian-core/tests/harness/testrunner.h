@@ -78,6 +78,7 @@ class TestRunner {
 	INMEMORY	= 0x00002000,
 	CHERT		= 0x00004000,
 	GLASS		= 0x00008000,
+	SEGMENTED	= 0x00010000,
     };
 
   public:
@@ -22,9 +22,11 @@
 
 #include <config.h>
 
+#include <algorithm>
 #include <cfloat>
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 #define XAPIAN_UNITTEST
 static const char * unittest_assertion_failed = NULL;
@@ -74,6 +76,7 @@ using namespace std;
 #include "../net/serialise-error.cc"
 #include "../api/error.cc"
 #include "../api/sortable-serialise.cc"
+#include "../api/editdistance.cc"
 
 // Stub replacement, which doesn't deal with escaping or producing valid UTF-8.
 // The full implementation needs Xapian::Utf8Iterator and
@@ -546,6 +549,79 @@ static bool test_strbool1()
     return true;
 }
 
+/// Simple dynamic programming edit distance to check the real version against.
+static int
+naive_edit_distance(const vector<unsigned> & a, const vector<unsigned> & b)
+{
+    vector<vector<int>> d(a.size() + 1, vector<int>(b.size() + 1));
+    for (size_t i = 0; i <= a.size(); ++i) d[i][0] = int(i);
+    for (size_t j = 0; j <= b.size(); ++j) d[0][j] = int(j);
+    for (size_t i = 1; i <= a.size(); ++i) {
+	for (size_t j = 1; j <= b.size(); ++j) {
+	    int cost = (a[i - 1] != b[j - 1]);
+	    int r = min(d[i - 1][j - 1] + cost, min(d[i - 1][j], d[i][j - 1]) + 1);
+	    if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+		r = min(r, d[i - 2][j - 2] + 1);
+	    d[i][j] = r;
+	}
+    }
+    return d[a.size()][b.size()];
+}
+
+static bool test_editdistance1()
+{
+    // Use a simple LCG so the test is repeatable.
+    unsigned seed = 42;
+    auto rnd = [&seed](unsigned n) {
+	seed = seed * 1103515245u + 12345u;
+	return (seed >> 16) % n;
+    };
+    // Exercise the single block and blocked versions, and both short and long
+    // max_distance values.
+    static const unsigned lengths[] = { 10, 70, 200 };
+    for (unsigned max_len : lengths) {
+	for (int n = 0; n < 1000; ++n) {
+	    // Use a small alphabet of widely spaced characters so there are
+	    // plenty of matches and hash collisions.
+	    unsigned alphabet = 1 + rnd(5);
+	    vector<unsigned> a(rnd(max_len));
+	    for (unsigned & ch : a) ch = rnd(alphabet) * 0x10001;
+	    vector<unsigned> b = a;
+	    for (unsigned edits = rnd(6); edits; --edits) {
+		size_t pos = rnd(unsigned(b.size()) + 1);
+		unsigned ch = rnd(alphabet) * 0x10001;
+		switch (rnd(4)) {
+		    case 0:
+			b.insert(b.begin() + pos, ch);
+			break;
+		    case 1:
+			if (pos < b.size()) b.erase(b.begin() + pos);
+			break;
+		    case 2:
+			if (pos < b.size()) b[pos] = ch;
+			break;
+		    default:
+			if (pos + 1 < b.size()) swap(b[pos], b[pos + 1]);
+			break;
+		}
+	    }
+	    int expect = naive_edit_distance(a, b);
+	    int max_distance = int(rnd(8));
+	    int result = edit_distance_unsigned(a.data(), int(a.size()),
+						b.data(), int(b.size()),
+						max_distance);
+	    if (expect <= max_distance) {
+		TEST_EQUAL(result, expect);
+	    } else {
+		TEST_REL(result, >, max_distance);
+	    }
+	    EditDistanceCalculator edcalc(a.data(), int(a.size()));
+	    TEST_EQUAL(edcalc(b.data(), int(b.size()), 1000), expect);
+	}
+    }
+    return true;
+}
+
 static const test_desc tests[] = {
     TESTCASE(simple_exceptions_work1),
     TESTCASE(class_exceptions_work1),
@@ -560,6 +636,7 @@ static const test_desc tests[] = {
     TESTCASE(sortableserialise1),
     TESTCASE(tostring1),
     TESTCASE(strbool1),
+    TESTCASE(editdistance1),
     END_OF_TESTCASES
 };
 
@@ -67,7 +67,7 @@ Weight::init_(const Internal & stats, Xapian::termcount query_length,
     if (stats_needed & DOC_LENGTH_MAX)
 	doclength_upper_bound_ = stats.db.get_doclength_upper_bound();
     if (stats_needed & DOC_LENGTH_MIN)
-	doclength_lower_bound_ = stats.db.get_doclength_lower_bound();
+	doclength_lower_bound_ = stats.get_doclength_lower_bound(term);
     if (stats_needed & WDF_MAX)
 	wdf_upper_bound_ = stats.db.get_wdf_upper_bound(term);
     if (stats_needed & (TERMFREQ | RELTERMFREQ | COLLECTION_FREQ)) {
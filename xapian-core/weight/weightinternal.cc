@@ -119,6 +119,21 @@ Weight::Internal::accumulate_stats(const Xapian::Database::Internal &subdb,
     }
 }
 
+Xapian::termcount
+Weight::Internal::get_doclength_lower_bound(const string & term) const
+{
+    // Combine the sub-databases in the same way that
+    // Database::get_doclength_lower_bound() does.
+    Xapian::termcount full_lb = 0;
+    for (auto && sub_db : db.internal) {
+	if (sub_db->get_total_length() != 0) {
+	    Xapian::termcount lb = sub_db->get_term_doclength_lower_bound(term);
+	    if (full_lb == 0 || lb < full_lb) full_lb = lb;
+	}
+    }
+    return full_lb;
+}
+
 string
 Weight::Internal::get_description() const
 {
@@ -237,6 +237,13 @@ class Weight::Internal {
 	return Xapian::doclength(total_length) / collection_size;
     }
 
+    /** Get a lower bound on the length of documents indexed by @a term.
+     *
+     *  This is at least as tight as db.get_doclength_lower_bound(), and may
+     *  be tighter if the backend stores per-term bounds.
+     */
+    Xapian::termcount get_doclength_lower_bound(const std::string & term) const;
+
     /** Set the "bounds" stats from Database @a db. */
     void set_bounds_from_db(const Xapian::Database &db_) {
 	Assert(!finalised);
@@ -1,5 +1,6 @@
 noinst_HEADERS +=\
 	api/letor_internal.h\
+	api/letor_model.h\
 	api/featuremanager_internal.h
 
 EXTRA_DIST +=\
@@ -12,6 +13,7 @@ lib_src +=\
 	api/letor.cc\
 	api/letor_features.cc\
 	api/letor_internal.cc\
+	api/letor_model.cc\
 	api/ranker.cc\
 	api/ranklist.cc
 
@@ -65,7 +65,7 @@ FeatureManager::getdid(const Document &doc)
 int
 FeatureManager::getlabel(map<string, map<string, int> > qrel2, const Document &doc, std::string & qid)
 {
-    return internal->getlabel(qrel2, doc, qid);
+    return internal->getlabel(qrel2, internal->getdid(doc), qid);
 }
 
 Xapian::RankList
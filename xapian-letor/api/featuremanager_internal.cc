@@ -26,6 +26,7 @@
 #include "xapian-letor/ranklist.h"
 #include "featuremanager_internal.h"
 
+#include <cmath>
 #include <cstring>
 #include <cstdlib>
 #include <fstream>
@@ -56,18 +57,17 @@ FeatureManager::Internal::getdid(const Document &doc)
 }
 
 int
-FeatureManager::Internal::getlabel(map<string, map<string, int> > qrel2,
-                                 const Document &doc, std::string & qid)
+FeatureManager::Internal::getlabel(const map<string, map<string, int> > & qrel2,
+                                 const std::string & did, const std::string & qid)
 {
     int label = -1;
-    string id = getdid(doc);
 
-    map<string, map<string, int> >::iterator outerit;
-    map<string, int>::iterator innerit;
+    map<string, map<string, int> >::const_iterator outerit;
+    map<string, int>::const_iterator innerit;
 
     outerit = qrel2.find(qid);
     if (outerit != qrel2.end()) {
-    innerit = outerit->second.find(id);
+    innerit = outerit->second.find(did);
     if (innerit != outerit->second.end()) {
         label = innerit->second;
     }
@@ -80,19 +80,25 @@ FeatureManager::Internal::create_rank_list(const Xapian::MSet & mset, std::strin
 {
     Xapian::RankList rl;
 
+    // Ask for all the documents up front, which lets a remote backend
+    // fetch them in one go.
+    mset.fetch();
+
     for (Xapian::MSetIterator i = mset.begin(); i != mset.end(); ++i) {
 
         Xapian::Document doc = i.get_document();
 
-        // Here a weight vector can be created in future for different
-        // weights of the document like BM25, LM etc.
-        double weight = i.get_weight();
-
-        map<int,double> fVals = transform(doc, weight);
         string did = getdid(doc);
-        int label = getlabel(qrel, doc, qid);
+        int label = getlabel(qrel, did, qid);
 
+        // Documents without a relevance judgement don't go in the ranklist,
+        // so don't waste time calculating their features.
         if(label!=-1) {
+            // Here a weight vector can be created in future for different
+            // weights of the document like BM25, LM etc.
+            double weight = i.get_weight();
+
+            map<int,double> fVals = transform(doc, weight);
             Xapian::FeatureVector fv = create_feature_vector(fVals, label, did);
             rl.set_qid(qid);
             rl.add_feature_vector(fv);
@@ -102,6 +108,22 @@ FeatureManager::Internal::create_rank_list(const Xapian::MSet & mset, std::strin
     return rl;
 }
 
+void
+FeatureManager::Internal::create_feature_matrix(const Xapian::MSet & mset,
+                                                vector<double> & matrix)
+{
+    const size_t n_cols = fNum + 1;
+    matrix.assign(mset.size() * n_cols, 0.0);
+
+    mset.fetch();
+
+    double * row = matrix.data();
+    for (Xapian::MSetIterator i = mset.begin(); i != mset.end(); ++i) {
+        extract_features(i.get_document(), i.get_weight(), row);
+        row += n_cols;
+    }
+}
+
 Xapian::FeatureVector
 FeatureManager::Internal::create_feature_vector(map<int,double> fvals,
                                                 int &label, std::string & did)
@@ -143,57 +165,150 @@ FeatureManager::Internal::load_relevance(const std::string & qrel_file)
     return qrel1;
 }
 
-std::map<int,double>
-FeatureManager::Internal::transform(const Document &doc, double &weight_)
+void
+FeatureManager::Internal::extract_features(const Document &doc, double weight,
+                                           double * val)
 {
-    map<int, double> fvals;
-    map<string,long int> tf = f.termfreq(doc, letor_query);
-    map<string, long int> doclen = f.doc_length(letor_db, doc);
-
-    double val[20];// = new double[fCount+1];
-
-    // storing the feature values from array index 1 to sync it with feature number.
-    val[1]=f.calculate_f1(letor_query,tf,'t');
-    val[2]=f.calculate_f1(letor_query,tf,'b');
-    val[3]=f.calculate_f1(letor_query,tf,'w');
-
-    val[4]=f.calculate_f2(letor_query,tf,doclen,'t');
-    val[5]=f.calculate_f2(letor_query,tf,doclen,'b');
-    val[6]=f.calculate_f2(letor_query,tf,doclen,'w');
-
-    val[7]=f.calculate_f3(letor_query,idf,'t');
-    val[8]=f.calculate_f3(letor_query,idf,'b');
-    val[9]=f.calculate_f3(letor_query,idf,'w');
+    // Walk the document's termlist once, picking up the wdf of each query
+    // term and adding up the wdf of the title terms as we go.  Outside the
+    // title terms we only need the query terms, so skip straight to those.
+    vector<long int> tf(qterms.size(), 0);
+    long int title_len = 0;
+    size_t q = 0;
+    Xapian::TermIterator t = doc.termlist_begin();
+    while (t != doc.termlist_end()) {
+        const string term = *t;
+        bool in_title = (term[0] == 'S');
+        if (in_title)
+            title_len += t.get_wdf();
+
+        while (q < qterms.size() && qterms[q].term < term)
+            ++q;
+        if (q < qterms.size() && qterms[q].term == term) {
+            tf[q] = t.get_wdf();
+            ++q;
+        }
 
-    val[10]=f.calculate_f4(letor_query,coll_tf,coll_len,'t');
-    val[11]=f.calculate_f4(letor_query,coll_tf,coll_len,'b');
-    val[12]=f.calculate_f4(letor_query,coll_tf,coll_len,'w');
+        if (in_title) {
+            ++t;
+        } else if (term < "S") {
+            if (q < qterms.size() && qterms[q].term < "S")
+                t.skip_to(qterms[q].term);
+            else
+                t.skip_to("S");
+        } else {
+            if (q == qterms.size())
+                break;
+            t.skip_to(qterms[q].term);
+        }
+    }
 
-    val[13]=f.calculate_f5(letor_query,tf,idf,doclen,'t');
-    val[14]=f.calculate_f5(letor_query,tf,idf,doclen,'b');
-    val[15]=f.calculate_f5(letor_query,tf,idf,doclen,'w');
+    // Document length of the title, body and whole document.
+    double doc_len[3];
+    long int whole_len = letor_db.get_doclength(doc.get_docid());
+    doc_len[0] = title_len;
+    doc_len[1] = whole_len - title_len;
+    doc_len[2] = whole_len;
+
+    // Features are numbered from 1 in groups of three: title, body and whole
+    // document.  Each query term contributes to the whole document feature
+    // and to either the title or the body one.
+    for (size_t i = 0; i != qterms.size(); ++i) {
+        const TermStats & stats = qterms[i];
+        double tf_i = tf[i];
+        double n = stats.count;
+        int part = stats.title ? 0 : 1;
+
+        double v = n * log10(1 + tf_i);
+        val[1 + part] += v;
+        val[3] += v;
+
+        val[4 + part] += n * log10(1 + (tf_i / (1 + doc_len[part])));
+        val[6] += n * log10(1 + (tf_i / (1 + doc_len[2])));
+
+        val[13 + part] += n * log10(1 + ((tf_i * stats.idf) / (1 + doc_len[part])));
+        val[15] += n * log10(1 + ((tf_i * stats.idf) / (1 + doc_len[2])));
+
+        val[16 + part] += n * log10(1 + ((tf_i * coll_length[part]) / (1 + (doc_len[part] * stats.coll_tf))));
+        val[18] += n * log10(1 + ((tf_i * coll_length[2]) / (1 + (doc_len[2] * stats.coll_tf))));
+    }
 
-    val[16]=f.calculate_f6(letor_query,tf,doclen,coll_tf,coll_len,'t');
-    val[17]=f.calculate_f6(letor_query,tf,doclen,coll_tf,coll_len,'b');
-    val[18]=f.calculate_f6(letor_query,tf,doclen,coll_tf,coll_len,'w');
+    for (int i = 0; i != 6; ++i)
+        val[7 + i] = query_features[i];
 
 // this weight can be either set on the outside how it is done right now
 // or, better, extend Enquiry to support advanced ranking models
-    val[19]=weight_;
+    val[19] = weight;
+}
+
+std::map<int,double>
+FeatureManager::Internal::transform(const Document &doc, double &weight_)
+{
+    map<int, double> fvals;
+
+    // storing the feature values from array index 1 to sync it with feature number.
+    double val[fNum + 1] = {};
+    extract_features(doc, weight_, val);
 
     for(int i=0; i<=fNum;i++)
-        fvals.insert(pair<int,double>(i,val[i]));
+        fvals.insert(fvals.end(), pair<int,double>(i,val[i]));
 
     return fvals;
 }
 
 void
 FeatureManager::Internal::update_collection_level() {
-    coll_len = f.collection_length(letor_db);
+    string uuid = letor_db.get_uuid();
+    Xapian::doccount doccount = letor_db.get_doccount();
+    Xapian::docid lastdocid = letor_db.get_lastdocid();
+    double avlength = letor_db.get_avlength();
+    if (uuid.empty() || uuid != coll_uuid || doccount != coll_doccount ||
+        lastdocid != coll_lastdocid || avlength != coll_avlength) {
+        coll_len = f.collection_length(letor_db);
+        coll_uuid = uuid;
+        coll_doccount = doccount;
+        coll_lastdocid = lastdocid;
+        coll_avlength = avlength;
+    }
+
+    coll_length[0] = coll_len["title"];
+    coll_length[1] = coll_len["body"];
+    coll_length[2] = coll_len["whole"];
+
+    // The query-level features use the collection length too.
+    update_query_level();
 }
 
 void
 FeatureManager::Internal::update_query_level() {
     coll_tf = f.collection_termfreq(letor_db, letor_query);
     idf = f.inverse_doc_freq(letor_db, letor_query);
+
+    // The features count a term once for each time it appears in the query.
+    map<string, int> term_counts;
+    for (Xapian::TermIterator qt = letor_query.get_terms_begin();
+         qt != letor_query.get_terms_end(); ++qt) {
+        ++term_counts[*qt];
+    }
+
+    qterms.clear();
+    map<string, int>::const_iterator i;
+    for (i = term_counts.begin(); i != term_counts.end(); ++i) {
+        TermStats stats;
+        stats.term = i->first;
+        stats.title = (stats.term.substr(0, 1) == "S" ||
+                       stats.term.substr(1, 1) == "S");
+        stats.idf = idf[stats.term];
+        stats.coll_tf = coll_tf[stats.term];
+        stats.count = i->second;
+        qterms.push_back(stats);
+    }
+
+    query_features[0] = f.calculate_f3(letor_query, idf, 't');
+    query_features[1] = f.calculate_f3(letor_query, idf, 'b');
+    query_features[2] = f.calculate_f3(letor_query, idf, 'w');
+
+    query_features[3] = f.calculate_f4(letor_query, coll_tf, coll_len, 't');
+    query_features[4] = f.calculate_f4(letor_query, coll_tf, coll_len, 'b');
+    query_features[5] = f.calculate_f4(letor_query, coll_tf, coll_len, 'w');
 }
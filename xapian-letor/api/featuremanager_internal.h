@@ -31,6 +31,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -52,6 +53,41 @@ class FeatureManager::Internal : public Xapian::Internal::intrusive_base
     map<string,long int> coll_tf;
     map<string,double> idf;
 
+    /** Which database coll_len was calculated for.
+     *
+     *  Working out the collection length can mean iterating all the title
+     *  terms, so we only do it again if the database has changed.
+     */
+    string coll_uuid;
+    Xapian::doccount coll_doccount;
+    Xapian::docid coll_lastdocid;
+    double coll_avlength;
+
+    /// A query term and the statistics the features need for it.
+    struct TermStats {
+        string term;
+        // Is this a title (S-prefixed) term?
+        bool title;
+        double idf;
+        double coll_tf;
+        // How many times the term appears in the query.
+        int count;
+    };
+
+    /** The distinct terms of letor_query in ascending order.
+     *
+     *  Query::get_terms_begin() returns the terms in query order, with
+     *  repeats, but extract_features() needs them in the same order as a
+     *  document's termlist.
+     */
+    vector<TermStats> qterms;
+
+    /// Collection length of the title, body and whole collection.
+    double coll_length[3];
+
+    /// Features 7 to 12, which don't depend on the document.
+    double query_features[6];
+
     map<string, map<string, int> > qrel;
 
   public:
@@ -60,17 +96,32 @@ class FeatureManager::Internal : public Xapian::Internal::intrusive_base
 
     Xapian::RankList create_rank_list(const Xapian::MSet & mset,std::string & qid);
 
+    /** Calculate the features of every document in an MSet.
+     *
+     *  Row i of the row-major matrix holds the features of the i-th MSet
+     *  item, with fNum + 1 columns so column j is feature j.
+     */
+    void create_feature_matrix(const Xapian::MSet & mset, vector<double> & matrix);
+
     map<string, map<string,int> > load_relevance(const std::string & qrel_file);
 
     Xapian::FeatureVector create_feature_vector(map<int,double> fvals, int &label, std::string & did);
 
     std::string getdid(const Document &doc);
 
-    int getlabel(map<string, map<string, int> > qrel, const Document &doc, std::string & qid);
+    int getlabel(const map<string, map<string, int> > & qrel, const std::string & did, const std::string & qid);
 
     static const int fNum = 20;
 
+    Internal() : coll_doccount(0), coll_lastdocid(0), coll_avlength(0) { }
+
   private:
+    /** Calculate all the features for a document in one pass.
+     *
+     *  val must have room for fNum + 1 entries, which should be zero on entry.
+     */
+    void extract_features(const Document &doc, double weight, double * val);
+
     // update collection-level measures
     void update_collection_level();
 
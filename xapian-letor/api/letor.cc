@@ -50,6 +50,7 @@ Letor::~Letor() { }
 void
 Letor::set_database(const Xapian::Database & db) {
     internal->letor_db = db;
+    internal->fm.set_database(db);
 }
 
 void
@@ -36,9 +36,11 @@ map<string, long int>
 Features::termfreq(const Xapian::Document & doc, const Xapian::Query & query) {
     map<string, long int> tf;
 
-    Xapian::TermIterator docterms = doc.termlist_begin();
+    // The query terms are in query order, not sorted, so look each one up
+    // from the start of the termlist.
     for (Xapian::TermIterator qt = query.get_terms_begin();
 	 qt != query.get_terms_end(); ++qt) {
+	Xapian::TermIterator docterms = doc.termlist_begin();
 	docterms.skip_to(*qt);
 	if (docterms != doc.termlist_end() && *qt == *docterms) {
 	    tf[*qt] = docterms.get_wdf();
@@ -26,6 +26,7 @@
 #include "xapian-letor/letor.h"
 #include "letor_internal.h"
 #include "xapian-letor/featuremanager.h"
+#include "featuremanager_internal.h"
 
 #include "str.h"
 #include "stringutils.h"
@@ -110,26 +111,31 @@ static string get_cwd() {
 
 
 /* This method will calculate the score assigned by the Letor function.
- * It will take MSet as input then convert the documents in feature vectors
- * then normalize them according to QueryLevelNorm
- * and after that use the machine learned model file
- * to assign a score to the document
+ * It will take MSet as input then convert the documents in a dense feature
+ * matrix, one row per document, and score each row with the machine learned
+ * model, which is read from model.txt in the current working directory the
+ * first time it's needed.
  */
 map<Xapian::docid, double>
 Letor::Internal::letor_score(const Xapian::MSet & mset) {
 
     map<Xapian::docid, double> letor_mset;
 
-    Xapian::FeatureManager fm;
-    fm.set_database(letor_db);
     fm.set_query(letor_query);
-    
-    std::string s="1";
-    Xapian::RankList rl = fm.create_rank_list(mset, s);
-    std::list<double> scores =ranker.rank(rl);
-    
-    /*code to convert list<double> scores to map<docid,double>*/
-    
+
+    if (scoring_model.empty())
+	scoring_model.load(get_cwd().append("/model.txt"));
+
+    fm.internal->create_feature_matrix(mset, features);
+
+    const size_t n_cols = FeatureManager::fNum + 1;
+    vector<double> scores(mset.size());
+    scoring_model.score(features.data(), mset.size(), n_cols, scores.data());
+
+    size_t row = 0;
+    for (Xapian::MSetIterator i = mset.begin(); i != mset.end(); ++i) {
+	letor_mset.insert(letor_mset.end(), make_pair(*i, scores[row++]));
+    }
     return letor_mset;
 }
 
@@ -285,6 +291,9 @@ Letor::Internal::letor_learn_model(int s_type, int k_type) {
 	fprintf(stderr, "can't save model to file %s\n", model_file_name.c_str());
 	exit(1);
     }
+
+    // Use the new model for scoring from now on.
+    scoring_model.load(model_file_name);
 }
 
 
@@ -332,9 +341,6 @@ Letor::Internal::prepare_training_file(const string & queryfile, const string &
 
     map<string, map<string, int> > qrel; // 1
 
-    Xapian::FeatureManager fm;
-    fm.set_database(letor_db);
-    fm.load_relevance(qrel_file);
     qrel = fm.load_relevance(qrel_file);
 
     list<Xapian::RankList> l;
@@ -23,9 +23,12 @@
 #define XAPIAN_INCLUDED_LETOR_INTERNAL_H
 
 #include "xapian-letor/letor.h"
+#include "xapian-letor/featuremanager.h"
 #include "xapian-letor/ranker.h"
+#include "letor_model.h"
 
 #include <map>
+#include <vector>
 
 using namespace std;
 
@@ -37,6 +40,19 @@ class Letor::Internal : public Xapian::Internal::intrusive_base {
     Database letor_db;
     Query letor_query;
 
+    /** Calculates the features for letor_db.
+     *
+     *  This is kept between queries so the collection-level statistics are
+     *  only worked out once per database.
+     */
+    FeatureManager fm;
+
+    /// The model letor_score() uses, loaded the first time it's needed.
+    LetorModel scoring_model;
+
+    /// Feature matrix for the MSet being scored, reused between calls.
+    std::vector<double> features;
+
   public:
 
     std::map<Xapian::docid, double>  letor_score(const Xapian::MSet & mset);
@@ -0,0 +1,229 @@
+/** @file letor_model.cc
+ * @brief A ranking model held in memory for scoring feature matrices
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "letor_model.h"
+
+#include <xapian.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace Xapian;
+
+void
+LetorModel::load(const string & model_file)
+{
+    ifstream in(model_file.c_str());
+    if (!in)
+	throw Xapian::InvalidArgumentError("Couldn't open model file " +
+					   model_file);
+
+    kernel new_kernel = NONE;
+    string svm_type;
+    double new_gamma = 0, new_coef0 = 0, new_rho = 0;
+    int new_degree = 3;
+    int nr_class = 2;
+    vector<double> labels;
+
+    // Read the header, which is "name value..." lines up to "SV".
+    string line;
+    bool seen_sv = false;
+    while (getline(in, line)) {
+	istringstream iss(line);
+	string name;
+	iss >> name;
+	if (name == "SV") {
+	    seen_sv = true;
+	    break;
+	}
+	if (name == "svm_type") {
+	    iss >> svm_type;
+	} else if (name == "kernel_type") {
+	    string k;
+	    iss >> k;
+	    if (k == "linear") {
+		new_kernel = LINEAR;
+	    } else if (k == "polynomial") {
+		new_kernel = POLY;
+	    } else if (k == "rbf") {
+		new_kernel = RBF;
+	    } else if (k == "sigmoid") {
+		new_kernel = SIGMOID;
+	    } else {
+		throw Xapian::InvalidArgumentError("Unsupported kernel type '" +
+						   k + "' in " + model_file);
+	    }
+	} else if (name == "degree") {
+	    iss >> new_degree;
+	} else if (name == "gamma") {
+	    iss >> new_gamma;
+	} else if (name == "coef0") {
+	    iss >> new_coef0;
+	} else if (name == "nr_class") {
+	    iss >> nr_class;
+	} else if (name == "rho") {
+	    iss >> new_rho;
+	} else if (name == "label") {
+	    double l;
+	    while (iss >> l) labels.push_back(l);
+	}
+	// Ignore anything else (e.g. total_sv, nr_sv, probA, probB).
+    }
+
+    if (!seen_sv || new_kernel == NONE)
+	throw Xapian::InvalidArgumentError("Not a libsvm model file: " +
+					   model_file);
+    if (nr_class > 2)
+	throw Xapian::InvalidArgumentError("Models with more than two classes "
+					   "aren't supported: " + model_file);
+
+    // Read the support vectors: "coef index:value index:value ...".
+    vector<double> coefs;
+    vector<vector<pair<size_t, double> > > svs;
+    size_t max_index = 0;
+    while (getline(in, line)) {
+	istringstream iss(line);
+	double coef;
+	if (!(iss >> coef)) continue;
+	coefs.push_back(coef);
+	svs.push_back(vector<pair<size_t, double> >());
+	string item;
+	while (iss >> item) {
+	    string::size_type colon = item.find(':');
+	    if (colon == string::npos)
+		throw Xapian::InvalidArgumentError("Bad support vector in " +
+						   model_file);
+	    size_t index = strtoul(item.c_str(), NULL, 10);
+	    double value = strtod(item.c_str() + colon + 1, NULL);
+	    svs.back().push_back(make_pair(index, value));
+	    max_index = max(max_index, index);
+	}
+    }
+
+    kernel_type = new_kernel;
+    gamma = new_gamma;
+    coef0 = new_coef0;
+    degree = new_degree;
+    rho = new_rho;
+    n_features = max_index + 1;
+
+    // A classifier's decision value is positive for its first label, so
+    // flip the sign if that's the less relevant one.
+    sign = 1;
+    if ((svm_type == "c_svc" || svm_type == "nu_svc") &&
+	labels.size() == 2 && labels[0] < labels[1]) {
+	sign = -1;
+    }
+
+    support_vectors.clear();
+    if (kernel_type == LINEAR) {
+	// sum(coef_i * <sv_i, x>) is <sum(coef_i * sv_i), x>.
+	weights.assign(n_features, 0.0);
+	for (size_t i = 0; i != svs.size(); ++i) {
+	    for (size_t j = 0; j != svs[i].size(); ++j) {
+		weights[svs[i][j].first] += coefs[i] * svs[i][j].second;
+	    }
+	}
+    } else {
+	weights.swap(coefs);
+	support_vectors.assign(svs.size() * n_features, 0.0);
+	for (size_t i = 0; i != svs.size(); ++i) {
+	    double * row = &support_vectors[i * n_features];
+	    for (size_t j = 0; j != svs[i].size(); ++j) {
+		row[svs[i][j].first] = svs[i][j].second;
+	    }
+	}
+    }
+}
+
+double
+LetorModel::kernel_function(const double * x, const double * sv,
+			    size_t n, double tail) const
+{
+    if (kernel_type == RBF) {
+	double dist = tail;
+	for (size_t j = 0; j != n; ++j) {
+	    double d = x[j] - sv[j];
+	    dist += d * d;
+	}
+	return exp(-gamma * dist);
+    }
+
+    double dot = 0;
+    for (size_t j = 0; j != n; ++j) {
+	dot += x[j] * sv[j];
+    }
+    if (kernel_type == POLY)
+	return pow(gamma * dot + coef0, degree);
+    return tanh(gamma * dot + coef0);
+}
+
+void
+LetorModel::score(const double * matrix, size_t n_rows, size_t n_cols,
+		  double * scores) const
+{
+    // Features which the model has no weight for don't affect the score,
+    // except with the RBF kernel where they add to the distance.
+    size_t n = min(n_cols, n_features);
+
+    if (kernel_type == LINEAR) {
+	const double * w = weights.data();
+	for (size_t r = 0; r != n_rows; ++r) {
+	    const double * x = matrix + r * n_cols;
+	    double s = 0;
+	    for (size_t j = 0; j != n; ++j) {
+		s += w[j] * x[j];
+	    }
+	    scores[r] = sign * (s - rho);
+	}
+	return;
+    }
+
+    size_t n_svs = weights.size();
+    for (size_t r = 0; r != n_rows; ++r) {
+	const double * x = matrix + r * n_cols;
+	double extra = 0;
+	if (kernel_type == RBF) {
+	    for (size_t j = n; j < n_cols; ++j) {
+		extra += x[j] * x[j];
+	    }
+	}
+	double s = 0;
+	for (size_t i = 0; i != n_svs; ++i) {
+	    const double * sv = &support_vectors[i * n_features];
+	    double tail = extra;
+	    if (kernel_type == RBF) {
+		for (size_t j = n; j < n_features; ++j) {
+		    tail += sv[j] * sv[j];
+		}
+	    }
+	    s += weights[i] * kernel_function(x, sv, n, tail);
+	}
+	scores[r] = sign * (s - rho);
+    }
+}
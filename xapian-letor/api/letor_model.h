@@ -0,0 +1,111 @@
+/** @file letor_model.h
+ * @brief A ranking model held in memory for scoring feature matrices
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_LETOR_MODEL_H
+#define XAPIAN_INCLUDED_LETOR_MODEL_H
+
+#include <string>
+#include <vector>
+
+namespace Xapian {
+
+/** A ranking model held in memory for scoring feature matrices.
+ *
+ *  The model is read from a libsvm model file once, and converted to a dense
+ *  form so scoring doesn't need any libsvm structures.  A model with a
+ *  linear kernel is collapsed to a single weight vector, so scoring a
+ *  document is one dot product.  For other kernels the support vectors are
+ *  kept as a dense matrix.
+ *
+ *  A feature matrix has a row for each document, and column i of a row holds
+ *  the value of feature i.
+ */
+class LetorModel {
+    /// The libsvm kernel types we understand.
+    enum kernel { NONE, LINEAR, POLY, RBF, SIGMOID };
+
+    kernel kernel_type;
+
+    /// Parameters of the kernel function.
+    double gamma, coef0;
+    int degree;
+
+    /// Constant term of the decision function.
+    double rho;
+
+    /** Multiplier for the decision value.
+     *
+     *  This is -1 for a classifier whose first label is the less relevant, so
+     *  that a higher score always means a more relevant document.
+     */
+    double sign;
+
+    /// Number of columns in weights and in each row of support_vectors.
+    size_t n_features;
+
+    /** For a linear kernel, the weight of each feature.  Otherwise the
+     *  coefficient of each support vector.
+     */
+    std::vector<double> weights;
+
+    /// The support vectors, one row per vector (unused for a linear kernel).
+    std::vector<double> support_vectors;
+
+    /** Evaluate the kernel function for a row and a support vector.
+     *
+     *  @param n	Number of columns the row and support vector share.
+     *  @param tail	Sum of the squares of the values in either beyond
+     *			those n columns (only used by the RBF kernel).
+     */
+    double kernel_function(const double * x, const double * sv,
+			   size_t n, double tail) const;
+
+  public:
+    LetorModel()
+	: kernel_type(NONE), gamma(0), coef0(0), degree(3), rho(0), sign(1),
+	  n_features(0) { }
+
+    /// Has a model been loaded?
+    bool empty() const { return kernel_type == NONE; }
+
+    /** Load a model from a file written by libsvm's svm_save_model().
+     *
+     *  Any previously loaded model is replaced.  Only models with a single
+     *  decision function (two-class, one-class and regression models) are
+     *  supported.
+     *
+     *  @exception Xapian::InvalidArgumentError if the file can't be read or
+     *		   isn't a supported model.
+     */
+    void load(const std::string & model_file);
+
+    /** Score each row of a feature matrix.
+     *
+     *  @param matrix	Row-major matrix of feature values.
+     *  @param n_rows	Number of rows in matrix.
+     *  @param n_cols	Number of columns in each row of matrix.
+     *  @param scores	Array of n_rows entries to store the scores in.
+     */
+    void score(const double * matrix, size_t n_rows, size_t n_cols,
+	       double * scores) const;
+};
+
+}
+
+#endif // XAPIAN_INCLUDED_LETOR_MODEL_H
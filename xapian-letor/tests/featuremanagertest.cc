@@ -0,0 +1,147 @@
+/** @file featuremanagertest.cc
+ * @brief Check FeatureManager against the Features helpers
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include <xapian.h>
+#include <xapian-letor.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+using namespace std;
+
+/// Build a small database with title (S-prefixed) and body terms.
+static Xapian::Database
+build_database()
+{
+    Xapian::WritableDatabase db(string(), Xapian::DB_BACKEND_INMEMORY);
+    Xapian::Document doc;
+    doc.add_term("Szebra");
+    doc.add_term("apple", 3);
+    doc.add_term("pear");
+    doc.add_term("zebra", 2);
+    db.add_document(doc);
+
+    doc = Xapian::Document();
+    doc.add_term("Sapple", 2);
+    doc.add_term("apple");
+    doc.add_term("mango", 4);
+    db.add_document(doc);
+
+    doc = Xapian::Document();
+    doc.add_term("zebra", 5);
+    db.add_document(doc);
+    return db;
+}
+
+/** Calculate the features of @a doc using the Features helpers.
+ *
+ *  These iterate the query terms in query order, so they don't depend on
+ *  the terms being sorted.
+ */
+static map<int, double>
+reference_features(const Xapian::Database & db, const Xapian::Query & query,
+		   const Xapian::Document & doc, double weight)
+{
+    Xapian::Features f;
+    map<string, long int> tf = f.termfreq(doc, query);
+    map<string, double> idf = f.inverse_doc_freq(db, query);
+    map<string, long int> doc_len = f.doc_length(db, doc);
+    map<string, long int> coll_tf = f.collection_termfreq(db, query);
+    map<string, long int> coll_len = f.collection_length(db);
+
+    map<int, double> fvals;
+    const char parts[] = "tbw";
+    for (int i = 0; i != 3; ++i) {
+	char ch = parts[i];
+	fvals[1 + i] = f.calculate_f1(query, tf, ch);
+	fvals[4 + i] = f.calculate_f2(query, tf, doc_len, ch);
+	fvals[7 + i] = f.calculate_f3(query, idf, ch);
+	fvals[10 + i] = f.calculate_f4(query, coll_tf, coll_len, ch);
+	fvals[13 + i] = f.calculate_f5(query, tf, idf, doc_len, ch);
+	fvals[16 + i] = f.calculate_f6(query, tf, doc_len, coll_tf, coll_len,
+				       ch);
+    }
+    fvals[19] = weight;
+    return fvals;
+}
+
+/// Check FeatureManager gives the reference features for every document.
+static bool
+check_query(const Xapian::Database & db, const Xapian::Query & query)
+{
+    Xapian::FeatureManager fm;
+    fm.set_database(db);
+    fm.set_query(query);
+
+    bool ok = true;
+    for (Xapian::docid did = 1; did <= db.get_lastdocid(); ++did) {
+	Xapian::Document doc = db.get_document(did);
+	double weight = 1.5;
+	map<int, double> got = fm.transform(doc, weight);
+	map<int, double> want = reference_features(db, query, doc, weight);
+	map<int, double>::const_iterator i;
+	for (i = want.begin(); i != want.end(); ++i) {
+	    double value = got[i->first];
+	    if (fabs(value - i->second) > 1e-9) {
+		cerr << query.get_description() << ", document " << did
+		     << ", feature " << i->first << ": got " << value
+		     << ", expected " << i->second << endl;
+		ok = false;
+	    }
+	}
+    }
+    return ok;
+}
+
+int
+main()
+{
+    try {
+	Xapian::Database db = build_database();
+	bool ok = true;
+
+	// Query::get_terms_begin() returns the terms in order of position, so
+	// they aren't in the same order as a termlist.  "Szebra" and "apple"
+	// sort either side of the body terms.
+	ok &= check_query(db, Xapian::Query(Xapian::Query::OP_OR,
+					    Xapian::Query("zebra", 1, 1),
+					    Xapian::Query("apple", 1, 2)));
+	ok &= check_query(db, Xapian::Query(Xapian::Query::OP_OR,
+					    Xapian::Query("zebra", 1, 1),
+					    Xapian::Query("Szebra", 1, 2)));
+
+	// A repeated term counts for each time it appears in the query.
+	Xapian::Query query(Xapian::Query::OP_OR,
+			    Xapian::Query("apple", 1, 1),
+			    Xapian::Query("pear", 1, 2));
+	ok &= check_query(db, Xapian::Query(Xapian::Query::OP_OR,
+					    query,
+					    Xapian::Query("apple", 1, 3)));
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const Xapian::Error & e) {
+	cerr << e.get_description() << endl;
+	return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,237 @@
+/** @file letormodeltest.cc
+ * @brief Check LetorModel scores against hand-computed decision values
+ */
+/* This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include <xapian.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// LetorModel isn't part of the public API, so build it into the test.
+#include "../api/letor_model.cc"
+
+using namespace std;
+
+/// File the test models are written to.
+static const char MODEL_FILE[] = "letormodeltest.model";
+
+/// Header of a two-class linear model.
+static const char LINEAR_HEADER[] =
+    "svm_type c_svc\n"
+    "kernel_type linear\n"
+    "nr_class 2\n"
+    "total_sv 2\n"
+    "rho 0.5\n";
+
+/** Support vectors of the linear model.
+ *
+ *  The weights are 0.75 * (2, 0, 1) - 0.25 * (1, 4, 0) = (1.25, -1, 0.75)
+ *  for features 1 to 3.
+ */
+static const char LINEAR_SVS[] =
+    "nr_sv 1 1\n"
+    "SV\n"
+    "0.75 1:2 3:1 \n"
+    "-0.25 1:1 2:4 \n";
+
+/// Write @a contents to MODEL_FILE and load it into @a model.
+static void
+load_model(Xapian::LetorModel & model, const string & contents)
+{
+    {
+	ofstream out(MODEL_FILE);
+	out << contents;
+    }
+    model.load(MODEL_FILE);
+}
+
+/// Check @a got is @a want, reporting @a what if it isn't.
+static bool
+check_score(const char * what, double got, double want)
+{
+    if (fabs(got - want) > 1e-9) {
+	cerr << what << ": got " << got << ", expected " << want << endl;
+	return false;
+    }
+    return true;
+}
+
+/// Check a linear model against its weights minus rho.
+static bool
+test_linear()
+{
+    Xapian::LetorModel model;
+    load_model(model, string(LINEAR_HEADER) + "label 1 -1\n" + LINEAR_SVS);
+
+    // Column 0 isn't a feature.  The second row has an extra column which
+    // the model has no weight for, and the third is missing feature 3.
+    const double matrix[] = {
+	0, 1, 2, 3, 0,
+	0, 1, 2, 3, 7,
+	0, 2, 1, 0, 0
+    };
+    double scores[3];
+    model.score(matrix, 3, 5, scores);
+    bool ok = true;
+    ok &= check_score("linear row 1", scores[0],
+		      1.25 * 1 - 1 * 2 + 0.75 * 3 - 0.5);
+    ok &= check_score("linear row 2", scores[1], scores[0]);
+    ok &= check_score("linear row 3", scores[2], 1.25 * 2 - 1 * 1 - 0.5);
+
+    // A matrix with fewer columns than the model has features.
+    model.score(matrix, 1, 3, scores);
+    ok &= check_score("linear 3 columns", scores[0], 1.25 * 1 - 1 * 2 - 0.5);
+    return ok;
+}
+
+/// Check that the score is negated if the first label is the less relevant.
+static bool
+test_label_order()
+{
+    Xapian::LetorModel model;
+    const double matrix[] = { 0, 1, 2, 3 };
+    double want = 1.25 * 1 - 1 * 2 + 0.75 * 3 - 0.5;
+    double score;
+    bool ok = true;
+
+    load_model(model, string(LINEAR_HEADER) + "label -1 1\n" + LINEAR_SVS);
+    model.score(matrix, 1, 4, &score);
+    ok &= check_score("reversed labels", score, -want);
+
+    load_model(model, string(LINEAR_HEADER) + "label 0 3\n" + LINEAR_SVS);
+    model.score(matrix, 1, 4, &score);
+    ok &= check_score("ascending relevance labels", score, -want);
+
+    load_model(model, string(LINEAR_HEADER) + "label 3 0\n" + LINEAR_SVS);
+    model.score(matrix, 1, 4, &score);
+    ok &= check_score("descending relevance labels", score, want);
+
+    // A regression model has no labels, so is never flipped.
+    string svr = LINEAR_HEADER;
+    svr.replace(svr.find("c_svc"), 5, "epsilon_svr");
+    load_model(model, svr + LINEAR_SVS);
+    model.score(matrix, 1, 4, &score);
+    ok &= check_score("regression", score, want);
+    return ok;
+}
+
+/// Check an RBF model against the decision function evaluated directly.
+static bool
+test_rbf()
+{
+    Xapian::LetorModel model;
+    load_model(model,
+	       "svm_type c_svc\n"
+	       "kernel_type rbf\n"
+	       "gamma 0.5\n"
+	       "nr_class 2\n"
+	       "total_sv 2\n"
+	       "rho 0.1\n"
+	       "label 1 -1\n"
+	       "nr_sv 1 1\n"
+	       "SV\n"
+	       "0.8 1:1 2:0.5 \n"
+	       "-0.3 2:2 \n");
+
+    // The second row has a column beyond the model's features, which adds
+    // to its distance from every support vector.
+    const double matrix[] = {
+	0, 1, 1, 0,
+	0, 0, 2, 1
+    };
+    double scores[2];
+    model.score(matrix, 2, 4, scores);
+
+    // |(1, 1) - (1, 0.5)|^2 = 0.25, |(1, 1) - (0, 2)|^2 = 2
+    double want0 = 0.8 * exp(-0.5 * 0.25) - 0.3 * exp(-0.5 * 2) - 0.1;
+    // |(0, 2, 1) - (1, 0.5, 0)|^2 = 4.25, |(0, 2, 1) - (0, 2, 0)|^2 = 1
+    double want1 = 0.8 * exp(-0.5 * 4.25) - 0.3 * exp(-0.5 * 1) - 0.1;
+    bool ok = true;
+    ok &= check_score("rbf row 1", scores[0], want0);
+    ok &= check_score("rbf row 2", scores[1], want1);
+    return ok;
+}
+
+/// Check that loading @a contents throws InvalidArgumentError.
+static bool
+check_bad_model(const char * what, const string & contents)
+{
+    Xapian::LetorModel model;
+    try {
+	load_model(model, contents);
+    } catch (const Xapian::InvalidArgumentError &) {
+	return true;
+    }
+    cerr << what << ": no InvalidArgumentError" << endl;
+    return false;
+}
+
+/// Check malformed and unsupported model files are rejected.
+static bool
+test_bad_models()
+{
+    bool ok = true;
+    ok &= check_bad_model("no SV line",
+			  string(LINEAR_HEADER) + "label 1 -1\n");
+    ok &= check_bad_model("no kernel_type",
+			  "svm_type c_svc\nrho 0.5\nSV\n0.75 1:2\n");
+    ok &= check_bad_model("bad support vector",
+			  string(LINEAR_HEADER) +
+			  "label 1 -1\nSV\n0.75 1=2\n");
+    ok &= check_bad_model("unsupported kernel",
+			  "svm_type c_svc\nkernel_type precomputed\nSV\n");
+    ok &= check_bad_model("three classes",
+			  "svm_type c_svc\nkernel_type linear\nnr_class 3\n"
+			  "label 1 2 3\nSV\n");
+
+    Xapian::LetorModel model;
+    try {
+	model.load("letormodeltest.nosuchfile");
+	cerr << "missing file: no InvalidArgumentError" << endl;
+	ok = false;
+    } catch (const Xapian::InvalidArgumentError &) {
+    }
+    if (!model.empty()) {
+	cerr << "missing file: model loaded" << endl;
+	ok = false;
+    }
+    return ok;
+}
+
+int
+main()
+{
+    bool ok = true;
+    try {
+	ok &= test_linear();
+	ok &= test_label_order();
+	ok &= test_rbf();
+	ok &= test_bad_models();
+    } catch (const Xapian::Error & e) {
+	cerr << e.get_description() << endl;
+	ok = false;
+    }
+    remove(MODEL_FILE);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}